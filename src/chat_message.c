@@ -0,0 +1,100 @@
+/*
+ * chat_message.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <glib.h>
+
+#include "chat_message.h"
+
+ChatMessage*
+chat_message_new(const char * const barejid, const char * const resource,
+    const char * const body, GTimeVal *tv_stamp)
+{
+    ChatMessage *message = malloc(sizeof(struct chat_message_t));
+    message->barejid = strdup(barejid);
+    if (resource) {
+        message->resource = strdup(resource);
+    } else {
+        message->resource = NULL;
+    }
+    message->body = strdup(body);
+    if (tv_stamp) {
+        message->timestamp = *tv_stamp;
+        message->delayed = TRUE;
+    } else {
+        g_get_current_time(&message->timestamp);
+        message->delayed = FALSE;
+    }
+    message->encrypted = FALSE;
+    message->refs = 1;
+
+    return message;
+}
+
+ChatMessage*
+chat_message_ref(ChatMessage *message)
+{
+    assert(message->refs > 0);
+    message->refs++;
+    return message;
+}
+
+void
+chat_message_unref(ChatMessage *message)
+{
+    if (message == NULL) {
+        return;
+    }
+
+    assert(message->refs > 0);
+    message->refs--;
+    if (message->refs == 0) {
+        free(message->barejid);
+        free(message->resource);
+        free(message->body);
+        free(message);
+    }
+}
+
+// takes ownership of body, which must have been allocated with malloc
+void
+chat_message_set_body(ChatMessage *message, char *body)
+{
+    assert(message->refs == 1);
+    free(message->body);
+    message->body = body;
+}
@@ -33,25 +33,34 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <glib.h>
 
 #include "chat_state.h"
 #include "chat_session.h"
+#include "tools/timerwheel.h"
 #include "xmpp/xmpp.h"
 #include "config/preferences.h"
 
-#define PAUSED_TIMEOUT 10.0
-#define INACTIVE_TIMEOUT 30.0
+#define PAUSED_TIMEOUT_MS 10000
+#define INACTIVE_TIMEOUT_MS 30000
+
+// pending transitions for all chats, only chats with a deadline are in the wheel
+static TimerWheel wheel = NULL;
 
 static void _send_if_supported(const char * const barejid, void(*send_func)(const char * const));
+static void _set_state(ChatState *state, chat_state_type_t type);
+static void _timeout(ChatState *state);
+static gint64 _now_ms(void);
 
 ChatState*
-chat_state_new(void)
+chat_state_new(const char * const barejid)
 {
     ChatState *new_state = malloc(sizeof(struct prof_chat_state_t));
     new_state->type = CHAT_STATE_GONE;
-    new_state->timer = g_timer_new();
+    new_state->barejid = strdup(barejid);
+    new_state->timer = NULL;
 
     return new_state;
 }
@@ -59,61 +68,23 @@ chat_state_new(void)
 void
 chat_state_free(ChatState *state)
 {
-    if (state && state->timer!= NULL) {
-        g_timer_destroy(state->timer);
+    if (state) {
+        if (state->timer) {
+            timer_wheel_cancel(wheel, state->timer);
+        }
+        free(state->barejid);
     }
     free(state);
 }
 
+/*
+ * Fire any transitions that have become due since the last call
+ */
 void
-chat_state_handle_idle(const char * const barejid, ChatState *state)
+chat_state_handle_idle(void)
 {
-    gdouble elapsed = g_timer_elapsed(state->timer, NULL);
-
-    // TYPING -> PAUSED
-    if (state->type == CHAT_STATE_COMPOSING && elapsed > PAUSED_TIMEOUT) {
-        state->type = CHAT_STATE_PAUSED;
-        g_timer_start(state->timer);
-        if (prefs_get_boolean(PREF_STATES) && prefs_get_boolean(PREF_OUTTYPE)) {
-            _send_if_supported(barejid, message_send_paused);
-        }
-        return;
-    }
-
-    // PAUSED|ACTIVE -> INACTIVE
-    if ((state->type == CHAT_STATE_PAUSED || state->type == CHAT_STATE_ACTIVE) && elapsed > INACTIVE_TIMEOUT) {
-        state->type = CHAT_STATE_INACTIVE;
-        g_timer_start(state->timer);
-        if (prefs_get_boolean(PREF_STATES)) {
-            _send_if_supported(barejid, message_send_inactive);
-        }
-        return;
-
-    }
-
-    // INACTIVE -> GONE
-    if (state->type == CHAT_STATE_INACTIVE) {
-        if (prefs_get_gone() != 0 && (elapsed > (prefs_get_gone() * 60.0))) {
-            ChatSession *session = chat_session_get(barejid);
-            if (session) {
-                // never move to GONE when resource override
-                if (!session->resource_override) {
-                    if (prefs_get_boolean(PREF_STATES)) {
-                        _send_if_supported(barejid, message_send_gone);
-                    }
-                    chat_session_remove(barejid);
-                    state->type = CHAT_STATE_GONE;
-                    g_timer_start(state->timer);
-                }
-            } else {
-                if (prefs_get_boolean(PREF_STATES)) {
-                    message_send_gone(barejid);
-                }
-                state->type = CHAT_STATE_GONE;
-                g_timer_start(state->timer);
-            }
-            return;
-        }
+    if (wheel) {
+        timer_wheel_advance(wheel, _now_ms());
     }
 }
 
@@ -122,8 +93,7 @@ chat_state_handle_typing(const char * const barejid, ChatState *state)
 {
     // ACTIVE|INACTIVE|PAUSED|GONE -> COMPOSING
     if (state->type != CHAT_STATE_COMPOSING) {
-        state->type = CHAT_STATE_COMPOSING;
-        g_timer_start(state->timer);
+        _set_state(state, CHAT_STATE_COMPOSING);
         if (prefs_get_boolean(PREF_STATES) && prefs_get_boolean(PREF_OUTTYPE)) {
             _send_if_supported(barejid, message_send_composing);
         }
@@ -133,8 +103,7 @@ chat_state_handle_typing(const char * const barejid, ChatState *state)
 void
 chat_state_active(ChatState *state)
 {
-    state->type = CHAT_STATE_ACTIVE;
-    g_timer_start(state->timer);
+    _set_state(state, CHAT_STATE_ACTIVE);
 }
 
 void
@@ -144,9 +113,98 @@ chat_state_gone(const char * const barejid, ChatState *state)
         if (prefs_get_boolean(PREF_STATES)) {
             _send_if_supported(barejid, message_send_gone);
         }
-        state->type = CHAT_STATE_GONE;
-        g_timer_start(state->timer);
+        _set_state(state, CHAT_STATE_GONE);
+    }
+}
+
+/*
+ * Change state and schedule the transition that follows it:
+ * COMPOSING -> PAUSED -> INACTIVE -> GONE, ACTIVE -> INACTIVE
+ */
+static void
+_set_state(ChatState *state, chat_state_type_t type)
+{
+    if (wheel == NULL) {
+        wheel = timer_wheel_new(_now_ms());
+    }
+    if (state->timer) {
+        timer_wheel_cancel(wheel, state->timer);
+        state->timer = NULL;
+    }
+
+    state->type = type;
+
+    gint64 delay_ms = 0;
+    switch (type) {
+    case CHAT_STATE_COMPOSING:
+        delay_ms = PAUSED_TIMEOUT_MS;
+        break;
+    case CHAT_STATE_PAUSED:
+    case CHAT_STATE_ACTIVE:
+        delay_ms = INACTIVE_TIMEOUT_MS;
+        break;
+    case CHAT_STATE_INACTIVE:
+        delay_ms = (gint64)prefs_get_gone() * 60 * 1000;
+        break;
+    default:
+        break;
+    }
+
+    if (delay_ms > 0) {
+        state->timer = timer_wheel_add(wheel, _now_ms(), delay_ms, (wheel_timer_func)_timeout, state);
+    }
+}
+
+static void
+_timeout(ChatState *state)
+{
+    // the wheel frees the timer once this returns
+    state->timer = NULL;
+    const char *barejid = state->barejid;
+
+    // TYPING -> PAUSED
+    if (state->type == CHAT_STATE_COMPOSING) {
+        _set_state(state, CHAT_STATE_PAUSED);
+        if (prefs_get_boolean(PREF_STATES) && prefs_get_boolean(PREF_OUTTYPE)) {
+            _send_if_supported(barejid, message_send_paused);
+        }
+        return;
+    }
+
+    // PAUSED|ACTIVE -> INACTIVE
+    if (state->type == CHAT_STATE_PAUSED || state->type == CHAT_STATE_ACTIVE) {
+        _set_state(state, CHAT_STATE_INACTIVE);
+        if (prefs_get_boolean(PREF_STATES)) {
+            _send_if_supported(barejid, message_send_inactive);
+        }
+        return;
     }
+
+    // INACTIVE -> GONE
+    if (state->type == CHAT_STATE_INACTIVE && prefs_get_gone() != 0) {
+        ChatSession *session = chat_session_get(barejid);
+        if (session) {
+            // never move to GONE when resource override
+            if (!session->resource_override) {
+                if (prefs_get_boolean(PREF_STATES)) {
+                    _send_if_supported(barejid, message_send_gone);
+                }
+                chat_session_remove(barejid);
+                _set_state(state, CHAT_STATE_GONE);
+            }
+        } else {
+            if (prefs_get_boolean(PREF_STATES)) {
+                message_send_gone(barejid);
+            }
+            _set_state(state, CHAT_STATE_GONE);
+        }
+    }
+}
+
+static gint64
+_now_ms(void)
+{
+    return g_get_monotonic_time() / 1000;
 }
 
 static void
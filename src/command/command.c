@@ -89,6 +89,8 @@ static char * _bookmark_autocomplete(const char * const input);
 static char * _otr_autocomplete(const char * const input);
 static char * _connect_autocomplete(const char * const input);
 static char * _statuses_autocomplete(const char * const input);
+static char * _xmlconsole_autocomplete(const char * const input);
+static char * _highlight_autocomplete(const char * const input);
 static char * _alias_autocomplete(const char * const input);
 static char * _join_autocomplete(const char * const input);
 static char * _log_autocomplete(const char * const input);
@@ -581,6 +583,15 @@ static struct cmd_t command_defs[] =
           "Logout of any current session, and quit Profanity.",
           NULL } } },
 
+    { "/detach",
+        cmd_detach, parse_args, 0, 0, NULL,
+        { "/detach", "Leave Profanity running in the background.",
+        { "/detach",
+          "-------",
+          "Give the terminal back while staying logged in, rooms, windows and logging carry on in the background.",
+          "Run 'profanity --attach' from any terminal to return to the session.",
+          NULL } } },
+
     { "/privileges",
         cmd_privileges, parse_args, 1, 1, &cons_privileges_setting,
         { "/privileges on|off", "Show occupant privileges in chat rooms.",
@@ -638,6 +649,16 @@ static struct cmd_t command_defs[] =
           "Using the dynamic setting, higher CPU usage will occur during activity, but over time the CPU usage will decrease whilst there is no activity.",
           NULL } } },
 
+    { "/inputhistory",
+        cmd_inputhistory, parse_args, 1, 1, &cons_inputhistory_setting,
+        { "/inputhistory size", "Input history size.",
+        { "/inputhistory size",
+          "------------------",
+          "Number of input lines to remember, defaults to 100. Valid values are 1-10000.",
+          "Input history is kept per account and restored on the next login.",
+          "Use Ctrl-r to search back through the history for lines starting with the current input.",
+          NULL } } },
+
     { "/notify",
         cmd_notify, parse_args, 2, 3, &cons_notify_setting,
         { "/notify [type value]|[type setting value]", "Control various desktop notifications.",
@@ -659,6 +680,8 @@ static struct cmd_t command_defs[] =
           "remind          : Notification reminders of unread messages.",
           "                : where value is the reminder period in seconds,",
           "                : use 0 to disable.",
+          "coalesce        : Period in seconds over which notifications for the same window",
+          "                : are merged into one, use 0 to send them as they arrive.",
           "typing          : Notifications when contacts are typing.",
           "                : on|off",
           "typing current  : Whether typing notifications are triggered for the current window.",
@@ -675,6 +698,7 @@ static struct cmd_t command_defs[] =
           "Example : /notify room text off     (do not show message text in chat room notifications)",
           "Example : /notify remind 10         (remind every 10 seconds)",
           "Example : /notify remind 0          (switch off reminders)",
+          "Example : /notify coalesce 5        (merge a window's notifications over 5 seconds)",
           "Example : /notify typing on         (enable typing notifications)",
           "Example : /notify invite on         (enable chat room invite notifications)",
           NULL } } },
@@ -689,6 +713,16 @@ static struct cmd_t command_defs[] =
           "If the terminal doesn't support flashing, it may attempt to beep.",
           NULL } } },
 
+    { "/multiline",
+        cmd_multiline, parse_args, 1, 1, &cons_multiline_setting,
+        { "/multiline on|off", "Send multi-line pastes as one message.",
+        { "/multiline on|off",
+          "-----------------",
+          "When on, text pasted with several lines is kept in the input line, with line breaks shown as a marker, and sent as one message when you press enter.",
+          "When off, each pasted line is sent as a separate message, the last line waits for enter.",
+          "Requires a terminal with bracketed paste support.",
+          NULL } } },
+
     { "/intype",
         cmd_intype, parse_args, 1, 1, &cons_intype_setting,
         { "/intype on|off", "Show when contact is typing.",
@@ -873,6 +907,28 @@ static struct cmd_t command_defs[] =
           "A value of 0 will switch off autopinging the server.",
           NULL } } },
 
+    { "/csi",
+        cmd_csi, parse_args, 1, 1, &cons_csi_setting,
+        { "/csi seconds", "Client state indication idle period.",
+        { "/csi seconds",
+          "------------",
+          "Tell the server the client is inactive after the given number of seconds idle, or when the terminal loses focus.",
+          "The server may then hold back presence updates and other non urgent traffic until the client is active again.",
+          "Only used when the server supports client state indication (XEP-0352), defaults to 60.",
+          "A value of 0 will switch off client state indication.",
+          NULL } } },
+
+    { "/compression",
+        cmd_compression, parse_args, 1, 1, &cons_compression_setting,
+        { "/compression on|off|stats", "Stream compression.",
+        { "/compression on|off|stats",
+          "-------------------------",
+          "Ask the server to compress the XML stream (XEP-0138), useful on slow or metered connections.",
+          "The setting applies from the next time you connect.",
+          "stats : Show how much has been sent and received, and an estimate of what compression has saved.",
+          "The compressed sizes are estimated by compressing a copy of the stream locally, libstrophe does not report the real ones.",
+          NULL } } },
+
     { "/ping",
         cmd_ping, parse_args, 0, 1, NULL,
         { "/ping [target]", "Send ping IQ request.",
@@ -1007,11 +1063,41 @@ static struct cmd_t command_defs[] =
           NULL } } },
 
     { "/xmlconsole",
-        cmd_xmlconsole, parse_args, 0, 0, NULL,
-        { "/xmlconsole", "Open the XML console",
-        { "/xmlconsole",
-          "-----------",
+        cmd_xmlconsole, parse_args, 0, 2, NULL,
+        { "/xmlconsole [filter] [value]", "Open the XML console",
+        { "/xmlconsole [filter] [value]",
+          "----------------------------",
           "Open the XML console to view incoming and outgoing XMPP traffic.",
+          "Stanzas are only captured while the console window is open.",
+          "Filters are applied before stanzas are formatted:",
+          "dir value     : Show only 'in', 'out' or 'all' stanzas.",
+          "element value : Show only stanzas with the top level element, e.g. 'message'.",
+          "ns value      : Show only stanzas declaring the namespace.",
+          "clear         : Remove all filters.",
+          "",
+          "Example : /xmlconsole dir in",
+          "Example : /xmlconsole element presence",
+          "Example : /xmlconsole ns http://jabber.org/protocol/disco#info",
+          NULL } } },
+
+    { "/highlight",
+        cmd_highlight, parse_args, 0, 2, NULL,
+        { "/highlight [add|remove|list] [word]", "Highlight words in chat rooms.",
+        { "/highlight [add|remove|list] [word]",
+          "-----------------------------------",
+          "Chat room messages containing your nickname or any highlight word are",
+          "shown in the mention colour, trigger '/notify room mention' notifications",
+          "and are copied to the highlights window.",
+          "Words are matched anywhere in the message, ignoring case.",
+          "A word written as /pattern/ is matched as a regular expression.",
+          "With no arguments, open the highlights window.",
+          "add word    : Add a highlight word.",
+          "remove word : Remove a highlight word.",
+          "list        : List highlight words.",
+          "",
+          "Example : /highlight add profanity",
+          "Example : /highlight add \"release notes\"",
+          "Example : /highlight add /deploy(ed|ing)?/",
           NULL } } },
 
     { "/away",
@@ -1106,6 +1192,10 @@ static Autocomplete otr_policy_ac;
 static Autocomplete connect_property_ac;
 static Autocomplete statuses_ac;
 static Autocomplete statuses_setting_ac;
+static Autocomplete xmlconsole_ac;
+static Autocomplete xmlconsole_dir_ac;
+static Autocomplete highlight_ac;
+static Autocomplete highlights_ac;
 static Autocomplete alias_ac;
 static Autocomplete aliases_ac;
 static Autocomplete join_property_ac;
@@ -1121,6 +1211,7 @@ static Autocomplete occupants_default_ac;
 static Autocomplete time_ac;
 static Autocomplete resource_ac;
 static Autocomplete inpblock_ac;
+static Autocomplete compression_ac;
 
 /*
  * Initialise command autocompleter and history
@@ -1172,6 +1263,15 @@ cmd_init(void)
     }
     prefs_free_aliases(aliases);
 
+    highlights_ac = autocomplete_new();
+    GList *highlights = prefs_get_highlights();
+    curr = highlights;
+    while (curr != NULL) {
+        autocomplete_add(highlights_ac, curr->data);
+        curr = g_list_next(curr);
+    }
+    prefs_free_highlights(highlights);
+
     prefs_ac = autocomplete_new();
     autocomplete_add(prefs_ac, "ui");
     autocomplete_add(prefs_ac, "desktop");
@@ -1186,6 +1286,7 @@ cmd_init(void)
     autocomplete_add(notify_ac, "room");
     autocomplete_add(notify_ac, "typing");
     autocomplete_add(notify_ac, "remind");
+    autocomplete_add(notify_ac, "coalesce");
     autocomplete_add(notify_ac, "invite");
     autocomplete_add(notify_ac, "sub");
 
@@ -1407,6 +1508,27 @@ cmd_init(void)
     autocomplete_add(statuses_setting_ac, "online");
     autocomplete_add(statuses_setting_ac, "none");
 
+    xmlconsole_ac = autocomplete_new();
+    autocomplete_add(xmlconsole_ac, "dir");
+    autocomplete_add(xmlconsole_ac, "element");
+    autocomplete_add(xmlconsole_ac, "ns");
+    autocomplete_add(xmlconsole_ac, "clear");
+
+    compression_ac = autocomplete_new();
+    autocomplete_add(compression_ac, "on");
+    autocomplete_add(compression_ac, "off");
+    autocomplete_add(compression_ac, "stats");
+
+    xmlconsole_dir_ac = autocomplete_new();
+    autocomplete_add(xmlconsole_dir_ac, "in");
+    autocomplete_add(xmlconsole_dir_ac, "out");
+    autocomplete_add(xmlconsole_dir_ac, "all");
+
+    highlight_ac = autocomplete_new();
+    autocomplete_add(highlight_ac, "add");
+    autocomplete_add(highlight_ac, "remove");
+    autocomplete_add(highlight_ac, "list");
+
     alias_ac = autocomplete_new();
     autocomplete_add(alias_ac, "add");
     autocomplete_add(alias_ac, "remove");
@@ -1513,6 +1635,10 @@ cmd_uninit(void)
     autocomplete_free(connect_property_ac);
     autocomplete_free(statuses_ac);
     autocomplete_free(statuses_setting_ac);
+    autocomplete_free(xmlconsole_ac);
+    autocomplete_free(xmlconsole_dir_ac);
+    autocomplete_free(highlight_ac);
+    autocomplete_free(highlights_ac);
     autocomplete_free(alias_ac);
     autocomplete_free(aliases_ac);
     autocomplete_free(join_property_ac);
@@ -1528,6 +1654,7 @@ cmd_uninit(void)
     autocomplete_free(time_ac);
     autocomplete_free(resource_ac);
     autocomplete_free(inpblock_ac);
+    autocomplete_free(compression_ac);
 }
 
 gboolean
@@ -1606,6 +1733,22 @@ cmd_alias_remove(char *value)
     }
 }
 
+void
+cmd_highlight_add(char *value)
+{
+    if (highlights_ac != NULL) {
+        autocomplete_add(highlights_ac, value);
+    }
+}
+
+void
+cmd_highlight_remove(char *value)
+{
+    if (highlights_ac != NULL) {
+        autocomplete_remove(highlights_ac, value);
+    }
+}
+
 // Command autocompletion functions
 char*
 cmd_autocomplete(const char * const input)
@@ -1678,6 +1821,11 @@ cmd_reset_autocomplete()
     autocomplete_reset(connect_property_ac);
     autocomplete_reset(statuses_ac);
     autocomplete_reset(statuses_setting_ac);
+    autocomplete_reset(xmlconsole_ac);
+    autocomplete_reset(xmlconsole_dir_ac);
+    autocomplete_reset(compression_ac);
+    autocomplete_reset(highlight_ac);
+    autocomplete_reset(highlights_ac);
     autocomplete_reset(alias_ac);
     autocomplete_reset(aliases_ac);
     autocomplete_reset(join_property_ac);
@@ -1718,6 +1866,47 @@ cmd_reset_autocomplete()
     bookmark_autocomplete_reset();
 }
 
+/*
+ * Only commands are written to the history file, messages are left to the
+ * chat log settings. Commands that can carry a password, an OTR secret or a
+ * message stay in memory history only.
+ */
+gboolean
+cmd_history_savable(const char * const inp)
+{
+    if (inp[0] != '/') {
+        return FALSE;
+    }
+
+    gboolean savable = TRUE;
+    gchar **tokens = g_strsplit_set(inp, " \t", -1);
+
+    if (g_strcmp0(tokens[0], "/msg") == 0) {
+        if (tokens[1] != NULL && tokens[2] != NULL) {
+            savable = FALSE;
+        }
+    } else if (g_strcmp0(tokens[0], "/otr") == 0) {
+        if ((g_strcmp0(tokens[1], "secret") == 0) ||
+                (g_strcmp0(tokens[1], "question") == 0) ||
+                (g_strcmp0(tokens[1], "answer") == 0)) {
+            savable = FALSE;
+        }
+    } else if ((g_strcmp0(tokens[0], "/account") == 0) ||
+            (g_strcmp0(tokens[0], "/join") == 0) ||
+            (g_strcmp0(tokens[0], "/bookmark") == 0)) {
+        int i;
+        for (i = 1; tokens[i] != NULL; i++) {
+            if ((g_strcmp0(tokens[i], "password") == 0) || (g_strcmp0(tokens[i], "eval_password") == 0)) {
+                savable = FALSE;
+                break;
+            }
+        }
+    }
+
+    g_strfreev(tokens);
+    return savable;
+}
+
 /*
  * Take a line of input and process it, return TRUE if profanity is to
  * continue, FALSE otherwise
@@ -1928,6 +2117,7 @@ _cmd_execute_default(const char * inp)
 
         case WIN_CONSOLE:
         case WIN_XML:
+        case WIN_HIGHLIGHTS:
             cons_show("Unknown command: %s", inp);
             break;
 
@@ -1946,7 +2136,7 @@ _cmd_complete_parameters(const char * const input)
 
     // autocomplete boolean settings
     gchar *boolean_choices[] = { "/beep", "/intype", "/states", "/outtype",
-        "/flash", "/splash", "/chlog", "/grlog", "/mouse", "/history",
+        "/flash", "/multiline", "/splash", "/chlog", "/grlog", "/mouse", "/history",
         "/vercheck", "/privileges", "/presence", "/wrap" };
 
     for (i = 0; i < ARRAY_SIZE(boolean_choices); i++) {
@@ -2011,8 +2201,8 @@ _cmd_complete_parameters(const char * const input)
         }
     }
 
-    gchar *cmds[] = { "/help", "/prefs", "/disco", "/close", "/wins", "/subject", "/room", "/time" };
-    Autocomplete completers[] = { help_ac, prefs_ac, disco_ac, close_ac, wins_ac, subject_ac, room_ac, time_ac };
+    gchar *cmds[] = { "/help", "/prefs", "/disco", "/close", "/wins", "/subject", "/room", "/time", "/compression" };
+    Autocomplete completers[] = { help_ac, prefs_ac, disco_ac, close_ac, wins_ac, subject_ac, room_ac, time_ac, compression_ac };
 
     for (i = 0; i < ARRAY_SIZE(cmds); i++) {
         result = autocomplete_param_with_ac(input, cmds[i], completers[i], TRUE);
@@ -2036,6 +2226,8 @@ _cmd_complete_parameters(const char * const input)
     g_hash_table_insert(ac_funcs, "/otr",           _otr_autocomplete);
     g_hash_table_insert(ac_funcs, "/connect",       _connect_autocomplete);
     g_hash_table_insert(ac_funcs, "/statuses",      _statuses_autocomplete);
+    g_hash_table_insert(ac_funcs, "/xmlconsole",    _xmlconsole_autocomplete);
+    g_hash_table_insert(ac_funcs, "/highlight",     _highlight_autocomplete);
     g_hash_table_insert(ac_funcs, "/alias",         _alias_autocomplete);
     g_hash_table_insert(ac_funcs, "/join",          _join_autocomplete);
     g_hash_table_insert(ac_funcs, "/form",          _form_autocomplete);
@@ -2845,6 +3037,42 @@ _statuses_autocomplete(const char * const input)
     return NULL;
 }
 
+static char *
+_xmlconsole_autocomplete(const char * const input)
+{
+    char *result = NULL;
+
+    result = autocomplete_param_with_ac(input, "/xmlconsole dir", xmlconsole_dir_ac, TRUE);
+    if (result != NULL) {
+        return result;
+    }
+
+    result = autocomplete_param_with_ac(input, "/xmlconsole", xmlconsole_ac, TRUE);
+    if (result != NULL) {
+        return result;
+    }
+
+    return NULL;
+}
+
+static char *
+_highlight_autocomplete(const char * const input)
+{
+    char *result = NULL;
+
+    result = autocomplete_param_with_ac(input, "/highlight remove", highlights_ac, TRUE);
+    if (result != NULL) {
+        return result;
+    }
+
+    result = autocomplete_param_with_ac(input, "/highlight", highlight_ac, TRUE);
+    if (result != NULL) {
+        return result;
+    }
+
+    return NULL;
+}
+
 static char *
 _alias_autocomplete(const char * const input)
 {
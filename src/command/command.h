@@ -52,6 +52,8 @@ void cmd_autocomplete_add_form_fields(DataForm *form);
 void cmd_autocomplete_remove_form_fields(DataForm *form);
 void cmd_alias_add(char *value);
 void cmd_alias_remove(char *value);
+void cmd_highlight_add(char *value);
+void cmd_highlight_remove(char *value);
 
 gboolean cmd_process_input(char *inp);
 void cmd_execute_connect(const char * const account);
@@ -63,6 +65,7 @@ GSList * cmd_get_settings_help(void);
 GSList * cmd_get_presence_help(void);
 
 void cmd_history_append(char *inp);
+gboolean cmd_history_savable(const char * const inp);
 char *cmd_history_previous(char *inp);
 char *cmd_history_next(char *inp);
 
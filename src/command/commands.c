@@ -52,6 +52,7 @@
 #include "config/preferences.h"
 #include "config/theme.h"
 #include "contact.h"
+#include "detach.h"
 #include "roster_list.h"
 #include "jid.h"
 #include "log.h"
@@ -65,6 +66,8 @@
 #include "tools/tinyurl.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/bookmark.h"
+#include "xmpp/compression.h"
+#include "xmpp/xmltrace.h"
 #include "ui/ui.h"
 #include "ui/windows.h"
 
@@ -616,6 +619,15 @@ cmd_quit(gchar **args, struct cmd_help_t help)
     return FALSE;
 }
 
+gboolean
+cmd_detach(gchar **args, struct cmd_help_t help)
+{
+    if (!detach_session()) {
+        cons_show_error("Could not detach, see the log for details.");
+    }
+    return TRUE;
+}
+
 gboolean
 cmd_wins(gchar **args, struct cmd_help_t help)
 {
@@ -698,7 +710,7 @@ cmd_help(gchar **args, struct cmd_help_t help)
 
     } else if (strcmp(args[0], "basic") == 0) {
         gchar *filter[] = { "/about", "/clear", "/close", "/connect",
-            "/disconnect", "/help", "/msg", "/join", "/quit", "/vercheck",
+            "/disconnect", "/help", "/msg", "/join", "/quit", "/detach", "/vercheck",
             "/wins", "/ping" };
         _cmd_show_filtered_help("Basic commands", filter, ARRAY_SIZE(filter));
 
@@ -730,8 +742,8 @@ cmd_help(gchar **args, struct cmd_help_t help)
 
     } else if (strcmp(args[0], "settings") == 0) {
         gchar *filter[] = { "/account", "/autoaway", "/autoping", "/autoconnect", "/beep",
-            "/chlog", "/flash", "/gone", "/grlog", "/history", "/intype",
-            "/log", "/mouse", "/notify", "/outtype", "/prefs", "/priority",
+            "/chlog", "/compression", "/csi", "/flash", "/gone", "/grlog", "/history", "/inputhistory", "/intype",
+            "/log", "/mouse", "/multiline", "/notify", "/outtype", "/prefs", "/priority",
             "/reconnect", "/roster", "/splash", "/states", "/statuses", "/theme",
             "/titlebar", "/vercheck", "/privileges", "/occupants", "/presence", "/wrap" };
         _cmd_show_filtered_help("Settings commands", filter, ARRAY_SIZE(filter));
@@ -1682,14 +1694,14 @@ cmd_resource(gchar **args, struct cmd_help_t help)
 
         chatwin->resource_override = strdup(resource);
         chat_state_free(chatwin->state);
-        chatwin->state = chat_state_new();
+        chatwin->state = chat_state_new(chatwin->barejid);
         chat_session_resource_override(chatwin->barejid, resource);
         return TRUE;
 
     } else if (g_strcmp0(cmd, "off") == 0) {
         FREE_SET_NULL(chatwin->resource_override);
         chat_state_free(chatwin->state);
-        chatwin->state = chat_state_new();
+        chatwin->state = chat_state_new(chatwin->barejid);
         chat_session_remove(chatwin->barejid);
         return TRUE;
     } else {
@@ -3369,7 +3381,8 @@ cmd_notify(gchar **args, struct cmd_help_t help)
     // bad kind
     if ((strcmp(kind, "message") != 0) && (strcmp(kind, "typing") != 0) &&
             (strcmp(kind, "remind") != 0) && (strcmp(kind, "invite") != 0) &&
-            (strcmp(kind, "sub") != 0) && (strcmp(kind, "room") != 0)) {
+            (strcmp(kind, "sub") != 0) && (strcmp(kind, "room") != 0) &&
+            (strcmp(kind, "coalesce") != 0)) {
         cons_show("Usage: %s", help.usage);
 
     // set message setting
@@ -3497,6 +3510,22 @@ cmd_notify(gchar **args, struct cmd_help_t help)
             cons_show("Message reminder period set to %d seconds.", period);
         }
 
+    // set coalesce setting
+    } else if (strcmp(kind, "coalesce") == 0) {
+        gint period = atoi(args[1]);
+        if (period < 0) {
+            cons_show("Usage: /notify coalesce <seconds>");
+        } else {
+            prefs_set_notify_coalesce(period);
+            if (period == 0) {
+                cons_show("Notification coalescing disabled.");
+            } else if (period == 1) {
+                cons_show("Notification coalescing period set to 1 second.");
+            } else {
+                cons_show("Notification coalescing period set to %d seconds.", period);
+            }
+        }
+
     } else {
         cons_show("Unknown command: %s.", kind);
     }
@@ -3545,6 +3574,20 @@ cmd_inpblock(gchar **args, struct cmd_help_t help)
     return TRUE;
 }
 
+gboolean
+cmd_inputhistory(gchar **args, struct cmd_help_t help)
+{
+    int intval;
+
+    if (_strtoi(args[0], &intval, 1, 10000) == 0) {
+        prefs_set_inputhistory_size(intval);
+        ui_inp_history_set_size(intval);
+        cons_show("Input history set to %d lines.", intval);
+    }
+
+    return TRUE;
+}
+
 gboolean
 cmd_log(gchar **args, struct cmd_help_t help)
 {
@@ -3615,6 +3658,66 @@ cmd_reconnect(gchar **args, struct cmd_help_t help)
     return TRUE;
 }
 
+gboolean
+cmd_csi(gchar **args, struct cmd_help_t help)
+{
+    char *value = args[0];
+    int intval;
+
+    if (_strtoi(value, &intval, 0, INT_MAX) == 0) {
+        prefs_set_csi(intval);
+        if (intval == 0) {
+            cons_show("Client state indication disabled.");
+        } else {
+            cons_show("Client state inactive after %d seconds idle.", intval);
+        }
+    } else {
+        cons_show("Usage: %s", help.usage);
+    }
+
+    return TRUE;
+}
+
+gboolean
+cmd_compression(gchar **args, struct cmd_help_t help)
+{
+    if (g_strcmp0(args[0], "stats") != 0) {
+        gboolean result = _cmd_set_boolean_preference(args[0], help,
+            "Stream compression", PREF_COMPRESSION);
+        if (jabber_get_connection_status() == JABBER_CONNECTED) {
+            cons_show("The change will apply the next time you connect.");
+        }
+        return result;
+    }
+
+    CompressionStats stats;
+    compression_get_stats(&stats);
+    if (!stats.active) {
+        cons_show("Stream compression is not in use.");
+        return TRUE;
+    }
+
+    cons_show("Stream compression statistics:");
+    cons_show("Sent     : %" G_GUINT64_FORMAT " bytes", stats.sent);
+    cons_show("Received : %" G_GUINT64_FORMAT " bytes", stats.received);
+    if (!stats.estimated) {
+        cons_show("Compressed sizes are not available in this build.");
+        return TRUE;
+    }
+
+    guint64 total = stats.sent + stats.received;
+    guint64 compressed = stats.sent_compressed + stats.received_compressed;
+    if (total > 0 && compressed <= total) {
+        cons_show("Estimated compressed sent     : %" G_GUINT64_FORMAT " bytes", stats.sent_compressed);
+        cons_show("Estimated compressed received : %" G_GUINT64_FORMAT " bytes", stats.received_compressed);
+        cons_show("Estimated saving : %" G_GUINT64_FORMAT " bytes (ratio %.1f:1)", total - compressed,
+            compressed > 0 ? (double)total / compressed : 1.0);
+        cons_show("Estimates come from compressing a copy of the stream locally, the actual compressed sizes are not visible.");
+    }
+
+    return TRUE;
+}
+
 gboolean
 cmd_autoping(gchar **args, struct cmd_help_t help)
 {
@@ -3803,6 +3906,45 @@ cmd_vercheck(gchar **args, struct cmd_help_t help)
 gboolean
 cmd_xmlconsole(gchar **args, struct cmd_help_t help)
 {
+    char *filter = args[0];
+    char *value = args[0] ? args[1] : NULL;
+
+    if (filter != NULL) {
+        if (strcmp(filter, "clear") == 0) {
+            xmltrace_clear_filters();
+            cons_show("XML console filters cleared.");
+            return TRUE;
+        }
+
+        if (value == NULL) {
+            cons_show("Usage: %s", help.usage);
+            return TRUE;
+        }
+
+        if (strcmp(filter, "dir") == 0) {
+            if (strcmp(value, "in") == 0) {
+                xmltrace_set_dir_filter(XMLTRACE_DIR_RECV);
+            } else if (strcmp(value, "out") == 0) {
+                xmltrace_set_dir_filter(XMLTRACE_DIR_SENT);
+            } else if (strcmp(value, "all") == 0) {
+                xmltrace_set_dir_filter(XMLTRACE_DIR_ALL);
+            } else {
+                cons_show("Usage: %s", help.usage);
+                return TRUE;
+            }
+            cons_show("XML console direction filter set to: %s", value);
+        } else if (strcmp(filter, "element") == 0) {
+            xmltrace_set_element_filter(value);
+            cons_show("XML console element filter set to: %s", value);
+        } else if (strcmp(filter, "ns") == 0) {
+            xmltrace_set_ns_filter(value);
+            cons_show("XML console namespace filter set to: %s", value);
+        } else {
+            cons_show("Usage: %s", help.usage);
+        }
+        return TRUE;
+    }
+
     if (!ui_xmlconsole_exists()) {
         ui_create_xmlconsole_win();
     } else {
@@ -3812,6 +3954,56 @@ cmd_xmlconsole(gchar **args, struct cmd_help_t help)
     return TRUE;
 }
 
+gboolean
+cmd_highlight(gchar **args, struct cmd_help_t help)
+{
+    char *subcmd = args[0];
+
+    if (subcmd == NULL) {
+        if (!ui_highlights_exists()) {
+            ui_create_highlights_win();
+        } else {
+            ui_open_highlights_win();
+        }
+        return TRUE;
+    }
+
+    if (strcmp(subcmd, "list") == 0) {
+        GList *highlights = prefs_get_highlights();
+        cons_show_highlights(highlights);
+        prefs_free_highlights(highlights);
+        return TRUE;
+    }
+
+    char *word = args[1];
+    if (word == NULL) {
+        cons_show("Usage: %s", help.usage);
+        return TRUE;
+    }
+
+    if (strcmp(subcmd, "add") == 0) {
+        if (prefs_add_highlight(word)) {
+            cmd_highlight_add(word);
+            ui_highlights_changed();
+            cons_show("Highlight added: %s", word);
+        } else {
+            cons_show("Highlight already exists: %s", word);
+        }
+    } else if (strcmp(subcmd, "remove") == 0) {
+        if (prefs_remove_highlight(word)) {
+            cmd_highlight_remove(word);
+            ui_highlights_changed();
+            cons_show("Highlight removed: %s", word);
+        } else {
+            cons_show("No such highlight: %s", word);
+        }
+    } else {
+        cons_show("Usage: %s", help.usage);
+    }
+
+    return TRUE;
+}
+
 gboolean
 cmd_flash(gchar **args, struct cmd_help_t help)
 {
@@ -3819,6 +4011,13 @@ cmd_flash(gchar **args, struct cmd_help_t help)
         "Screen flash", PREF_FLASH);
 }
 
+gboolean
+cmd_multiline(gchar **args, struct cmd_help_t help)
+{
+    return _cmd_set_boolean_preference(args[0], help,
+        "Multi-line paste as one message", PREF_MULTILINE);
+}
+
 gboolean
 cmd_intype(gchar **args, struct cmd_help_t help)
 {
@@ -3987,6 +4186,7 @@ cmd_otr(gchar **args, struct cmd_help_t help)
         char *contact = args[2];
         if (contact == NULL) {
             prefs_set_string(PREF_OTR_POLICY, choice);
+            otr_policy_changed();
             cons_show("OTR policy is now set to: %s", choice);
             return TRUE;
         } else {
@@ -67,6 +67,8 @@ gboolean cmd_account(gchar **args, struct cmd_help_t help);
 gboolean cmd_autoaway(gchar **args, struct cmd_help_t help);
 gboolean cmd_autoconnect(gchar **args, struct cmd_help_t help);
 gboolean cmd_autoping(gchar **args, struct cmd_help_t help);
+gboolean cmd_csi(gchar **args, struct cmd_help_t help);
+gboolean cmd_compression(gchar **args, struct cmd_help_t help);
 gboolean cmd_away(gchar **args, struct cmd_help_t help);
 gboolean cmd_beep(gchar **args, struct cmd_help_t help);
 gboolean cmd_caps(gchar **args, struct cmd_help_t help);
@@ -80,6 +82,7 @@ gboolean cmd_disco(gchar **args, struct cmd_help_t help);
 gboolean cmd_disconnect(gchar **args, struct cmd_help_t help);
 gboolean cmd_dnd(gchar **args, struct cmd_help_t help);
 gboolean cmd_flash(gchar **args, struct cmd_help_t help);
+gboolean cmd_multiline(gchar **args, struct cmd_help_t help);
 gboolean cmd_gone(gchar **args, struct cmd_help_t help);
 gboolean cmd_grlog(gchar **args, struct cmd_help_t help);
 gboolean cmd_group(gchar **args, struct cmd_help_t help);
@@ -102,6 +105,7 @@ gboolean cmd_outtype(gchar **args, struct cmd_help_t help);
 gboolean cmd_prefs(gchar **args, struct cmd_help_t help);
 gboolean cmd_priority(gchar **args, struct cmd_help_t help);
 gboolean cmd_quit(gchar **args, struct cmd_help_t help);
+gboolean cmd_detach(gchar **args, struct cmd_help_t help);
 gboolean cmd_reconnect(gchar **args, struct cmd_help_t help);
 gboolean cmd_room(gchar **args, struct cmd_help_t help);
 gboolean cmd_rooms(gchar **args, struct cmd_help_t help);
@@ -123,6 +127,7 @@ gboolean cmd_wins(gchar **args, struct cmd_help_t help);
 gboolean cmd_xa(gchar **args, struct cmd_help_t help);
 gboolean cmd_alias(gchar **args, struct cmd_help_t help);
 gboolean cmd_xmlconsole(gchar **args, struct cmd_help_t help);
+gboolean cmd_highlight(gchar **args, struct cmd_help_t help);
 gboolean cmd_ping(gchar **args, struct cmd_help_t help);
 gboolean cmd_form(gchar **args, struct cmd_help_t help);
 gboolean cmd_occupants(gchar **args, struct cmd_help_t help);
@@ -137,6 +142,7 @@ gboolean cmd_wrap(gchar **args, struct cmd_help_t help);
 gboolean cmd_time(gchar **args, struct cmd_help_t help);
 gboolean cmd_resource(gchar **args, struct cmd_help_t help);
 gboolean cmd_inpblock(gchar **args, struct cmd_help_t help);
+gboolean cmd_inputhistory(gchar **args, struct cmd_help_t help);
 
 gboolean cmd_form_field(char *tag, gchar **args);
 
@@ -38,6 +38,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -107,6 +108,33 @@ p_hash_table_contains(GHashTable  *hash_table, gconstpointer key)
     return (found != NULL);
 }
 
+void
+p_queue_free_full(GQueue *queue, GDestroyNotify free_func)
+{
+    g_queue_foreach(queue, (GFunc) free_func, NULL);
+    g_queue_free(queue);
+}
+
+gint64
+p_get_monotonic_time(void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return ((gint64)ts.tv_sec * G_TIME_SPAN_SECOND) + (ts.tv_nsec / 1000);
+    }
+#endif
+    return p_get_real_time();
+}
+
+gint64
+p_get_real_time(void)
+{
+    GTimeVal tv;
+    g_get_current_time(&tv);
+    return ((gint64)tv.tv_sec * G_TIME_SPAN_SECOND) + tv.tv_usec;
+}
+
 gboolean
 create_dir(char *name)
 {
@@ -42,6 +42,8 @@
 #if !GLIB_CHECK_VERSION(2,28,0)
 #define g_slist_free_full(items, free_func)         p_slist_free_full(items, free_func)
 #define g_list_free_full(items, free_func)          p_list_free_full(items, free_func)
+#define g_get_monotonic_time()                      p_get_monotonic_time()
+#define g_get_real_time()                           p_get_real_time()
 #endif
 
 #if !GLIB_CHECK_VERSION(2,30,0)
@@ -51,6 +53,7 @@
 #if !GLIB_CHECK_VERSION(2,32,0)
 #define g_hash_table_add(hash_table, key)           p_hash_table_add(hash_table, key)
 #define g_hash_table_contains(hash_table, key)      p_hash_table_contains(hash_table, key)
+#define g_queue_free_full(queue, free_func)         p_queue_free_full(queue, free_func)
 #endif
 
 #ifndef NOTIFY_CHECK_VERSION
@@ -98,6 +101,9 @@ void p_slist_free_full(GSList *items, GDestroyNotify free_func);
 void p_list_free_full(GList *items, GDestroyNotify free_func);
 gboolean p_hash_table_add(GHashTable *hash_table, gpointer key);
 gboolean p_hash_table_contains(GHashTable  *hash_table, gconstpointer  key);
+void p_queue_free_full(GQueue *queue, GDestroyNotify free_func);
+gint64 p_get_monotonic_time(void);
+gint64 p_get_real_time(void);
 
 gboolean create_dir(char *name);
 gboolean mkdir_recursive(const char *dir);
@@ -53,6 +53,10 @@ static GKeyFile *accounts;
 static Autocomplete all_ac;
 static Autocomplete enabled_ac;
 
+// accounts built from the accounts file, keyed by name, dropped when changed
+static GHashTable *account_cache;
+static GSList *listeners;
+
 // used to rename account (copies properties to new account)
 static gchar *string_keys[] = {
     "jid",
@@ -70,6 +74,7 @@ static gchar *string_keys[] = {
 
 static void _fix_legacy_accounts(const char * const account_name);
 static void _save_accounts(void);
+static void _account_changed(const char * const account_name);
 static gchar * _get_accounts_file(void);
 static void _remove_from_list(GKeyFile *accounts, const char * const account_name, const char * const key, const char * const contact_jid);
 
@@ -87,6 +92,7 @@ accounts_load(void)
     }
 
     accounts = g_key_file_new();
+    account_cache = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)account_free);
     g_key_file_load_from_file(accounts, accounts_loc, G_KEY_FILE_KEEP_COMMENTS,
         NULL);
 
@@ -114,6 +120,10 @@ accounts_close(void)
     autocomplete_free(all_ac);
     autocomplete_free(enabled_ac);
     g_key_file_free(accounts);
+    g_hash_table_destroy(account_cache);
+    account_cache = NULL;
+    g_slist_free(listeners);
+    listeners = NULL;
 }
 
 char *
@@ -199,6 +209,7 @@ accounts_remove(const char *account_name)
 {
     int r = g_key_file_remove_group(accounts, account_name, NULL);
     _save_accounts();
+    _account_changed(account_name);
     autocomplete_remove(all_ac, account_name);
     autocomplete_remove(enabled_ac, account_name);
     return r;
@@ -210,6 +221,30 @@ accounts_get_list(void)
     return g_key_file_get_groups(accounts, NULL);
 }
 
+const ProfAccount*
+accounts_get_account_ref(const char * const name)
+{
+    if (name == NULL) {
+        return NULL;
+    }
+
+    ProfAccount *account = g_hash_table_lookup(account_cache, name);
+    if (account == NULL) {
+        account = accounts_get_account(name);
+        if (account != NULL) {
+            g_hash_table_insert(account_cache, strdup(name), account);
+        }
+    }
+
+    return account;
+}
+
+void
+accounts_add_listener(accounts_changed_func func)
+{
+    listeners = g_slist_append(listeners, func);
+}
+
 ProfAccount*
 accounts_get_account(const char * const name)
 {
@@ -307,6 +342,7 @@ accounts_enable(const char * const name)
     if (g_key_file_has_group(accounts, name)) {
         g_key_file_set_boolean(accounts, name, "enabled", TRUE);
         _save_accounts();
+        _account_changed(name);
         autocomplete_add(enabled_ac, name);
         return TRUE;
     } else {
@@ -320,6 +356,7 @@ accounts_disable(const char * const name)
     if (g_key_file_has_group(accounts, name)) {
         g_key_file_set_boolean(accounts, name, "enabled", FALSE);
         _save_accounts();
+        _account_changed(name);
         autocomplete_remove(enabled_ac, name);
         return TRUE;
     } else {
@@ -364,6 +401,8 @@ accounts_rename(const char * const account_name, const char * const new_name)
 
     g_key_file_remove_group(accounts, account_name, NULL);
     _save_accounts();
+    _account_changed(account_name);
+    _account_changed(new_name);
 
     autocomplete_remove(all_ac, account_name);
     autocomplete_add(all_ac, new_name);
@@ -404,6 +443,7 @@ accounts_set_jid(const char * const account_name, const char * const value)
             }
 
             _save_accounts();
+            _account_changed(account_name);
         }
     }
 }
@@ -414,6 +454,7 @@ accounts_set_server(const char * const account_name, const char * const value)
     if (accounts_account_exists(account_name)) {
         g_key_file_set_string(accounts, account_name, "server", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -423,6 +464,7 @@ accounts_set_port(const char * const account_name, const int value)
     if (value != 0) {
         g_key_file_set_integer(accounts, account_name, "port", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -432,6 +474,7 @@ accounts_set_resource(const char * const account_name, const char * const value)
     if (accounts_account_exists(account_name)) {
         g_key_file_set_string(accounts, account_name, "resource", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -441,6 +484,7 @@ accounts_set_password(const char * const account_name, const char * const value)
     if (accounts_account_exists(account_name)) {
         g_key_file_set_string(accounts, account_name, "password", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -450,6 +494,7 @@ accounts_set_eval_password(const char * const account_name, const char * const v
     if (accounts_account_exists(account_name)) {
         g_key_file_set_string(accounts, account_name, "eval_password", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -459,6 +504,7 @@ accounts_clear_password(const char * const account_name)
     if (accounts_account_exists(account_name)) {
         g_key_file_remove_key(accounts, account_name, "password", NULL);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -468,6 +514,7 @@ accounts_clear_eval_password(const char * const account_name)
     if (accounts_account_exists(account_name)) {
         g_key_file_remove_key(accounts, account_name, "eval_password", NULL);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -477,6 +524,7 @@ accounts_clear_server(const char * const account_name)
     if (accounts_account_exists(account_name)) {
         g_key_file_remove_key(accounts, account_name, "server", NULL);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -486,6 +534,7 @@ accounts_clear_port(const char * const account_name)
     if (accounts_account_exists(account_name)) {
         g_key_file_remove_key(accounts, account_name, "port", NULL);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -495,6 +544,7 @@ accounts_clear_otr(const char * const account_name)
     if (accounts_account_exists(account_name)) {
         g_key_file_remove_key(accounts, account_name, "otr.policy", NULL);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -563,6 +613,7 @@ accounts_add_otr_policy(const char * const account_name, const char * const cont
         }
 
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -616,6 +667,7 @@ accounts_set_muc_service(const char * const account_name, const char * const val
     if (accounts_account_exists(account_name)) {
         g_key_file_set_string(accounts, account_name, "muc.service", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -625,6 +677,7 @@ accounts_set_muc_nick(const char * const account_name, const char * const value)
     if (accounts_account_exists(account_name)) {
         g_key_file_set_string(accounts, account_name, "muc.nick", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -634,6 +687,7 @@ accounts_set_otr_policy(const char * const account_name, const char * const valu
     if (accounts_account_exists(account_name)) {
         g_key_file_set_string(accounts, account_name, "otr.policy", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -643,6 +697,7 @@ accounts_set_priority_online(const char * const account_name, const gint value)
     if (accounts_account_exists(account_name)) {
         g_key_file_set_integer(accounts, account_name, "priority.online", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -652,6 +707,7 @@ accounts_set_priority_chat(const char * const account_name, const gint value)
     if (accounts_account_exists(account_name)) {
         g_key_file_set_integer(accounts, account_name, "priority.chat", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -661,6 +717,7 @@ accounts_set_priority_away(const char * const account_name, const gint value)
     if (accounts_account_exists(account_name)) {
         g_key_file_set_integer(accounts, account_name, "priority.away", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -670,6 +727,7 @@ accounts_set_priority_xa(const char * const account_name, const gint value)
     if (accounts_account_exists(account_name)) {
         g_key_file_set_integer(accounts, account_name, "priority.xa", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -679,6 +737,7 @@ accounts_set_priority_dnd(const char * const account_name, const gint value)
     if (accounts_account_exists(account_name)) {
         g_key_file_set_integer(accounts, account_name, "priority.dnd", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -732,6 +791,7 @@ accounts_set_last_presence(const char * const account_name, const char * const v
     if (accounts_account_exists(account_name)) {
         g_key_file_set_string(accounts, account_name, "presence.last", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -741,6 +801,7 @@ accounts_set_login_presence(const char * const account_name, const char * const
     if (accounts_account_exists(account_name)) {
         g_key_file_set_string(accounts, account_name, "presence.login", value);
         _save_accounts();
+        _account_changed(account_name);
     }
 }
 
@@ -852,6 +913,19 @@ _fix_legacy_accounts(const char * const account_name)
     jid_destroy(jid);
 }
 
+static void
+_account_changed(const char * const account_name)
+{
+    g_hash_table_remove(account_cache, account_name);
+
+    GSList *curr = listeners;
+    while (curr != NULL) {
+        accounts_changed_func func = curr->data;
+        func(account_name);
+        curr = g_slist_next(curr);
+    }
+}
+
 static void
 _save_accounts(void)
 {
@@ -40,6 +40,8 @@
 #include "common.h"
 #include "config/account.h"
 
+typedef void (*accounts_changed_func)(const char * const account_name);
+
 void accounts_load(void);
 void accounts_close(void);
 
@@ -51,6 +53,8 @@ void accounts_add(const char *jid, const char *altdomain, const int port);
 int  accounts_remove(const char *jid);
 gchar** accounts_get_list(void);
 ProfAccount* accounts_get_account(const char * const name);
+const ProfAccount* accounts_get_account_ref(const char * const name);
+void accounts_add_listener(accounts_changed_func func);
 gboolean accounts_enable(const char * const name);
 gboolean accounts_disable(const char * const name);
 gboolean accounts_rename(const char * const account_name,
@@ -63,6 +63,7 @@
 #define PREF_GROUP_OTR "otr"
 
 #define INPBLOCK_DEFAULT 1000
+#define INPUTHISTORY_SIZE_DEFAULT 100
 
 static gchar *prefs_loc;
 static GKeyFile *prefs;
@@ -71,6 +72,7 @@ gint log_maxsize = 0;
 static Autocomplete boolean_choice_ac;
 
 static void _save_prefs(void);
+static void _set_highlights(GList *highlights);
 static gchar * _get_preferences_file(void);
 static const char * _get_group(preference_t pref);
 static const char * _get_key(preference_t pref);
@@ -257,6 +259,19 @@ prefs_set_notify_remind(gint value)
     _save_prefs();
 }
 
+gint
+prefs_get_notify_coalesce(void)
+{
+    return g_key_file_get_integer(prefs, PREF_GROUP_NOTIFICATIONS, "coalesce", NULL);
+}
+
+void
+prefs_set_notify_coalesce(gint value)
+{
+    g_key_file_set_integer(prefs, PREF_GROUP_NOTIFICATIONS, "coalesce", value);
+    _save_prefs();
+}
+
 gint
 prefs_get_max_log_size(void)
 {
@@ -290,6 +305,22 @@ void prefs_set_inpblock(gint value)
     _save_prefs();
 }
 
+gint prefs_get_inputhistory_size(void)
+{
+    int val = g_key_file_get_integer(prefs, PREF_GROUP_UI, "inputhistory.size", NULL);
+    if (val == 0) {
+        return INPUTHISTORY_SIZE_DEFAULT;
+    } else {
+        return val;
+    }
+}
+
+void prefs_set_inputhistory_size(gint value)
+{
+    g_key_file_set_integer(prefs, PREF_GROUP_UI, "inputhistory.size", value);
+    _save_prefs();
+}
+
 gint
 prefs_get_priority(void)
 {
@@ -326,6 +357,23 @@ prefs_set_autoping(gint value)
     _save_prefs();
 }
 
+gint
+prefs_get_csi(void)
+{
+    if (!g_key_file_has_key(prefs, PREF_GROUP_CONNECTION, "csi", NULL)) {
+        return 60;
+    } else {
+        return g_key_file_get_integer(prefs, PREF_GROUP_CONNECTION, "csi", NULL);
+    }
+}
+
+void
+prefs_set_csi(gint value)
+{
+    g_key_file_set_integer(prefs, PREF_GROUP_CONNECTION, "csi", value);
+    _save_prefs();
+}
+
 gint
 prefs_get_autoaway_time(void)
 {
@@ -468,6 +516,83 @@ prefs_free_aliases(GList *aliases)
     g_list_free_full(aliases, (GDestroyNotify)_free_alias);
 }
 
+gboolean
+prefs_add_highlight(const char * const entry)
+{
+    GList *highlights = prefs_get_highlights();
+    if (g_list_find_custom(highlights, entry, (GCompareFunc)g_strcmp0) != NULL) {
+        prefs_free_highlights(highlights);
+        return FALSE;
+    }
+
+    highlights = g_list_append(highlights, strdup(entry));
+    _set_highlights(highlights);
+    prefs_free_highlights(highlights);
+
+    return TRUE;
+}
+
+gboolean
+prefs_remove_highlight(const char * const entry)
+{
+    GList *highlights = prefs_get_highlights();
+    GList *found = g_list_find_custom(highlights, entry, (GCompareFunc)g_strcmp0);
+    if (found == NULL) {
+        prefs_free_highlights(highlights);
+        return FALSE;
+    }
+
+    free(found->data);
+    highlights = g_list_delete_link(highlights, found);
+    _set_highlights(highlights);
+    prefs_free_highlights(highlights);
+
+    return TRUE;
+}
+
+GList *
+prefs_get_highlights(void)
+{
+    GList *result = NULL;
+    gsize len;
+    gchar **list = g_key_file_get_string_list(prefs, PREF_GROUP_UI, "highlight", &len, NULL);
+    if (list != NULL) {
+        int i;
+        for (i = 0; i < len; i++) {
+            result = g_list_append(result, strdup(list[i]));
+        }
+        g_strfreev(list);
+    }
+
+    return result;
+}
+
+void
+prefs_free_highlights(GList *highlights)
+{
+    g_list_free_full(highlights, free);
+}
+
+static void
+_set_highlights(GList *highlights)
+{
+    if (highlights == NULL) {
+        g_key_file_remove_key(prefs, PREF_GROUP_UI, "highlight", NULL);
+    } else {
+        guint len = g_list_length(highlights);
+        const gchar* list[len + 1];
+        int i = 0;
+        GList *curr = highlights;
+        while (curr != NULL) {
+            list[i++] = curr->data;
+            curr = g_list_next(curr);
+        }
+        list[i] = NULL;
+        g_key_file_set_string_list(prefs, PREF_GROUP_UI, "highlight", list, len);
+    }
+    _save_prefs();
+}
+
 static void
 _save_prefs(void)
 {
@@ -532,6 +657,7 @@ _get_group(preference_t pref)
         case PREF_RESOURCE_TITLE:
         case PREF_RESOURCE_MESSAGE:
         case PREF_INPBLOCK_DYNAMIC:
+        case PREF_MULTILINE:
             return PREF_GROUP_UI;
         case PREF_STATES:
         case PREF_OUTTYPE:
@@ -558,6 +684,7 @@ _get_group(preference_t pref)
             return PREF_GROUP_PRESENCE;
         case PREF_CONNECT_ACCOUNT:
         case PREF_DEFAULT_ACCOUNT:
+        case PREF_COMPRESSION:
             return PREF_GROUP_CONNECTION;
         case PREF_OTR_WARN:
         case PREF_OTR_LOG:
@@ -675,6 +802,10 @@ _get_key(preference_t pref)
             return "resource.message";
         case PREF_INPBLOCK_DYNAMIC:
             return "inpblock.dynamic";
+        case PREF_COMPRESSION:
+            return "compression";
+        case PREF_MULTILINE:
+            return "multiline";
         default:
             return NULL;
     }
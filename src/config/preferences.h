@@ -101,7 +101,9 @@ typedef enum {
     PREF_OTR_POLICY,
     PREF_RESOURCE_TITLE,
     PREF_RESOURCE_MESSAGE,
-    PREF_INPBLOCK_DYNAMIC
+    PREF_INPBLOCK_DYNAMIC,
+    PREF_COMPRESSION,
+    PREF_MULTILINE
 } preference_t;
 
 typedef struct prof_alias_t {
@@ -122,6 +124,8 @@ void prefs_set_gone(gint value);
 
 void prefs_set_notify_remind(gint period);
 gint prefs_get_notify_remind(void);
+void prefs_set_notify_coalesce(gint period);
+gint prefs_get_notify_coalesce(void);
 
 void prefs_set_max_log_size(gint value);
 gint prefs_get_max_log_size(void);
@@ -130,8 +134,12 @@ void prefs_set_reconnect(gint value);
 gint prefs_get_reconnect(void);
 void prefs_set_autoping(gint value);
 gint prefs_get_autoping(void);
+void prefs_set_csi(gint value);
+gint prefs_get_csi(void);
 gint prefs_get_inpblock(void);
 void prefs_set_inpblock(gint value);
+gint prefs_get_inputhistory_size(void);
+void prefs_set_inputhistory_size(gint value);
 
 void prefs_set_occupants_size(gint value);
 gint prefs_get_occupants_size(void);
@@ -149,6 +157,11 @@ char* prefs_get_alias(const char * const name);
 GList* prefs_get_aliases(void);
 void prefs_free_aliases(GList *aliases);
 
+gboolean prefs_add_highlight(const char * const entry);
+gboolean prefs_remove_highlight(const char * const entry);
+GList* prefs_get_highlights(void);
+void prefs_free_highlights(GList *highlights);
+
 gboolean prefs_get_boolean(preference_t pref);
 void prefs_set_boolean(preference_t pref, gboolean value);
 char * prefs_get_string(preference_t pref);
@@ -52,9 +52,13 @@ struct p_contact_t {
     gboolean pending_out;
     GDateTime *last_activity;
     GHashTable *available_resources;
+    // highest priority, most available resource, NULL when offline
+    Resource *most_available;
     Autocomplete resource_ac;
 };
 
+static void _update_most_available(PContact contact);
+
 PContact
 p_contact_new(const char * const barejid, const char * const name,
     GSList *groups, const char * const subscription,
@@ -86,6 +90,7 @@ p_contact_new(const char * const barejid, const char * const name,
 
     contact->available_resources = g_hash_table_new_full(g_str_hash, g_str_equal, free,
         (GDestroyNotify)resource_destroy);
+    contact->most_available = NULL;
 
     contact->resource_ac = autocomplete_new();
 
@@ -137,6 +142,9 @@ p_contact_remove_resource(PContact contact, const char * const resource)
 {
     gboolean result = g_hash_table_remove(contact->available_resources, resource);
     autocomplete_remove(contact->resource_ac, resource);
+    if (result) {
+        _update_most_available(contact);
+    }
 
     return result;
 }
@@ -232,7 +240,7 @@ _highest_presence(Resource *first, Resource *second)
     }
 }
 
-Resource *
+static Resource *
 _get_most_available_resource(PContact contact)
 {
     // find resource with highest priority, if more than one,
@@ -266,19 +274,28 @@ _get_most_available_resource(PContact contact)
     return highest;
 }
 
+// called whenever a resource is set or removed, so readers never walk the resources
+static void
+_update_most_available(PContact contact)
+{
+    if (g_hash_table_size(contact->available_resources) == 0) {
+        contact->most_available = NULL;
+    } else {
+        contact->most_available = _get_most_available_resource(contact);
+    }
+}
+
 const char *
 p_contact_presence(const PContact contact)
 {
     assert(contact != NULL);
 
     // no available resources, offline
-    if (g_hash_table_size(contact->available_resources) == 0) {
+    if (contact->most_available == NULL) {
         return "offline";
     }
 
-    Resource *resource = _get_most_available_resource(contact);
-
-    return string_from_resource_presence(resource->presence);
+    return string_from_resource_presence(contact->most_available->presence);
 }
 
 const char *
@@ -287,13 +304,11 @@ p_contact_status(const PContact contact)
     assert(contact != NULL);
 
     // no available resources, use offline message
-    if (g_hash_table_size(contact->available_resources) == 0) {
+    if (contact->most_available == NULL) {
         return contact->offline_message;
     }
 
-    Resource *resource = _get_most_available_resource(contact);
-
-    return resource->status;
+    return contact->most_available->status;
 }
 
 const char *
@@ -357,12 +372,12 @@ gboolean
 p_contact_is_available(const PContact contact)
 {
     // no available resources, unavailable
-    if (g_hash_table_size(contact->available_resources) == 0) {
+    if (contact->most_available == NULL) {
         return FALSE;
     }
 
     // if most available resource is CHAT or ONLINE, available
-    Resource *most_available = _get_most_available_resource(contact);
+    Resource *most_available = contact->most_available;
     if ((most_available->presence == RESOURCE_ONLINE) ||
         (most_available->presence == RESOURCE_CHAT)) {
         return TRUE;
@@ -382,6 +397,7 @@ p_contact_set_presence(const PContact contact, Resource *resource)
 {
     g_hash_table_replace(contact->available_resources, strdup(resource->name), resource);
     autocomplete_add(contact->resource_ac, resource->name);
+    _update_most_available(contact);
 }
 
 void
@@ -0,0 +1,512 @@
+/*
+ * detach.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+// for struct ucred
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+
+#include <glib.h>
+
+#include "detach.h"
+#include "log.h"
+#include "ui/ui.h"
+
+/*
+ * Keeping a session running without a terminal. /detach forks, the parent
+ * hands the terminal back to the shell and exits, and the child carries on
+ * with the connection, rooms, logs and windows, listening on a UNIX socket.
+ * 'profanity --attach' connects to the socket and passes over its terminal,
+ * which the session redraws into from the state it already holds.
+ *
+ * The client sends its terminal with one byte, then only sends
+ * DETACH_MSG_RESIZE when its window size changes. The session closes the
+ * connection when it lets go of the terminal.
+ *
+ * Whoever is on the other end of the socket gets the terminal, so the socket
+ * lives in a directory only we can use and both ends check that the peer runs
+ * as the same user.
+ *
+ * Only the thread calling fork() survives in the child, the GDBus worker
+ * thread libnotify relies on does not, so the detached session turns desktop
+ * notifications off rather than risk hanging on them.
+ */
+#define DETACH_MSG_ATTACH 'a'
+#define DETACH_MSG_RESIZE 'r'
+
+static gboolean detached = FALSE;
+static int listen_fd = -1;
+static int client_fd = -1;
+static volatile sig_atomic_t resized = 0;
+
+static int _listen(void);
+static void _release_terminal(void);
+static void _attach(int sock);
+static void _handle_winch(int sig);
+
+gboolean
+detach_session(void)
+{
+    if (detached) {
+        return FALSE;
+    }
+
+    // let go of a terminal passed over by 'profanity --attach'
+    if (client_fd >= 0) {
+        ui_suspend();
+        _release_terminal();
+        close(client_fd);
+        client_fd = -1;
+        detached = TRUE;
+        log_info("Detached from terminal");
+        return TRUE;
+    }
+
+    listen_fd = _listen();
+    if (listen_fd < 0) {
+        return FALSE;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        log_error("Could not detach: %s", strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        return FALSE;
+    }
+
+    // the parent leaves without logging out, the session lives on in the child
+    if (pid > 0) {
+        ui_suspend();
+        printf("Profanity detached, use 'profanity --attach' to return.\n");
+        fflush(stdout);
+        _exit(0);
+    }
+
+    setsid();
+    signal(SIGHUP, SIG_IGN);
+    notifier_forked();
+    _release_terminal();
+    ui_suspend();
+    detached = TRUE;
+    log_info("Detached from terminal, session pid %d", getpid());
+
+    return TRUE;
+}
+
+gboolean
+detach_is_detached(void)
+{
+    return detached;
+}
+
+void
+detach_wait_for_attach(int timeout_ms)
+{
+    if (listen_fd < 0) {
+        g_usleep(timeout_ms * 1000);
+        return;
+    }
+
+    struct pollfd pfd = { listen_fd, POLLIN, 0 };
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+        return;
+    }
+
+    int sock = accept(listen_fd, NULL, NULL);
+    if (sock < 0) {
+        return;
+    }
+    if (!detach_peer_is_user(sock)) {
+        log_warning("Refused attach from another user");
+        close(sock);
+        return;
+    }
+
+    _attach(sock);
+}
+
+// handle size changes from the attached terminal, and notice when it goes away
+void
+detach_check_attached(void)
+{
+    if (client_fd < 0) {
+        return;
+    }
+
+    struct pollfd pfd = { client_fd, POLLIN, 0 };
+    if (poll(&pfd, 1, 0) <= 0) {
+        return;
+    }
+
+    char msg;
+    ssize_t read_len = recv(client_fd, &msg, 1, 0);
+    if (read_len == 1 && msg == DETACH_MSG_RESIZE) {
+        ui_resume();
+    } else if (read_len <= 0) {
+        log_info("Attached terminal closed");
+        detach_session();
+    }
+}
+
+void
+detach_close(void)
+{
+    if (client_fd >= 0) {
+        close(client_fd);
+        client_fd = -1;
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+        char *path = detach_socket_path();
+        unlink(path);
+        free(path);
+    }
+    detached = FALSE;
+}
+
+// run by 'profanity --attach', returns the exit status
+int
+detach_attach_client(void)
+{
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+        fprintf(stderr, "Attaching needs a terminal.\n");
+        return 1;
+    }
+
+    char *dir = detach_socket_dir();
+    if (!g_file_test(dir, G_FILE_TEST_EXISTS)) {
+        fprintf(stderr, "No detached Profanity session found.\n");
+        free(dir);
+        return 1;
+    }
+    if (!detach_dir_is_private(dir)) {
+        fprintf(stderr, "Refusing to attach, %s must be a directory owned by you with mode 0700.\n", dir);
+        free(dir);
+        return 1;
+    }
+    free(dir);
+
+    char *path = detach_socket_path();
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    g_strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+    free(path);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0 || connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "No detached Profanity session found.\n");
+        if (sock >= 0) {
+            close(sock);
+        }
+        return 1;
+    }
+    if (!detach_peer_is_user(sock)) {
+        fprintf(stderr, "Refusing to attach, the session belongs to another user.\n");
+        close(sock);
+        return 1;
+    }
+
+    struct termios saved;
+    tcgetattr(STDIN_FILENO, &saved);
+    signal(SIGINT, SIG_IGN);
+    signal(SIGQUIT, SIG_IGN);
+    signal(SIGTSTP, SIG_IGN);
+    struct sigaction winch;
+    memset(&winch, 0, sizeof(winch));
+    winch.sa_handler = _handle_winch;
+    sigaction(SIGWINCH, &winch, NULL);
+
+    if (!detach_send_terminal(sock, STDIN_FILENO, STDOUT_FILENO)) {
+        fprintf(stderr, "Could not pass the terminal to the session.\n");
+        close(sock);
+        return 1;
+    }
+
+    // wait for the session to let go of the terminal
+    while (TRUE) {
+        char msg;
+        ssize_t read_len = recv(sock, &msg, 1, 0);
+        if (read_len < 0 && errno == EINTR) {
+            if (resized) {
+                resized = 0;
+                msg = DETACH_MSG_RESIZE;
+                send(sock, &msg, 1, 0);
+            }
+            continue;
+        }
+        if (read_len <= 0) {
+            break;
+        }
+    }
+
+    tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    close(sock);
+
+    return 0;
+}
+
+// the per user runtime directory when there is one, otherwise our own directory in tmp
+char *
+detach_socket_dir(void)
+{
+    const gchar *runtime_dir = g_getenv("XDG_RUNTIME_DIR");
+    gchar *dir = NULL;
+    if (runtime_dir && g_path_is_absolute(runtime_dir)) {
+        dir = g_strdup_printf("%s/profanity", runtime_dir);
+    } else {
+        dir = g_strdup_printf("%s/profanity-%d", g_get_tmp_dir(), (int)getuid());
+    }
+
+    char *result = strdup(dir);
+    g_free(dir);
+
+    return result;
+}
+
+char *
+detach_socket_path(void)
+{
+    char *dir = detach_socket_dir();
+    gchar *path = g_strdup_printf("%s/session.sock", dir);
+    free(dir);
+
+    char *result = strdup(path);
+    g_free(path);
+
+    return result;
+}
+
+// a real directory, not a link to one, that only we can get into
+gboolean
+detach_dir_is_private(const char * const dir)
+{
+    struct stat st;
+    if (lstat(dir, &st) != 0) {
+        return FALSE;
+    }
+
+    return S_ISDIR(st.st_mode) && st.st_uid == getuid() && (st.st_mode & 0777) == S_IRWXU;
+}
+
+gboolean
+detach_peer_is_user(int sock)
+{
+#ifdef __linux__
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) {
+        return FALSE;
+    }
+
+    return cred.uid == getuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    if (getpeereid(sock, &uid, &gid) != 0) {
+        return FALSE;
+    }
+
+    return uid == getuid();
+#endif
+}
+
+gboolean
+detach_send_terminal(int sock, int in_fd, int out_fd)
+{
+    char msg = DETACH_MSG_ATTACH;
+    struct iovec iov = { &msg, 1 };
+    int fds[2] = { in_fd, out_fd };
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    return sendmsg(sock, &hdr, 0) == 1;
+}
+
+gboolean
+detach_receive_terminal(int sock, int *in_fd, int *out_fd)
+{
+    char msg = 0;
+    struct iovec iov = { &msg, 1 };
+    int fds[2] = { -1, -1 };
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+
+    if (recvmsg(sock, &hdr, 0) != 1 || msg != DETACH_MSG_ATTACH) {
+        return FALSE;
+    }
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+    if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS
+            || cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) {
+        return FALSE;
+    }
+
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    *in_fd = fds[0];
+    *out_fd = fds[1];
+
+    return TRUE;
+}
+
+static int
+_listen(void)
+{
+    // another user could have made the directory first, or put their own socket in it
+    char *dir = detach_socket_dir();
+    if (mkdir(dir, S_IRWXU) == 0) {
+        chmod(dir, S_IRWXU);
+    } else if (errno != EEXIST) {
+        log_error("Could not create %s: %s", dir, strerror(errno));
+        free(dir);
+        return -1;
+    }
+    if (!detach_dir_is_private(dir)) {
+        log_error("Not detaching, %s must be a directory owned by you with mode 0700", dir);
+        free(dir);
+        return -1;
+    }
+    free(dir);
+
+    char *path = detach_socket_path();
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    g_strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+        log_error("Could not create session socket: %s", strerror(errno));
+        free(path);
+        return -1;
+    }
+
+    // only one detached session, but clear up after one that has gone
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        log_error("A detached session is already listening on %s", path);
+        close(sock);
+        free(path);
+        return -1;
+    }
+    unlink(path);
+
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(sock, 1) != 0) {
+        log_error("Could not listen on %s: %s", path, strerror(errno));
+        close(sock);
+        free(path);
+        return -1;
+    }
+    chmod(path, S_IRUSR | S_IWUSR);
+    free(path);
+
+    return sock;
+}
+
+// point stdin, stdout and stderr at /dev/null so drawing goes nowhere
+static void
+_release_terminal(void)
+{
+    int null_fd = open("/dev/null", O_RDWR);
+    if (null_fd < 0) {
+        return;
+    }
+    dup2(null_fd, STDIN_FILENO);
+    dup2(null_fd, STDOUT_FILENO);
+    dup2(null_fd, STDERR_FILENO);
+    if (null_fd > STDERR_FILENO) {
+        close(null_fd);
+    }
+}
+
+static void
+_attach(int sock)
+{
+    int in_fd, out_fd;
+    if (!detach_receive_terminal(sock, &in_fd, &out_fd)) {
+        log_warning("Attach attempt without a terminal");
+        close(sock);
+        return;
+    }
+
+    dup2(in_fd, STDIN_FILENO);
+    dup2(out_fd, STDOUT_FILENO);
+    close(in_fd);
+    close(out_fd);
+
+    client_fd = sock;
+    detached = FALSE;
+    log_info("Attached to terminal");
+    ui_resume();
+}
+
+static void
+_handle_winch(int sig)
+{
+    resized = 1;
+}
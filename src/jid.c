@@ -41,6 +41,14 @@
 
 #include "common.h"
 
+// interned jids with only the table's reference are dropped once it grows past this
+#define JID_INTERN_MAX 1024
+
+static GHashTable *interned = NULL;
+
+static void _jid_unref(Jid *jid);
+static gboolean _jid_unused(gpointer key, gpointer value, gpointer user_data);
+
 Jid *
 jid_create(const gchar * const str)
 {
@@ -74,6 +82,7 @@ jid_create(const gchar * const str)
     result->resourcepart = NULL;
     result->barejid = NULL;
     result->fulljid = NULL;
+    result->refs = 0;
 
     gchar *atp = g_utf8_strchr(trimmed, -1, '@');
     gchar *slashp = g_utf8_strchr(trimmed, -1, '/');
@@ -130,6 +139,67 @@ jid_destroy(Jid *jid)
     }
 }
 
+/*
+ * Return a shared, immutable jid for str, parsing it only the first time it is seen.
+ * The caller owns a reference and must give it back with jid_release, never jid_destroy.
+ * Returns NULL if str is not a valid jid.
+ */
+Jid *
+jid_intern(const gchar * const str)
+{
+    if (str == NULL) {
+        return NULL;
+    }
+
+    if (interned == NULL) {
+        interned = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)_jid_unref);
+    }
+
+    Jid *jid = g_hash_table_lookup(interned, str);
+    if (jid) {
+        return jid_ref(jid);
+    }
+
+    jid = jid_create(str);
+    if (jid == NULL) {
+        return NULL;
+    }
+
+    if (g_hash_table_size(interned) >= JID_INTERN_MAX) {
+        g_hash_table_foreach_remove(interned, _jid_unused, NULL);
+    }
+
+    // one reference for the table, one for the caller
+    jid->refs = 2;
+    g_hash_table_insert(interned, jid->str, jid);
+
+    return jid;
+}
+
+Jid *
+jid_ref(Jid *jid)
+{
+    jid->refs++;
+    return jid;
+}
+
+void
+jid_release(Jid *jid)
+{
+    if (jid != NULL) {
+        _jid_unref(jid);
+    }
+}
+
+void
+jid_intern_clear(void)
+{
+    if (interned) {
+        g_hash_table_destroy(interned);
+        interned = NULL;
+    }
+}
+
 gboolean
 jid_is_valid_room_form(Jid *jid)
 {
@@ -189,4 +259,19 @@ jid_fulljid_or_barejid(Jid *jid)
     } else {
         return jid->barejid;
     }
-}
\ No newline at end of file
+}
+static void
+_jid_unref(Jid *jid)
+{
+    jid->refs--;
+    if (jid->refs == 0) {
+        jid_destroy(jid);
+    }
+}
+
+static gboolean
+_jid_unused(gpointer key, gpointer value, gpointer user_data)
+{
+    Jid *jid = value;
+    return jid->refs == 1;
+}
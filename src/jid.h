@@ -44,6 +44,8 @@ struct jid_t {
     char *resourcepart;
     char *barejid;
     char *fulljid;
+    // references held on an interned jid, unused for jids from jid_create
+    int refs;
 };
 
 typedef struct jid_t Jid;
@@ -52,6 +54,11 @@ Jid * jid_create(const gchar * const str);
 Jid * jid_create_from_bare_and_resource(const char * const room, const char * const nick);
 void jid_destroy(Jid *jid);
 
+Jid * jid_intern(const gchar * const str);
+Jid * jid_ref(Jid *jid);
+void jid_release(Jid *jid);
+void jid_intern_clear(void);
+
 gboolean jid_is_valid_room_form(Jid *jid);
 char * create_fulljid(const char * const barejid, const char * const resource);
 char * get_nick_from_full_jid(const char * const full_room_jid);
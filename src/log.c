@@ -49,13 +49,27 @@
 
 #define PROF "prof"
 
+// flush buffered main log lines when this many bytes are pending
+#define LOG_BUFFER_MAX 8192
+// or when this many seconds have passed since the last flush
+#define LOG_FLUSH_INTERVAL 1.0
+
 static FILE *logp;
 GString *mainlogfile;
 
 static GTimeZone *tz;
-static GDateTime *dt;
 static log_level_t level_filter;
 
+// pending lines not yet written to logp
+static GString *logbuf;
+static GTimer *flush_timer;
+// bytes in the main log file, including buffered lines
+static gint64 logsize;
+
+// timestamp is formatted at most once per second
+static gint64 stamp_sec = -1;
+static gchar *stamp_str;
+
 static GHashTable *logs;
 static GHashTable *groupchat_logs;
 static GDateTime *session_started;
@@ -78,10 +92,17 @@ static gchar * _get_chatlog_dir(void);
 static gchar * _get_main_log_file(void);
 static void _rotate_log_file(void);
 static char* _log_string_from_level(log_level_t level);
+static const gchar * _log_timestamp(void);
+static void _log_write(void);
+static void _log_flush(void);
 
 void
 log_debug(const char * const msg, ...)
 {
+    if (level_filter > PROF_LEVEL_DEBUG || logp == NULL) {
+        return;
+    }
+
     va_list arg;
     va_start(arg, msg);
     GString *fmt_msg = g_string_new(NULL);
@@ -94,6 +115,10 @@ log_debug(const char * const msg, ...)
 void
 log_info(const char * const msg, ...)
 {
+    if (level_filter > PROF_LEVEL_INFO || logp == NULL) {
+        return;
+    }
+
     va_list arg;
     va_start(arg, msg);
     GString *fmt_msg = g_string_new(NULL);
@@ -106,6 +131,10 @@ log_info(const char * const msg, ...)
 void
 log_warning(const char * const msg, ...)
 {
+    if (level_filter > PROF_LEVEL_WARN || logp == NULL) {
+        return;
+    }
+
     va_list arg;
     va_start(arg, msg);
     GString *fmt_msg = g_string_new(NULL);
@@ -118,6 +147,10 @@ log_warning(const char * const msg, ...)
 void
 log_error(const char * const msg, ...)
 {
+    if (level_filter > PROF_LEVEL_ERROR || logp == NULL) {
+        return;
+    }
+
     va_list arg;
     va_start(arg, msg);
     GString *fmt_msg = g_string_new(NULL);
@@ -136,7 +169,17 @@ log_init(log_level_t filter)
     logp = fopen(log_file, "a");
     g_chmod(log_file, S_IRUSR | S_IWUSR);
     mainlogfile = g_string_new(log_file);
+
+    GStatBuf st;
+    if (g_stat(log_file, &st) == 0) {
+        logsize = st.st_size;
+    } else {
+        logsize = 0;
+    }
     free(log_file);
+
+    logbuf = g_string_sized_new(LOG_BUFFER_MAX);
+    flush_timer = g_timer_new();
 }
 
 void
@@ -161,38 +204,90 @@ log_get_filter(void)
 void
 log_close(void)
 {
+    _log_write();
     g_string_free(mainlogfile, TRUE);
+    g_string_free(logbuf, TRUE);
+    logbuf = NULL;
+    g_timer_destroy(flush_timer);
+    flush_timer = NULL;
     g_time_zone_unref(tz);
+    GFREE_SET_NULL(stamp_str);
+    stamp_sec = -1;
     if (logp != NULL) {
         fclose(logp);
+        logp = NULL;
     }
 }
 
 void
 log_msg(log_level_t level, const char * const area, const char * const msg)
 {
-    if (level >= level_filter && logp != NULL) {
-        dt = g_date_time_new_now(tz);
+    if (level < level_filter || logp == NULL) {
+        return;
+    }
+
+    gsize before = logbuf->len;
+    g_string_append_printf(logbuf, "%s: %s: %s: %s\n", _log_timestamp(), area,
+        _log_string_from_level(level), msg);
+    logsize += logbuf->len - before;
 
-        char *level_str = _log_string_from_level(level);
+    // errors are written straight away in case we are about to crash
+    if (level == PROF_LEVEL_ERROR || logbuf->len >= LOG_BUFFER_MAX ||
+            g_timer_elapsed(flush_timer, NULL) >= LOG_FLUSH_INTERVAL) {
+        _log_flush();
+    }
+}
 
-        gchar *date_fmt = g_date_time_format(dt, "%d/%m/%Y %H:%M:%S");
+void
+log_timed_flush(void)
+{
+    if (logp != NULL && logbuf->len > 0 &&
+            g_timer_elapsed(flush_timer, NULL) >= LOG_FLUSH_INTERVAL) {
+        _log_flush();
+    }
+}
 
-        fprintf(logp, "%s: %s: %s: %s\n", date_fmt, area, level_str, msg);
-        g_date_time_unref(dt);
+static void
+_log_write(void)
+{
+    if (logp == NULL || logbuf == NULL) {
+        return;
+    }
 
+    g_timer_start(flush_timer);
+    if (logbuf->len > 0) {
+        fwrite(logbuf->str, 1, logbuf->len, logp);
         fflush(logp);
-        g_free(date_fmt);
+        g_string_truncate(logbuf, 0);
+    }
+}
 
-        if (prefs_get_boolean(PREF_LOG_ROTATE)) {
-            long result = ftell(logp);
-            if (result != -1 && result >= prefs_get_max_log_size()) {
-                _rotate_log_file();
-            }
-        }
+static void
+_log_flush(void)
+{
+    _log_write();
+
+    if (logp != NULL && prefs_get_boolean(PREF_LOG_ROTATE) &&
+            logsize >= prefs_get_max_log_size()) {
+        _rotate_log_file();
     }
 }
 
+static const gchar *
+_log_timestamp(void)
+{
+    gint64 now_sec = g_get_real_time() / G_USEC_PER_SEC;
+    if (now_sec != stamp_sec) {
+        GDateTime *dt = g_date_time_new_now(tz);
+        g_free(stamp_str);
+        stamp_str = g_date_time_format(dt, "%d/%m/%Y %H:%M:%S");
+        g_date_time_unref(dt);
+        stamp_sec = now_sec;
+    }
+
+    return stamp_str;
+}
+
 log_level_t
 log_level_from_string(char *log_level)
 {
@@ -502,6 +597,49 @@ _get_log_filename(const char * const other, const char * const login,
     return result;
 }
 
+/*
+ * File next to the room logs recording what has been seen in each room
+ */
+char *
+groupchat_log_seen_filename(const gchar * const login)
+{
+    gchar *chatlogs_dir = _get_chatlog_dir();
+    GString *seen_file = g_string_new(chatlogs_dir);
+    g_free(chatlogs_dir);
+
+    gchar *login_dir = str_replace(login, "@", "_at_");
+    g_string_append_printf(seen_file, "/%s/rooms", login_dir);
+    free(login_dir);
+    mkdir_recursive(seen_file->str);
+
+    g_string_append(seen_file, "/history.seen");
+
+    char *result = strdup(seen_file->str);
+    g_string_free(seen_file, TRUE);
+
+    return result;
+}
+
+char *
+chat_log_archive_filename(const gchar * const login)
+{
+    gchar *chatlogs_dir = _get_chatlog_dir();
+    GString *archive_file = g_string_new(chatlogs_dir);
+    g_free(chatlogs_dir);
+
+    gchar *login_dir = str_replace(login, "@", "_at_");
+    g_string_append_printf(archive_file, "/%s", login_dir);
+    free(login_dir);
+    mkdir_recursive(archive_file->str);
+
+    g_string_append(archive_file, "/archive.positions");
+
+    char *result = strdup(archive_file->str);
+    g_string_free(archive_file, TRUE);
+
+    return result;
+}
+
 static char *
 _get_groupchat_log_filename(const char * const room, const char * const login,
     GDateTime *dt, gboolean create)
@@ -61,6 +61,7 @@ void log_warning(const char * const msg, ...);
 void log_error(const char * const msg, ...);
 void log_msg(log_level_t level, const char * const area,
     const char * const msg);
+void log_timed_flush(void);
 log_level_t log_level_from_string(char *log_level);
 
 void chat_log_init(void);
@@ -69,8 +70,10 @@ void chat_log_chat(const gchar * const login, gchar *other,
 void chat_log_close(void);
 GSList * chat_log_get_previous(const gchar * const login,
     const gchar * const recipient);
+char * chat_log_archive_filename(const gchar * const login);
 
 void groupchat_log_init(void);
 void groupchat_log_chat(const gchar * const login, const gchar * const room,
     const gchar * const nick, const gchar * const msg);
+char * groupchat_log_seen_filename(const gchar * const login);
 #endif
@@ -40,10 +40,12 @@
 #endif
 
 #include "profanity.h"
+#include "detach.h"
 #include "command/command.h"
 
 static gboolean disable_tls = FALSE;
 static gboolean version = FALSE;
+static gboolean attach = FALSE;
 static char *log = "INFO";
 static char *account_name = NULL;
 
@@ -61,6 +63,7 @@ main(int argc, char **argv)
         { "disable-tls", 'd', 0, G_OPTION_ARG_NONE, &disable_tls, "Disable TLS", NULL },
         { "account", 'a', 0, G_OPTION_ARG_STRING, &account_name, "Auto connect to an account on startup" },
         { "log",'l', 0, G_OPTION_ARG_STRING, &log, "Set logging levels, DEBUG, INFO (default), WARN, ERROR", "LEVEL" },
+        { "attach", 0, 0, G_OPTION_ARG_NONE, &attach, "Return to a session left with /detach", NULL },
         { NULL }
     };
 
@@ -124,6 +127,10 @@ main(int argc, char **argv)
         return 0;
     }
 
+    if (attach == TRUE) {
+        return detach_attach_client();
+    }
+
     prof_run(disable_tls, log, account_name);
 
     return 0;
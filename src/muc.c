@@ -58,14 +58,21 @@ typedef struct _muc_room_t {
     gboolean autojoin;
     gboolean pending_nick_change;
     GHashTable *roster;
+    // occupants received while joining, moved into the roster when the join completes
+    GPtrArray *pending_occupants;
     Autocomplete nick_ac;
     Autocomplete jid_ac;
     GHashTable *nick_changes;
     gboolean roster_received;
 } ChatRoom;
 
-GHashTable *rooms = NULL;
-Autocomplete invite_ac;
+struct muc_rooms_t {
+    GHashTable *rooms;
+    Autocomplete invite_ac;
+};
+
+// the rooms of the connection being serviced
+static MucRooms *muc = NULL;
 
 static void _free_room(ChatRoom *room);
 static gint _compare_occupants(Occupant *a, Occupant *b);
@@ -76,50 +83,82 @@ static char* _affiliation_to_string(muc_affiliation_t affiliation);
 static Occupant* _muc_occupant_new(const char *const nick, const char * const jid,
     muc_role_t role, muc_affiliation_t affiliation, resource_presence_t presence, const char * const status);
 static void _occupant_free(Occupant *occupant);
+static void _roster_materialise(ChatRoom *chat_room);
+
+MucRooms*
+muc_rooms_new(void)
+{
+    MucRooms *rooms = malloc(sizeof(MucRooms));
+    rooms->invite_ac = autocomplete_new();
+    rooms->rooms = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_free_room);
+
+    return rooms;
+}
 
+void
+muc_rooms_free(MucRooms *rooms)
+{
+    if (rooms) {
+        if (muc == rooms) {
+            muc = NULL;
+        }
+        autocomplete_free(rooms->invite_ac);
+        g_hash_table_destroy(rooms->rooms);
+        free(rooms);
+    }
+}
+
+/*
+ * Point the muc functions at another connection's rooms, the rooms stay
+ * owned by the caller
+ */
+void
+muc_rooms_use(MucRooms *rooms)
+{
+    muc = rooms;
+}
+
+// rooms of their own for callers without a connection
 void
 muc_init(void)
 {
-    invite_ac = autocomplete_new();
-    rooms = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_free_room);
+    muc = muc_rooms_new();
 }
 
 void
 muc_close(void)
 {
-    autocomplete_free(invite_ac);
-    g_hash_table_destroy(rooms);
-    rooms = NULL;
+    muc_rooms_free(muc);
 }
 
 void
 muc_invites_add(const char * const room)
 {
-    autocomplete_add(invite_ac, room);
+    autocomplete_add(muc->invite_ac, room);
 }
 
 void
 muc_invites_remove(const char * const room)
 {
-    autocomplete_remove(invite_ac, room);
+    autocomplete_remove(muc->invite_ac, room);
 }
 
 gint
 muc_invites_count(void)
 {
-    return autocomplete_length(invite_ac);
+    return autocomplete_length(muc->invite_ac);
 }
 
 GSList *
 muc_invites(void)
 {
-    return autocomplete_create_list(invite_ac);
+    return autocomplete_create_list(muc->invite_ac);
 }
 
 gboolean
 muc_invites_contain(const char * const room)
 {
-    GSList *invites = autocomplete_create_list(invite_ac);
+    GSList *invites = autocomplete_create_list(muc->invite_ac);
     GSList *curr = invites;
     while (curr) {
         if (strcmp(curr->data, room) == 0) {
@@ -137,19 +176,19 @@ muc_invites_contain(const char * const room)
 void
 muc_invites_reset_ac(void)
 {
-    autocomplete_reset(invite_ac);
+    autocomplete_reset(muc->invite_ac);
 }
 
 char *
 muc_invites_find(const char * const search_str)
 {
-    return autocomplete_complete(invite_ac, search_str, TRUE);
+    return autocomplete_complete(muc->invite_ac, search_str, TRUE);
 }
 
 void
 muc_invites_clear(void)
 {
-    autocomplete_clear(invite_ac);
+    autocomplete_clear(muc->invite_ac);
 }
 
 void
@@ -171,6 +210,7 @@ muc_join(const char * const room, const char * const nick,
     new_room->pending_broadcasts = NULL;
     new_room->pending_config = FALSE;
     new_room->roster = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_occupant_free);
+    new_room->pending_occupants = g_ptr_array_new_with_free_func((GDestroyNotify)_occupant_free);
     new_room->nick_ac = autocomplete_new();
     new_room->jid_ac = autocomplete_new();
     new_room->nick_changes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
@@ -178,19 +218,19 @@ muc_join(const char * const room, const char * const nick,
     new_room->pending_nick_change = FALSE;
     new_room->autojoin = autojoin;
 
-    g_hash_table_insert(rooms, strdup(room), new_room);
+    g_hash_table_insert(muc->rooms, strdup(room), new_room);
 }
 
 void
 muc_leave(const char * const room)
 {
-    g_hash_table_remove(rooms, room);
+    g_hash_table_remove(muc->rooms, room);
 }
 
 gboolean
 muc_requires_config(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         return chat_room->pending_config;
     } else {
@@ -202,7 +242,7 @@ muc_requires_config(const char * const room)
 void
 muc_set_requires_config(const char * const room, gboolean val)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         chat_room->pending_config = val;
     }
@@ -214,14 +254,14 @@ muc_set_requires_config(const char * const room, gboolean val)
 gboolean
 muc_active(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     return (chat_room != NULL);
 }
 
 gboolean
 muc_autojoin(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         return chat_room->autojoin;
     } else {
@@ -232,7 +272,7 @@ muc_autojoin(const char * const room)
 void
 muc_set_subject(const char * const room, const char * const subject)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         free(chat_room->subject);
         if (subject) {
@@ -246,7 +286,7 @@ muc_set_subject(const char * const room, const char * const subject)
 char *
 muc_subject(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         return chat_room->subject;
     } else {
@@ -257,7 +297,7 @@ muc_subject(const char * const room)
 void
 muc_pending_broadcasts_add(const char * const room, const char * const message)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         chat_room->pending_broadcasts = g_list_append(chat_room->pending_broadcasts, strdup(message));
     }
@@ -266,7 +306,7 @@ muc_pending_broadcasts_add(const char * const room, const char * const message)
 GList *
 muc_pending_broadcasts(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         return chat_room->pending_broadcasts;
     } else {
@@ -277,7 +317,7 @@ muc_pending_broadcasts(const char * const room)
 char *
 muc_old_nick(const char * const room, const char * const new_nick)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room && chat_room->pending_nick_change) {
         return g_hash_table_lookup(chat_room->nick_changes, new_nick);
     } else {
@@ -292,7 +332,7 @@ muc_old_nick(const char * const room, const char * const new_nick)
 void
 muc_nick_change_start(const char * const room, const char * const new_nick)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         chat_room->pending_nick_change = TRUE;
         g_hash_table_insert(chat_room->nick_changes, strdup(new_nick), strdup(chat_room->nick));
@@ -306,7 +346,7 @@ muc_nick_change_start(const char * const room, const char * const new_nick)
 gboolean
 muc_nick_change_pending(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         return chat_room->pending_nick_change;
     } else {
@@ -321,7 +361,7 @@ muc_nick_change_pending(const char * const room)
 void
 muc_nick_change_complete(const char * const room, const char * const nick)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         g_hash_table_remove(chat_room->roster, chat_room->nick);
         autocomplete_remove(chat_room->nick_ac, chat_room->nick);
@@ -340,7 +380,7 @@ muc_nick_change_complete(const char * const room, const char * const nick)
 GList *
 muc_rooms(void)
 {
-    return g_hash_table_get_keys(rooms);
+    return g_hash_table_get_keys(muc->rooms);
 }
 
 /*
@@ -350,7 +390,7 @@ muc_rooms(void)
 char *
 muc_nick(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         return chat_room->nick;
     } else {
@@ -365,7 +405,7 @@ muc_nick(const char * const room)
 char *
 muc_password(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         return chat_room->password;
     } else {
@@ -379,7 +419,7 @@ muc_password(const char * const room)
 gboolean
 muc_roster_contains_nick(const char * const room, const char * const nick)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         Occupant *occupant = g_hash_table_lookup(chat_room->roster, nick);
         return (occupant != NULL);
@@ -395,11 +435,19 @@ gboolean
 muc_roster_add(const char * const room, const char * const nick, const char * const jid,
     const char * const role, const char * const affiliation, const char * const show, const char * const status)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     gboolean updated = FALSE;
     resource_presence_t new_presence = resource_presence_from_string(show);
 
-    if (chat_room) {
+    if (chat_room && chat_room->pending_occupants) {
+        resource_presence_t presence = resource_presence_from_string(show);
+        muc_role_t role_t = _role_from_string(role);
+        muc_affiliation_t affiliation_t = _affiliation_from_string(affiliation);
+        Occupant *occupant = _muc_occupant_new(nick, jid, role_t, affiliation_t, presence, status);
+        g_ptr_array_add(chat_room->pending_occupants, occupant);
+        updated = TRUE;
+
+    } else if (chat_room) {
         Occupant *old = g_hash_table_lookup(chat_room->roster, nick);
 
         if (!old) {
@@ -417,11 +465,11 @@ muc_roster_add(const char * const room, const char * const nick, const char * co
         g_hash_table_replace(chat_room->roster, strdup(nick), occupant);
 
         if (jid) {
-            Jid *jidp = jid_create(jid);
-            if (jidp->barejid) {
+            Jid *jidp = jid_intern(jid);
+            if (jidp) {
                 autocomplete_add(chat_room->jid_ac, jidp->barejid);
             }
-            jid_destroy(jidp);
+            jid_release(jidp);
         }
     }
 
@@ -434,8 +482,16 @@ muc_roster_add(const char * const room, const char * const nick, const char * co
 void
 muc_roster_remove(const char * const room, const char * const nick)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
-    if (chat_room) {
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
+    if (chat_room && chat_room->pending_occupants) {
+        int i;
+        for (i = chat_room->pending_occupants->len - 1; i >= 0; i--) {
+            Occupant *occupant = g_ptr_array_index(chat_room->pending_occupants, i);
+            if (g_strcmp0(occupant->nick, nick) == 0) {
+                g_ptr_array_remove_index(chat_room->pending_occupants, i);
+            }
+        }
+    } else if (chat_room) {
         g_hash_table_remove(chat_room->roster, nick);
         autocomplete_remove(chat_room->nick_ac, nick);
     }
@@ -444,7 +500,7 @@ muc_roster_remove(const char * const room, const char * const nick)
 Occupant *
 muc_roster_item(const char * const room, const char * const nick)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         Occupant *occupant = g_hash_table_lookup(chat_room->roster, nick);
         return occupant;
@@ -459,20 +515,10 @@ muc_roster_item(const char * const room, const char * const nick)
 GList *
 muc_roster(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
-        GList *result = NULL;
         GList *occupants = g_hash_table_get_values(chat_room->roster);
-
-        GList *curr = occupants;
-        while (curr) {
-            result = g_list_insert_sorted(result, curr->data, (GCompareFunc)_compare_occupants);
-            curr = g_list_next(curr);
-        }
-
-        g_list_free(occupants);
-
-        return result;
+        return g_list_sort(occupants, (GCompareFunc)_compare_occupants);
     } else {
         return NULL;
     }
@@ -484,7 +530,7 @@ muc_roster(const char * const room)
 Autocomplete
 muc_roster_ac(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         return chat_room->nick_ac;
     } else {
@@ -495,7 +541,7 @@ muc_roster_ac(const char * const room)
 Autocomplete
 muc_roster_jid_ac(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         return chat_room->jid_ac;
     } else {
@@ -509,8 +555,9 @@ muc_roster_jid_ac(const char * const room)
 void
 muc_roster_set_complete(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
+        _roster_materialise(chat_room);
         chat_room->roster_received = TRUE;
     }
 }
@@ -521,7 +568,7 @@ muc_roster_set_complete(const char * const room)
 gboolean
 muc_roster_complete(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         return chat_room->roster_received;
     } else {
@@ -550,7 +597,7 @@ muc_occupant_role_str(Occupant *occupant)
 GSList *
 muc_occupants_by_role(const char * const room, muc_role_t role)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         GSList *result = NULL;
         GHashTableIter iter;
@@ -573,7 +620,7 @@ muc_occupants_by_role(const char * const room, muc_role_t role)
 GSList *
 muc_occupants_by_affiliation(const char * const room, muc_affiliation_t affiliation)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         GSList *result = NULL;
         GHashTableIter iter;
@@ -601,7 +648,7 @@ void
 muc_occupant_nick_change_start(const char * const room,
     const char * const new_nick, const char * const old_nick)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         g_hash_table_insert(chat_room->nick_changes, strdup(new_nick), strdup(old_nick));
         muc_roster_remove(room, old_nick);
@@ -618,7 +665,7 @@ char *
 muc_roster_nick_change_complete(const char * const room,
     const char * const nick)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         char *old_nick = g_hash_table_lookup(chat_room->nick_changes, nick);
         if (old_nick) {
@@ -638,7 +685,7 @@ muc_autocomplete(const char * const input)
     win_type_t wintype = ui_current_win_type();
     if (wintype == WIN_MUC) {
         ProfMucWin *mucwin = wins_get_current_muc();
-        ChatRoom *chat_room = g_hash_table_lookup(rooms, mucwin->roomjid);
+        ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, mucwin->roomjid);
 
         if (chat_room && chat_room->nick_ac) {
             const char * search_str = NULL;
@@ -677,7 +724,7 @@ muc_autocomplete(const char * const input)
 void
 muc_jid_autocomplete_reset(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         if (chat_room->jid_ac) {
             autocomplete_reset(chat_room->jid_ac);
@@ -688,7 +735,7 @@ muc_jid_autocomplete_reset(const char * const room)
 void
 muc_jid_autocomplete_add_all(const char * const room, GSList *jids)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         if (chat_room->jid_ac) {
             GSList *curr_jid = jids;
@@ -710,7 +757,7 @@ muc_jid_autocomplete_add_all(const char * const room, GSList *jids)
 void
 muc_autocomplete_reset(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         if (chat_room->nick_ac) {
             autocomplete_reset(chat_room->nick_ac);
@@ -726,7 +773,7 @@ muc_autocomplete_reset(const char * const room)
 char *
 muc_role_str(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         return _role_to_string(chat_room->role);
     } else {
@@ -737,7 +784,7 @@ muc_role_str(const char * const room)
 void
 muc_set_role(const char * const room, const char * const role)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         chat_room->role = _role_from_string(role);
     }
@@ -746,7 +793,7 @@ muc_set_role(const char * const room, const char * const role)
 char *
 muc_affiliation_str(const char * const room)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         return _affiliation_to_string(chat_room->affiliation);
     } else {
@@ -757,7 +804,7 @@ muc_affiliation_str(const char * const room)
 void
 muc_set_affiliation(const char * const room, const char * const affiliation)
 {
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    ChatRoom *chat_room = g_hash_table_lookup(muc->rooms, room);
     if (chat_room) {
         chat_room->affiliation = _affiliation_from_string(affiliation);
     }
@@ -775,6 +822,9 @@ _free_room(ChatRoom *room)
         if (room->roster) {
             g_hash_table_destroy(room->roster);
         }
+        if (room->pending_occupants) {
+            g_ptr_array_free(room->pending_occupants, TRUE);
+        }
         autocomplete_free(room->nick_ac);
         autocomplete_free(room->jid_ac);
         if (room->nick_changes) {
@@ -787,6 +837,52 @@ _free_room(ChatRoom *room)
     }
 }
 
+/*
+ * Move the occupants received while joining into the roster, building the
+ * nick and jid autocompleters in one pass rather than a sorted insert each
+ */
+static void
+_roster_materialise(ChatRoom *chat_room)
+{
+    if (chat_room->pending_occupants == NULL) {
+        return;
+    }
+
+    // later presences for the same nick replace earlier ones
+    GPtrArray *pending = chat_room->pending_occupants;
+    chat_room->pending_occupants = NULL;
+    g_ptr_array_set_free_func(pending, NULL);
+    int i;
+    for (i = 0; i < pending->len; i++) {
+        Occupant *occupant = g_ptr_array_index(pending, i);
+        g_hash_table_replace(chat_room->roster, strdup(occupant->nick), occupant);
+    }
+    g_ptr_array_free(pending, TRUE);
+
+    GSList *nicks = NULL;
+    GSList *barejids = NULL;
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, chat_room->roster);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        Occupant *occupant = value;
+        nicks = g_slist_prepend(nicks, key);
+        if (occupant->jid) {
+            Jid *jidp = jid_intern(occupant->jid);
+            if (jidp) {
+                barejids = g_slist_prepend(barejids, strdup(jidp->barejid));
+            }
+            jid_release(jidp);
+        }
+    }
+
+    autocomplete_add_all(chat_room->nick_ac, nicks);
+    autocomplete_add_all(chat_room->jid_ac, barejids);
+    g_slist_free(nicks);
+    g_slist_free_full(barejids, free);
+}
+
 static
 gint _compare_occupants(Occupant *a, Occupant *b)
 {
@@ -65,6 +65,12 @@ typedef struct _muc_occupant_t {
     char *status;
 } Occupant;
 
+typedef struct muc_rooms_t MucRooms;
+
+MucRooms* muc_rooms_new(void);
+void muc_rooms_free(MucRooms *rooms);
+void muc_rooms_use(MucRooms *rooms);
+
 void muc_init(void);
 void muc_close(void);
 
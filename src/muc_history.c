@@ -0,0 +1,307 @@
+/*
+ * muc_history.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "common.h"
+#include "muc_history.h"
+
+/*
+ * Remembers the newest message seen in each room, so joins can ask for history
+ * since then, and a key for each of the last lines shown, so history the room
+ * sends again is not printed twice. Lines are keyed by the room's stanza id
+ * when they have one, and history lines also by the room's exact delay stamp
+ * with the nick and message.
+ */
+typedef struct room_seen_t {
+    gint64 latest;
+    GQueue *recent;
+} RoomSeen;
+
+static GHashTable *rooms = NULL;
+static char *seen_file = NULL;
+static gboolean dirty = FALSE;
+
+static RoomSeen * _get_room(const char * const room, gboolean create);
+static void _add_key(RoomSeen *seen, const char * const key);
+static gboolean _has_key(RoomSeen *seen, const char * const key);
+static char * _stamp_key(const char * const nick, const char * const message, GTimeVal *tv_stamp);
+static void _free_room(RoomSeen *seen);
+
+void
+muc_history_init(void)
+{
+    muc_history_close();
+    rooms = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_free_room);
+}
+
+void
+muc_history_close(void)
+{
+    if (rooms) {
+        muc_history_save();
+        g_hash_table_destroy(rooms);
+        rooms = NULL;
+    }
+    free(seen_file);
+    seen_file = NULL;
+    dirty = FALSE;
+}
+
+/*
+ * Replace what is remembered with the contents of filename, which is also
+ * where muc_history_save writes to. A NULL filename keeps it in memory only.
+ */
+void
+muc_history_load(const char * const filename)
+{
+    muc_history_init();
+    if (filename == NULL) {
+        return;
+    }
+    seen_file = strdup(filename);
+
+    GKeyFile *keyfile = g_key_file_new();
+    if (!g_key_file_load_from_file(keyfile, filename, G_KEY_FILE_NONE, NULL)) {
+        g_key_file_free(keyfile);
+        return;
+    }
+
+    gsize num_rooms = 0;
+    gchar **groups = g_key_file_get_groups(keyfile, &num_rooms);
+    gsize i;
+    for (i = 0; i < num_rooms; i++) {
+        RoomSeen *seen = _get_room(groups[i], TRUE);
+        seen->latest = g_key_file_get_int64(keyfile, groups[i], "latest", NULL);
+
+        gsize num_keys = 0;
+        gchar **keys = g_key_file_get_string_list(keyfile, groups[i], "recent", &num_keys, NULL);
+        gsize j;
+        for (j = 0; j < num_keys; j++) {
+            _add_key(seen, keys[j]);
+        }
+        g_strfreev(keys);
+    }
+    g_strfreev(groups);
+    g_key_file_free(keyfile);
+    dirty = FALSE;
+}
+
+void
+muc_history_save(void)
+{
+    if (!dirty || seen_file == NULL || rooms == NULL) {
+        return;
+    }
+
+    GKeyFile *keyfile = g_key_file_new();
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, rooms);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        RoomSeen *seen = value;
+        g_key_file_set_int64(keyfile, key, "latest", seen->latest);
+
+        const gchar **keys = g_new0(const gchar *, g_queue_get_length(seen->recent) + 1);
+        int i = 0;
+        GList *curr = seen->recent->head;
+        while (curr) {
+            keys[i++] = curr->data;
+            curr = g_list_next(curr);
+        }
+        g_key_file_set_string_list(keyfile, key, "recent", keys, i);
+        g_free(keys);
+    }
+
+    gsize length = 0;
+    gchar *data = g_key_file_to_data(keyfile, &length, NULL);
+    if (g_file_set_contents(seen_file, data, length, NULL)) {
+        g_chmod(seen_file, S_IRUSR | S_IWUSR);
+        dirty = FALSE;
+    }
+    g_free(data);
+    g_key_file_free(keyfile);
+}
+
+/*
+ * A line from room has been shown. id is the room's stanza id, if any, and
+ * tv_stamp the room's delay stamp for history, NULL for a live line.
+ */
+void
+muc_history_seen(const char * const room, const char * const id, const char * const nick,
+    const char * const message, GTimeVal *tv_stamp)
+{
+    RoomSeen *seen = _get_room(room, TRUE);
+    if (seen == NULL) {
+        return;
+    }
+
+    if (id) {
+        char *key = g_strdup_printf("id:%s", id);
+        _add_key(seen, key);
+        g_free(key);
+    }
+    if (tv_stamp) {
+        char *key = _stamp_key(nick, message, tv_stamp);
+        _add_key(seen, key);
+        g_free(key);
+    }
+
+    gint64 stamp = 0;
+    if (tv_stamp) {
+        stamp = tv_stamp->tv_sec;
+    } else {
+        GTimeVal tv_now;
+        g_get_current_time(&tv_now);
+        stamp = tv_now.tv_sec;
+    }
+    if (stamp > seen->latest) {
+        seen->latest = stamp;
+    }
+    dirty = TRUE;
+}
+
+/*
+ * Whether a history line has already been shown, with the same stanza id or
+ * the same nick and message at the same delay stamp
+ */
+gboolean
+muc_history_is_duplicate(const char * const room, const char * const id, const char * const nick,
+    const char * const message, GTimeVal *tv_stamp)
+{
+    RoomSeen *seen = _get_room(room, FALSE);
+    if (seen == NULL) {
+        return FALSE;
+    }
+
+    gboolean found = FALSE;
+    if (id) {
+        char *key = g_strdup_printf("id:%s", id);
+        found = _has_key(seen, key);
+        g_free(key);
+    }
+    if (!found) {
+        char *key = _stamp_key(nick, message, tv_stamp);
+        found = _has_key(seen, key);
+        g_free(key);
+    }
+
+    return found;
+}
+
+/*
+ * The time to request room history from when joining, FALSE if nothing has
+ * been seen in the room. Goes back MUC_HISTORY_TOLERANCE seconds so a clock
+ * ahead of the room's does not lose messages, the overlap is removed as duplicates.
+ */
+gboolean
+muc_history_since(const char * const room, GTimeVal *since)
+{
+    RoomSeen *seen = _get_room(room, FALSE);
+    if (seen == NULL || seen->latest == 0) {
+        return FALSE;
+    }
+
+    since->tv_sec = seen->latest - MUC_HISTORY_TOLERANCE;
+    since->tv_usec = 0;
+
+    return TRUE;
+}
+
+static RoomSeen *
+_get_room(const char * const room, gboolean create)
+{
+    if (rooms == NULL) {
+        return NULL;
+    }
+
+    RoomSeen *seen = g_hash_table_lookup(rooms, room);
+    if (seen == NULL && create) {
+        seen = malloc(sizeof(RoomSeen));
+        seen->latest = 0;
+        seen->recent = g_queue_new();
+        g_hash_table_insert(rooms, strdup(room), seen);
+    }
+
+    return seen;
+}
+
+static void
+_add_key(RoomSeen *seen, const char * const key)
+{
+    if (_has_key(seen, key)) {
+        return;
+    }
+
+    g_queue_push_tail(seen->recent, strdup(key));
+    if (g_queue_get_length(seen->recent) > MUC_HISTORY_RECENT) {
+        free(g_queue_pop_head(seen->recent));
+    }
+}
+
+static gboolean
+_has_key(RoomSeen *seen, const char * const key)
+{
+    GList *curr = seen->recent->tail;
+    while (curr) {
+        if (g_strcmp0(curr->data, key) == 0) {
+            return TRUE;
+        }
+        curr = g_list_previous(curr);
+    }
+
+    return FALSE;
+}
+
+static char *
+_stamp_key(const char * const nick, const char * const message, GTimeVal *tv_stamp)
+{
+    return g_strdup_printf("%ld.%06ld:%u:%u", (long)tv_stamp->tv_sec, (long)tv_stamp->tv_usec,
+        g_str_hash(nick), g_str_hash(message));
+}
+
+static void
+_free_room(RoomSeen *seen)
+{
+    if (seen) {
+        g_queue_free_full(seen->recent, free);
+        free(seen);
+    }
+}
@@ -38,6 +38,7 @@
 #include <libotr/sm.h>
 #include <glib.h>
 
+#include "common.h"
 #include "otr/otr.h"
 #include "otr/otrlib.h"
 #include "log.h"
@@ -57,6 +58,16 @@ static char *jid;
 static gboolean data_loaded;
 static GHashTable *smp_initiators;
 
+// policy lookups for the connected account, rebuilt after a policy change
+static char *policy_account;
+static GHashTable *contact_policies;
+static prof_otrpolicy_t default_policy;
+
+static void _policy_cache_load(const char * const account_name);
+static void _account_changed(const char * const account_name);
+static void _policy_cache_add(GList *contacts, prof_otrpolicy_t policy);
+static prof_otrpolicy_t _policy_from_string(const char * const policy);
+
 OtrlUserState
 otr_userstate(void)
 {
@@ -172,6 +183,7 @@ otr_init(void)
     otrlib_init_ops(&ops);
     otrlib_init_timer();
     smp_initiators = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    accounts_add_listener(_account_changed);
 
     data_loaded = FALSE;
 }
@@ -182,6 +194,7 @@ otr_shutdown(void)
     if (jid != NULL) {
         free(jid);
     }
+    otr_policy_changed();
 }
 
 void
@@ -547,53 +560,90 @@ otr_get_their_fingerprint(const char * const recipient)
 prof_otrpolicy_t
 otr_get_policy(const char * const recipient)
 {
-    ProfAccount *account = accounts_get_account(jabber_get_account_name());
+    char *account_name = jabber_get_account_name();
+    if (contact_policies == NULL || g_strcmp0(policy_account, account_name) != 0) {
+        _policy_cache_load(account_name);
+    }
+
     // check contact specific setting
-    if (g_list_find_custom(account->otr_manual, recipient, (GCompareFunc)g_strcmp0)) {
-        account_free(account);
-        return PROF_OTRPOLICY_MANUAL;
+    gpointer policy;
+    if (g_hash_table_lookup_extended(contact_policies, recipient, NULL, &policy)) {
+        return GPOINTER_TO_INT(policy);
     }
-    if (g_list_find_custom(account->otr_opportunistic, recipient, (GCompareFunc)g_strcmp0)) {
-        account_free(account);
-        return PROF_OTRPOLICY_OPPORTUNISTIC;
+
+    // account or global setting
+    return default_policy;
+}
+
+void
+otr_policy_changed(void)
+{
+    if (contact_policies != NULL) {
+        g_hash_table_destroy(contact_policies);
+        contact_policies = NULL;
     }
-    if (g_list_find_custom(account->otr_always, recipient, (GCompareFunc)g_strcmp0)) {
-        account_free(account);
-        return PROF_OTRPOLICY_ALWAYS;
+    FREE_SET_NULL(policy_account);
+}
+
+static void
+_policy_cache_load(const char * const account_name)
+{
+    otr_policy_changed();
+    contact_policies = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    const ProfAccount *account = NULL;
+    if (account_name != NULL) {
+        policy_account = strdup(account_name);
+        account = accounts_get_account_ref(account_name);
+    }
+    if (account != NULL) {
+        // added lowest precedence first, so manual wins when a contact is listed twice
+        _policy_cache_add(account->otr_always, PROF_OTRPOLICY_ALWAYS);
+        _policy_cache_add(account->otr_opportunistic, PROF_OTRPOLICY_OPPORTUNISTIC);
+        _policy_cache_add(account->otr_manual, PROF_OTRPOLICY_MANUAL);
     }
 
     // check default account setting
-    if (account->otr_policy != NULL) {
-        prof_otrpolicy_t result;
-        if (g_strcmp0(account->otr_policy, "manual") == 0) {
-            result = PROF_OTRPOLICY_MANUAL;
-        }
-        if (g_strcmp0(account->otr_policy, "opportunistic") == 0) {
-            result = PROF_OTRPOLICY_OPPORTUNISTIC;
-        }
-        if (g_strcmp0(account->otr_policy, "always") == 0) {
-            result = PROF_OTRPOLICY_ALWAYS;
-        }
-        account_free(account);
-        return result;
-    }
-    account_free(account);
+    if (account != NULL && account->otr_policy != NULL) {
+        default_policy = _policy_from_string(account->otr_policy);
 
     // check global setting
-    char *pref_otr_policy = prefs_get_string(PREF_OTR_POLICY);
-
-    // pref defaults to manual
-    prof_otrpolicy_t result = PROF_OTRPOLICY_MANUAL;
+    } else {
+        char *pref_otr_policy = prefs_get_string(PREF_OTR_POLICY);
+        default_policy = _policy_from_string(pref_otr_policy);
+        prefs_free_string(pref_otr_policy);
+    }
+}
 
-    if (strcmp(pref_otr_policy, "opportunistic") == 0) {
-        result = PROF_OTRPOLICY_OPPORTUNISTIC;
-    } else if (strcmp(pref_otr_policy, "always") == 0) {
-        result = PROF_OTRPOLICY_ALWAYS;
+static void
+_account_changed(const char * const account_name)
+{
+    if (g_strcmp0(account_name, policy_account) == 0) {
+        otr_policy_changed();
     }
+}
 
-    prefs_free_string(pref_otr_policy);
+static void
+_policy_cache_add(GList *contacts, prof_otrpolicy_t policy)
+{
+    GList *curr = contacts;
+    while (curr != NULL) {
+        g_hash_table_replace(contact_policies, g_strdup(curr->data), GINT_TO_POINTER(policy));
+        curr = g_list_next(curr);
+    }
+}
 
-    return result;
+static prof_otrpolicy_t
+_policy_from_string(const char * const policy)
+{
+    // defaults to manual
+    if (g_strcmp0(policy, "opportunistic") == 0) {
+        return PROF_OTRPOLICY_OPPORTUNISTIC;
+    } else if (g_strcmp0(policy, "always") == 0) {
+        return PROF_OTRPOLICY_ALWAYS;
+    } else {
+        return PROF_OTRPOLICY_MANUAL;
+    }
 }
 
 char *
@@ -609,13 +659,14 @@ otr_encrypt_message(const char * const to, const char * const message)
     }
 }
 
-char *
-otr_decrypt_message(const char * const from, const char * const message, gboolean *was_decrypted)
+// returns FALSE for internal OTR messages, decrypted is left NULL for plaintext
+gboolean
+otr_decrypt_message(const char * const from, const char * const message, char **decrypted)
 {
-    char *decrypted = NULL;
     OtrlTLV *tlvs = NULL;
+    *decrypted = NULL;
 
-    int result = otrlib_decrypt_message(user_state, &ops, jid, from, message, &decrypted, &tlvs);
+    int result = otrlib_decrypt_message(user_state, &ops, jid, from, message, decrypted, &tlvs);
 
     // internal libotr message
     if (result == 1) {
@@ -634,17 +685,16 @@ otr_decrypt_message(const char * const from, const char * const message, gboolea
         // library version specific tlv handling
         otrlib_handle_tlvs(user_state, &ops, context, tlvs, smp_initiators);
 
-        return NULL;
+        if (*decrypted) {
+            otrl_message_free(*decrypted);
+            *decrypted = NULL;
+        }
 
-    // message was decrypted, return to user
-    } else if (decrypted != NULL) {
-        *was_decrypted = TRUE;
-        return decrypted;
+        return FALSE;
 
-    // normal non OTR message
+    // message was decrypted (decrypted set) or normal non OTR message (decrypted NULL)
     } else {
-        *was_decrypted = FALSE;
-        return strdup(message);
+        return TRUE;
     }
 }
 
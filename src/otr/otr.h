@@ -75,11 +75,12 @@ char * otr_get_my_fingerprint(void);
 char * otr_get_their_fingerprint(const char * const recipient);
 
 char * otr_encrypt_message(const char * const to, const char * const message);
-char * otr_decrypt_message(const char * const from, const char * const message,
-    gboolean *was_decrypted);
+gboolean otr_decrypt_message(const char * const from, const char * const message,
+    char **decrypted);
 
 void otr_free_message(char *message);
 
 prof_otrpolicy_t otr_get_policy(const char * const recipient);
+void otr_policy_changed(void);
 
 #endif
@@ -53,24 +53,28 @@
 #include "command/command.h"
 #include "common.h"
 #include "contact.h"
-#include "roster_list.h"
+#include "detach.h"
 #include "log.h"
-#include "muc.h"
+#include "muc_history.h"
 #ifdef HAVE_LIBOTR
 #include "otr/otr.h"
 #endif
 #include "resource.h"
+#include "xmpp/csi.h"
+#include "xmpp/mam.h"
 #include "xmpp/xmpp.h"
 #include "ui/ui.h"
 #include "ui/windows.h"
 
 static void _check_autoaway(void);
+static void _check_csi(void);
 static void _init(const int disable_tls, char *log_level);
 static void _shutdown(void);
 static void _create_directories(void);
 static void _connect_default(const char * const account);
 
 static gboolean idle = FALSE;
+static gboolean focused = TRUE;
 
 void
 prof_run(const int disable_tls, char *log_level, char *account_name)
@@ -87,13 +91,22 @@ prof_run(const int disable_tls, char *log_level, char *account_name)
     while(cmd_result) {
         while(!line) {
             _check_autoaway();
-            line = ui_readline();
+            _check_csi();
+            if (detach_is_detached()) {
+                detach_wait_for_attach(DETACH_WAIT_MS);
+            } else {
+                detach_check_attached();
+                line = ui_readline();
+            }
 #ifdef HAVE_LIBOTR
             otr_poll();
 #endif
             notify_remind();
             jabber_process_events();
-            ui_update();
+            if (!detach_is_detached()) {
+                ui_update();
+            }
+            log_timed_flush();
         }
         cmd_result = cmd_process_input(line);
         ui_input_clear();
@@ -106,19 +119,7 @@ prof_handle_idle(void)
 {
     jabber_conn_status_t status = jabber_get_connection_status();
     if (status == JABBER_CONNECTED) {
-        GSList *recipients = ui_get_chat_recipients();
-        GSList *curr = recipients;
-
-        while (curr != NULL) {
-            char *barejid = curr->data;
-            ProfChatWin *chatwin = wins_get_chat(barejid);
-            chat_state_handle_idle(chatwin->barejid, chatwin->state);
-            curr = g_slist_next(curr);
-        }
-
-        if (recipients != NULL) {
-            g_slist_free(recipients);
-        }
+        chat_state_handle_idle();
     }
 }
 
@@ -134,6 +135,12 @@ prof_handle_activity(void)
     }
 }
 
+void
+prof_handle_focus(gboolean is_focused)
+{
+    focused = is_focused;
+}
+
 static void
 _connect_default(const char * const account)
 {
@@ -148,6 +155,29 @@ _connect_default(const char * const account)
     }
 }
 
+/*
+ * The client is inactive when the terminal loses focus or the user has
+ * been idle for the /csi period
+ */
+static void
+_check_csi(void)
+{
+    jabber_conn_status_t conn_status = jabber_get_connection_status();
+    if (conn_status != JABBER_CONNECTED || !csi_supported()) {
+        return;
+    }
+
+    gint csi_time = prefs_get_csi();
+    if (csi_time == 0) {
+        csi_set_active(TRUE);
+        return;
+    }
+
+    unsigned long idle_ms = ui_get_idle_time();
+    gboolean active = focused && (idle_ms < (unsigned long)csi_time * 1000);
+    csi_set_active(active);
+}
+
 static void
 _check_autoaway()
 {
@@ -224,6 +254,7 @@ _init(const int disable_tls, char *log_level)
     }
     chat_log_init();
     groupchat_log_init();
+    muc_history_init();
     accounts_load();
     char *theme = prefs_get_string(PREF_THEME);
     theme_init(theme);
@@ -231,9 +262,6 @@ _init(const int disable_tls, char *log_level)
     ui_init();
     jabber_init(disable_tls);
     cmd_init();
-    log_info("Initialising contact list");
-    roster_init();
-    muc_init();
 #ifdef HAVE_LIBOTR
     otr_init();
 #endif
@@ -254,13 +282,14 @@ _shutdown(void)
     ui_close_all_wins();
     jabber_disconnect();
     jabber_shutdown();
-    roster_free();
-    muc_close();
     caps_close();
     ui_close();
+    detach_close();
 #ifdef HAVE_LIBOTR
     otr_shutdown();
 #endif
+    muc_history_close();
+    mam_close();
     chat_log_close();
     prefs_close();
     theme_close();
@@ -42,6 +42,7 @@ void prof_run(const int disable_tls, char *log_level, char *account_name);
 
 void prof_handle_idle(void);
 void prof_handle_activity(void);
+void prof_handle_focus(gboolean focused);
 
 gboolean process_input(char *inp);
 
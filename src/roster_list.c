@@ -33,33 +33,34 @@
  */
 
 
+#include <stdlib.h>
 #include <string.h>
 #include <glib.h>
 #include <assert.h>
 
+#include "common.h"
 #include "roster_list.h"
 #include "resource.h"
 #include "contact.h"
 #include "jid.h"
 #include "tools/autocomplete.h"
 
-// nicknames
-static Autocomplete name_ac;
-
-// barejids
-static Autocomplete barejid_ac;
-
-// fulljids
-static Autocomplete fulljid_ac;
-
-// groups
-static Autocomplete groups_ac;
-
-// contacts, indexed on barejid
-static GHashTable *contacts;
-
-// nickname to jid map
-static GHashTable *name_to_barejid;
+// one account's contacts and the indexes kept over them
+struct roster_list_t {
+    Autocomplete name_ac; // nicknames
+    Autocomplete barejid_ac;
+    Autocomplete fulljid_ac;
+    Autocomplete groups_ac;
+    // contacts, indexed on barejid
+    GHashTable *contacts;
+    // nickname to jid map
+    GHashTable *name_to_barejid;
+    // presence to set of contacts with that presence, kept up to date on presence changes
+    GHashTable *presence_buckets;
+};
+
+// the roster of the connection being serviced
+static RosterList *roster = NULL;
 
 static gboolean _key_equals(void *key1, void *key2);
 static gboolean _datetimes_equal(GDateTime *dt1, GDateTime *dt2);
@@ -68,20 +69,25 @@ static void _replace_name(const char * const current_name,
 static void _add_name_and_barejid(const char * const name,
     const char * const barejid);
 static gint _compare_contacts(PContact a, PContact b);
+static GHashTable * _presence_buckets_new(void);
+static void _bucket_add(PContact contact);
+static void _bucket_remove(PContact contact);
 
 void
 roster_clear(void)
 {
-    autocomplete_clear(name_ac);
-    autocomplete_clear(barejid_ac);
-    autocomplete_clear(fulljid_ac);
-    autocomplete_clear(groups_ac);
-    g_hash_table_destroy(contacts);
-    contacts = g_hash_table_new_full(g_str_hash, (GEqualFunc)_key_equals, g_free,
+    autocomplete_clear(roster->name_ac);
+    autocomplete_clear(roster->barejid_ac);
+    autocomplete_clear(roster->fulljid_ac);
+    autocomplete_clear(roster->groups_ac);
+    g_hash_table_destroy(roster->contacts);
+    roster->contacts = g_hash_table_new_full(g_str_hash, (GEqualFunc)_key_equals, g_free,
         (GDestroyNotify)p_contact_free);
-    g_hash_table_destroy(name_to_barejid);
-    name_to_barejid = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+    g_hash_table_destroy(roster->name_to_barejid);
+    roster->name_to_barejid = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
         g_free);
+    g_hash_table_destroy(roster->presence_buckets);
+    roster->presence_buckets = _presence_buckets_new();
 }
 
 gboolean
@@ -91,16 +97,18 @@ roster_update_presence(const char * const barejid, Resource *resource,
     assert(barejid != NULL);
     assert(resource != NULL);
 
-    PContact contact = g_hash_table_lookup(contacts, barejid);
+    PContact contact = g_hash_table_lookup(roster->contacts, barejid);
     if (contact == NULL) {
         return FALSE;
     }
     if (!_datetimes_equal(p_contact_last_activity(contact), last_activity)) {
         p_contact_set_last_activity(contact, last_activity);
     }
+    _bucket_remove(contact);
     p_contact_set_presence(contact, resource);
+    _bucket_add(contact);
     Jid *jid = jid_create_from_bare_and_resource(barejid, resource->name);
-    autocomplete_add(fulljid_ac, jid->fulljid);
+    autocomplete_add(roster->fulljid_ac, jid->fulljid);
     jid_destroy(jid);
 
     return TRUE;
@@ -109,14 +117,14 @@ roster_update_presence(const char * const barejid, Resource *resource,
 PContact
 roster_get_contact(const char * const barejid)
 {
-    return g_hash_table_lookup(contacts, barejid);
+    return g_hash_table_lookup(roster->contacts, barejid);
 }
 
 gboolean
 roster_contact_offline(const char * const barejid,
     const char * const resource, const char * const status)
 {
-    PContact contact = g_hash_table_lookup(contacts, barejid);
+    PContact contact = g_hash_table_lookup(roster->contacts, barejid);
 
     if (contact == NULL) {
         return FALSE;
@@ -124,10 +132,12 @@ roster_contact_offline(const char * const barejid,
     if (resource == NULL) {
         return TRUE;
     } else {
+        _bucket_remove(contact);
         gboolean result = p_contact_remove_resource(contact, resource);
+        _bucket_add(contact);
         if (result == TRUE) {
             Jid *jid = jid_create_from_bare_and_resource(barejid, resource);
-            autocomplete_remove(fulljid_ac, jid->fulljid);
+            autocomplete_remove(roster->fulljid_ac, jid->fulljid);
             jid_destroy(jid);
         }
 
@@ -138,32 +148,68 @@ roster_contact_offline(const char * const barejid,
 void
 roster_reset_search_attempts(void)
 {
-    autocomplete_reset(name_ac);
-    autocomplete_reset(barejid_ac);
-    autocomplete_reset(fulljid_ac);
-    autocomplete_reset(groups_ac);
+    autocomplete_reset(roster->name_ac);
+    autocomplete_reset(roster->barejid_ac);
+    autocomplete_reset(roster->fulljid_ac);
+    autocomplete_reset(roster->groups_ac);
 }
 
-void
-roster_init(void)
+RosterList*
+roster_list_new(void)
 {
-    name_ac = autocomplete_new();
-    barejid_ac = autocomplete_new();
-    fulljid_ac = autocomplete_new();
-    groups_ac = autocomplete_new();
-    contacts = g_hash_table_new_full(g_str_hash, (GEqualFunc)_key_equals, g_free,
+    RosterList *list = malloc(sizeof(RosterList));
+    list->name_ac = autocomplete_new();
+    list->barejid_ac = autocomplete_new();
+    list->fulljid_ac = autocomplete_new();
+    list->groups_ac = autocomplete_new();
+    list->contacts = g_hash_table_new_full(g_str_hash, (GEqualFunc)_key_equals, g_free,
         (GDestroyNotify)p_contact_free);
-    name_to_barejid = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+    list->name_to_barejid = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
         g_free);
+    list->presence_buckets = _presence_buckets_new();
+
+    return list;
+}
+
+void
+roster_list_free(RosterList *list)
+{
+    if (list) {
+        if (roster == list) {
+            roster = NULL;
+        }
+        autocomplete_free(list->name_ac);
+        autocomplete_free(list->barejid_ac);
+        autocomplete_free(list->fulljid_ac);
+        autocomplete_free(list->groups_ac);
+        g_hash_table_destroy(list->presence_buckets);
+        g_hash_table_destroy(list->name_to_barejid);
+        g_hash_table_destroy(list->contacts);
+        free(list);
+    }
+}
+
+/*
+ * Point the roster functions at another connection's contacts, the list
+ * stays owned by the caller
+ */
+void
+roster_list_use(RosterList *list)
+{
+    roster = list;
+}
+
+// a roster of its own for callers without a connection
+void
+roster_init(void)
+{
+    roster = roster_list_new();
 }
 
 void
 roster_free(void)
 {
-    autocomplete_free(name_ac);
-    autocomplete_free(barejid_ac);
-    autocomplete_free(fulljid_ac);
-    autocomplete_free(groups_ac);
+    roster_list_free(roster);
 }
 
 void
@@ -185,9 +231,9 @@ roster_change_name(PContact contact, const char * const new_name)
 void
 roster_remove(const char * const name, const char * const barejid)
 {
-    autocomplete_remove(barejid_ac, barejid);
-    autocomplete_remove(name_ac, name);
-    g_hash_table_remove(name_to_barejid, name);
+    autocomplete_remove(roster->barejid_ac, barejid);
+    autocomplete_remove(roster->name_ac, name);
+    g_hash_table_remove(roster->name_to_barejid, name);
 
     // remove each fulljid
     PContact contact = roster_get_contact(barejid);
@@ -197,7 +243,7 @@ roster_remove(const char * const name, const char * const barejid)
             GString *fulljid = g_string_new(strdup(barejid));
             g_string_append(fulljid, "/");
             g_string_append(fulljid, resources->data);
-            autocomplete_remove(fulljid_ac, fulljid->str);
+            autocomplete_remove(roster->fulljid_ac, fulljid->str);
             g_string_free(fulljid, TRUE);
             resources = g_list_next(resources);
         }
@@ -205,14 +251,17 @@ roster_remove(const char * const name, const char * const barejid)
     }
 
     // remove the contact
-    g_hash_table_remove(contacts, barejid);
+    if (contact != NULL) {
+        _bucket_remove(contact);
+    }
+    g_hash_table_remove(roster->contacts, barejid);
 }
 
 void
 roster_update(const char * const barejid, const char * const name,
     GSList *groups, const char * const subscription, gboolean pending_out)
 {
-    PContact contact = g_hash_table_lookup(contacts, barejid);
+    PContact contact = g_hash_table_lookup(roster->contacts, barejid);
     assert(contact != NULL);
 
     p_contact_set_subscription(contact, subscription);
@@ -230,7 +279,7 @@ roster_update(const char * const barejid, const char * const name,
 
     // add groups
     while (groups != NULL) {
-        autocomplete_add(groups_ac, groups->data);
+        autocomplete_add(roster->groups_ac, groups->data);
         groups = g_slist_next(groups);
     }
 }
@@ -239,7 +288,7 @@ gboolean
 roster_add(const char * const barejid, const char * const name, GSList *groups,
     const char * const subscription, gboolean pending_out)
 {
-    PContact contact = g_hash_table_lookup(contacts, barejid);
+    PContact contact = g_hash_table_lookup(roster->contacts, barejid);
     if (contact != NULL) {
         return FALSE;
     }
@@ -249,12 +298,13 @@ roster_add(const char * const barejid, const char * const name, GSList *groups,
 
     // add groups
     while (groups != NULL) {
-        autocomplete_add(groups_ac, groups->data);
+        autocomplete_add(roster->groups_ac, groups->data);
         groups = g_slist_next(groups);
     }
 
-    g_hash_table_insert(contacts, strdup(barejid), contact);
-    autocomplete_add(barejid_ac, barejid);
+    g_hash_table_insert(roster->contacts, strdup(barejid), contact);
+    _bucket_add(contact);
+    autocomplete_add(roster->barejid_ac, barejid);
     _add_name_and_barejid(name, barejid);
 
     return TRUE;
@@ -264,7 +314,7 @@ char *
 roster_barejid_from_name(const char * const name)
 {
     if (name) {
-        return g_hash_table_lookup(name_to_barejid, name);
+        return g_hash_table_lookup(roster->name_to_barejid, name);
     } else {
         return NULL;
     }
@@ -274,20 +324,22 @@ GSList *
 roster_get_contacts_by_presence(const char * const presence)
 {
     GSList *result = NULL;
+    GHashTable *bucket = g_hash_table_lookup(roster->presence_buckets, presence);
+    if (bucket == NULL) {
+        return NULL;
+    }
+
     GHashTableIter iter;
     gpointer key;
     gpointer value;
 
-    g_hash_table_iter_init(&iter, contacts);
+    g_hash_table_iter_init(&iter, bucket);
     while (g_hash_table_iter_next(&iter, &key, &value)) {
-        PContact contact = (PContact)value;
-        if (g_strcmp0(p_contact_presence(contact), presence) == 0) {
-            result = g_slist_insert_sorted(result, value, (GCompareFunc)_compare_contacts);
-        }
+        result = g_slist_prepend(result, value);
     }
 
     // resturn all contact structs
-    return result;
+    return g_slist_sort(result, (GCompareFunc)_compare_contacts);
 }
 
 GSList *
@@ -298,7 +350,7 @@ roster_get_contacts(void)
     gpointer key;
     gpointer value;
 
-    g_hash_table_iter_init(&iter, contacts);
+    g_hash_table_iter_init(&iter, roster->contacts);
     while (g_hash_table_iter_next(&iter, &key, &value)) {
         result = g_slist_insert_sorted(result, value, (GCompareFunc)_compare_contacts);
     }
@@ -315,7 +367,7 @@ roster_get_contacts_online(void)
     gpointer key;
     gpointer value;
 
-    g_hash_table_iter_init(&iter, contacts);
+    g_hash_table_iter_init(&iter, roster->contacts);
     while (g_hash_table_iter_next(&iter, &key, &value)) {
         if(strcmp(p_contact_presence(value), "offline"))
             result = g_slist_insert_sorted(result, value, (GCompareFunc)_compare_contacts);
@@ -332,7 +384,7 @@ roster_has_pending_subscriptions(void)
     gpointer key;
     gpointer value;
 
-    g_hash_table_iter_init(&iter, contacts);
+    g_hash_table_iter_init(&iter, roster->contacts);
     while (g_hash_table_iter_next(&iter, &key, &value)) {
         PContact contact = (PContact) value;
         if (p_contact_pending_out(contact)) {
@@ -346,13 +398,13 @@ roster_has_pending_subscriptions(void)
 char *
 roster_contact_autocomplete(const char * const search_str)
 {
-    return autocomplete_complete(name_ac, search_str, TRUE);
+    return autocomplete_complete(roster->name_ac, search_str, TRUE);
 }
 
 char *
 roster_fulljid_autocomplete(const char * const search_str)
 {
-    return autocomplete_complete(fulljid_ac, search_str, TRUE);
+    return autocomplete_complete(roster->fulljid_ac, search_str, TRUE);
 }
 
 GSList *
@@ -363,7 +415,7 @@ roster_get_nogroup(void)
     gpointer key;
     gpointer value;
 
-    g_hash_table_iter_init(&iter, contacts);
+    g_hash_table_iter_init(&iter, roster->contacts);
     while (g_hash_table_iter_next(&iter, &key, &value)) {
         GSList *groups = p_contact_groups(value);
         if (groups == NULL) {
@@ -383,7 +435,7 @@ roster_get_group(const char * const group)
     gpointer key;
     gpointer value;
 
-    g_hash_table_iter_init(&iter, contacts);
+    g_hash_table_iter_init(&iter, roster->contacts);
     while (g_hash_table_iter_next(&iter, &key, &value)) {
         GSList *groups = p_contact_groups(value);
         while (groups != NULL) {
@@ -402,19 +454,19 @@ roster_get_group(const char * const group)
 GSList *
 roster_get_groups(void)
 {
-    return autocomplete_create_list(groups_ac);
+    return autocomplete_create_list(roster->groups_ac);
 }
 
 char *
 roster_group_autocomplete(const char * const search_str)
 {
-    return autocomplete_complete(groups_ac, search_str, TRUE);
+    return autocomplete_complete(roster->groups_ac, search_str, TRUE);
 }
 
 char *
 roster_barejid_autocomplete(const char * const search_str)
 {
-    return autocomplete_complete(barejid_ac, search_str, TRUE);
+    return autocomplete_complete(roster->barejid_ac, search_str, TRUE);
 }
 
 static
@@ -446,13 +498,13 @@ _replace_name(const char * const current_name, const char * const new_name,
 {
     // current handle exists already
     if (current_name != NULL) {
-        autocomplete_remove(name_ac, current_name);
-        g_hash_table_remove(name_to_barejid, current_name);
+        autocomplete_remove(roster->name_ac, current_name);
+        g_hash_table_remove(roster->name_to_barejid, current_name);
         _add_name_and_barejid(new_name, barejid);
     // no current handle
     } else if (new_name != NULL) {
-        autocomplete_remove(name_ac, barejid);
-        g_hash_table_remove(name_to_barejid, barejid);
+        autocomplete_remove(roster->name_ac, barejid);
+        g_hash_table_remove(roster->name_to_barejid, barejid);
         _add_name_and_barejid(new_name, barejid);
     }
 }
@@ -461,11 +513,11 @@ static void
 _add_name_and_barejid(const char * const name, const char * const barejid)
 {
     if (name != NULL) {
-        autocomplete_add(name_ac, name);
-        g_hash_table_insert(name_to_barejid, strdup(name), strdup(barejid));
+        autocomplete_add(roster->name_ac, name);
+        g_hash_table_insert(roster->name_to_barejid, strdup(name), strdup(barejid));
     } else {
-        autocomplete_add(name_ac, barejid);
-        g_hash_table_insert(name_to_barejid, strdup(barejid), strdup(barejid));
+        autocomplete_add(roster->name_ac, barejid);
+        g_hash_table_insert(roster->name_to_barejid, strdup(barejid), strdup(barejid));
     }
 }
 
@@ -496,3 +548,31 @@ gint _compare_contacts(PContact a, PContact b)
 
     return result;
 }
+
+static GHashTable *
+_presence_buckets_new(void)
+{
+    return g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify)g_hash_table_destroy);
+}
+
+static void
+_bucket_add(PContact contact)
+{
+    const char *presence = p_contact_presence(contact);
+    GHashTable *bucket = g_hash_table_lookup(roster->presence_buckets, presence);
+    if (bucket == NULL) {
+        bucket = g_hash_table_new(g_direct_hash, g_direct_equal);
+        g_hash_table_insert(roster->presence_buckets, g_strdup(presence), bucket);
+    }
+    g_hash_table_add(bucket, contact);
+}
+
+static void
+_bucket_remove(PContact contact)
+{
+    GHashTable *bucket = g_hash_table_lookup(roster->presence_buckets, p_contact_presence(contact));
+    if (bucket) {
+        g_hash_table_remove(bucket, contact);
+    }
+}
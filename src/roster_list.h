@@ -40,6 +40,12 @@
 #include "resource.h"
 #include "contact.h"
 
+typedef struct roster_list_t RosterList;
+
+RosterList* roster_list_new(void);
+void roster_list_free(RosterList *list);
+void roster_list_use(RosterList *list);
+
 void roster_clear(void);
 gboolean roster_update_presence(const char * const barejid, Resource *resource,
     GDateTime *last_activity);
@@ -38,8 +38,11 @@
 #include "config.h"
 
 #include "chat_session.h"
+#include "chat_message.h"
 #include "log.h"
 #include "muc.h"
+#include "muc_history.h"
+#include "xmpp/mam.h"
 #include "config/preferences.h"
 #include "config/account.h"
 #include "roster_list.h"
@@ -107,6 +110,16 @@ handle_login_account_success(char *account_name)
 
     ui_handle_login_account_success(account);
 
+    char *seen_file = groupchat_log_seen_filename(account->jid);
+    muc_history_load(seen_file);
+    free(seen_file);
+
+    char *archive_file = chat_log_archive_filename(account->jid);
+    mam_load(archive_file);
+    free(archive_file);
+    Jid *jidp = jabber_get_jid();
+    mam_catch_up(jidp->barejid);
+
     // attempt to rejoin rooms with passwords
     GList *curr = muc_rooms();
     while (curr != NULL) {
@@ -135,6 +148,8 @@ void
 handle_lost_connection(void)
 {
     cons_show_error("Lost connection.");
+    muc_history_save();
+    mam_save();
     roster_clear();
     muc_invites_clear();
     chat_sessions_clear();
@@ -271,22 +286,28 @@ handle_room_subject(const char * const room, const char * const nick, const char
 }
 
 void
-handle_room_history(const char * const room_jid, const char * const nick,
+handle_room_history(const char * const room_jid, const char * const id, const char * const nick,
     GTimeVal tv_stamp, const char * const message)
 {
+    // already shown before a reconnect, or in an earlier session
+    if (muc_history_is_duplicate(room_jid, id, nick, message, &tv_stamp)) {
+        return;
+    }
+
     ui_room_history(room_jid, nick, tv_stamp, message);
+    muc_history_seen(room_jid, id, nick, message, &tv_stamp);
 }
 
 void
-handle_room_message(const char * const room_jid, const char * const nick,
+handle_room_message(const char * const room_jid, const char * const id, const char * const nick,
     const char * const message)
 {
     ui_room_message(room_jid, nick, message);
+    muc_history_seen(room_jid, id, nick, message, NULL);
 
     if (prefs_get_boolean(PREF_GRLOG)) {
-        Jid *jid = jid_create(jabber_get_fulljid());
+        Jid *jid = jabber_get_jid();
         groupchat_log_chat(jid->barejid, room_jid, nick, message);
-        jid_destroy(jid);
     }
 }
 
@@ -297,23 +318,23 @@ handle_incoming_private_message(char *fulljid, char *message)
 }
 
 void
-handle_incoming_message(char *barejid, char *resource, char *message)
+handle_incoming_message(ChatMessage *message)
 {
 #ifdef HAVE_LIBOTR
-    gboolean was_decrypted = FALSE;
-    char *newmessage;
+    char *barejid = message->barejid;
+    char *decrypted = NULL;
 
     prof_otrpolicy_t policy = otr_get_policy(barejid);
-    char *whitespace_base = strstr(message,OTRL_MESSAGE_TAG_BASE);
+    char *whitespace_base = strstr(message->body, OTRL_MESSAGE_TAG_BASE);
 
     //check for OTR whitespace (opportunistic or always)
     if (policy == PROF_OTRPOLICY_OPPORTUNISTIC || policy == PROF_OTRPOLICY_ALWAYS) {
         if (whitespace_base) {
-            if (strstr(message, OTRL_MESSAGE_TAG_V2) || strstr(message, OTRL_MESSAGE_TAG_V1)) {
+            if (strstr(message->body, OTRL_MESSAGE_TAG_V2) || strstr(message->body, OTRL_MESSAGE_TAG_V1)) {
                 // Remove whitespace pattern for proper display in UI
                 // Handle both BASE+TAGV1/2(16+8) and BASE+TAGV1+TAGV2(16+8+8)
                 int tag_length	=	24;
-                if (strstr(message, OTRL_MESSAGE_TAG_V2) && strstr(message, OTRL_MESSAGE_TAG_V1)) {
+                if (strstr(message->body, OTRL_MESSAGE_TAG_V2) && strstr(message->body, OTRL_MESSAGE_TAG_V1)) {
                     tag_length = 32;
                 }
                 memmove(whitespace_base, whitespace_base+tag_length, tag_length);
@@ -323,45 +344,43 @@ handle_incoming_message(char *barejid, char *resource, char *message)
             }
         }
     }
-    newmessage = otr_decrypt_message(barejid, message, &was_decrypted);
 
     // internal OTR message
-    if (newmessage == NULL) {
+    if (!otr_decrypt_message(barejid, message->body, &decrypted)) {
         return;
     }
 
-    if (policy == PROF_OTRPOLICY_ALWAYS && !was_decrypted && !whitespace_base) {
+    // plaintext messages keep the body read from the stanza
+    if (decrypted) {
+        chat_message_set_body(message, decrypted);
+        message->encrypted = TRUE;
+    }
+
+    if (policy == PROF_OTRPOLICY_ALWAYS && !message->encrypted && !whitespace_base) {
         char *otr_query_message = otr_start_query();
         cons_show("Attempting to start OTR session...");
         message_send_chat(barejid, otr_query_message);
     }
 
-    ui_incoming_msg(barejid, resource, newmessage, NULL);
+    ui_incoming_msg(message);
 
     if (prefs_get_boolean(PREF_CHLOG)) {
-        const char *jid = jabber_get_fulljid();
-        Jid *jidp = jid_create(jid);
+        Jid *jidp = jabber_get_jid();
 
         char *pref_otr_log = prefs_get_string(PREF_OTR_LOG);
-        if (!was_decrypted || (strcmp(pref_otr_log, "on") == 0)) {
-            chat_log_chat(jidp->barejid, barejid, newmessage, PROF_IN_LOG, NULL);
+        if (!message->encrypted || (strcmp(pref_otr_log, "on") == 0)) {
+            chat_log_chat(jidp->barejid, barejid, message->body, PROF_IN_LOG, NULL);
         } else if (strcmp(pref_otr_log, "redact") == 0) {
             chat_log_chat(jidp->barejid, barejid, "[redacted]", PROF_IN_LOG, NULL);
         }
         prefs_free_string(pref_otr_log);
-
-        jid_destroy(jidp);
     }
-
-    otr_free_message(newmessage);
 #else
-    ui_incoming_msg(barejid, resource, message, NULL);
+    ui_incoming_msg(message);
 
     if (prefs_get_boolean(PREF_CHLOG)) {
-        const char *jid = jabber_get_fulljid();
-        Jid *jidp = jid_create(jid);
-        chat_log_chat(jidp->barejid, barejid, message, PROF_IN_LOG, NULL);
-        jid_destroy(jidp);
+        Jid *jidp = jabber_get_jid();
+        chat_log_chat(jidp->barejid, message->barejid, message->body, PROF_IN_LOG, NULL);
     }
 #endif
 }
@@ -373,15 +392,43 @@ handle_delayed_private_message(char *fulljid, char *message, GTimeVal tv_stamp)
 }
 
 void
-handle_delayed_message(char *barejid, char *message, GTimeVal tv_stamp)
+handle_delayed_message(ChatMessage *message)
 {
-    ui_incoming_msg(barejid, NULL, message, &tv_stamp);
+    ui_incoming_msg(message);
 
     if (prefs_get_boolean(PREF_CHLOG)) {
-        const char *jid = jabber_get_fulljid();
-        Jid *jidp = jid_create(jid);
-        chat_log_chat(jidp->barejid, barejid, message, PROF_IN_LOG, &tv_stamp);
-        jid_destroy(jidp);
+        Jid *jidp = jabber_get_jid();
+        chat_log_chat(jidp->barejid, message->barejid, message->body, PROF_IN_LOG, &message->timestamp);
+    }
+}
+
+/*
+ * A page of archived messages, in timestamp order. Chat messages go straight
+ * into their windows and logs without per message notifications, room
+ * messages are treated as room history.
+ */
+void
+handle_archived_messages(const char * const archive, GList *messages)
+{
+    Jid *jidp = jabber_get_jid();
+    GList *curr = messages;
+
+    if (g_strcmp0(archive, jidp->barejid) == 0) {
+        ui_archived_messages(messages);
+        if (prefs_get_boolean(PREF_CHLOG)) {
+            while (curr != NULL) {
+                ArchivedMessage *message = curr->data;
+                chat_log_chat(jidp->barejid, message->from, message->body,
+                    message->outgoing ? PROF_OUT_LOG : PROF_IN_LOG, &message->timestamp);
+                curr = g_list_next(curr);
+            }
+        }
+    } else if (muc_active(archive)) {
+        while (curr != NULL) {
+            ArchivedMessage *message = curr->data;
+            handle_room_history(archive, message->id, message->from, message->timestamp, message->body);
+            curr = g_list_next(curr);
+        }
     }
 }
 
@@ -516,6 +563,8 @@ void
 handle_leave_room(const char * const room)
 {
     muc_leave(room);
+    muc_history_save();
+    mam_save();
     ui_leave_room(room);
 }
 
@@ -651,12 +700,6 @@ handle_autoping_cancel(void)
     cons_show_error("Server ping not supported, autoping disabled.");
 }
 
-void
-handle_xmpp_stanza(const char * const msg)
-{
-    ui_handle_stanza(msg);
-}
-
 void
 handle_ping_result(const char * const from, int millis)
 {
@@ -702,6 +745,7 @@ handle_muc_self_online(const char * const room, const char * const nick, gboolea
         }
         muc_invites_remove(room);
         muc_roster_set_complete(room);
+        mam_catch_up(room);
 
         // show roster if occupants list disabled by default
         if (!prefs_get_boolean(PREF_OCCUPANTS)) {
@@ -35,6 +35,7 @@
 #ifndef SERVER_EVENTS_H
 #define SERVER_EVENTS_H
 
+#include "chat_message.h"
 #include "xmpp/xmpp.h"
 
 void handle_login_account_success(char *account_name);
@@ -52,9 +53,9 @@ void handle_room_invite(jabber_invite_t invite_type,
 void handle_room_broadcast(const char *const room_jid,
     const char * const message);
 void handle_room_subject(const char * const room, const char * const nick, const char * const subject);
-void handle_room_history(const char * const room_jid, const char * const nick,
+void handle_room_history(const char * const room_jid, const char * const id, const char * const nick,
     GTimeVal tv_stamp, const char * const message);
-void handle_room_message(const char * const room_jid, const char * const nick,
+void handle_room_message(const char * const room_jid, const char * const id, const char * const nick,
     const char * const message);
 void handle_room_join_error(const char * const room, const char * const err);
 void handle_room_info_error(const char * const room, const char * const error);
@@ -69,10 +70,11 @@ void handle_room_role_list(const char * const from, const char * const role, GSL
 void handle_room_role_set_error(const char * const room, const char * const nick, const char * const role,
     const char * const error);
 void handle_room_kick_result_error(const char * const room, const char * const nick, const char * const error);
-void handle_incoming_message(char *barejid, char *resource, char *message);
+void handle_incoming_message(ChatMessage *message);
 void handle_incoming_private_message(char *fulljid, char *message);
-void handle_delayed_message(char *fulljid, char *message, GTimeVal tv_stamp);
+void handle_delayed_message(ChatMessage *message);
 void handle_delayed_private_message(char *fulljid, char *message, GTimeVal tv_stamp);
+void handle_archived_messages(const char * const archive, GList *messages);
 void handle_typing(char *barejid, char *resource);
 void handle_paused(char *barejid, char *resource);
 void handle_inactive(char *barejid, char *resource);
@@ -105,7 +107,6 @@ void handle_message_error(const char * const from, const char * const type,
     const char * const err_msg);
 void handle_presence_error(const char *from, const char * const type,
     const char *err_msg);
-void handle_xmpp_stanza(const char * const msg);
 void handle_ping_result(const char * const from, int millis);
 void handle_ping_error_result(const char * const from, const char * const error);
 void handle_room_configure(const char * const room, DataForm *form);
@@ -117,6 +117,37 @@ autocomplete_add(Autocomplete ac, const char *item)
     return;
 }
 
+/*
+ * Add a batch of items with one sort instead of a sorted insert per item
+ */
+void
+autocomplete_add_all(Autocomplete ac, GSList *items)
+{
+    if (ac) {
+        GSList *all = ac->items;
+        GSList *curr = items;
+        while (curr) {
+            all = g_slist_prepend(all, strdup(curr->data));
+            curr = g_slist_next(curr);
+        }
+        all = g_slist_sort(all, (GCompareFunc)strcmp);
+
+        // drop duplicates, now adjacent
+        curr = all;
+        while (curr && curr->next) {
+            if (strcmp(curr->data, curr->next->data) == 0) {
+                free(curr->next->data);
+                curr->next = g_slist_delete_link(curr->next, curr->next);
+            } else {
+                curr = g_slist_next(curr);
+            }
+        }
+
+        ac->items = all;
+        autocomplete_reset(ac);
+    }
+}
+
 void
 autocomplete_remove(Autocomplete ac, const char * const item)
 {
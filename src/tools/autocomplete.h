@@ -50,6 +50,7 @@ void autocomplete_clear(Autocomplete ac);
 void autocomplete_free(Autocomplete ac);
 
 void autocomplete_add(Autocomplete ac, const char *item);
+void autocomplete_add_all(Autocomplete ac, GSList *items);
 void autocomplete_remove(Autocomplete ac, const char * const item);
 
 // find the next item prefixed with search string
@@ -0,0 +1,310 @@
+/*
+ * gapbuffer.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "tools/gapbuffer.h"
+
+#define GAPBUF_INITIAL_SIZE 256
+
+// text before the cursor is data[0, gap_start), text after is data[gap_end, size),
+// data[size] is always '\0' so the text after the cursor is a C string
+struct gap_buffer_t {
+    char *data;
+    int size;
+    int gap_start;
+    int gap_end;
+    int chars_before;
+    int cols_before;
+    int chars_after;
+    int cols_after;
+};
+
+static void _make_room(GapBuffer buf, int needed);
+static int _char_width(gunichar ch);
+
+GapBuffer
+gapbuf_new(void)
+{
+    GapBuffer buf = malloc(sizeof(struct gap_buffer_t));
+    buf->size = GAPBUF_INITIAL_SIZE;
+    buf->data = malloc(buf->size + 1);
+    buf->data[buf->size] = '\0';
+    gapbuf_clear(buf);
+
+    return buf;
+}
+
+void
+gapbuf_free(GapBuffer buf)
+{
+    if (buf) {
+        free(buf->data);
+        free(buf);
+    }
+}
+
+void
+gapbuf_clear(GapBuffer buf)
+{
+    buf->gap_start = 0;
+    buf->gap_end = buf->size;
+    buf->chars_before = 0;
+    buf->cols_before = 0;
+    buf->chars_after = 0;
+    buf->cols_after = 0;
+}
+
+void
+gapbuf_set(GapBuffer buf, const char * const str)
+{
+    gapbuf_clear(buf);
+    gapbuf_insert(buf, str, -1);
+}
+
+// insert len bytes of str at the cursor, or all of it when len is -1
+void
+gapbuf_insert(GapBuffer buf, const char * const str, int len)
+{
+    if (len < 0) {
+        len = strlen(str);
+    }
+    if (len == 0) {
+        return;
+    }
+
+    _make_room(buf, len);
+    memcpy(&buf->data[buf->gap_start], str, len);
+    buf->gap_start += len;
+
+    const char *curr = str;
+    while (curr < str + len) {
+        buf->chars_before++;
+        buf->cols_before += _char_width(g_utf8_get_char(curr));
+        curr = g_utf8_next_char(curr);
+    }
+}
+
+gboolean
+gapbuf_delete_prev(GapBuffer buf)
+{
+    if (buf->gap_start == 0) {
+        return FALSE;
+    }
+
+    char *prev = g_utf8_find_prev_char(buf->data, &buf->data[buf->gap_start]);
+    buf->cols_before -= _char_width(g_utf8_get_char(prev));
+    buf->chars_before--;
+    buf->gap_start = prev - buf->data;
+
+    return TRUE;
+}
+
+gboolean
+gapbuf_delete_next(GapBuffer buf)
+{
+    if (buf->gap_end == buf->size) {
+        return FALSE;
+    }
+
+    char *curr = &buf->data[buf->gap_end];
+    buf->cols_after -= _char_width(g_utf8_get_char(curr));
+    buf->chars_after--;
+    buf->gap_end = g_utf8_next_char(curr) - buf->data;
+
+    return TRUE;
+}
+
+gboolean
+gapbuf_left(GapBuffer buf)
+{
+    if (buf->gap_start == 0) {
+        return FALSE;
+    }
+
+    char *prev = g_utf8_find_prev_char(buf->data, &buf->data[buf->gap_start]);
+    int len = &buf->data[buf->gap_start] - prev;
+    int width = _char_width(g_utf8_get_char(prev));
+
+    buf->gap_end -= len;
+    memmove(&buf->data[buf->gap_end], prev, len);
+    buf->gap_start -= len;
+
+    buf->chars_before--;
+    buf->cols_before -= width;
+    buf->chars_after++;
+    buf->cols_after += width;
+
+    return TRUE;
+}
+
+gboolean
+gapbuf_right(GapBuffer buf)
+{
+    if (buf->gap_end == buf->size) {
+        return FALSE;
+    }
+
+    char *curr = &buf->data[buf->gap_end];
+    int len = g_utf8_next_char(curr) - curr;
+    int width = _char_width(g_utf8_get_char(curr));
+
+    memmove(&buf->data[buf->gap_start], curr, len);
+    buf->gap_start += len;
+    buf->gap_end += len;
+
+    buf->chars_before++;
+    buf->cols_before += width;
+    buf->chars_after--;
+    buf->cols_after -= width;
+
+    return TRUE;
+}
+
+void
+gapbuf_set_cursor(GapBuffer buf, int pos)
+{
+    while (buf->chars_before > pos && gapbuf_left(buf));
+    while (buf->chars_before < pos && gapbuf_right(buf));
+}
+
+gunichar
+gapbuf_char_before(GapBuffer buf)
+{
+    if (buf->gap_start == 0) {
+        return 0;
+    }
+
+    return g_utf8_get_char(g_utf8_find_prev_char(buf->data, &buf->data[buf->gap_start]));
+}
+
+gunichar
+gapbuf_char_after(GapBuffer buf)
+{
+    if (buf->gap_end == buf->size) {
+        return 0;
+    }
+
+    return g_utf8_get_char(&buf->data[buf->gap_end]);
+}
+
+gunichar
+gapbuf_first_char(GapBuffer buf)
+{
+    if (buf->gap_start > 0) {
+        return g_utf8_get_char(buf->data);
+    }
+
+    return gapbuf_char_after(buf);
+}
+
+int
+gapbuf_cursor(GapBuffer buf)
+{
+    return buf->chars_before;
+}
+
+int
+gapbuf_cursor_col(GapBuffer buf)
+{
+    return buf->cols_before;
+}
+
+int
+gapbuf_length(GapBuffer buf)
+{
+    return buf->chars_before + buf->chars_after;
+}
+
+int
+gapbuf_width(GapBuffer buf)
+{
+    return buf->cols_before + buf->cols_after;
+}
+
+int
+gapbuf_bytes(GapBuffer buf)
+{
+    return buf->gap_start + (buf->size - buf->gap_end);
+}
+
+const char *
+gapbuf_after_cursor(GapBuffer buf)
+{
+    return &buf->data[buf->gap_end];
+}
+
+char *
+gapbuf_contents(GapBuffer buf)
+{
+    int after_len = buf->size - buf->gap_end;
+    char *result = malloc(buf->gap_start + after_len + 1);
+    memcpy(result, buf->data, buf->gap_start);
+    memcpy(&result[buf->gap_start], &buf->data[buf->gap_end], after_len + 1);
+
+    return result;
+}
+
+// grow the gap to at least needed bytes, doubling the buffer so inserts are amortised constant time
+static void
+_make_room(GapBuffer buf, int needed)
+{
+    if (buf->gap_end - buf->gap_start >= needed) {
+        return;
+    }
+
+    int after_len = buf->size - buf->gap_end;
+    int new_size = buf->size * 2;
+    while (new_size - buf->gap_start - after_len < needed) {
+        new_size *= 2;
+    }
+
+    char *new_data = malloc(new_size + 1);
+    memcpy(new_data, buf->data, buf->gap_start);
+    memcpy(&new_data[new_size - after_len], &buf->data[buf->gap_end], after_len + 1);
+
+    free(buf->data);
+    buf->data = new_data;
+    buf->gap_end = new_size - after_len;
+    buf->size = new_size;
+}
+
+static int
+_char_width(gunichar ch)
+{
+    return g_unichar_iswide(ch) ? 2 : 1;
+}
@@ -0,0 +1,65 @@
+/*
+ * gapbuffer.h
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef GAPBUFFER_H
+#define GAPBUFFER_H
+
+#include <glib.h>
+
+// UTF-8 text with a gap at the cursor, so editing at the cursor is constant time.
+// Positions are in code points, columns count wide characters as two.
+typedef struct gap_buffer_t *GapBuffer;
+
+GapBuffer gapbuf_new(void);
+void gapbuf_free(GapBuffer buf);
+void gapbuf_clear(GapBuffer buf);
+void gapbuf_set(GapBuffer buf, const char * const str);
+void gapbuf_insert(GapBuffer buf, const char * const str, int len);
+gboolean gapbuf_delete_prev(GapBuffer buf);
+gboolean gapbuf_delete_next(GapBuffer buf);
+gboolean gapbuf_left(GapBuffer buf);
+gboolean gapbuf_right(GapBuffer buf);
+void gapbuf_set_cursor(GapBuffer buf, int pos);
+gunichar gapbuf_char_before(GapBuffer buf);
+gunichar gapbuf_char_after(GapBuffer buf);
+gunichar gapbuf_first_char(GapBuffer buf);
+int gapbuf_cursor(GapBuffer buf);
+int gapbuf_cursor_col(GapBuffer buf);
+int gapbuf_length(GapBuffer buf);
+int gapbuf_width(GapBuffer buf);
+int gapbuf_bytes(GapBuffer buf);
+const char * gapbuf_after_cursor(GapBuffer buf);
+char * gapbuf_contents(GapBuffer buf);
+
+#endif
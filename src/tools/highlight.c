@@ -0,0 +1,250 @@
+/*
+ * highlight.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "common.h"
+#include "tools/highlight.h"
+
+#define HL_NO_STATE -1
+#define HL_ALPHABET 256
+
+// words are matched with an Aho-Corasick automaton over the casefolded
+// UTF-8 bytes, once compiled every state has a transition for every byte
+// so a message is scanned in one pass whatever the number of words
+typedef struct hl_state_t {
+    int next[HL_ALPHABET];
+    int fail;
+    gboolean output;
+} HLState;
+
+struct highlighter_t {
+    GSList *words;
+    GArray *states;
+    GSList *regexes;
+    gboolean compiled;
+};
+
+static int _add_state(Highlighter highlighter);
+static void _add_to_trie(Highlighter highlighter, const char * const word);
+static void _compile(Highlighter highlighter);
+
+#define STATE(highlighter, i) (&g_array_index((highlighter)->states, HLState, (i)))
+
+Highlighter
+highlighter_new(void)
+{
+    Highlighter new = malloc(sizeof(struct highlighter_t));
+    new->words = NULL;
+    new->states = g_array_new(FALSE, FALSE, sizeof(HLState));
+    new->regexes = NULL;
+    new->compiled = FALSE;
+
+    return new;
+}
+
+void
+highlighter_free(Highlighter highlighter)
+{
+    if (highlighter != NULL) {
+        g_slist_free_full(highlighter->words, g_free);
+        g_array_free(highlighter->states, TRUE);
+        g_slist_free_full(highlighter->regexes, (GDestroyNotify)g_regex_unref);
+        free(highlighter);
+    }
+}
+
+void
+highlighter_add_word(Highlighter highlighter, const char * const word)
+{
+    if (word == NULL || word[0] == '\0') {
+        return;
+    }
+
+    highlighter->words = g_slist_append(highlighter->words, g_utf8_casefold(word, -1));
+    highlighter->compiled = FALSE;
+}
+
+gboolean
+highlighter_add_regex(Highlighter highlighter, const char * const pattern)
+{
+    GRegex *regex = g_regex_new(pattern, G_REGEX_CASELESS | G_REGEX_OPTIMIZE, 0, NULL);
+    if (regex == NULL) {
+        return FALSE;
+    }
+
+    highlighter->regexes = g_slist_append(highlighter->regexes, regex);
+    return TRUE;
+}
+
+void
+highlighter_add_entry(Highlighter highlighter, const char * const entry)
+{
+    size_t len = strlen(entry);
+    if (len > 2 && entry[0] == '/' && entry[len - 1] == '/') {
+        gchar *pattern = g_strndup(&entry[1], len - 2);
+        highlighter_add_regex(highlighter, pattern);
+        g_free(pattern);
+    } else {
+        highlighter_add_word(highlighter, entry);
+    }
+}
+
+gboolean
+highlighter_matches(Highlighter highlighter, const char * const message)
+{
+    if (message == NULL) {
+        return FALSE;
+    }
+
+    if (highlighter->words != NULL) {
+        if (!highlighter->compiled) {
+            _compile(highlighter);
+        }
+
+        gboolean found = FALSE;
+        gchar *folded = g_utf8_casefold(message, -1);
+        int state = 0;
+        const guchar *curr = (const guchar *)folded;
+        while (*curr != '\0') {
+            state = STATE(highlighter, state)->next[*curr];
+            if (STATE(highlighter, state)->output) {
+                found = TRUE;
+                break;
+            }
+            curr++;
+        }
+        g_free(folded);
+
+        if (found) {
+            return TRUE;
+        }
+    }
+
+    GSList *curr_regex = highlighter->regexes;
+    while (curr_regex != NULL) {
+        if (g_regex_match(curr_regex->data, message, 0, NULL)) {
+            return TRUE;
+        }
+        curr_regex = g_slist_next(curr_regex);
+    }
+
+    return FALSE;
+}
+
+static int
+_add_state(Highlighter highlighter)
+{
+    HLState state;
+    int i;
+    for (i = 0; i < HL_ALPHABET; i++) {
+        state.next[i] = HL_NO_STATE;
+    }
+    state.fail = 0;
+    state.output = FALSE;
+    g_array_append_val(highlighter->states, state);
+
+    return highlighter->states->len - 1;
+}
+
+static void
+_add_to_trie(Highlighter highlighter, const char * const word)
+{
+    int state = 0;
+    const guchar *curr = (const guchar *)word;
+    while (*curr != '\0') {
+        int next = STATE(highlighter, state)->next[*curr];
+        if (next == HL_NO_STATE) {
+            next = _add_state(highlighter);
+            STATE(highlighter, state)->next[*curr] = next;
+        }
+        state = next;
+        curr++;
+    }
+    STATE(highlighter, state)->output = TRUE;
+}
+
+static void
+_compile(Highlighter highlighter)
+{
+    g_array_set_size(highlighter->states, 0);
+    _add_state(highlighter);
+
+    GSList *curr_word = highlighter->words;
+    while (curr_word != NULL) {
+        _add_to_trie(highlighter, curr_word->data);
+        curr_word = g_slist_next(curr_word);
+    }
+
+    // breadth first, so the failure state of each state is complete
+    // before its own missing transitions are filled from it
+    GQueue *queue = g_queue_new();
+    int c;
+
+    HLState *root = STATE(highlighter, 0);
+    for (c = 0; c < HL_ALPHABET; c++) {
+        int child = root->next[c];
+        if (child == HL_NO_STATE) {
+            root->next[c] = 0;
+        } else {
+            STATE(highlighter, child)->fail = 0;
+            g_queue_push_tail(queue, GINT_TO_POINTER(child));
+        }
+    }
+
+    while (!g_queue_is_empty(queue)) {
+        int curr = GPOINTER_TO_INT(g_queue_pop_head(queue));
+        HLState *state = STATE(highlighter, curr);
+        HLState *fail = STATE(highlighter, state->fail);
+        if (fail->output) {
+            state->output = TRUE;
+        }
+
+        for (c = 0; c < HL_ALPHABET; c++) {
+            int child = state->next[c];
+            if (child == HL_NO_STATE) {
+                state->next[c] = fail->next[c];
+            } else {
+                STATE(highlighter, child)->fail = fail->next[c];
+                g_queue_push_tail(queue, GINT_TO_POINTER(child));
+            }
+        }
+    }
+
+    g_queue_free(queue);
+    highlighter->compiled = TRUE;
+}
@@ -34,9 +34,13 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
+#include <sys/stat.h>
 
 #include <glib.h>
+#include <glib/gstdio.h>
 
+#include "common.h"
 #include "history.h"
 
 struct history_session_t {
@@ -46,10 +50,27 @@ struct history_session_t {
     GList *orig_curr;
 };
 
+// a distinct history item and the sequence number of its latest occurrence
+typedef struct history_index_entry_t {
+    char *text;
+    gint64 latest;
+    GSequenceIter *pos;
+} HistoryIndexEntry;
+
 struct history_t {
-    GList *items;
+    GQueue *items;
     guint max_size;
     struct history_session_t session;
+    // sequence number of the next item appended, older items count down from it
+    gint64 next_seq;
+    // distinct items by text, and the same entries sorted for prefix search
+    GHashTable *index;
+    GSequence *sorted;
+    gboolean index_dirty;
+    char *filename;
+    history_save_func save_filter;
+    gboolean loaded;
+    gsize load_until;
 };
 
 static void _replace_history_with_session(History history);
@@ -64,34 +85,105 @@ static void _replace_current_with_original(History history);
 static void _create_session(History history);
 static void _session_previous(History history);
 static void _session_next(History history);
+static void _load(History history);
+static void _write(History history, const char * const item);
+static void _index_add(History history, const char * const item, gint64 seq);
+static void _index_remove(History history, const char * const item, gint64 seq);
+static void _index_rebuild(History history);
+static GSequenceIter * _index_lower_bound(History history, const char * const text);
+static gint _compare_index_entries(HistoryIndexEntry *a, HistoryIndexEntry *b, gpointer data);
+static void _free_index_entry(HistoryIndexEntry *entry);
 
 History
 history_new(unsigned int size)
 {
     History new_history = malloc(sizeof(struct history_t));
-    new_history->items = NULL;
+    new_history->items = g_queue_new();
     new_history->max_size = size;
+    new_history->next_seq = 0;
+    new_history->index = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)_free_index_entry);
+    new_history->sorted = g_sequence_new(NULL);
+    new_history->index_dirty = FALSE;
+    new_history->filename = NULL;
+    new_history->save_filter = NULL;
+    new_history->loaded = TRUE;
+    new_history->load_until = 0;
 
     _reset_session(new_history);
 
     return new_history;
 }
 
+void
+history_free(History history)
+{
+    if (history) {
+        g_list_free(history->session.items);
+        g_queue_free_full(history->items, free);
+        g_sequence_free(history->sorted);
+        g_hash_table_destroy(history->index);
+        free(history->filename);
+        free(history);
+    }
+}
+
+/*
+ * Keep history in filename, items already in the file are loaded the first
+ * time history is browsed or searched, new items are appended to it.
+ * Setting the file in use again, as on reconnect, changes nothing.
+ */
+void
+history_set_file(History history, const char * const filename)
+{
+    if (g_strcmp0(history->filename, filename) == 0) {
+        return;
+    }
+
+    free(history->filename);
+    history->filename = strdup(filename);
+    history->loaded = FALSE;
+
+    GStatBuf st;
+    if (g_stat(filename, &st) == 0) {
+        history->load_until = st.st_size;
+    } else {
+        history->load_until = 0;
+    }
+}
+
+void
+history_set_save_filter(History history, history_save_func save_func)
+{
+    history->save_filter = save_func;
+}
+
+void
+history_set_size(History history, unsigned int size)
+{
+    history->max_size = size;
+    while (g_queue_get_length(history->items) > history->max_size) {
+        _remove_first(history);
+    }
+}
+
 void
 history_append(History history, char *item)
 {
-    char *copied = "";
+    char *copied = strdup("");
     if (item != NULL) {
+        free(copied);
         copied = strdup(item);
     }
 
-    if (history->items == NULL) {
+    _write(history, copied);
+
+    if (g_queue_is_empty(history->items)) {
         _add_to_history(history, copied);
         return;
     }
 
     if (!_has_session(history)) {
-        if (g_list_length(history->items) == history->max_size) {
+        if (g_queue_get_length(history->items) >= history->max_size) {
             _remove_first(history);
         }
 
@@ -116,19 +208,23 @@ history_append(History history, char *item)
             _replace_current_with_original(history);
             _replace_history_with_session(history);
         }
+        history->next_seq++;
     }
 }
 
 char *
 history_previous(History history, char *item)
 {
+    _load(history);
+
     // no history
-    if (history->items == NULL) {
+    if (g_queue_is_empty(history->items)) {
         return NULL;
     }
 
-    char *copied = "";
+    char *copied = strdup("");
     if (item != NULL) {
+        free(copied);
         copied = strdup(item);
     }
 
@@ -154,7 +250,7 @@ char *
 history_next(History history, char *item)
 {
     // no history, or no session, return NULL
-    if ((history->items == NULL) || (history->session.items == NULL)) {
+    if (g_queue_is_empty(history->items) || (history->session.items == NULL)) {
         return NULL;
     }
 
@@ -162,8 +258,9 @@ history_next(History history, char *item)
         return NULL;
     }
 
-    char *copied = "";
+    char *copied = strdup("");
     if (item != NULL) {
+        free(copied);
         copied = strdup(item);
     }
 
@@ -174,16 +271,59 @@ history_next(History history, char *item)
     return result;
 }
 
+/*
+ * Find the most recent item starting with prefix, older than *position.
+ * Start with *position as HISTORY_SEARCH_NEWEST, it is updated to the item found
+ * so calling again finds the next older match. Repeated items are only found once.
+ * Returns a newly allocated string, or NULL when there are no more matches.
+ */
+char *
+history_search(History history, const char * const prefix, gint64 *position)
+{
+    _load(history);
+    if (history->index_dirty) {
+        _index_rebuild(history);
+    }
+
+    gint64 bound = *position;
+    HistoryIndexEntry *found = NULL;
+
+    GSequenceIter *iter = _index_lower_bound(history, prefix);
+    while (!g_sequence_iter_is_end(iter)) {
+        HistoryIndexEntry *entry = g_sequence_get(iter);
+        if (!g_str_has_prefix(entry->text, prefix)) {
+            break;
+        }
+        if (entry->latest < bound && (found == NULL || entry->latest > found->latest)) {
+            found = entry;
+        }
+        iter = g_sequence_iter_next(iter);
+    }
+
+    if (found == NULL) {
+        return NULL;
+    }
+
+    *position = found->latest;
+    return strdup(found->text);
+}
+
 static void
 _replace_history_with_session(History history)
 {
-    g_list_free(history->items);
-    history->items = g_list_copy(history->session.items);
+    g_queue_clear(history->items);
+    GList *curr = history->session.items;
+    while (curr) {
+        g_queue_push_tail(history->items, curr->data);
+        curr = g_list_next(curr);
+    }
+    g_list_free(history->session.items);
 
-    if (g_list_length(history->items) > history->max_size) {
+    while (g_queue_get_length(history->items) > history->max_size) {
         _remove_first(history);
     }
 
+    history->index_dirty = TRUE;
     _reset_session(history);
 }
 
@@ -212,9 +352,12 @@ _has_session(History history)
 static void
 _remove_first(History history)
 {
-    GList *first = g_list_first(history->items);
-    char *first_item = first->data;
-    history->items = g_list_remove(history->items, first_item);
+    gint64 seq = history->next_seq - g_queue_get_length(history->items);
+    char *first_item = g_queue_pop_head(history->items);
+    if (!history->index_dirty) {
+        _index_remove(history, first_item, seq);
+    }
+    free(first_item);
 }
 
 static void
@@ -226,7 +369,11 @@ _update_current_session_item(History history, char *item)
 static void
 _add_to_history(History history, char *item)
 {
-    history->items = g_list_append(history->items, item);
+    g_queue_push_tail(history->items, item);
+    if (!history->index_dirty) {
+        _index_add(history, item, history->next_seq);
+    }
+    history->next_seq++;
 }
 
 static void
@@ -248,9 +395,9 @@ _replace_current_with_original(History history)
 static void
 _create_session(History history)
 {
-    history->session.items = g_list_copy(history->items);
+    history->session.items = g_list_copy(history->items->head);
     history->session.sess_curr = g_list_last(history->session.items);
-    history->session.orig_curr = g_list_last(history->items);
+    history->session.orig_curr = history->items->tail;
 }
 
 static void
@@ -259,14 +406,14 @@ _session_previous(History history)
     history->session.sess_curr =
         g_list_previous(history->session.sess_curr);
     if (history->session.orig_curr == NULL)
-        history->session.orig_curr = g_list_last(history->items);
+        history->session.orig_curr = history->items->tail;
     else
         history->session.orig_curr =
             g_list_previous(history->session.orig_curr);
 
     if (history->session.sess_curr == NULL) {
         history->session.sess_curr = g_list_first(history->session.items);
-        history->session.orig_curr = g_list_first(history->items);
+        history->session.orig_curr = history->items->head;
     }
 }
 
@@ -281,3 +428,182 @@ _session_next(History history)
         history->session.orig_curr = NULL;
     }
 }
+
+/*
+ * Put the items written to the file before it was set in front of the current items,
+ * the file is rewritten when it has grown past twice the history size
+ */
+static void
+_load(History history)
+{
+    if (history->loaded || history->filename == NULL) {
+        return;
+    }
+    history->loaded = TRUE;
+
+    gchar *contents = NULL;
+    gsize length = 0;
+    if (!g_file_get_contents(history->filename, &contents, &length, NULL)) {
+        return;
+    }
+    if (history->load_until > length) {
+        history->load_until = length;
+    }
+
+    gchar *saved = g_strndup(contents, history->load_until);
+    gchar **lines = g_strsplit(saved, "\n", -1);
+    g_free(saved);
+
+    GPtrArray *items = g_ptr_array_new();
+    int i;
+    for (i = 0; lines[i] != NULL; i++) {
+        if (strlen(lines[i]) > 0) {
+            g_ptr_array_add(items, lines[i]);
+        }
+    }
+
+    guint current = g_queue_get_length(history->items);
+    guint space = (history->max_size > current) ? history->max_size - current : 0;
+    guint first = (items->len > space) ? items->len - space : 0;
+    guint j;
+    for (j = items->len; j > first; j--) {
+        g_queue_push_head(history->items, strdup(g_ptr_array_index(items, j - 1)));
+    }
+    history->index_dirty = TRUE;
+
+    if (items->len > history->max_size * 2) {
+        guint keep = items->len - history->max_size;
+        GString *compacted = g_string_new("");
+        for (j = keep; j < items->len; j++) {
+            g_string_append_printf(compacted, "%s\n", (char *)g_ptr_array_index(items, j));
+        }
+        g_string_append(compacted, contents + history->load_until);
+        if (g_file_set_contents(history->filename, compacted->str, compacted->len, NULL)) {
+            g_chmod(history->filename, S_IRUSR | S_IWUSR);
+        }
+        g_string_free(compacted, TRUE);
+    }
+
+    g_ptr_array_free(items, TRUE);
+    g_strfreev(lines);
+    g_free(contents);
+}
+
+static void
+_write(History history, const char * const item)
+{
+    // the file holds one entry per line, multi-line pastes stay in memory only
+    if (history->filename == NULL || strlen(item) == 0 || strchr(item, '\n')) {
+        return;
+    }
+    if (history->save_filter != NULL && !history->save_filter(item)) {
+        return;
+    }
+
+    FILE *file = fopen(history->filename, "a");
+    if (file) {
+        fprintf(file, "%s\n", item);
+        fclose(file);
+        g_chmod(history->filename, S_IRUSR | S_IWUSR);
+    }
+}
+
+static void
+_index_add(History history, const char * const item, gint64 seq)
+{
+    if (strlen(item) == 0) {
+        return;
+    }
+
+    HistoryIndexEntry *entry = g_hash_table_lookup(history->index, item);
+    if (entry) {
+        entry->latest = seq;
+        return;
+    }
+
+    entry = malloc(sizeof(HistoryIndexEntry));
+    entry->text = strdup(item);
+    entry->latest = seq;
+    g_hash_table_insert(history->index, entry->text, entry);
+
+    entry->pos = g_sequence_insert_sorted(history->sorted, entry,
+        (GCompareDataFunc)_compare_index_entries, NULL);
+}
+
+// drop the entry for an evicted item, unless the item occurs again later
+static void
+_index_remove(History history, const char * const item, gint64 seq)
+{
+    HistoryIndexEntry *entry = g_hash_table_lookup(history->index, item);
+    if (entry == NULL || entry->latest != seq) {
+        return;
+    }
+
+    g_sequence_remove(entry->pos);
+    g_hash_table_remove(history->index, item);
+}
+
+static void
+_index_rebuild(History history)
+{
+    g_sequence_remove_range(g_sequence_get_begin_iter(history->sorted),
+        g_sequence_get_end_iter(history->sorted));
+    g_hash_table_remove_all(history->index);
+
+    gint64 seq = history->next_seq - g_queue_get_length(history->items);
+    GList *curr = history->items->head;
+    while (curr) {
+        char *item = curr->data;
+        if (strlen(item) > 0) {
+            HistoryIndexEntry *entry = g_hash_table_lookup(history->index, item);
+            if (entry == NULL) {
+                entry = malloc(sizeof(HistoryIndexEntry));
+                entry->text = strdup(item);
+                g_hash_table_insert(history->index, entry->text, entry);
+                entry->pos = g_sequence_append(history->sorted, entry);
+            }
+            entry->latest = seq;
+        }
+        seq++;
+        curr = g_list_next(curr);
+    }
+
+    g_sequence_sort(history->sorted, (GCompareDataFunc)_compare_index_entries, NULL);
+    history->index_dirty = FALSE;
+}
+
+static gint
+_compare_index_entries(HistoryIndexEntry *a, HistoryIndexEntry *b, gpointer data)
+{
+    return strcmp(a->text, b->text);
+}
+
+// position of the first sorted entry not less than text
+static GSequenceIter *
+_index_lower_bound(History history, const char * const text)
+{
+    HistoryIndexEntry probe;
+    probe.text = (char *)text;
+    GSequenceIter *iter = g_sequence_search(history->sorted, &probe,
+        (GCompareDataFunc)_compare_index_entries, NULL);
+
+    // search gives the position after an equal entry, entries are distinct so step back at most once
+    if (!g_sequence_iter_is_begin(iter)) {
+        GSequenceIter *prev = g_sequence_iter_prev(iter);
+        HistoryIndexEntry *entry = g_sequence_get(prev);
+        if (strcmp(entry->text, text) == 0) {
+            iter = prev;
+        }
+    }
+
+    return iter;
+}
+
+static void
+_free_index_entry(HistoryIndexEntry *entry)
+{
+    if (entry) {
+        free(entry->text);
+        free(entry);
+    }
+}
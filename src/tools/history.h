@@ -35,11 +35,23 @@
 #ifndef HISTORY_H
 #define HISTORY_H
 
+#include <glib.h>
+
+#define HISTORY_SEARCH_NEWEST G_MAXINT64
+
 typedef struct history_t  *History;
 
+// return FALSE for items that must not be written to the history file
+typedef gboolean (*history_save_func)(const char * const item);
+
 History history_new(unsigned int size);
+void history_free(History history);
+void history_set_file(History history, const char * const filename);
+void history_set_save_filter(History history, history_save_func save_func);
+void history_set_size(History history, unsigned int size);
 char * history_previous(History history, char *item);
 char * history_next(History history, char *item);
 void history_append(History history, char *item);
+char * history_search(History history, const char * const prefix, gint64 *position);
 
 #endif
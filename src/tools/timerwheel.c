@@ -0,0 +1,273 @@
+/*
+ * timerwheel.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "common.h"
+#include "tools/timerwheel.h"
+
+/*
+ * Hierarchical timer wheel, level 0 has one slot per tick and each further
+ * level has one slot per full turn of the level below. A timer sits in the
+ * level that covers its deadline and moves down a level each time the slot it
+ * is in comes round, so advancing only touches timers that are nearly due.
+ */
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4
+
+// the top level is used for anything further away, such timers are cascaded again
+#define WHEEL_MAX_TICKS (((gint64)1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1)
+
+struct wheel_timer_t {
+    gint64 expires;
+    wheel_timer_func func;
+    void *data;
+    // level and slot the timer is in, level -1 while waiting to fire
+    int level;
+    int slot;
+    GList *link;
+};
+
+struct timer_wheel_t {
+    gint64 current;
+    GList *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    GList *firing;
+    guint pending;
+};
+
+static gint64 _ms_to_ticks(gint64 ms);
+static void _insert(TimerWheel wheel, WheelTimer *timer);
+static void _unlink(TimerWheel wheel, WheelTimer *timer);
+static void _cascade(TimerWheel wheel, int level);
+static void _fire_slot(TimerWheel wheel);
+
+TimerWheel
+timer_wheel_new(gint64 now_ms)
+{
+    TimerWheel wheel = malloc(sizeof(struct timer_wheel_t));
+    wheel->current = _ms_to_ticks(now_ms);
+    int level, slot;
+    for (level = 0; level < WHEEL_LEVELS; level++) {
+        for (slot = 0; slot < WHEEL_SLOTS; slot++) {
+            wheel->slots[level][slot] = NULL;
+        }
+    }
+    wheel->firing = NULL;
+    wheel->pending = 0;
+
+    return wheel;
+}
+
+void
+timer_wheel_free(TimerWheel wheel)
+{
+    if (wheel) {
+        int level, slot;
+        for (level = 0; level < WHEEL_LEVELS; level++) {
+            for (slot = 0; slot < WHEEL_SLOTS; slot++) {
+                g_list_free_full(wheel->slots[level][slot], free);
+            }
+        }
+        g_list_free_full(wheel->firing, free);
+        free(wheel);
+    }
+}
+
+/*
+ * Call func with data once delay_ms has passed since now_ms, rounded up to the
+ * next tick. The deadline does not depend on when the wheel was last advanced.
+ * The returned timer belongs to the wheel, it is freed after it fires and
+ * must not be cancelled after that.
+ */
+WheelTimer*
+timer_wheel_add(TimerWheel wheel, gint64 now_ms, gint64 delay_ms, wheel_timer_func func, void *data)
+{
+    gint64 expires = _ms_to_ticks(now_ms + delay_ms + TIMER_WHEEL_TICK_MS - 1);
+    if (expires <= wheel->current) {
+        expires = wheel->current + 1;
+    }
+
+    WheelTimer *timer = malloc(sizeof(WheelTimer));
+    timer->expires = expires;
+    timer->func = func;
+    timer->data = data;
+    _insert(wheel, timer);
+    wheel->pending++;
+
+    return timer;
+}
+
+void
+timer_wheel_cancel(TimerWheel wheel, WheelTimer *timer)
+{
+    if (timer == NULL) {
+        return;
+    }
+
+    _unlink(wheel, timer);
+    wheel->pending--;
+    free(timer);
+}
+
+/*
+ * Move the wheel on to now_ms, firing every timer that is due in deadline order
+ */
+void
+timer_wheel_advance(TimerWheel wheel, gint64 now_ms)
+{
+    gint64 target = _ms_to_ticks(now_ms);
+
+    // nothing to fire, skip straight there
+    if (wheel->pending == 0) {
+        if (target > wheel->current) {
+            wheel->current = target;
+        }
+        return;
+    }
+
+    while (wheel->current < target) {
+        wheel->current++;
+
+        int level = 0;
+        while (level < WHEEL_LEVELS - 1 &&
+                ((wheel->current >> (WHEEL_BITS * level)) & WHEEL_MASK) == 0) {
+            level++;
+            _cascade(wheel, level);
+        }
+
+        _fire_slot(wheel);
+
+        if (wheel->pending == 0) {
+            wheel->current = target;
+        }
+    }
+}
+
+guint
+timer_wheel_pending(TimerWheel wheel)
+{
+    return wheel->pending;
+}
+
+static gint64
+_ms_to_ticks(gint64 ms)
+{
+    return ms / TIMER_WHEEL_TICK_MS;
+}
+
+static void
+_insert(TimerWheel wheel, WheelTimer *timer)
+{
+    gint64 delta = timer->expires - wheel->current;
+    gint64 expires = timer->expires;
+    if (delta > WHEEL_MAX_TICKS) {
+        expires = wheel->current + WHEEL_MAX_TICKS;
+        delta = WHEEL_MAX_TICKS;
+    }
+
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= ((gint64)1 << (WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+
+    int slot = (expires >> (WHEEL_BITS * level)) & WHEEL_MASK;
+    timer->level = level;
+    timer->slot = slot;
+    wheel->slots[level][slot] = g_list_prepend(wheel->slots[level][slot], timer);
+    timer->link = wheel->slots[level][slot];
+}
+
+static void
+_unlink(TimerWheel wheel, WheelTimer *timer)
+{
+    if (timer->level < 0) {
+        wheel->firing = g_list_delete_link(wheel->firing, timer->link);
+    } else {
+        GList **slot = &wheel->slots[timer->level][timer->slot];
+        *slot = g_list_delete_link(*slot, timer->link);
+    }
+    timer->link = NULL;
+}
+
+// the level's current slot has come round, spread its timers over the levels below
+static void
+_cascade(TimerWheel wheel, int level)
+{
+    int slot = (wheel->current >> (WHEEL_BITS * level)) & WHEEL_MASK;
+    GList *timers = wheel->slots[level][slot];
+    wheel->slots[level][slot] = NULL;
+
+    GList *curr = timers;
+    while (curr) {
+        _insert(wheel, curr->data);
+        curr = g_list_next(curr);
+    }
+    g_list_free(timers);
+}
+
+static void
+_fire_slot(TimerWheel wheel)
+{
+    int slot = wheel->current & WHEEL_MASK;
+    GList *timers = wheel->slots[0][slot];
+    wheel->slots[0][slot] = NULL;
+
+    // timers clamped to the top level are not due yet, put them back
+    GList *curr = timers;
+    while (curr) {
+        WheelTimer *timer = curr->data;
+        if (timer->expires > wheel->current) {
+            _insert(wheel, timer);
+        } else {
+            timer->level = -1;
+            wheel->firing = g_list_prepend(wheel->firing, timer);
+            timer->link = wheel->firing;
+        }
+        curr = g_list_next(curr);
+    }
+    g_list_free(timers);
+
+    // callbacks may add or cancel timers, including ones still waiting here
+    while (wheel->firing) {
+        WheelTimer *timer = wheel->firing->data;
+        wheel->firing = g_list_delete_link(wheel->firing, wheel->firing);
+        wheel->pending--;
+        timer->func(timer->data);
+        free(timer);
+    }
+}
@@ -0,0 +1,54 @@
+/*
+ * timerwheel.h
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <glib.h>
+
+#define TIMER_WHEEL_TICK_MS 100
+
+typedef struct timer_wheel_t *TimerWheel;
+typedef struct wheel_timer_t WheelTimer;
+
+typedef void (*wheel_timer_func)(void *data);
+
+TimerWheel timer_wheel_new(gint64 now_ms);
+void timer_wheel_free(TimerWheel wheel);
+WheelTimer* timer_wheel_add(TimerWheel wheel, gint64 now_ms, gint64 delay_ms, wheel_timer_func func, void *data);
+void timer_wheel_cancel(TimerWheel wheel, WheelTimer *timer);
+void timer_wheel_advance(TimerWheel wheel, gint64 now_ms);
+guint timer_wheel_pending(TimerWheel wheel);
+
+#endif
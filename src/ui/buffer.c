@@ -52,36 +52,70 @@
 #define BUFF_SIZE 1200
 
 struct prof_buff_t {
-    GSList *entries;
+    GPtrArray *entries;
 };
 
 static void _free_entry(ProfBuffEntry *entry);
+static ProfBuffEntry* _create_entry(const char show_char, GDateTime *time, int flags, theme_item_t theme_item,
+    const char * const from);
+static void _add_entry(ProfBuff buffer, ProfBuffEntry *entry);
 
 ProfBuff
 buffer_create()
 {
     ProfBuff new_buff = malloc(sizeof(struct prof_buff_t));
-    new_buff->entries = NULL;
+    new_buff->entries = g_ptr_array_sized_new(BUFF_SIZE);
+    g_ptr_array_set_free_func(new_buff->entries, (GDestroyNotify)_free_entry);
     return new_buff;
 }
 
 int
 buffer_size(ProfBuff buffer)
 {
-    return g_slist_length(buffer->entries);
+    return buffer->entries->len;
 }
 
 void
 buffer_free(ProfBuff buffer)
 {
-    g_slist_free_full(buffer->entries, (GDestroyNotify)_free_entry);
+    g_ptr_array_free(buffer->entries, TRUE);
     free(buffer);
     buffer = NULL;
 }
 
-void
+ProfBuffEntry*
 buffer_push(ProfBuff buffer, const char show_char, GDateTime *time,
     int flags, theme_item_t theme_item, const char * const from, const char * const message)
+{
+    ProfBuffEntry *e = _create_entry(show_char, time, flags, theme_item, from);
+    e->message = strdup(message);
+    e->chat_message = NULL;
+    _add_entry(buffer, e);
+
+    return e;
+}
+
+ProfBuffEntry*
+buffer_push_message(ProfBuff buffer, const char show_char, GDateTime *time,
+    int flags, theme_item_t theme_item, const char * const from, ChatMessage *message)
+{
+    ProfBuffEntry *e = _create_entry(show_char, time, flags, theme_item, from);
+    e->chat_message = chat_message_ref(message);
+    e->message = message->body;
+    _add_entry(buffer, e);
+
+    return e;
+}
+
+ProfBuffEntry*
+buffer_yield_entry(ProfBuff buffer, int entry)
+{
+    return g_ptr_array_index(buffer->entries, entry);
+}
+
+static ProfBuffEntry*
+_create_entry(const char show_char, GDateTime *time, int flags, theme_item_t theme_item,
+    const char * const from)
 {
     ProfBuffEntry *e = malloc(sizeof(struct prof_buff_entry_t));
     e->show_char = show_char;
@@ -89,28 +123,36 @@ buffer_push(ProfBuff buffer, const char show_char, GDateTime *time,
     e->theme_item = theme_item;
     e->time = time;
     e->from = strdup(from);
-    e->message = strdup(message);
+    e->lines = NULL;
+    e->lines_width = 0;
+    e->lines_startx = 0;
+    e->lines_indent = 0;
 
-    if (g_slist_length(buffer->entries) == BUFF_SIZE) {
-        _free_entry(buffer->entries->data);
-        buffer->entries = g_slist_delete_link(buffer->entries, buffer->entries);
-    }
-
-    buffer->entries = g_slist_append(buffer->entries, e);
+    return e;
 }
 
-ProfBuffEntry*
-buffer_yield_entry(ProfBuff buffer, int entry)
+static void
+_add_entry(ProfBuff buffer, ProfBuffEntry *entry)
 {
-    GSList *node = g_slist_nth(buffer->entries, entry);
-    return node->data;
+    if (buffer->entries->len == BUFF_SIZE) {
+        g_ptr_array_remove_index(buffer->entries, 0);
+    }
+
+    g_ptr_array_add(buffer->entries, entry);
 }
 
 static void
 _free_entry(ProfBuffEntry *entry)
 {
-    free(entry->message);
+    if (entry->chat_message) {
+        chat_message_unref(entry->chat_message);
+    } else {
+        free(entry->message);
+    }
     free(entry->from);
+    if (entry->lines) {
+        g_array_free(entry->lines, TRUE);
+    }
     g_date_time_unref(entry->time);
     free(entry);
 }
\ No newline at end of file
@@ -37,9 +37,17 @@
 
 #include "config.h"
 #include "config/theme.h"
+#include "chat_message.h"
 
 #include <glib.h>
 
+typedef struct prof_buff_line_t {
+    int offset;
+    int length;
+    // line ends on the last column, the cursor has already moved to the next row
+    gboolean filled;
+} ProfBuffLine;
+
 typedef struct prof_buff_entry_t {
     char show_char;
     GDateTime *time;
@@ -47,13 +55,21 @@ typedef struct prof_buff_entry_t {
     theme_item_t theme_item;
     char *from;
     char *message;
+    // when set, message points at its body and the entry holds a reference
+    ChatMessage *chat_message;
+    // wrapped lines of message, valid for the width, start column and indent below
+    GArray *lines;
+    int lines_width;
+    int lines_startx;
+    int lines_indent;
 } ProfBuffEntry;
 
 typedef struct prof_buff_t *ProfBuff;
 
 ProfBuff buffer_create();
 void buffer_free(ProfBuff buffer);
-void buffer_push(ProfBuff buffer, const char show_char, GDateTime *time, int flags, theme_item_t theme_item, const char * const from, const char * const message);
+ProfBuffEntry* buffer_push(ProfBuff buffer, const char show_char, GDateTime *time, int flags, theme_item_t theme_item, const char * const from, const char * const message);
+ProfBuffEntry* buffer_push_message(ProfBuff buffer, const char show_char, GDateTime *time, int flags, theme_item_t theme_item, const char * const from, ChatMessage *message);
 int buffer_size(ProfBuff buffer);
 ProfBuffEntry* buffer_yield_entry(ProfBuff buffer, int entry);
 #endif
@@ -819,6 +819,23 @@ cons_show_aliases(GList *aliases)
     cons_show("");
 }
 
+void
+cons_show_highlights(GList *highlights)
+{
+    if (highlights == NULL) {
+        cons_show("No highlights configured.");
+        return;
+    }
+
+    cons_show("Highlights:");
+    GList *curr = highlights;
+    while (curr != NULL) {
+        cons_show("  %s", curr->data);
+        curr = g_list_next(curr);
+    }
+    cons_show("");
+}
+
 void
 cons_theme_setting(void)
 {
@@ -889,6 +906,15 @@ cons_flash_setting(void)
         cons_show("Terminal flash (/flash)       : OFF");
 }
 
+void
+cons_multiline_setting(void)
+{
+    if (prefs_get_boolean(PREF_MULTILINE))
+        cons_show("Multi-line paste (/multiline) : ON");
+    else
+        cons_show("Multi-line paste (/multiline) : OFF");
+}
+
 void
 cons_splash_setting(void)
 {
@@ -1028,6 +1054,8 @@ cons_show_ui_prefs(void)
     cons_titlebar_setting();
     cons_presence_setting();
     cons_inpblock_setting();
+    cons_multiline_setting();
+    cons_inputhistory_setting();
 
     cons_alert();
 }
@@ -1110,6 +1138,15 @@ cons_notify_setting(void)
         } else {
             cons_show("Reminder period (/notify remind)    : %d seconds", remind_period);
         }
+
+        gint coalesce_period = prefs_get_notify_coalesce();
+        if (coalesce_period == 0) {
+            cons_show("Coalesce period (/notify coalesce)  : OFF");
+        } else if (coalesce_period == 1) {
+            cons_show("Coalesce period (/notify coalesce)  : 1 second");
+        } else {
+            cons_show("Coalesce period (/notify coalesce)  : %d seconds", coalesce_period);
+        }
     } else {
         cons_show("Notification support was not included in this build.");
     }
@@ -1199,6 +1236,12 @@ cons_inpblock_setting(void)
     }
 }
 
+void
+cons_inputhistory_setting(void)
+{
+    cons_show("Input history (/inputhistory) : %d lines", prefs_get_inputhistory_size());
+}
+
 void
 cons_log_setting(void)
 {
@@ -1298,6 +1341,26 @@ cons_reconnect_setting(void)
     }
 }
 
+void
+cons_csi_setting(void)
+{
+    gint csi_time = prefs_get_csi();
+    if (csi_time == 0) {
+        cons_show("Client state idle (/csi)        : OFF");
+    } else {
+        cons_show("Client state idle (/csi)        : %d seconds", csi_time);
+    }
+}
+
+void
+cons_compression_setting(void)
+{
+    if (prefs_get_boolean(PREF_COMPRESSION))
+        cons_show("Stream compression (/compression) : ON");
+    else
+        cons_show("Stream compression (/compression) : OFF");
+}
+
 void
 cons_autoping_setting(void)
 {
@@ -1325,6 +1388,8 @@ cons_show_connection_prefs(void)
     cons_show("");
     cons_reconnect_setting();
     cons_autoping_setting();
+    cons_csi_setting();
+    cons_compression_setting();
     cons_autoconnect_setting();
 
     cons_alert();
@@ -1433,6 +1498,7 @@ cons_navigation_help(void)
     cons_show("Alt-LEFT, Alt-RIGHT              : Previous/next chat window");
     cons_show("UP, DOWN                         : Navigate input history.");
     cons_show("Ctrl-n, Ctrl-p                   : Navigate input history.");
+    cons_show("Ctrl-r                           : Search input history for current input, repeat for older matches.");
     cons_show("LEFT, RIGHT, HOME, END           : Move cursor.");
     cons_show("Ctrl-b, Ctrl-f, Ctrl-a, Ctrl-e   : Move cursor.");
     cons_show("Ctrl-LEFT, Ctrl-RIGHT            : Jump word.");
@@ -1443,6 +1509,7 @@ cons_navigation_help(void)
     cons_show("Ctrl-d                           : Delete next character.");
     cons_show("ESC                              : Clear current input.");
     cons_show("Ctrl-u                           : Delete all previous characters.");
+    cons_show("Alt-ENTER                        : Start a new line in the current message.");
     cons_show("TAB                              : Autocomplete.");
     cons_show("PAGE UP, PAGE DOWN               : Page the main window.");
     cons_show("Shift-UP, Shift-DOWN             : Page occupants/roster panel.");
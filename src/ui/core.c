@@ -41,6 +41,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
 #ifdef HAVE_LIBXSS
 #include <X11/extensions/scrnsaver.h>
 #endif
@@ -70,7 +72,10 @@
 #include "ui/inputwin.h"
 #include "ui/window.h"
 #include "ui/windows.h"
+#include "tools/highlight.h"
+#include "xmpp/mam.h"
 #include "xmpp/xmpp.h"
+#include "xmpp/xmltrace.h"
 
 static char *win_title;
 
@@ -82,9 +87,16 @@ static Display *display;
 
 static GTimer *ui_idle_time;
 
+// bumped when the highlight list changes, room highlighters are rebuilt on next use
+static int highlights_gen = 1;
+
 static void _win_handle_switch(const wint_t ch);
 static void _win_show_history(int win_index, const char * const contact);
 static void _ui_draw_term_title(void);
+static void _ui_xmlconsole_render(ProfWin *window);
+static Highlighter _ui_room_highlighter(ProfMucWin *mucwin, const char * const my_nick);
+static void _ui_highlights_print(const char * const roomjid, const char * const nick,
+    const char * const message);
 
 void
 ui_init(void)
@@ -99,6 +111,10 @@ ui_init(void)
     }
     ui_load_colours();
     refresh();
+    // report terminal focus changes, used for client state indication,
+    // and bracket pasted text so it can be inserted in one go
+    printf("\033[?1004h\033[?2004h");
+    fflush(stdout);
     create_title_bar();
     create_status_bar();
     status_bar_active(1);
@@ -119,6 +135,9 @@ void
 ui_update(void)
 {
     ProfWin *current = wins_get_current();
+    if (current->type == WIN_XML) {
+        _ui_xmlconsole_render(current);
+    }
     if (current->layout->paged == 0) {
         win_move_to_end(current);
     }
@@ -158,6 +177,13 @@ ui_get_idle_time(void)
     }
 // if no libxss or xss idle time failed, use profanity idle time
 #endif
+    return ui_get_input_idle_time();
+}
+
+// time since the last key press in profanity itself, whatever the rest of the session does
+unsigned long
+ui_get_input_idle_time(void)
+{
     gdouble seconds_elapsed = g_timer_elapsed(ui_idle_time, NULL);
     unsigned long ms_elapsed = seconds_elapsed * 1000.0;
     return ms_elapsed;
@@ -174,9 +200,34 @@ ui_close(void)
 {
     notifier_uninit();
     wins_destroy();
+    printf("\033[?1004l\033[?2004l");
+    fflush(stdout);
     endwin();
 }
 
+// give the terminal back, windows are kept for when a terminal is resumed
+void
+ui_suspend(void)
+{
+    printf("\033[?1004l\033[?2004l");
+    fflush(stdout);
+    endwin();
+}
+
+// take over the terminal now on stdin and stdout, and redraw everything
+void
+ui_resume(void)
+{
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0) {
+        resizeterm(size.ws_row, size.ws_col);
+    }
+    printf("\033[?1004h\033[?2004h");
+    fflush(stdout);
+    clearok(curscr, TRUE);
+    ui_resize();
+}
+
 char*
 ui_readline(void)
 {
@@ -209,6 +260,12 @@ ui_inp_history_append(char *inp)
     inp_history_append(inp);
 }
 
+void
+ui_inp_history_set_size(int size)
+{
+    inp_history_set_size(size);
+}
+
 void
 ui_input_clear(void)
 {
@@ -297,25 +354,6 @@ ui_xmlconsole_exists(void)
     }
 }
 
-void
-ui_handle_stanza(const char * const msg)
-{
-    if (ui_xmlconsole_exists()) {
-        ProfXMLWin *xmlconsole = wins_get_xmlconsole();
-        ProfWin *window = (ProfWin*) xmlconsole;
-
-        if (g_str_has_prefix(msg, "SENT:")) {
-            win_save_print(window, '-', NULL, 0, 0, "", "SENT:");
-            win_save_print(window, '-', NULL, 0, THEME_ONLINE, "", &msg[6]);
-            win_save_print(window, '-', NULL, 0, THEME_ONLINE, "", "");
-        } else if (g_str_has_prefix(msg, "RECV:")) {
-            win_save_print(window, '-', NULL, 0, 0, "", "RECV:");
-            win_save_print(window, '-', NULL, 0, THEME_AWAY, "", &msg[6]);
-            win_save_print(window, '-', NULL, 0, THEME_AWAY, "", "");
-        }
-    }
-}
-
 gboolean
 ui_chat_win_exists(const char * const barejid)
 {
@@ -380,8 +418,9 @@ ui_get_current_chat(void)
 }
 
 void
-ui_incoming_msg(const char * const barejid, const char * const resource, const char * const message, GTimeVal *tv_stamp)
+ui_incoming_msg(ChatMessage *message)
 {
+    const char * const barejid = message->barejid;
     gboolean win_created = FALSE;
     GString *user = g_string_new("");
 
@@ -396,9 +435,9 @@ ui_incoming_msg(const char * const barejid, const char * const resource, const c
         g_string_append(user, barejid);
     }
 
-    if (resource && prefs_get_boolean(PREF_RESOURCE_MESSAGE)) {
+    if (message->resource && prefs_get_boolean(PREF_RESOURCE_MESSAGE)) {
         g_string_append(user, "/");
-        g_string_append(user, resource);
+        g_string_append(user, message->resource);
     }
 
     ProfChatWin *chatwin = wins_get_chat(barejid);
@@ -419,7 +458,7 @@ ui_incoming_msg(const char * const barejid, const char * const resource, const c
 
     // currently viewing chat window with sender
     if (wins_is_current(window)) {
-        win_print_incoming_message(window, tv_stamp, user->str, message);
+        win_print_incoming_chat(window, user->str, message);
         title_bar_set_typing(FALSE);
         status_bar_active(num);
 
@@ -438,14 +477,14 @@ ui_incoming_msg(const char * const barejid, const char * const resource, const c
         }
 
         // show users status first, when receiving message via delayed delivery
-        if ((tv_stamp != NULL) && (win_created)) {
+        if (message->delayed && win_created) {
             PContact pcontact = roster_get_contact(barejid);
             if (pcontact != NULL) {
                 win_show_contact(window, pcontact);
             }
         }
 
-        win_print_incoming_message(window, tv_stamp, user->str, message);
+        win_print_incoming_chat(window, user->str, message);
     }
 
     int ui_index = num;
@@ -461,7 +500,7 @@ ui_incoming_msg(const char * const barejid, const char * const resource, const c
         gboolean is_current = wins_is_current(window);
         if ( !is_current || (is_current && prefs_get_boolean(PREF_NOTIFY_MESSAGE_CURRENT)) ) {
             if (prefs_get_boolean(PREF_NOTIFY_MESSAGE_TEXT)) {
-                notify_message(user->str, ui_index, message);
+                notify_message(user->str, ui_index, message->body);
             } else {
                 notify_message(user->str, ui_index, NULL);
             }
@@ -471,6 +510,46 @@ ui_incoming_msg(const char * const barejid, const char * const resource, const c
     g_string_free(user, TRUE);
 }
 
+/*
+ * Messages fetched from the account's archive. Each goes into its chat window
+ * with the archived timestamp, windows not in view are only marked as having
+ * new messages once, rather than notifying for each message.
+ */
+void
+ui_archived_messages(GList *messages)
+{
+    GList *curr = messages;
+    while (curr != NULL) {
+        ArchivedMessage *message = curr->data;
+
+        ProfChatWin *chatwin = wins_get_chat(message->from);
+        if (chatwin == NULL) {
+            chatwin = (ProfChatWin*)wins_new_chat(message->from);
+        }
+        ProfWin *window = (ProfWin*)chatwin;
+
+        if (message->outgoing) {
+            win_save_print(window, '-', &message->timestamp, 0, THEME_TEXT_ME, "me", message->body);
+        } else {
+            const char *display_from = message->from;
+            PContact contact = roster_get_contact(message->from);
+            if (contact != NULL && p_contact_name(contact) != NULL) {
+                display_from = p_contact_name(contact);
+            }
+            win_save_print(window, '-', &message->timestamp, NO_ME, THEME_TEXT_THEM, display_from, message->body);
+
+            if (!wins_is_current(window)) {
+                if (chatwin->unread == 0) {
+                    status_bar_new(wins_get_num(window));
+                }
+                chatwin->unread++;
+            }
+        }
+
+        curr = g_list_next(curr);
+    }
+}
+
 void
 ui_incoming_private_msg(const char * const fulljid, const char * const message, GTimeVal *tv_stamp)
 {
@@ -621,6 +700,7 @@ ui_handle_login_account_success(ProfAccount *account)
     resource_presence_t resource_presence = accounts_get_login_presence(account->name);
     contact_presence_t contact_presence = contact_presence_from_resource_presence(resource_presence);
     cons_show_login_success(account);
+    inp_history_set_file(account->name);
     title_bar_set_presence(contact_presence);
     status_bar_print_message(account->jid);
     status_bar_update_virtual();
@@ -1154,6 +1234,10 @@ ui_close_win(int index)
         }
     }
 
+    if (window && window->type == WIN_XML) {
+        xmltrace_stop();
+    }
+
     wins_close_by_num(index);
     title_bar_console();
     status_bar_current(1);
@@ -1392,11 +1476,47 @@ ui_new_chat_win(const char * const barejid)
 void
 ui_create_xmlconsole_win(void)
 {
+    xmltrace_start();
     ProfWin *window = wins_new_xmlconsole();
     int num = wins_get_num(window);
     ui_switch_win(num);
 }
 
+void
+ui_create_highlights_win(void)
+{
+    ProfWin *window = wins_new_highlights();
+    int num = wins_get_num(window);
+    ui_switch_win(num);
+}
+
+gboolean
+ui_highlights_exists(void)
+{
+    ProfHighlightsWin *highlightswin = wins_get_highlights();
+    if (highlightswin) {
+        return TRUE;
+    } else {
+        return FALSE;
+    }
+}
+
+void
+ui_open_highlights_win(void)
+{
+    ProfHighlightsWin *highlightswin = wins_get_highlights();
+    if (highlightswin != NULL) {
+        int num = wins_get_num((ProfWin*)highlightswin);
+        ui_switch_win(num);
+    }
+}
+
+void
+ui_highlights_changed(void)
+{
+    highlights_gen++;
+}
+
 void
 ui_open_xmlconsole_win(void)
 {
@@ -1856,10 +1976,13 @@ ui_room_message(const char * const roomjid, const char * const nick,
         ProfWin *window = (ProfWin*) mucwin;
         int num = wins_get_num(window);
         char *my_nick = muc_nick(roomjid);
+        gboolean mention = FALSE;
 
         if (g_strcmp0(nick, my_nick) != 0) {
-            if (g_strrstr(message, my_nick) != NULL) {
+            mention = highlighter_matches(_ui_room_highlighter(mucwin, my_nick), message);
+            if (mention) {
                 win_save_print(window, '-', NULL, NO_ME, THEME_ROOMMENTION, nick, message);
+                _ui_highlights_print(roomjid, nick, message);
             } else {
                 win_save_print(window, '-', NULL, NO_ME, THEME_TEXT_THEM, nick, message);
             }
@@ -1900,27 +2023,21 @@ ui_room_message(const char * const roomjid, const char * const nick,
             if (g_strcmp0(room_setting, "on") == 0) {
                 notify = TRUE;
             }
-            if (g_strcmp0(room_setting, "mention") == 0) {
-                char *message_lower = g_utf8_strdown(message, -1);
-                char *nick_lower = g_utf8_strdown(nick, -1);
-                if (g_strrstr(message_lower, nick_lower) != NULL) {
-                    notify = TRUE;
-                }
-                g_free(message_lower);
-                g_free(nick_lower);
+            if ((g_strcmp0(room_setting, "mention") == 0) && mention) {
+                notify = TRUE;
             }
             prefs_free_string(room_setting);
 
             if (notify) {
                 gboolean is_current = wins_is_current(window);
                 if ( !is_current || (is_current && prefs_get_boolean(PREF_NOTIFY_ROOM_CURRENT)) ) {
-                    Jid *jidp = jid_create(roomjid);
+                    Jid *jidp = jid_intern(roomjid);
                     if (prefs_get_boolean(PREF_NOTIFY_ROOM_TEXT)) {
                         notify_room_message(nick, jidp->localpart, ui_index, message);
                     } else {
                         notify_room_message(nick, jidp->localpart, ui_index, NULL);
                     }
-                    jid_destroy(jidp);
+                    jid_release(jidp);
                 }
             }
         }
@@ -2973,9 +3090,8 @@ _win_show_history(int win_index, const char * const contact)
         ProfChatWin *chatwin = (ProfChatWin*) window;
         assert(chatwin->memcheck == PROFCHATWIN_MEMCHECK);
         if (!chatwin->history_shown) {
-            Jid *jid = jid_create(jabber_get_fulljid());
+            Jid *jid = jabber_get_jid();
             GSList *history = chat_log_get_previous(jid->barejid, contact);
-            jid_destroy(jid);
             GSList *curr = history;
             while (curr != NULL) {
                 char *line = curr->data;
@@ -3002,3 +3118,83 @@ _win_show_history(int win_index, const char * const contact)
     }
 }
 
+// stanzas are only formatted once the console is the current window
+static void
+_ui_xmlconsole_render(ProfWin *window)
+{
+    guint dropped = xmltrace_take_dropped();
+    if (dropped > 0) {
+        win_save_vprint(window, '-', NULL, 0, THEME_ERROR, "", "%u stanzas not shown, console buffer full.", dropped);
+        win_save_print(window, '-', NULL, 0, 0, "", "");
+    }
+
+    GSList *entries = xmltrace_take();
+    GSList *curr = entries;
+    while (curr != NULL) {
+        XMLTraceEntry *entry = curr->data;
+        theme_item_t theme_item = THEME_ONLINE;
+        if (entry->dir == XMLTRACE_DIR_SENT) {
+            win_save_print(window, '-', NULL, 0, 0, "", "SENT:");
+        } else {
+            win_save_print(window, '-', NULL, 0, 0, "", "RECV:");
+            theme_item = THEME_AWAY;
+        }
+
+        GSList *lines = xmltrace_pretty(entry->raw);
+        GSList *curr_line = lines;
+        while (curr_line != NULL) {
+            win_save_print(window, '-', NULL, 0, theme_item, "", curr_line->data);
+            curr_line = g_slist_next(curr_line);
+        }
+        g_slist_free_full(lines, g_free);
+        win_save_print(window, '-', NULL, 0, theme_item, "", "");
+
+        curr = g_slist_next(curr);
+    }
+    g_slist_free_full(entries, (GDestroyNotify)xmltrace_entry_free);
+}
+
+static Highlighter
+_ui_room_highlighter(ProfMucWin *mucwin, const char * const my_nick)
+{
+    if (mucwin->highlighter == NULL || mucwin->highlighter_gen != highlights_gen ||
+            g_strcmp0(mucwin->highlighter_nick, my_nick) != 0) {
+        highlighter_free(mucwin->highlighter);
+        free(mucwin->highlighter_nick);
+
+        mucwin->highlighter = highlighter_new();
+        highlighter_add_word(mucwin->highlighter, my_nick);
+        GList *highlights = prefs_get_highlights();
+        GList *curr = highlights;
+        while (curr != NULL) {
+            highlighter_add_entry(mucwin->highlighter, curr->data);
+            curr = g_list_next(curr);
+        }
+        prefs_free_highlights(highlights);
+
+        mucwin->highlighter_nick = my_nick ? strdup(my_nick) : NULL;
+        mucwin->highlighter_gen = highlights_gen;
+    }
+
+    return mucwin->highlighter;
+}
+
+static void
+_ui_highlights_print(const char * const roomjid, const char * const nick,
+    const char * const message)
+{
+    ProfHighlightsWin *highlightswin = wins_get_highlights();
+    if (highlightswin == NULL) {
+        return;
+    }
+
+    ProfWin *window = (ProfWin*)highlightswin;
+    win_save_vprint(window, '-', NULL, 0, THEME_ROOMMENTION, "", "%s %s: %s", roomjid, nick, message);
+
+    int num = wins_get_num(window);
+    if (wins_is_current(window)) {
+        status_bar_active(num);
+    } else {
+        status_bar_new(num);
+    }
+}
@@ -50,6 +50,7 @@
 #include "config/accounts.h"
 #include "config/preferences.h"
 #include "config/theme.h"
+#include "tools/gapbuffer.h"
 #include "tools/history.h"
 #include "log.h"
 #include "muc.h"
@@ -70,17 +71,25 @@
 #define KEY_CTRL_F 0006
 #define KEY_CTRL_N 0016
 #define KEY_CTRL_P 0020
+#define KEY_CTRL_R 0022
 #define KEY_CTRL_U 0025
 #define KEY_CTRL_W 0027
 
-#define MAX_HISTORY 100
-#define INP_WIN_MAX 1000
+// starting width of the input pad, it grows with the input
+#define INP_WIN_COLS 1000
+#define PASTE_TIMEOUT_MS 100
 
 static WINDOW *inp_win;
 static History history;
+static char *search_query = NULL;
+static gint64 search_position;
+static gboolean focus_event = FALSE;
 
-static char input[INP_WIN_MAX];
-static int input_len_bytes;
+static GapBuffer input;
+static int pad_cols = INP_WIN_COLS;
+
+// remaining lines of a multi-line paste, entered one per read
+static GString *paste_pending = NULL;
 
 static int pad_start = 0;
 static int rows, cols;
@@ -90,8 +99,18 @@ static int _handle_alt_key(int key);
 static void _handle_backspace(void);
 static int _printable(const wint_t ch);
 static void _clear_input(void);
-static void _go_to_end(void);
 static void _delete_previous_word(void);
+static void _reset_search(void);
+static gboolean _handle_terminal_event(void);
+static void _handle_paste(void);
+static gboolean _paste_next_line(void);
+static gboolean _read_sequence(const char * const seq);
+static void _inp_insert(const char * const str);
+static void _inp_write(const char * const str);
+static void _inp_fit(void);
+static void _inp_redraw(void);
+static void _inp_redraw_from_cursor(void);
+static void _inp_cursor_update(void);
 
 void
 create_input_window(void)
@@ -102,12 +121,14 @@ create_input_window(void)
     ESCDELAY = 25;
 #endif
     getmaxyx(stdscr, rows, cols);
-    inp_win = newpad(1, INP_WIN_MAX);
+    inp_win = newpad(1, pad_cols);
     wbkgd(inp_win, theme_attrs(THEME_INPUT_TEXT));;
     keypad(inp_win, TRUE);
     wmove(inp_win, 0, 0);
     _inp_win_update_virtual();
-    history = history_new(MAX_HISTORY);
+    history = history_new(prefs_get_inputhistory_size());
+    history_set_save_filter(history, cmd_history_savable);
+    input = gapbuf_new();
 }
 
 void
@@ -115,7 +136,7 @@ inp_win_resize(void)
 {
     int inp_x;
     getmaxyx(stdscr, rows, cols);
-    inp_x = getcurx(inp_win);
+    inp_x = gapbuf_cursor_col(input);
 
     // if lost cursor off screen, move contents to show it
     if (inp_x >= pad_start + cols) {
@@ -144,15 +165,26 @@ inp_block(void)
 char *
 inp_read(int *key_type, wint_t *ch)
 {
-    int display_size = utf8_display_len(input);
+    if (paste_pending) {
+        *key_type = OK;
+        if (_paste_next_line()) {
+            *ch = '\n';
+            char *line = gapbuf_contents(input);
+            gapbuf_clear(input);
+            return line;
+        } else {
+            *ch = ERR;
+            return NULL;
+        }
+    }
 
     // echo off, and get some more input
     noecho();
     *key_type = wget_wch(inp_win, ch);
 
     gboolean in_command = FALSE;
-    if ((display_size > 0 && input[0] == '/') ||
-            (display_size == 0 && *ch == '/')) {
+    gunichar first = gapbuf_first_char(input);
+    if (first == '/' || (first == 0 && *ch == '/')) {
         in_command = TRUE;
     }
 
@@ -166,75 +198,31 @@ inp_read(int *key_type, wint_t *ch)
     // if it wasn't an arrow key etc
     if (!_handle_edit(*key_type, *ch)) {
         if (_printable(*ch) && *key_type != KEY_CODE_YES) {
-            if (input_len_bytes >= INP_WIN_MAX) {
-                *ch = ERR;
-                return NULL;
-            }
-
-            int inp_x = getcurx(inp_win);
-
-            // handle insert if not at end of input
-            if (inp_x < display_size) {
-                char bytes[MB_CUR_MAX];
-                size_t utf_len = wcrtomb(bytes, *ch, NULL);
-
-                char *next_ch = g_utf8_offset_to_pointer(input, inp_x);
-                char *offset;
-                for (offset = &input[input_len_bytes - 1]; offset >= next_ch; offset--) {
-                    *(offset + utf_len) = *offset;
-                }
-                int i;
-                for (i = 0; i < utf_len; i++) {
-                     *(next_ch + i) = bytes[i];
-                }
-
-                input_len_bytes += utf_len;
-                input[input_len_bytes] = '\0';
-                waddstr(inp_win, next_ch);
-                wmove(inp_win, 0, inp_x + 1);
-
-                if (inp_x - pad_start > cols-3) {
-                    pad_start++;
-                    _inp_win_update_virtual();
-                }
+            char bytes[MB_CUR_MAX+1];
+            size_t utf_len = wcrtomb(bytes, *ch, NULL);
 
-            // otherwise just append
-            } else {
-                char bytes[MB_CUR_MAX+1];
-                size_t utf_len = wcrtomb(bytes, *ch, NULL);
-
-                // wcrtomb can return (size_t) -1
-                if (utf_len < MB_CUR_MAX) {
-                    int i;
-                    for (i = 0 ; i < utf_len; i++) {
-                        input[input_len_bytes++] = bytes[i];
-                    }
-                    input[input_len_bytes] = '\0';
-
-                    bytes[utf_len] = '\0';
-                    waddstr(inp_win, bytes);
-                    display_size++;
-
-                    // if gone over screen size follow input
-                    int rows, cols;
-                    getmaxyx(stdscr, rows, cols);
-                    if (display_size - pad_start > cols-2) {
-                        pad_start++;
-                        _inp_win_update_virtual();
-                    }
-                }
+            // wcrtomb can return (size_t) -1
+            if (utf_len != (size_t) -1) {
+                bytes[utf_len] = '\0';
+                _inp_insert(bytes);
             }
 
             cmd_reset_autocomplete();
         }
     }
 
+    // focus changes are not key presses
+    if (focus_event) {
+        focus_event = FALSE;
+        *ch = ERR;
+    }
+
     echo();
 
     if (*ch == '\n') {
-        input[input_len_bytes] = '\0';
-        input_len_bytes = 0;
-        return strdup(input);
+        char *line = gapbuf_contents(input);
+        gapbuf_clear(input);
+        return line;
     } else {
         return NULL;
     }
@@ -262,17 +250,14 @@ inp_put_back(void)
 void
 inp_replace_input(const char * const new_input)
 {
-    strncpy(input, new_input, INP_WIN_MAX);
-    input_len_bytes = strlen(input);
-    inp_win_reset();
-    input[input_len_bytes] = '\0';
-    waddstr(inp_win, input);
-    _go_to_end();
+    gapbuf_set(input, new_input);
+    _inp_redraw();
 }
 
 void
 inp_win_reset(void)
 {
+    gapbuf_clear(input);
     _clear_input();
     pad_start = 0;
     _inp_win_update_virtual();
@@ -284,6 +269,238 @@ inp_history_append(char *inp)
     history_append(history, inp);
 }
 
+void
+inp_history_set_file(const char * const account_name)
+{
+    gchar *xdg_data = xdg_get_data_home();
+    GString *history_file = g_string_new(xdg_data);
+    g_string_append(history_file, "/profanity/inputhistory");
+    mkdir_recursive(history_file->str);
+
+    char *account_file = str_replace(account_name, "@", "_at_");
+    g_string_append_printf(history_file, "/%s", account_file);
+    history_set_file(history, history_file->str);
+
+    free(account_file);
+    g_string_free(history_file, TRUE);
+    g_free(xdg_data);
+}
+
+void
+inp_history_set_size(int size)
+{
+    history_set_size(history, size);
+}
+
+static void
+_reset_search(void)
+{
+    FREE_SET_NULL(search_query);
+}
+
+// with focus reporting on, the terminal sends ESC [ I on focus in and ESC [ O on focus out
+// with bracketed paste on, pasted text is wrapped in ESC [ 200 ~ and ESC [ 201 ~
+static gboolean
+_handle_terminal_event(void)
+{
+    int event = wgetch(inp_win);
+    if (event == 'I' || event == 'O') {
+        focus_event = TRUE;
+        prof_handle_focus(event == 'I');
+        return TRUE;
+    }
+
+    if (event == '2') {
+        if (_read_sequence("00~")) {
+            _handle_paste();
+        }
+        return TRUE;
+    }
+
+    if (event != ERR) {
+        ungetch(event);
+    }
+    return FALSE;
+}
+
+static gboolean
+_read_sequence(const char * const seq)
+{
+    int i;
+    for (i = 0; seq[i] != '\0'; i++) {
+        if (wgetch(inp_win) != seq[i]) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+// read the whole paste in one go, so it is inserted and drawn once
+static void
+_handle_paste(void)
+{
+    GString *paste = g_string_new("");
+    int key_type;
+    wint_t ch;
+
+    wtimeout(inp_win, PASTE_TIMEOUT_MS);
+    while ((key_type = wget_wch(inp_win, &ch)) != ERR) {
+        if (key_type == KEY_CODE_YES) {
+            continue;
+        } else if (ch == 27) {
+            if (_read_sequence("[201~")) {
+                break;
+            }
+        } else if (ch == '\r' || ch == '\n') {
+            g_string_append_c(paste, '\n');
+        } else if (ch == '\t') {
+            g_string_append_c(paste, ' ');
+        } else if (_printable(ch)) {
+            char bytes[MB_CUR_MAX];
+            size_t utf_len = wcrtomb(bytes, ch, NULL);
+            if (utf_len != (size_t) -1) {
+                g_string_append_len(paste, bytes, utf_len);
+            }
+        }
+    }
+
+    // never send the last line without the user pressing enter
+    while (paste->len > 0 && paste->str[paste->len - 1] == '\n') {
+        g_string_truncate(paste, paste->len - 1);
+    }
+
+    if (paste->len == 0) {
+        g_string_free(paste, TRUE);
+        return;
+    }
+
+    gunichar first = gapbuf_first_char(input);
+    if (first == 0) {
+        first = g_utf8_get_char(paste->str);
+    }
+    if (first != '/') {
+        prof_handle_activity();
+    }
+
+    if (strchr(paste->str, '\n') && !prefs_get_boolean(PREF_MULTILINE)) {
+        paste_pending = paste;
+    } else {
+        _inp_insert(paste->str);
+        g_string_free(paste, TRUE);
+    }
+
+    cmd_reset_autocomplete();
+}
+
+// insert the next pending pasted line, return TRUE if it was a complete line to send
+static gboolean
+_paste_next_line(void)
+{
+    gboolean complete = FALSE;
+    char *end = strchr(paste_pending->str, '\n');
+    if (end) {
+        *end = '\0';
+        complete = TRUE;
+    }
+
+    _inp_insert(paste_pending->str);
+
+    if (complete) {
+        g_string_erase(paste_pending, 0, (end - paste_pending->str) + 1);
+    }
+    if (!complete || paste_pending->len == 0) {
+        g_string_free(paste_pending, TRUE);
+        paste_pending = NULL;
+    }
+
+    return complete;
+}
+
+static void
+_inp_insert(const char * const str)
+{
+    int col = gapbuf_cursor_col(input);
+    gapbuf_insert(input, str, -1);
+    _inp_fit();
+
+    wmove(inp_win, 0, col);
+    _inp_write(str);
+    _inp_write(gapbuf_after_cursor(input));
+    _inp_cursor_update();
+}
+
+// grow the pad so the whole input fits
+static void
+_inp_fit(void)
+{
+    int needed = gapbuf_width(input) + 1;
+    if (needed > pad_cols) {
+        while (needed > pad_cols) {
+            pad_cols *= 2;
+        }
+        wresize(inp_win, 1, pad_cols);
+    }
+}
+
+static void
+_inp_redraw(void)
+{
+    char *contents = gapbuf_contents(input);
+    _inp_fit();
+    _clear_input();
+    _inp_write(contents);
+    free(contents);
+    _inp_cursor_update();
+}
+
+// after deleting at the cursor only the text after it moves
+static void
+_inp_redraw_from_cursor(void)
+{
+    wmove(inp_win, 0, gapbuf_cursor_col(input));
+    _inp_write(gapbuf_after_cursor(input));
+    wclrtoeol(inp_win);
+    _inp_cursor_update();
+}
+
+// place the cursor, scrolling the pad if it has gone off screen
+static void
+_inp_cursor_update(void)
+{
+    int col = gapbuf_cursor_col(input);
+    wmove(inp_win, 0, col);
+
+    // off screen to left, jump left (half a screen worth)
+    if (col <= pad_start && pad_start > 0) {
+        pad_start = col - (cols / 2);
+        if (pad_start < 0) {
+            pad_start = 0;
+        }
+
+    // off screen to right, follow the cursor
+    } else if (col - pad_start > cols - 2) {
+        pad_start = col - cols + 2;
+    }
+
+    _inp_win_update_virtual();
+}
+
+// line breaks from a multi-line paste take one column each, shown as a marker
+static void
+_inp_write(const char * const str)
+{
+    const char *curr = str;
+    const char *line_end = strchr(curr, '\n');
+    while (line_end) {
+        waddnstr(inp_win, curr, line_end - curr);
+        waddch(inp_win, ACS_LRCORNER);
+        curr = line_end + 1;
+        line_end = strchr(curr, '\n');
+    }
+    waddstr(inp_win, curr);
+}
+
 static void
 _clear_input(void)
 {
@@ -301,101 +518,27 @@ _handle_edit(int key_type, const wint_t ch)
 {
     char *prev = NULL;
     char *next = NULL;
-    int inp_x = getcurx(inp_win);
+    char *found = NULL;
+    char *curr = NULL;
     int next_ch;
-    int display_size = utf8_display_len(input);
-
-    // CTRL-LEFT
-    if ((key_type == KEY_CODE_YES) && (ch == 547 || ch == 545 || ch == 544 || ch == 540 || ch == 539) && (inp_x > 0)) {
-        input[input_len_bytes] = '\0';
-        gchar *curr_ch = g_utf8_offset_to_pointer(input, inp_x);
-        curr_ch = g_utf8_find_prev_char(input, curr_ch);
-        gchar *prev_ch;
-        gunichar curr_uni;
-        gunichar prev_uni;
-
-        while (curr_ch != NULL) {
-            curr_uni = g_utf8_get_char(curr_ch);
-
-            if (g_unichar_isspace(curr_uni)) {
-                curr_ch = g_utf8_find_prev_char(input, curr_ch);
-            } else {
-                prev_ch = g_utf8_find_prev_char(input, curr_ch);
-                if (prev_ch == NULL) {
-                    curr_ch = NULL;
-                    break;
-                } else {
-                    prev_uni = g_utf8_get_char(prev_ch);
-                    if (g_unichar_isspace(prev_uni)) {
-                        break;
-                    } else {
-                        curr_ch = prev_ch;
-                    }
-                }
-            }
-        }
-
-        if (curr_ch == NULL) {
-            inp_x = 0;
-            wmove(inp_win, 0, inp_x);
-        } else {
-            glong offset = g_utf8_pointer_to_offset(input, curr_ch);
-            inp_x = offset;
-            wmove(inp_win, 0, inp_x);
-        }
 
-        // if gone off screen to left, jump left (half a screen worth)
-        if (inp_x <= pad_start) {
-            pad_start = pad_start - (cols / 2);
-            if (pad_start < 0) {
-                pad_start = 0;
-            }
+    // any key other than CTRL-R ends a history search
+    if ((key_type != ERR) && ((key_type == KEY_CODE_YES) || (ch != KEY_CTRL_R))) {
+        _reset_search();
+    }
 
-            _inp_win_update_virtual();
-        }
+    // CTRL-LEFT
+    if ((key_type == KEY_CODE_YES) && (ch == 547 || ch == 545 || ch == 544 || ch == 540 || ch == 539) && (gapbuf_cursor(input) > 0)) {
+        while (g_unichar_isspace(gapbuf_char_before(input)) && gapbuf_left(input));
+        while (gapbuf_char_before(input) != 0 && !g_unichar_isspace(gapbuf_char_before(input)) && gapbuf_left(input));
+        _inp_cursor_update();
         return 1;
 
     // CTRL-RIGHT
-    } else if ((key_type == KEY_CODE_YES) && (ch == 562 || ch == 560 || ch == 555 || ch == 559 || ch == 554) && (inp_x < display_size)) {
-        input[input_len_bytes] = '\0';
-        gchar *curr_ch = g_utf8_offset_to_pointer(input, inp_x);
-        gchar *next_ch = g_utf8_find_next_char(curr_ch, NULL);
-        gunichar curr_uni;
-        gunichar next_uni;
-        gboolean moved = FALSE;
-
-        while (g_utf8_pointer_to_offset(input, next_ch) < display_size) {
-            curr_uni = g_utf8_get_char(curr_ch);
-            next_uni = g_utf8_get_char(next_ch);
-            curr_ch = next_ch;
-            next_ch = g_utf8_find_next_char(next_ch, NULL);
-
-            if (!g_unichar_isspace(curr_uni) && g_unichar_isspace(next_uni) && moved) {
-                break;
-            } else {
-                moved = TRUE;
-            }
-        }
-
-        if (next_ch == NULL) {
-            inp_x = display_size;
-            wmove(inp_win, 0, inp_x);
-        } else {
-            glong offset = g_utf8_pointer_to_offset(input, curr_ch);
-            if (offset == display_size - 1) {
-                inp_x = offset + 1;
-            } else {
-                inp_x = offset;
-            }
-            wmove(inp_win, 0, inp_x);
-        }
-
-        // if gone off screen to right, jump right (half a screen worth)
-        if (inp_x > pad_start + cols) {
-            pad_start = pad_start + (cols / 2);
-            _inp_win_update_virtual();
-        }
-
+    } else if ((key_type == KEY_CODE_YES) && (ch == 562 || ch == 560 || ch == 555 || ch == 559 || ch == 554) && (gapbuf_cursor(input) < gapbuf_length(input))) {
+        while (g_unichar_isspace(gapbuf_char_after(input)) && gapbuf_right(input));
+        while (gapbuf_char_after(input) != 0 && !g_unichar_isspace(gapbuf_char_after(input)) && gapbuf_right(input));
+        _inp_cursor_update();
         return 1;
 
     // ALT-LEFT
@@ -415,10 +558,11 @@ _handle_edit(int key_type, const wint_t ch)
         case 27: // ESC
             // check for ALT-key
             next_ch = wgetch(inp_win);
-            if (next_ch != ERR) {
+            if (next_ch == '[' && _handle_terminal_event()) {
+                return 1;
+            } else if (next_ch != ERR) {
                 return _handle_alt_key(next_ch);
             } else {
-                input_len_bytes = 0;
                 inp_win_reset();
                 return 1;
             }
@@ -438,35 +582,8 @@ _handle_edit(int key_type, const wint_t ch)
                 return 0;
             }
         case KEY_CTRL_D:
-            if (inp_x == display_size-1) {
-                gchar *start = g_utf8_substring(input, 0, inp_x);
-                for (input_len_bytes = 0; input_len_bytes < strlen(start); input_len_bytes++) {
-                    input[input_len_bytes] = start[input_len_bytes];
-                }
-                input[input_len_bytes] = '\0';
-
-                g_free(start);
-
-                _clear_input();
-                waddstr(inp_win, input);
-            } else if (inp_x < display_size-1) {
-                gchar *start = g_utf8_substring(input, 0, inp_x);
-                gchar *end = g_utf8_substring(input, inp_x+1, input_len_bytes);
-                GString *new = g_string_new(start);
-                g_string_append(new, end);
-
-                for (input_len_bytes = 0; input_len_bytes < strlen(new->str); input_len_bytes++) {
-                    input[input_len_bytes] = new->str[input_len_bytes];
-                }
-                input[input_len_bytes] = '\0';
-
-                g_free(start);
-                g_free(end);
-                g_string_free(new, FALSE);
-
-                _clear_input();
-                waddstr(inp_win, input);
-                wmove(inp_win, 0, inp_x);
+            if (gapbuf_delete_next(input)) {
+                _inp_redraw_from_cursor();
             }
             return 1;
 
@@ -475,14 +592,8 @@ _handle_edit(int key_type, const wint_t ch)
                 return 0;
             }
         case KEY_CTRL_B:
-            if (inp_x > 0) {
-                wmove(inp_win, 0, inp_x-1);
-
-                // current position off screen to left
-                if (inp_x - 1 < pad_start) {
-                    pad_start--;
-                    _inp_win_update_virtual();
-                }
+            if (gapbuf_left(input)) {
+                _inp_cursor_update();
             }
             return 1;
 
@@ -491,14 +602,8 @@ _handle_edit(int key_type, const wint_t ch)
                 return 0;
             }
         case KEY_CTRL_F:
-            if (inp_x < display_size) {
-                wmove(inp_win, 0, inp_x+1);
-
-                // current position off screen to right
-                if ((inp_x + 1 - pad_start) >= cols) {
-                    pad_start++;
-                    _inp_win_update_virtual();
-                }
+            if (gapbuf_right(input)) {
+                _inp_cursor_update();
             }
             return 1;
 
@@ -507,27 +612,40 @@ _handle_edit(int key_type, const wint_t ch)
                 return 0;
             }
         case KEY_CTRL_P:
-            input[input_len_bytes] = '\0';
-            prev = history_previous(history, input);
+            curr = gapbuf_contents(input);
+            prev = history_previous(history, curr);
+            free(curr);
             if (prev) {
                 inp_replace_input(prev);
             }
             return 1;
 
+        case KEY_CTRL_R:
+            if (search_query == NULL) {
+                search_query = gapbuf_contents(input);
+                search_position = HISTORY_SEARCH_NEWEST;
+            }
+            found = history_search(history, search_query, &search_position);
+            if (found) {
+                inp_replace_input(found);
+                free(found);
+            }
+            return 1;
+
         case KEY_DOWN:
             if (key_type != KEY_CODE_YES) {
                 return 0;
             }
         case KEY_CTRL_N:
-            input[input_len_bytes] = '\0';
-            next = history_next(history, input);
+            curr = gapbuf_contents(input);
+            next = history_next(history, curr);
             if (next) {
                 inp_replace_input(next);
-            } else if (input_len_bytes != 0) {
-                input[input_len_bytes] = '\0';
-                history_append(history, input);
+            } else if (gapbuf_length(input) != 0) {
+                history_append(history, curr);
                 inp_replace_input("");
             }
+            free(curr);
             return 1;
 
         case KEY_HOME:
@@ -535,9 +653,8 @@ _handle_edit(int key_type, const wint_t ch)
                 return 0;
             }
         case KEY_CTRL_A:
-            wmove(inp_win, 0, 0);
-            pad_start = 0;
-            _inp_win_update_virtual();
+            gapbuf_set_cursor(input, 0);
+            _inp_cursor_update();
             return 1;
 
         case KEY_END:
@@ -545,25 +662,27 @@ _handle_edit(int key_type, const wint_t ch)
                 return 0;
             }
         case KEY_CTRL_E:
-            _go_to_end();
+            gapbuf_set_cursor(input, gapbuf_length(input));
+            _inp_cursor_update();
             return 1;
 
         case 9: // tab
-            if (input_len_bytes != 0) {
-                input[input_len_bytes] = '\0';
-                if ((strncmp(input, "/", 1) != 0) && (ui_current_win_type() == WIN_MUC)) {
-                    char *result = muc_autocomplete(input);
+            if (gapbuf_length(input) != 0) {
+                curr = gapbuf_contents(input);
+                if ((strncmp(curr, "/", 1) != 0) && (ui_current_win_type() == WIN_MUC)) {
+                    char *result = muc_autocomplete(curr);
                     if (result) {
                         inp_replace_input(result);
                         free(result);
                     }
-                } else if (strncmp(input, "/", 1) == 0) {
-                    char *result = cmd_autocomplete(input);
+                } else if (strncmp(curr, "/", 1) == 0) {
+                    char *result = cmd_autocomplete(curr);
                     if (result) {
                         inp_replace_input(result);
                         free(result);
                     }
                 }
+                free(curr);
             }
             return 1;
 
@@ -573,9 +692,8 @@ _handle_edit(int key_type, const wint_t ch)
             break;
 
         case KEY_CTRL_U:
-            while (getcurx(inp_win) > 0) {
-                _delete_previous_word();
-            }
+            while (gapbuf_delete_prev(input));
+            _inp_redraw_from_cursor();
             return 1;
             break;
 
@@ -588,57 +706,10 @@ _handle_edit(int key_type, const wint_t ch)
 static void
 _handle_backspace(void)
 {
-    int inp_x = getcurx(inp_win);
-    int display_size = utf8_display_len(input);
     roster_reset_search_attempts();
-    if (display_size > 0) {
-
-        // if at end, delete last char
-        if (inp_x >= display_size) {
-            gchar *start = g_utf8_substring(input, 0, inp_x-1);
-            for (input_len_bytes = 0; input_len_bytes < strlen(start); input_len_bytes++) {
-                input[input_len_bytes] = start[input_len_bytes];
-            }
-            input[input_len_bytes] = '\0';
-
-            g_free(start);
-
-            _clear_input();
-            waddstr(inp_win, input);
-            wmove(inp_win, 0, inp_x -1);
-
-        // if in middle, delete and shift chars left
-        } else if (inp_x > 0 && inp_x < display_size) {
-            gchar *start = g_utf8_substring(input, 0, inp_x - 1);
-            gchar *end = g_utf8_substring(input, inp_x, input_len_bytes);
-            GString *new_str = g_string_new(start);
-            g_string_append(new_str, end);
-
-            for (input_len_bytes = 0; input_len_bytes < strlen(new_str->str); input_len_bytes++) {
-                input[input_len_bytes] = new_str->str[input_len_bytes];
-            }
-            input[input_len_bytes] = '\0';
-
-            g_free(start);
-            g_free(end);
-            g_string_free(new_str, TRUE);
-
-            _clear_input();
-            waddstr(inp_win, input);
-            wmove(inp_win, 0, inp_x -1);
-        }
-
-        // if gone off screen to left, jump left (half a screen worth)
-        if (inp_x <= pad_start) {
-            pad_start = pad_start - (cols / 2);
-            if (pad_start < 0) {
-                pad_start = 0;
-            }
-
-            _inp_win_update_virtual();
-        }
+    if (gapbuf_delete_prev(input)) {
+        _inp_redraw_from_cursor();
     }
-
 }
 
 static int
@@ -686,6 +757,11 @@ _handle_alt_key(int key)
         case 127:
             _delete_previous_word();
             break;
+        // ALT-ENTER starts a new line in the message
+        case '\n':
+        case '\r':
+            _inp_insert("\n");
+            break;
         default:
             break;
     }
@@ -695,85 +771,9 @@ _handle_alt_key(int key)
 static void
 _delete_previous_word(void)
 {
-    int end_del = getcurx(inp_win);
-    int start_del = end_del;
-
-    input[input_len_bytes] = '\0';
-    gchar *curr_ch = g_utf8_offset_to_pointer(input, end_del);
-    curr_ch = g_utf8_find_prev_char(input, curr_ch);
-    gchar *prev_ch;
-    gunichar curr_uni;
-    gunichar prev_uni;
-
-    while (curr_ch != NULL) {
-        curr_uni = g_utf8_get_char(curr_ch);
-
-        if (g_unichar_isspace(curr_uni)) {
-            curr_ch = g_utf8_find_prev_char(input, curr_ch);
-        } else {
-            prev_ch = g_utf8_find_prev_char(input, curr_ch);
-            if (prev_ch == NULL) {
-                curr_ch = NULL;
-                break;
-            } else {
-                prev_uni = g_utf8_get_char(prev_ch);
-                if (g_unichar_isspace(prev_uni)) {
-                    break;
-                } else {
-                    curr_ch = prev_ch;
-                }
-            }
-        }
-    }
-
-    if (curr_ch == NULL) {
-        start_del = 0;
-    } else {
-        start_del = g_utf8_pointer_to_offset(input, curr_ch);
-    }
-
-    gint len = g_utf8_strlen(input, -1);
-    gchar *start_string = g_utf8_substring(input, 0, start_del);
-    gchar *end_string = g_utf8_substring(input, end_del, len);
-
-    int i;
-    for (i = 0; i < strlen(start_string); i++) {
-        input[i] = start_string[i];
-    }
-    for (i = 0; i < strlen(end_string); i++) {
-        input[strlen(start_string)+i] = end_string[i];
-    }
-
-    input_len_bytes = strlen(start_string)+i;
-    input[input_len_bytes] = '\0';
-
-    g_free(start_string);
-    g_free(end_string);
-
-    _clear_input();
-    waddstr(inp_win, input);
-    wmove(inp_win, 0, start_del);
-
-    // if gone off screen to left, jump left (half a screen worth)
-    if (start_del <= pad_start) {
-        pad_start = pad_start - (cols / 2);
-        if (pad_start < 0) {
-            pad_start = 0;
-        }
-
-        _inp_win_update_virtual();
-    }
-}
-
-static void
-_go_to_end(void)
-{
-    int display_size = utf8_display_len(input);
-    wmove(inp_win, 0, display_size);
-    if (display_size > cols-2) {
-        pad_start = display_size - cols + 1;
-        _inp_win_update_virtual();
-    }
+    while (g_unichar_isspace(gapbuf_char_before(input)) && gapbuf_delete_prev(input));
+    while (gapbuf_char_before(input) != 0 && !g_unichar_isspace(gapbuf_char_before(input)) && gapbuf_delete_prev(input));
+    _inp_redraw_from_cursor();
 }
 
 static int
@@ -45,5 +45,7 @@ void inp_block(void);
 void inp_get_password(char *passwd);
 void inp_replace_input(const char * const new_input);
 void inp_history_append(char *inp);
+void inp_history_set_file(const char * const account_name);
+void inp_history_set_size(int size);
 
 #endif
@@ -48,24 +48,46 @@
 #include "log.h"
 #include "muc.h"
 #include "ui/ui.h"
+#include "ui/notifyqueue.h"
 #include "config/preferences.h"
 
+// minimum gap between two desktop notifications
+#define NOTIFY_MIN_INTERVAL G_TIME_SPAN_SECOND
+
+// sending blocks the main loop, so hold notifications while the user is typing in profanity
+#define NOTIFY_TYPING_QUIET_MS 1000
+
 static void _notify(const char * const message, int timeout,
     const char * const category);
 
 static GTimer *remind_timer;
 
+// libnotify needs the GDBus worker thread, which a forked child does not have
+static gboolean libnotify_usable = TRUE;
+
 void
 notifier_initialise(void)
 {
     remind_timer = g_timer_new();
+    notifyqueue_init(_notify);
+}
+
+/*
+ * Called in the child after /detach forks, desktop notifications through
+ * libnotify stay off for the rest of the session.
+ */
+void
+notifier_forked(void)
+{
+    libnotify_usable = FALSE;
 }
 
 void
 notifier_uninit(void)
 {
+    notifyqueue_close();
 #ifdef HAVE_LIBNOTIFY
-    if (notify_is_initted()) {
+    if (libnotify_usable && notify_is_initted()) {
         notify_uninit();
     }
 #endif
@@ -78,7 +100,8 @@ notify_typing(const char * const handle)
     char message[strlen(handle) + 1 + 11];
     sprintf(message, "%s: typing...", handle);
 
-    _notify(message, 10000, "Incoming message");
+    notifyqueue_add_transient(handle, message, 10000, "Incoming message",
+        g_get_monotonic_time());
 }
 
 void
@@ -93,7 +116,8 @@ notify_invite(const char * const from, const char * const room,
         g_string_append_printf(message, "\n\"%s\"", reason);
     }
 
-    _notify(message->str, 10000, "Incoming message");
+    notifyqueue_add(NOTIFY_NO_WIN, NULL, message->str, 10000, "Incoming message",
+        g_get_monotonic_time());
 
     g_string_free(message, TRUE);
 }
@@ -107,7 +131,10 @@ notify_message(const char * const handle, int win, const char * const text)
         g_string_append_printf(message, "\n%s", text);
     }
 
-    _notify(message->str, 10000, "incoming message");
+    char *group = g_strdup_printf("from %s (win %d)", handle, win);
+    notifyqueue_add(win, group, message->str, 10000, "incoming message",
+        g_get_monotonic_time());
+    g_free(group);
 
     g_string_free(message, TRUE);
 }
@@ -121,7 +148,10 @@ notify_room_message(const char * const handle, const char * const room, int win,
         g_string_append_printf(message, "\n%s", text);
     }
 
-    _notify(message->str, 10000, "incoming message");
+    char *group = g_strdup_printf("in %s (win %d)", room, win);
+    notifyqueue_add(win, group, message->str, 10000, "incoming message",
+        g_get_monotonic_time());
+    g_free(group);
 
     g_string_free(message, TRUE);
 }
@@ -131,7 +161,8 @@ notify_subscription(const char * const from)
 {
     GString *message = g_string_new("Subscription request: \n");
     g_string_append(message, from);
-    _notify(message->str, 10000, "Incoming message");
+    notifyqueue_add(NOTIFY_NO_WIN, NULL, message->str, 10000, "Incoming message",
+        g_get_monotonic_time());
     g_string_free(message, TRUE);
 }
 
@@ -177,13 +208,19 @@ notify_remind(void)
         }
 
         if ((unread > 0) || (open > 0) || (subs > 0)) {
-            _notify(text->str, 5000, "Incoming message");
+            notifyqueue_add(NOTIFY_NO_WIN, NULL, text->str, 5000, "Incoming message",
+                g_get_monotonic_time());
         }
 
         g_string_free(text, TRUE);
 
         g_timer_start(remind_timer);
     }
+
+    if (notifyqueue_pending() > 0 && ui_get_input_idle_time() >= NOTIFY_TYPING_QUIET_MS) {
+        gint64 coalesce = (gint64)prefs_get_notify_coalesce() * G_TIME_SPAN_SECOND;
+        notifyqueue_dispatch(g_get_monotonic_time(), coalesce, NOTIFY_MIN_INTERVAL);
+    }
 }
 
 static void
@@ -191,12 +228,12 @@ _notify(const char * const message, int timeout,
     const char * const category)
 {
 #ifdef HAVE_LIBNOTIFY
+    if (!libnotify_usable) {
+        log_debug("Notification skipped in detached session: %s", message);
+        return;
+    }
     log_debug("Attempting notification: %s", message);
-    if (notify_is_initted()) {
-        log_debug("Reinitialising libnotify");
-        notify_uninit();
-        notify_init("Profanity");
-    } else {
+    if (!notify_is_initted()) {
         log_debug("Initialising libnotify");
         notify_init("Profanity");
     }
@@ -214,9 +251,11 @@ _notify(const char * const message, int timeout,
             log_error("Error sending desktop notification:");
             log_error("  -> Message : %s", message);
             log_error("  -> Error   : %s", error->message);
+            g_error_free(error);
         } else {
 	    log_debug("Notification sent.");
 	}
+        g_object_unref(notification);
     } else {
         log_error("Libnotify not initialised.");
     }
@@ -0,0 +1,238 @@
+/*
+ * notifyqueue.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "common.h"
+#include "ui/notifyqueue.h"
+
+typedef struct notify_item_t {
+    int win;
+    char *group;
+    char *message;
+    int count;
+    int timeout;
+    char *category;
+    gint64 first_seen;
+    // replaced by newer ones with the same group, dropped once out of date
+    gboolean transient;
+} NotifyItem;
+
+static GList *pending;
+static notify_send_func send_notification;
+static gint64 last_sent;
+
+static NotifyItem * _find_item(int win);
+static NotifyItem * _find_transient(const char * const key);
+static NotifyItem * _new_item(int win, const char * const group, const char * const message,
+    int timeout, const char * const category, gint64 now);
+static void _send_item(NotifyItem *item);
+static void _free_item(NotifyItem *item);
+
+void
+notifyqueue_init(notify_send_func send_func)
+{
+    send_notification = send_func;
+    pending = NULL;
+    last_sent = 0;
+}
+
+void
+notifyqueue_close(void)
+{
+    g_list_free_full(pending, (GDestroyNotify)_free_item);
+    pending = NULL;
+    send_notification = NULL;
+}
+
+void
+notifyqueue_add(int win, const char * const group, const char * const message,
+    int timeout, const char * const category, gint64 now)
+{
+    NotifyItem *item = _find_item(win);
+    if (item != NULL) {
+        free(item->message);
+        item->message = strdup(message);
+        item->count++;
+        return;
+    }
+
+    item = _new_item(win, group, message, timeout, category, now);
+    pending = g_list_append(pending, item);
+}
+
+/*
+ * Queue a notification that only matters while it is current, such as a
+ * contact typing. A newer one with the same key takes its place, and it is
+ * dropped if it waits longer than its timeout.
+ */
+void
+notifyqueue_add_transient(const char * const key, const char * const message,
+    int timeout, const char * const category, gint64 now)
+{
+    NotifyItem *item = _find_transient(key);
+    if (item != NULL) {
+        free(item->message);
+        item->message = strdup(message);
+        item->first_seen = now;
+        return;
+    }
+
+    item = _new_item(NOTIFY_NO_WIN, key, message, timeout, category, now);
+    item->transient = TRUE;
+    pending = g_list_append(pending, item);
+}
+
+int
+notifyqueue_dispatch(gint64 now, gint64 coalesce, gint64 min_interval)
+{
+    int sent = 0;
+    GList *curr = pending;
+
+    while (curr != NULL) {
+        GList *next = g_list_next(curr);
+        NotifyItem *item = curr->data;
+
+        if (item->transient && (now - item->first_seen) >= (gint64)item->timeout * G_TIME_SPAN_MILLISECOND) {
+            _free_item(item);
+            pending = g_list_delete_link(pending, curr);
+            curr = next;
+            continue;
+        }
+
+        if (last_sent != 0 && (now - last_sent) < min_interval) {
+            break;
+        }
+
+        if (item->win == NOTIFY_NO_WIN || (now - item->first_seen) >= coalesce) {
+            _send_item(item);
+            _free_item(item);
+            pending = g_list_delete_link(pending, curr);
+            last_sent = now;
+            sent++;
+        }
+
+        curr = next;
+    }
+
+    return sent;
+}
+
+guint
+notifyqueue_pending(void)
+{
+    return g_list_length(pending);
+}
+
+static NotifyItem *
+_find_item(int win)
+{
+    if (win == NOTIFY_NO_WIN) {
+        return NULL;
+    }
+
+    GList *curr = pending;
+    while (curr != NULL) {
+        NotifyItem *item = curr->data;
+        if (item->win == win) {
+            return item;
+        }
+        curr = g_list_next(curr);
+    }
+
+    return NULL;
+}
+
+static NotifyItem *
+_find_transient(const char * const key)
+{
+    GList *curr = pending;
+    while (curr != NULL) {
+        NotifyItem *item = curr->data;
+        if (item->transient && g_strcmp0(item->group, key) == 0) {
+            return item;
+        }
+        curr = g_list_next(curr);
+    }
+
+    return NULL;
+}
+
+static NotifyItem *
+_new_item(int win, const char * const group, const char * const message,
+    int timeout, const char * const category, gint64 now)
+{
+    NotifyItem *item = malloc(sizeof(NotifyItem));
+    item->win = win;
+    item->group = group ? strdup(group) : NULL;
+    item->message = strdup(message);
+    item->count = 1;
+    item->timeout = timeout;
+    item->category = strdup(category);
+    item->first_seen = now;
+    item->transient = FALSE;
+
+    return item;
+}
+
+static void
+_send_item(NotifyItem *item)
+{
+    if (send_notification == NULL) {
+        return;
+    }
+
+    if (item->count == 1 || item->group == NULL) {
+        send_notification(item->message, item->timeout, item->category);
+    } else {
+        GString *message = g_string_new("");
+        g_string_append_printf(message, "%d new messages %s", item->count, item->group);
+        send_notification(message->str, item->timeout, item->category);
+        g_string_free(message, TRUE);
+    }
+}
+
+static void
+_free_item(NotifyItem *item)
+{
+    if (item != NULL) {
+        free(item->group);
+        free(item->message);
+        free(item->category);
+        free(item);
+    }
+}
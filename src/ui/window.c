@@ -54,12 +54,13 @@
 
 #define CONS_WIN_TITLE "Profanity. Type /help for help information."
 #define XML_WIN_TITLE "XML Console"
+#define HIGHLIGHTS_WIN_TITLE "Highlights"
 
 #define CEILING(X) (X-(int)(X) > 0 ? (int)(X+1) : (int)(X))
 
-static void _win_print(ProfWin *window, const char show_char, GDateTime *time,
-    int flags, theme_item_t theme_item, const char * const from, const char * const message);
-static void _win_print_wrapped(WINDOW *win, const char * const message);
+static void _win_print(ProfWin *window, ProfBuffEntry *entry);
+static void _win_print_wrapped(WINDOW *win, ProfBuffEntry *entry, const char * const message,
+    int indent);
 
 int
 win_roster_cols(void)
@@ -89,6 +90,7 @@ _win_create_simple_layout(void)
     layout->base.buffer = buffer_create();
     layout->base.y_pos = 0;
     layout->base.paged = 0;
+    layout->base.stale = FALSE;
     scrollok(layout->base.win, TRUE);
 
     return &layout->base;
@@ -106,6 +108,7 @@ _win_create_split_layout(void)
     layout->base.buffer = buffer_create();
     layout->base.y_pos = 0;
     layout->base.paged = 0;
+    layout->base.stale = FALSE;
     scrollok(layout->base.win, TRUE);
     layout->subwin = NULL;
     layout->sub_y_pos = 0;
@@ -114,11 +117,23 @@ _win_create_split_layout(void)
     return &layout->base;
 }
 
+static char*
+_win_account(void)
+{
+    char *account = jabber_get_account_name();
+    if (account) {
+        return strdup(account);
+    } else {
+        return NULL;
+    }
+}
+
 ProfWin*
 win_create_console(void)
 {
     ProfConsoleWin *new_win = malloc(sizeof(ProfConsoleWin));
     new_win->window.type = WIN_CONSOLE;
+    new_win->window.account = NULL;
     new_win->window.layout = _win_create_split_layout();
 
     return &new_win->window;
@@ -129,6 +144,7 @@ win_create_chat(const char * const barejid)
 {
     ProfChatWin *new_win = malloc(sizeof(ProfChatWin));
     new_win->window.type = WIN_CHAT;
+    new_win->window.account = _win_account();
     new_win->window.layout = _win_create_simple_layout();
 
     new_win->barejid = strdup(barejid);
@@ -137,7 +153,7 @@ win_create_chat(const char * const barejid)
     new_win->is_trusted = FALSE;
     new_win->history_shown = FALSE;
     new_win->unread = 0;
-    new_win->state = chat_state_new();
+    new_win->state = chat_state_new(barejid);
 
     new_win->memcheck = PROFCHATWIN_MEMCHECK;
 
@@ -151,6 +167,7 @@ win_create_muc(const char * const roomjid)
     int cols = getmaxx(stdscr);
 
     new_win->window.type = WIN_MUC;
+    new_win->window.account = _win_account();
 
     ProfLayoutSplit *layout = malloc(sizeof(ProfLayoutSplit));
     layout->base.type = LAYOUT_SPLIT;
@@ -176,6 +193,9 @@ win_create_muc(const char * const roomjid)
 
     new_win->roomjid = strdup(roomjid);
     new_win->unread = 0;
+    new_win->highlighter = NULL;
+    new_win->highlighter_nick = NULL;
+    new_win->highlighter_gen = 0;
 
     new_win->memcheck = PROFMUCWIN_MEMCHECK;
 
@@ -187,6 +207,7 @@ win_create_muc_config(const char * const roomjid, DataForm *form)
 {
     ProfMucConfWin *new_win = malloc(sizeof(ProfMucConfWin));
     new_win->window.type = WIN_MUC_CONFIG;
+    new_win->window.account = _win_account();
     new_win->window.layout = _win_create_simple_layout();
 
     new_win->roomjid = strdup(roomjid);
@@ -202,6 +223,7 @@ win_create_private(const char * const fulljid)
 {
     ProfPrivateWin *new_win = malloc(sizeof(ProfPrivateWin));
     new_win->window.type = WIN_PRIVATE;
+    new_win->window.account = _win_account();
     new_win->window.layout = _win_create_simple_layout();
 
     new_win->fulljid = strdup(fulljid);
@@ -217,6 +239,7 @@ win_create_xmlconsole(void)
 {
     ProfXMLWin *new_win = malloc(sizeof(ProfXMLWin));
     new_win->window.type = WIN_XML;
+    new_win->window.account = NULL;
     new_win->window.layout = _win_create_simple_layout();
 
     new_win->memcheck = PROFXMLWIN_MEMCHECK;
@@ -224,6 +247,19 @@ win_create_xmlconsole(void)
     return &new_win->window;
 }
 
+ProfWin*
+win_create_highlights(void)
+{
+    ProfHighlightsWin *new_win = malloc(sizeof(ProfHighlightsWin));
+    new_win->window.type = WIN_HIGHLIGHTS;
+    new_win->window.account = NULL;
+    new_win->window.layout = _win_create_simple_layout();
+
+    new_win->memcheck = PROFHIGHLIGHTSWIN_MEMCHECK;
+
+    return &new_win->window;
+}
+
 char *
 win_get_title(ProfWin *window)
 {
@@ -269,6 +305,9 @@ win_get_title(ProfWin *window)
     if (window->type == WIN_XML) {
         return strdup(XML_WIN_TITLE);
     }
+    if (window->type == WIN_HIGHLIGHTS) {
+        return strdup(HIGHLIGHTS_WIN_TITLE);
+    }
 
     return NULL;
 }
@@ -331,6 +370,7 @@ win_free(ProfWin* window)
         delwin(window->layout->win);
     }
     free(window->layout);
+    free(window->account);
 
     if (window->type == WIN_CHAT) {
         ProfChatWin *chatwin = (ProfChatWin*)window;
@@ -342,6 +382,8 @@ win_free(ProfWin* window)
     if (window->type == WIN_MUC) {
         ProfMucWin *mucwin = (ProfMucWin*)window;
         free(mucwin->roomjid);
+        highlighter_free(mucwin->highlighter);
+        free(mucwin->highlighter_nick);
     }
 
     if (window->type == WIN_MUC_CONFIG) {
@@ -829,6 +871,25 @@ win_print_incoming_message(ProfWin *window, GTimeVal *tv_stamp,
     }
 }
 
+void
+win_print_incoming_chat(ProfWin *window, const char * const from, ChatMessage *message)
+{
+    assert(window->type == WIN_CHAT);
+
+    GDateTime *time;
+    if (message->delayed) {
+        time = g_date_time_new_from_timeval_utc(&message->timestamp);
+    } else {
+        time = g_date_time_new_now_local();
+    }
+
+    ProfBuffEntry *entry = buffer_push_message(window->layout->buffer, '-', time, NO_ME, THEME_TEXT_THEM, from,
+        message);
+    _win_print(window, entry);
+    // TODO: cross-reference.. this should be replaced by a real event-based system
+    ui_input_nonblocking(TRUE);
+}
+
 void
 win_save_vprint(ProfWin *window, const char show_char, GTimeVal *tstamp,
     int flags, theme_item_t theme_item, const char * const from, const char * const message, ...)
@@ -853,8 +914,8 @@ win_save_print(ProfWin *window, const char show_char, GTimeVal *tstamp,
         time = g_date_time_new_from_timeval_utc(tstamp);
     }
 
-    buffer_push(window->layout->buffer, show_char, time, flags, theme_item, from, message);
-    _win_print(window, show_char, time, flags, theme_item, from, message);
+    ProfBuffEntry *entry = buffer_push(window->layout->buffer, show_char, time, flags, theme_item, from, message);
+    _win_print(window, entry);
     // TODO: cross-reference.. this should be replaced by a real event-based system
     ui_input_nonblocking(TRUE);
 }
@@ -872,8 +933,7 @@ win_save_newline(ProfWin *window)
 }
 
 static void
-_win_print(ProfWin *window, const char show_char, GDateTime *time,
-    int flags, theme_item_t theme_item, const char * const from, const char * const message)
+_win_print(ProfWin *window, ProfBuffEntry *entry)
 {
     // flags : 1st bit =  0/1 - me/not me
     //         2nd bit =  0/1 - date/no date
@@ -883,30 +943,34 @@ _win_print(ProfWin *window, const char show_char, GDateTime *time,
     gboolean me_message = FALSE;
     int offset = 0;
     int colour = theme_attrs(THEME_ME);
+    int flags = entry->flags;
+    const char * const message = entry->message;
 
-    if ((flags & NO_DATE) == 0) {
-        gchar *date_fmt = NULL;
-        char *time_pref = prefs_get_string(PREF_TIME);
-        if (g_strcmp0(time_pref, "minutes") == 0) {
-            date_fmt = g_date_time_format(time, "%H:%M");
-        } else if (g_strcmp0(time_pref, "seconds") == 0) {
-            date_fmt = g_date_time_format(time, "%H:%M:%S");
-        }
-        free(time_pref);
+    char *time_pref = prefs_get_string(PREF_TIME);
+    const char *date_pattern = NULL;
+    int indent = 0;
+    if (g_strcmp0(time_pref, "minutes") == 0) {
+        date_pattern = "%H:%M";
+        indent = 8;
+    } else if (g_strcmp0(time_pref, "seconds") == 0) {
+        date_pattern = "%H:%M:%S";
+        indent = 11;
+    }
+    free(time_pref);
 
-        if (date_fmt) {
-            if ((flags & NO_COLOUR_DATE) == 0) {
-                wattron(window->layout->win, theme_attrs(THEME_TIME));
-            }
-            wprintw(window->layout->win, "%s %c ", date_fmt, show_char);
-            if ((flags & NO_COLOUR_DATE) == 0) {
-                wattroff(window->layout->win, theme_attrs(THEME_TIME));
-            }
+    if ((flags & NO_DATE) == 0 && date_pattern) {
+        gchar *date_fmt = g_date_time_format(entry->time, date_pattern);
+        if ((flags & NO_COLOUR_DATE) == 0) {
+            wattron(window->layout->win, theme_attrs(THEME_TIME));
+        }
+        wprintw(window->layout->win, "%s %c ", date_fmt, entry->show_char);
+        if ((flags & NO_COLOUR_DATE) == 0) {
+            wattroff(window->layout->win, theme_attrs(THEME_TIME));
         }
         g_free(date_fmt);
     }
 
-    if (strlen(from) > 0) {
+    if (strlen(entry->from) > 0) {
         if (flags & NO_ME) {
             colour = theme_attrs(THEME_THEM);
         }
@@ -917,21 +981,21 @@ _win_print(ProfWin *window, const char show_char, GDateTime *time,
 
         wattron(window->layout->win, colour);
         if (strncmp(message, "/me ", 4) == 0) {
-            wprintw(window->layout->win, "*%s ", from);
+            wprintw(window->layout->win, "*%s ", entry->from);
             offset = 4;
             me_message = TRUE;
         } else {
-            wprintw(window->layout->win, "%s: ", from);
+            wprintw(window->layout->win, "%s: ", entry->from);
             wattroff(window->layout->win, colour);
         }
     }
 
     if (!me_message) {
-        wattron(window->layout->win, theme_attrs(theme_item));
+        wattron(window->layout->win, theme_attrs(entry->theme_item));
     }
 
     if (prefs_get_boolean(PREF_WRAP)) {
-        _win_print_wrapped(window->layout->win, message+offset);
+        _win_print_wrapped(window->layout->win, entry, message+offset, indent);
     } else {
         wprintw(window->layout->win, "%s", message+offset);
     }
@@ -943,77 +1007,139 @@ _win_print(ProfWin *window, const char show_char, GDateTime *time,
     if (me_message) {
         wattroff(window->layout->win, colour);
     } else {
-        wattroff(window->layout->win, theme_attrs(theme_item));
+        wattroff(window->layout->win, theme_attrs(entry->theme_item));
     }
 }
 
 static void
 _win_indent(WINDOW *win, int size)
 {
-    int i = 0;
-    for (i = 0; i < size; i++) {
-        waddch(win, ' ');
+    if (size > 0) {
+        wprintw(win, "%*s", size, "");
+    }
+}
+
+static int
+_win_char_width(const char * const str)
+{
+    gunichar ch = g_utf8_get_char(str);
+    if (g_unichar_iswide(ch)) {
+        return 2;
+    } else {
+        return 1;
     }
 }
 
 static void
-_win_print_wrapped(WINDOW *win, const char * const message)
+_win_end_line(GArray *lines, ProfBuffLine *line, const char * const message,
+    const char * const end, int col, int width)
 {
-    int linei = 0;
-    int wordi = 0;
-    char *word = malloc(strlen(message) + 1);
+    line->length = end - (message + line->offset);
+    line->filled = (col >= width);
+    g_array_append_val(lines, *line);
+}
 
-    char *time_pref = prefs_get_string(PREF_TIME);
-    int indent = 0;
-    if (g_strcmp0(time_pref, "minutes") == 0) {
-        indent = 8;
-    } else if (g_strcmp0(time_pref, "seconds") == 0) {
-        indent = 11;
-    }
-    free(time_pref);
+static GArray *
+_win_wrap_lines(const char * const message, int startx, int width, int indent)
+{
+    GArray *lines = g_array_new(FALSE, FALSE, sizeof(ProfBuffLine));
+    ProfBuffLine line = { 0, 0, FALSE };
+    const char *curr = message;
+    int col = startx;
+
+    while (*curr != '\0') {
+        if (*curr == '\n') {
+            _win_end_line(lines, &line, message, curr, col, width);
+            curr++;
+            line.offset = curr - message;
+            col = indent;
+            continue;
+        }
 
-    while (message[linei] != '\0') {
-        if (message[linei] == ' ') {
-            waddch(win, ' ');
-            linei++;
-        } else if (message[linei] == '\n') {
-            waddch(win, '\n');
-            _win_indent(win, indent);
-            linei++;
-        } else {
-            wordi = 0;
-            while (message[linei] != ' ' && message[linei] != '\n' && message[linei] != '\0') {
-                word[wordi++] = message[linei++];
-            }
-            word[wordi] = '\0';
-
-            int curx = getcurx(win);
-            int maxx = getmaxx(win);
-
-            // word larger than line
-            if (strlen(word) > (maxx - indent)) {
-                int i;
-                for (i = 0; i < wordi; i++) {
-                    curx = getcurx(win);
-                    if (curx < indent) {
-                        _win_indent(win, indent);
-                    }
-                    waddch(win, word[i]);
-                }
+        if (*curr == ' ') {
+            // spaces at the wrap point are dropped
+            if (col + 1 > width && col > indent) {
+                _win_end_line(lines, &line, message, curr, col, width);
+                curr++;
+                line.offset = curr - message;
+                col = indent;
             } else {
-                if (curx + strlen(word) > maxx) {
-                    waddch(win, '\n');
-                    _win_indent(win, indent);
-                }
-                if (curx < indent) {
-                    _win_indent(win, indent);
+                col++;
+                curr++;
+            }
+            continue;
+        }
+
+        const char *word_end = curr;
+        int word_width = 0;
+        while (*word_end != ' ' && *word_end != '\n' && *word_end != '\0') {
+            word_width += _win_char_width(word_end);
+            word_end = g_utf8_next_char(word_end);
+        }
+
+        // word larger than line, break it wherever the line is full
+        if (word_width > width - indent) {
+            while (curr < word_end) {
+                int char_width = _win_char_width(curr);
+                if (col + char_width > width && col > indent) {
+                    _win_end_line(lines, &line, message, curr, col, width);
+                    line.offset = curr - message;
+                    col = indent;
                 }
-                wprintw(win, "%s", word);
+                col += char_width;
+                curr = g_utf8_next_char(curr);
             }
+            continue;
+        }
+
+        if (col + word_width > width && col > indent) {
+            _win_end_line(lines, &line, message, curr, col, width);
+            line.offset = curr - message;
+            col = indent;
         }
+        col += word_width;
+        curr = word_end;
     }
 
-    free(word);
+    _win_end_line(lines, &line, message, curr, col, width);
+
+    return lines;
+}
+
+static void
+_win_print_wrapped(WINDOW *win, ProfBuffEntry *entry, const char * const message, int indent)
+{
+    int startx = getcurx(win);
+    int width = getmaxx(win);
+
+    if (startx < indent && message[0] != '\0') {
+        _win_indent(win, indent - startx);
+        startx = indent;
+    }
+
+    if (entry->lines == NULL || entry->lines_width != width ||
+            entry->lines_startx != startx || entry->lines_indent != indent) {
+        if (entry->lines) {
+            g_array_free(entry->lines, TRUE);
+        }
+        entry->lines = _win_wrap_lines(message, startx, width, indent);
+        entry->lines_width = width;
+        entry->lines_startx = startx;
+        entry->lines_indent = indent;
+    }
+
+    int i;
+    for (i = 0; i < entry->lines->len; i++) {
+        ProfBuffLine *line = &g_array_index(entry->lines, ProfBuffLine, i);
+        if (i > 0) {
+            ProfBuffLine *prev = &g_array_index(entry->lines, ProfBuffLine, i - 1);
+            if (!prev->filled) {
+                waddch(win, '\n');
+            }
+            _win_indent(win, indent);
+        }
+        waddnstr(win, message + line->offset, line->length);
+    }
 }
 
 void
@@ -1025,7 +1151,7 @@ win_redraw(ProfWin *window)
 
     for (i = 0; i < size; i++) {
         ProfBuffEntry *e = buffer_yield_entry(window->layout->buffer, i);
-        _win_print(window, e->show_char, e->time, e->flags, e->theme_item, e->from, e->message);
+        _win_print(window, e);
     }
 }
 
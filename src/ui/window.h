@@ -48,8 +48,10 @@
 #include "contact.h"
 #include "muc.h"
 #include "ui/buffer.h"
+#include "tools/highlight.h"
 #include "xmpp/xmpp.h"
 #include "chat_state.h"
+#include "chat_message.h"
 
 #define NO_ME           1
 #define NO_DATE         2
@@ -65,6 +67,7 @@
 #define PROFPRIVATEWIN_MEMCHECK     77437483
 #define PROFCONFWIN_MEMCHECK        64334685
 #define PROFXMLWIN_MEMCHECK         87333463
+#define PROFHIGHLIGHTSWIN_MEMCHECK  35527134
 
 typedef enum {
     LAYOUT_SIMPLE,
@@ -77,6 +80,7 @@ typedef struct prof_layout_t {
     ProfBuff buffer;
     int y_pos;
     int paged;
+    gboolean stale;
 } ProfLayout;
 
 typedef struct prof_layout_simple_t {
@@ -96,12 +100,15 @@ typedef enum {
     WIN_MUC,
     WIN_MUC_CONFIG,
     WIN_PRIVATE,
-    WIN_XML
+    WIN_XML,
+    WIN_HIGHLIGHTS
 } win_type_t;
 
 typedef struct prof_win_t {
     win_type_t type;
     ProfLayout *layout;
+    // account the window was opened for, NULL when not tied to one
+    char *account;
 } ProfWin;
 
 typedef struct prof_console_win_t {
@@ -124,6 +131,9 @@ typedef struct prof_muc_win_t {
     ProfWin window;
     char *roomjid;
     int unread;
+    Highlighter highlighter;
+    char *highlighter_nick;
+    int highlighter_gen;
     unsigned long memcheck;
 } ProfMucWin;
 
@@ -146,12 +156,18 @@ typedef struct prof_xml_win_t {
     unsigned long memcheck;
 } ProfXMLWin;
 
+typedef struct prof_highlights_win_t {
+    ProfWin window;
+    unsigned long memcheck;
+} ProfHighlightsWin;
+
 ProfWin* win_create_console(void);
 ProfWin* win_create_chat(const char * const barejid);
 ProfWin* win_create_muc(const char * const roomjid);
 ProfWin* win_create_muc_config(const char * const title, DataForm *form);
 ProfWin* win_create_private(const char * const fulljid);
 ProfWin* win_create_xmlconsole(void);
+ProfWin* win_create_highlights(void);
 
 char *win_get_title(ProfWin *window);
 
@@ -164,6 +180,7 @@ void win_show_status_string(ProfWin *window, const char * const from,
     const char * const show, const char * const status,
     GDateTime *last_activity, const char * const pre,
     const char * const default_show);
+void win_print_incoming_chat(ProfWin *window, const char * const from, ChatMessage *message);
 void win_print_incoming_message(ProfWin *window, GTimeVal *tv_stamp,
     const char * const from, const char * const message);
 void win_show_info(ProfWin *window, PContact contact);
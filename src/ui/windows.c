@@ -53,11 +53,15 @@
 #include "ui/statusbar.h"
 #include "ui/window.h"
 #include "ui/windows.h"
+#include "xmpp/xmpp.h"
 
 static GHashTable *windows;
 static int current;
 static int max_cols;
 
+static void _wins_relayout(ProfWin *window);
+static void _wins_append_account(GString *summary, ProfWin *window);
+
 void
 wins_init(void)
 {
@@ -255,6 +259,9 @@ wins_set_current_by_num(int i)
     ProfWin *window = g_hash_table_lookup(windows, GINT_TO_POINTER(i));
     if (window) {
         current = i;
+        if (window->layout->stale) {
+            _wins_relayout(window);
+        }
         if (window->type == WIN_CHAT) {
             ProfChatWin *chatwin = (ProfChatWin*) window;
             assert(chatwin->memcheck == PROFCHATWIN_MEMCHECK);
@@ -377,6 +384,9 @@ wins_close_by_num(int i)
         if (i == current) {
             current = 1;
             ProfWin *window = wins_get_current();
+            if (window->layout->stale) {
+                _wins_relayout(window);
+            }
             win_update_virtual(window);
         }
 
@@ -416,6 +426,17 @@ wins_new_xmlconsole(void)
     return newwin;
 }
 
+ProfWin *
+wins_new_highlights(void)
+{
+    GList *keys = g_hash_table_get_keys(windows);
+    int result = get_next_available_win_num(keys);
+    g_list_free(keys);
+    ProfWin *newwin = win_create_highlights();
+    g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    return newwin;
+}
+
 ProfWin *
 wins_new_chat(const char * const barejid)
 {
@@ -479,41 +500,53 @@ wins_get_total_unread(void)
 void
 wins_resize_all(void)
 {
-    int cols = getmaxx(stdscr);
+    ProfWin *current_win = wins_get_current();
 
+    // only the current window is laid out now, the rest when next focused
     GList *values = g_hash_table_get_values(windows);
     GList *curr = values;
     while (curr != NULL) {
         ProfWin *window = curr->data;
-        int subwin_cols = 0;
-
-        if (window->layout->type == LAYOUT_SPLIT) {
-            ProfLayoutSplit *layout = (ProfLayoutSplit*)window->layout;
-            if (layout->subwin) {
-                if (window->type == WIN_CONSOLE) {
-                    subwin_cols = win_roster_cols();
-                } else if (window->type == WIN_MUC) {
-                    subwin_cols = win_occpuants_cols();
-                }
-                wresize(layout->base.win, PAD_SIZE, cols - subwin_cols);
-                wresize(layout->subwin, PAD_SIZE, subwin_cols);
-                rosterwin_roster();
-            } else {
-                wresize(layout->base.win, PAD_SIZE, cols);
-            }
+        if (window == current_win) {
+            _wins_relayout(window);
         } else {
-            wresize(window->layout->win, PAD_SIZE, cols);
+            window->layout->stale = TRUE;
         }
-
-        win_redraw(window);
         curr = g_list_next(curr);
     }
     g_list_free(values);
 
-    ProfWin *current_win = wins_get_current();
     win_update_virtual(current_win);
 }
 
+static void
+_wins_relayout(ProfWin *window)
+{
+    int cols = getmaxx(stdscr);
+    int subwin_cols = 0;
+
+    if (window->layout->type == LAYOUT_SPLIT) {
+        ProfLayoutSplit *layout = (ProfLayoutSplit*)window->layout;
+        if (layout->subwin) {
+            if (window->type == WIN_CONSOLE) {
+                subwin_cols = win_roster_cols();
+            } else if (window->type == WIN_MUC) {
+                subwin_cols = win_occpuants_cols();
+            }
+            wresize(layout->base.win, PAD_SIZE, cols - subwin_cols);
+            wresize(layout->subwin, PAD_SIZE, subwin_cols);
+            rosterwin_roster();
+        } else {
+            wresize(layout->base.win, PAD_SIZE, cols);
+        }
+    } else {
+        wresize(window->layout->win, PAD_SIZE, cols);
+    }
+
+    win_redraw(window);
+    window->layout->stale = FALSE;
+}
+
 void
 wins_hide_subwin(ProfWin *window)
 {
@@ -572,6 +605,27 @@ wins_get_xmlconsole(void)
     return NULL;
 }
 
+ProfHighlightsWin *
+wins_get_highlights(void)
+{
+    GList *values = g_hash_table_get_values(windows);
+    GList *curr = values;
+
+    while (curr != NULL) {
+        ProfWin *window = curr->data;
+        if (window->type == WIN_HIGHLIGHTS) {
+            ProfHighlightsWin *highlightswin = (ProfHighlightsWin*)window;
+            assert(highlightswin->memcheck == PROFHIGHLIGHTSWIN_MEMCHECK);
+            g_list_free(values);
+            return highlightswin;
+        }
+        curr = g_list_next(curr);
+    }
+
+    g_list_free(values);
+    return NULL;
+}
+
 GSList *
 wins_get_chat_recipients(void)
 {
@@ -604,6 +658,7 @@ wins_get_prune_wins(void)
                 window->type != WIN_MUC &&
                 window->type != WIN_MUC_CONFIG &&
                 window->type != WIN_XML &&
+                window->type != WIN_HIGHLIGHTS &&
                 window->type != WIN_CONSOLE) {
             result = g_slist_append(result, window);
         }
@@ -760,6 +815,7 @@ wins_create_summary(void)
         GString *muc_string;
         GString *muc_config_string;
         GString *xml_string;
+        GString *highlights_string;
 
         switch (window->type)
         {
@@ -789,6 +845,7 @@ wins_create_summary(void)
                     g_string_free(chat_unread, TRUE);
                 }
 
+                _wins_append_account(chat_string, window);
                 result = g_slist_append(result, strdup(chat_string->str));
                 g_string_free(chat_string, TRUE);
 
@@ -806,6 +863,7 @@ wins_create_summary(void)
                     g_string_free(priv_unread, TRUE);
                 }
 
+                _wins_append_account(priv_string, window);
                 result = g_slist_append(result, strdup(priv_string->str));
                 g_string_free(priv_string, TRUE);
 
@@ -823,6 +881,7 @@ wins_create_summary(void)
                     g_string_free(muc_unread, TRUE);
                 }
 
+                _wins_append_account(muc_string, window);
                 result = g_slist_append(result, strdup(muc_string->str));
                 g_string_free(muc_string, TRUE);
 
@@ -832,6 +891,7 @@ wins_create_summary(void)
                 muc_config_string = g_string_new("");
                 char *title = win_get_title(window);
                 g_string_printf(muc_config_string, "%d: %s", ui_index, title);
+                _wins_append_account(muc_config_string, window);
                 result = g_slist_append(result, strdup(muc_config_string->str));
                 g_string_free(muc_config_string, TRUE);
                 free(title);
@@ -846,6 +906,14 @@ wins_create_summary(void)
 
                 break;
 
+            case WIN_HIGHLIGHTS:
+                highlights_string = g_string_new("");
+                g_string_printf(highlights_string, "%d: Highlights", ui_index);
+                result = g_slist_append(result, strdup(highlights_string->str));
+                g_string_free(highlights_string, TRUE);
+
+                break;
+
             default:
                 break;
         }
@@ -856,6 +924,15 @@ wins_create_summary(void)
     return result;
 }
 
+// name the account of windows left over from another account
+static void
+_wins_append_account(GString *summary, ProfWin *window)
+{
+    if (window->account && (g_strcmp0(window->account, jabber_get_account_name()) != 0)) {
+        g_string_append_printf(summary, " (%s)", window->account);
+    }
+}
+
 void
 wins_destroy(void)
 {
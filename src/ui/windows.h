@@ -38,6 +38,7 @@
 void wins_init(void);
 
 ProfWin * wins_new_xmlconsole(void);
+ProfWin * wins_new_highlights(void);
 ProfWin * wins_new_chat(const char * const barejid);
 ProfWin * wins_new_muc(const char * const roomjid);
 ProfWin * wins_new_muc_config(const char * const roomjid, DataForm *form);
@@ -49,6 +50,7 @@ ProfMucWin * wins_get_muc(const char * const roomjid);
 ProfMucConfWin * wins_get_muc_conf(const char * const roomjid);
 ProfPrivateWin *wins_get_private(const char * const fulljid);
 ProfXMLWin * wins_get_xmlconsole(void);
+ProfHighlightsWin * wins_get_highlights(void);
 
 ProfWin * wins_get_current(void);
 ProfChatWin * wins_get_current_chat(void);
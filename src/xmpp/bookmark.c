@@ -84,7 +84,7 @@ bookmark_request(void)
 
     iq = stanza_create_bookmarks_storage_request(ctx);
     xmpp_stanza_set_id(iq, id);
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -171,7 +171,7 @@ bookmark_join(const char *jid)
         return FALSE;
     } else {
         char *account_name = jabber_get_account_name();
-        ProfAccount *account = accounts_get_account(account_name);
+        const ProfAccount *account = accounts_get_account_ref(account_name);
         Bookmark *item = found->data;
         if (!muc_active(item->jid)) {
             char *nick = item->nick;
@@ -180,7 +180,6 @@ bookmark_join(const char *jid)
             }
             presence_join_room(item->jid, nick, item->password);
             muc_join(item->jid, nick, item->password, FALSE);
-            account_free(account);
         } else if (muc_roster_complete(item->jid)) {
             ui_room_join(item->jid, TRUE);
         }
@@ -328,7 +327,7 @@ _bookmark_handle_result(xmpp_conn_t * const conn,
             Jid *room_jid;
 
             char *account_name = jabber_get_account_name();
-            ProfAccount *account = accounts_get_account(account_name);
+            const ProfAccount *account = accounts_get_account_ref(account_name);
             if (name == NULL) {
                 name = account->muc_nick;
             }
@@ -340,7 +339,6 @@ _bookmark_handle_result(xmpp_conn_t * const conn,
                 muc_join(jid, name, password, TRUE);
             }
             jid_destroy(room_jid);
-            account_free(account);
         }
 
         ptr = xmpp_stanza_get_next(ptr);
@@ -394,7 +392,6 @@ _match_bookmark_by_jid(gconstpointer a, gconstpointer b)
 static void
 _send_bookmarks(void)
 {
-    xmpp_conn_t *conn = connection_get_conn();
     xmpp_ctx_t *ctx = connection_get_ctx();
 
     xmpp_stanza_t *iq = xmpp_stanza_new(ctx);
@@ -466,6 +463,6 @@ _send_bookmarks(void)
     xmpp_stanza_release(storage);
     xmpp_stanza_release(query);
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
\ No newline at end of file
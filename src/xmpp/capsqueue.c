@@ -0,0 +1,267 @@
+/*
+ * capsqueue.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "common.h"
+#include "xmpp/capsqueue.h"
+
+typedef struct caps_query_t {
+    char *key;
+    char *node;
+    char *ver;
+    gboolean legacy;
+    GSList *waiters;
+    GSList *target;
+    int attempts;
+    char *attempt_id;
+    gboolean in_flight;
+    gint64 sent_at;
+} CapsQuery;
+
+static GHashTable *queries;
+static GQueue *waiting;
+static int inflight;
+static caps_query_func send_query;
+
+static void _send(CapsQuery *query, gint64 now);
+static void _send_waiting(gint64 now);
+static void _free_query(CapsQuery *query);
+
+void
+capsqueue_init(caps_query_func query_func)
+{
+    capsqueue_close();
+    send_query = query_func;
+    queries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)_free_query);
+    waiting = g_queue_new();
+    inflight = 0;
+}
+
+void
+capsqueue_close(void)
+{
+    if (waiting != NULL) {
+        g_queue_free(waiting);
+        waiting = NULL;
+    }
+    if (queries != NULL) {
+        g_hash_table_destroy(queries);
+        queries = NULL;
+    }
+    inflight = 0;
+    send_query = NULL;
+}
+
+gboolean
+capsqueue_request(const char * const key, const char * const jid,
+    const char * const node, const char * const ver, gboolean legacy, gint64 now)
+{
+    if (queries == NULL) {
+        return FALSE;
+    }
+
+    CapsQuery *query = g_hash_table_lookup(queries, key);
+    if (query != NULL) {
+        if (g_slist_find_custom(query->waiters, jid, (GCompareFunc)g_strcmp0) == NULL) {
+            query->waiters = g_slist_append(query->waiters, strdup(jid));
+        }
+        return FALSE;
+    }
+
+    query = malloc(sizeof(CapsQuery));
+    query->key = strdup(key);
+    query->node = strdup(node);
+    query->ver = strdup(ver);
+    query->legacy = legacy;
+    query->waiters = g_slist_append(NULL, strdup(jid));
+    query->target = query->waiters;
+    query->attempts = 0;
+    query->attempt_id = NULL;
+    query->in_flight = FALSE;
+    query->sent_at = 0;
+    g_hash_table_insert(queries, query->key, query);
+
+    if (inflight < CAPSQUEUE_MAX_INFLIGHT) {
+        _send(query, now);
+    } else {
+        g_queue_push_tail(waiting, query);
+    }
+
+    return TRUE;
+}
+
+GSList *
+capsqueue_complete(const char * const key, gint64 now)
+{
+    if (queries == NULL) {
+        return NULL;
+    }
+
+    CapsQuery *query = g_hash_table_lookup(queries, key);
+    if (query == NULL) {
+        return NULL;
+    }
+
+    GSList *waiters = query->waiters;
+    query->waiters = NULL;
+    if (query->in_flight) {
+        inflight--;
+    } else {
+        g_queue_remove(waiting, query);
+    }
+    g_hash_table_remove(queries, key);
+
+    _send_waiting(now);
+
+    return waiters;
+}
+
+// id is the stanza id of the failed attempt, replies to earlier attempts are ignored
+void
+capsqueue_failed(const char * const key, const char * const id, gint64 now)
+{
+    if (queries == NULL) {
+        return;
+    }
+
+    CapsQuery *query = g_hash_table_lookup(queries, key);
+    if (query == NULL || !query->in_flight) {
+        return;
+    }
+    if (g_strcmp0(id, query->attempt_id) != 0) {
+        return;
+    }
+
+    inflight--;
+    query->in_flight = FALSE;
+
+    // the last contact asked did not answer, try the next one that advertised the same ver
+    if (query->attempts < CAPSQUEUE_MAX_ATTEMPTS && query->target->next != NULL) {
+        query->target = query->target->next;
+        _send(query, now);
+    } else {
+        g_hash_table_remove(queries, key);
+    }
+
+    _send_waiting(now);
+}
+
+void
+capsqueue_expire(gint64 now, gint64 timeout)
+{
+    if (queries == NULL || inflight == 0) {
+        return;
+    }
+
+    GSList *expired = NULL;
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_hash_table_iter_init(&iter, queries);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        CapsQuery *query = value;
+        if (query->in_flight && (now - query->sent_at) >= timeout) {
+            expired = g_slist_append(expired, query);
+        }
+    }
+
+    GSList *curr = expired;
+    while (curr != NULL) {
+        CapsQuery *query = curr->data;
+        char *key = strdup(query->key);
+        char *id = query->attempt_id ? strdup(query->attempt_id) : NULL;
+        capsqueue_failed(key, id, now);
+        free(key);
+        free(id);
+        curr = g_slist_next(curr);
+    }
+    g_slist_free(expired);
+}
+
+gboolean
+capsqueue_pending(const char * const key)
+{
+    if (queries == NULL) {
+        return FALSE;
+    }
+
+    return g_hash_table_contains(queries, key);
+}
+
+int
+capsqueue_inflight(void)
+{
+    return inflight;
+}
+
+static void
+_send(CapsQuery *query, gint64 now)
+{
+    query->attempts++;
+    query->in_flight = TRUE;
+    query->sent_at = now;
+    inflight++;
+
+    free(query->attempt_id);
+    query->attempt_id = NULL;
+    if (send_query != NULL) {
+        query->attempt_id = send_query(query->target->data, query->node, query->ver, query->legacy);
+    }
+}
+
+static void
+_send_waiting(gint64 now)
+{
+    while (inflight < CAPSQUEUE_MAX_INFLIGHT && !g_queue_is_empty(waiting)) {
+        CapsQuery *query = g_queue_pop_head(waiting);
+        _send(query, now);
+    }
+}
+
+static void
+_free_query(CapsQuery *query)
+{
+    if (query != NULL) {
+        free(query->key);
+        free(query->node);
+        free(query->ver);
+        free(query->attempt_id);
+        g_slist_free_full(query->waiters, free);
+        free(query);
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * capsqueue.h
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef XMPP_CAPSQUEUE_H
+#define XMPP_CAPSQUEUE_H
+
+#include <glib.h>
+
+// disco#info requests allowed in flight at once
+#define CAPSQUEUE_MAX_INFLIGHT 8
+// requests sent for one ver before giving up
+#define CAPSQUEUE_MAX_ATTEMPTS 3
+// time to wait for a response before asking the next waiter
+#define CAPSQUEUE_TIMEOUT (30 * G_TIME_SPAN_SECOND)
+
+// sends the request and returns the stanza id used, owned by the queue
+typedef char * (*caps_query_func)(const char * const jid, const char * const node,
+    const char * const ver, gboolean legacy);
+
+void capsqueue_init(caps_query_func query_func);
+void capsqueue_close(void);
+gboolean capsqueue_request(const char * const key, const char * const jid,
+    const char * const node, const char * const ver, gboolean legacy, gint64 now);
+GSList * capsqueue_complete(const char * const key, gint64 now);
+void capsqueue_failed(const char * const key, const char * const id, gint64 now);
+void capsqueue_expire(gint64 now, gint64 timeout);
+gboolean capsqueue_pending(const char * const key);
+int capsqueue_inflight(void);
+
+#endif
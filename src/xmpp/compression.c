@@ -0,0 +1,200 @@
+/*
+ * compression.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "xmpp/compression.h"
+
+/*
+ * Statistics for stream compression (XEP-0138). libstrophe does the actual
+ * compression and only shows us the plain XML, so the compressed size is
+ * found by running each direction through its own zlib stream, flushed after
+ * every write as the stream compression is. Without zlib only the plain
+ * sizes are counted.
+ */
+static gboolean active = FALSE;
+static CompressionStats stats;
+
+#ifdef HAVE_ZLIB
+typedef struct direction_t {
+    z_stream stream;
+    gboolean ready;
+} Direction;
+
+static Direction outgoing;
+static Direction incoming;
+
+static guint64 _deflated_size(Direction *direction, const char * const data, gsize len);
+static void _end(Direction *direction);
+#endif
+
+// reset for a new stream, which starts out uncompressed
+void
+compression_init(void)
+{
+    compression_close();
+    memset(&stats, 0, sizeof(stats));
+}
+
+void
+compression_close(void)
+{
+#ifdef HAVE_ZLIB
+    _end(&outgoing);
+    _end(&incoming);
+#endif
+    active = FALSE;
+}
+
+void
+compression_set_active(gboolean is_active)
+{
+    active = is_active;
+}
+
+gboolean
+compression_active(void)
+{
+    return active;
+}
+
+/*
+ * Whether a chunk of received stream data is the server's <compressed/>
+ * answer. It is sent on its own before the stream restarts, so anything not
+ * starting with it, such as a message quoting it, is ignored.
+ */
+gboolean
+compression_confirmed(const char * const data)
+{
+    const char *curr = data;
+    while (g_ascii_isspace(*curr)) {
+        curr++;
+    }
+    if (!g_str_has_prefix(curr, "<compressed")) {
+        return FALSE;
+    }
+
+    const char *end = strchr(curr, '>');
+    const char *ns = strstr(curr, "xmlns='http://jabber.org/protocol/compress'");
+    if (ns == NULL) {
+        ns = strstr(curr, "xmlns=\"http://jabber.org/protocol/compress\"");
+    }
+
+    return ns != NULL && (end == NULL || ns < end);
+}
+
+void
+compression_sent(const char * const data, gsize len)
+{
+    if (!active) {
+        return;
+    }
+
+    stats.sent += len;
+#ifdef HAVE_ZLIB
+    stats.sent_compressed += _deflated_size(&outgoing, data, len);
+#else
+    stats.sent_compressed += len;
+#endif
+}
+
+void
+compression_received(const char * const data, gsize len)
+{
+    if (!active) {
+        return;
+    }
+
+    stats.received += len;
+#ifdef HAVE_ZLIB
+    stats.received_compressed += _deflated_size(&incoming, data, len);
+#else
+    stats.received_compressed += len;
+#endif
+}
+
+void
+compression_get_stats(CompressionStats *result)
+{
+    *result = stats;
+    result->active = active;
+#ifdef HAVE_ZLIB
+    result->estimated = TRUE;
+#else
+    result->estimated = FALSE;
+#endif
+}
+
+#ifdef HAVE_ZLIB
+static guint64
+_deflated_size(Direction *direction, const char * const data, gsize len)
+{
+    if (!direction->ready) {
+        memset(&direction->stream, 0, sizeof(z_stream));
+        if (deflateInit(&direction->stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+            return len;
+        }
+        direction->ready = TRUE;
+    }
+
+    unsigned char out[4096];
+    guint64 size = 0;
+    direction->stream.next_in = (Bytef *)data;
+    direction->stream.avail_in = len;
+    do {
+        direction->stream.next_out = out;
+        direction->stream.avail_out = sizeof(out);
+        deflate(&direction->stream, Z_SYNC_FLUSH);
+        size += sizeof(out) - direction->stream.avail_out;
+    } while (direction->stream.avail_out == 0);
+
+    return size;
+}
+
+static void
+_end(Direction *direction)
+{
+    if (direction->ready) {
+        deflateEnd(&direction->stream);
+        direction->ready = FALSE;
+    }
+}
+#endif
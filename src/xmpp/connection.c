@@ -32,6 +32,8 @@
  *
  */
 
+#include "config.h"
+
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
@@ -48,26 +50,21 @@
 #include "server_events.h"
 #include "xmpp/bookmark.h"
 #include "xmpp/capabilities.h"
+#include "xmpp/capsqueue.h"
+#include "xmpp/compression.h"
 #include "xmpp/connection.h"
+#include "xmpp/csi.h"
 #include "xmpp/iq.h"
+#include "xmpp/mam.h"
 #include "xmpp/message.h"
 #include "xmpp/presence.h"
 #include "xmpp/roster.h"
+#include "xmpp/sendqueue.h"
 #include "xmpp/stanza.h"
+#include "xmpp/xmltrace.h"
 #include "xmpp/xmpp.h"
 
-static struct _jabber_conn_t {
-    xmpp_log_t *log;
-    xmpp_ctx_t *ctx;
-    xmpp_conn_t *conn;
-    jabber_conn_status_t conn_status;
-    char *presence_message;
-    int priority;
-    int tls_disabled;
-    char *domain;
-} jabber_conn;
-
-static GHashTable *available_resources;
+static JabberConn jabber_conn;
 
 // for auto reconnect
 static struct {
@@ -103,6 +100,12 @@ static void _connection_handler(xmpp_conn_t * const conn,
 void _connection_free_saved_account(void);
 void _connection_free_saved_details(void);
 void _connection_free_session_data(void);
+static void _connection_flush(void);
+static void _send_queued(void *stanza);
+static void _release_queued(void *stanza);
+static void _send_csi(gboolean active);
+static void _check_stream_features(const char * const msg);
+static void _count_stream_bytes(const char * const msg);
 
 void
 jabber_init(const int disable_tls)
@@ -114,9 +117,13 @@ jabber_init(const int disable_tls)
     jabber_conn.ctx = NULL;
     jabber_conn.tls_disabled = disable_tls;
     jabber_conn.domain = NULL;
+    jabber_conn.my_jid = NULL;
+    jabber_conn.roster = roster_list_new();
+    jabber_conn.rooms = muc_rooms_new();
+    connection_use(&jabber_conn);
     presence_sub_requests_init();
     caps_init();
-    available_resources = g_hash_table_new_full(g_str_hash, g_str_equal, free,
+    jabber_conn.available_resources = g_hash_table_new_full(g_str_hash, g_str_equal, free,
         (GDestroyNotify)resource_destroy);
     xmpp_initialize();
 }
@@ -190,6 +197,7 @@ jabber_disconnect(void)
     // if connected, send end stream and wait for response
     if (jabber_conn.conn_status == JABBER_CONNECTED) {
         log_info("Closing connection");
+        _connection_flush();
         jabber_conn.conn_status = JABBER_DISCONNECTING;
         xmpp_disconnect(jabber_conn.conn);
 
@@ -220,8 +228,13 @@ jabber_shutdown(void)
     _connection_free_saved_account();
     _connection_free_saved_details();
     _connection_free_session_data();
+    compression_close();
     xmpp_shutdown();
     free(jabber_conn.log);
+    roster_list_free(jabber_conn.roster);
+    jabber_conn.roster = NULL;
+    muc_rooms_free(jabber_conn.rooms);
+    jabber_conn.rooms = NULL;
 }
 
 void
@@ -229,9 +242,15 @@ jabber_process_events(void)
 {
     int reconnect_sec;
 
+    connection_use(&jabber_conn);
+
     switch (jabber_conn.conn_status)
     {
         case JABBER_CONNECTED:
+            capsqueue_expire(g_get_monotonic_time(), CAPSQUEUE_TIMEOUT);
+            _connection_flush();
+            xmpp_run_once(jabber_conn.ctx, 10);
+            break;
         case JABBER_CONNECTING:
         case JABBER_DISCONNECTING:
             xmpp_run_once(jabber_conn.ctx, 10);
@@ -253,7 +272,7 @@ jabber_process_events(void)
 GList *
 jabber_get_available_resources(void)
 {
-    return g_hash_table_get_values(available_resources);
+    return g_hash_table_get_values(jabber_conn.available_resources);
 }
 
 jabber_conn_status_t
@@ -262,6 +281,23 @@ jabber_get_connection_status(void)
     return (jabber_conn.conn_status);
 }
 
+JabberConn*
+connection_get(void)
+{
+    return &jabber_conn;
+}
+
+/*
+ * Make the roster and rooms of a connection the ones the roster and muc
+ * functions work on, done before servicing that connection
+ */
+void
+connection_use(JabberConn *jc)
+{
+    roster_list_use(jc->roster);
+    muc_rooms_use(jc->rooms);
+}
+
 xmpp_conn_t *
 connection_get_conn(void)
 {
@@ -280,6 +316,32 @@ jabber_get_fulljid(void)
     return xmpp_conn_get_jid(jabber_conn.conn);
 }
 
+Jid *
+jabber_get_jid(void)
+{
+    const char *fulljid = jabber_get_fulljid();
+    if (fulljid == NULL) {
+        return NULL;
+    }
+
+    if (jabber_conn.my_jid == NULL || g_strcmp0(jabber_conn.my_jid->str, fulljid) != 0) {
+        jid_release(jabber_conn.my_jid);
+        jabber_conn.my_jid = jid_intern(fulljid);
+    }
+
+    return jabber_conn.my_jid;
+}
+
+/*
+ * Queue a stanza for sending on the next loop turn, the caller keeps its own reference.
+ * Presences and chat states with a key supersede ones already queued for that key.
+ */
+void
+connection_send_stanza(xmpp_stanza_t *stanza, send_priority_t priority, const char * const key)
+{
+    sendqueue_add(priority, key, xmpp_stanza_clone(stanza));
+}
+
 const char *
 jabber_get_domain(void)
 {
@@ -316,13 +378,13 @@ connection_set_priority(const int priority)
 void
 connection_add_available_resource(Resource *resource)
 {
-    g_hash_table_replace(available_resources, strdup(resource->name), resource);
+    g_hash_table_replace(jabber_conn.available_resources, strdup(resource->name), resource);
 }
 
 void
 connection_remove_available_resource(const char * const resource)
 {
-    g_hash_table_remove(available_resources, resource);
+    g_hash_table_remove(jabber_conn.available_resources, resource);
 }
 
 void
@@ -344,9 +406,14 @@ _connection_free_saved_details(void)
 void
 _connection_free_session_data(void)
 {
-    g_hash_table_remove_all(available_resources);
+    g_hash_table_remove_all(jabber_conn.available_resources);
     chat_sessions_clear();
     presence_clear_sub_requests();
+    capsqueue_close();
+    sendqueue_close();
+    jid_release(jabber_conn.my_jid);
+    jabber_conn.my_jid = NULL;
+    jid_intern_clear();
 }
 
 static jabber_conn_status_t
@@ -398,6 +465,18 @@ _jabber_connect(const char * const fulljid, const char * const passwd,
         xmpp_conn_disable_tls(jabber_conn.conn);
     }
 
+    csi_init(_send_csi);
+    mam_init(iq_mam_query, handle_archived_messages);
+    compression_init();
+    if (prefs_get_boolean(PREF_COMPRESSION)) {
+#ifdef HAVE_STROPHE_COMPRESSION
+        long flags = xmpp_conn_get_flags(jabber_conn.conn);
+        xmpp_conn_set_flags(jabber_conn.conn, flags | XMPP_CONN_FLAG_ENABLE_COMPRESSION);
+#else
+        log_warning("Stream compression requested, but libstrophe does not support it");
+#endif
+    }
+
     int connect_status = xmpp_connect_client(jabber_conn.conn, altdomain, port,
         _connection_handler, jabber_conn.ctx);
 
@@ -413,7 +492,7 @@ static void
 _jabber_reconnect(void)
 {
     // reconnect with account.
-    ProfAccount *account = accounts_get_account(saved_account.name);
+    const ProfAccount *account = accounts_get_account_ref(saved_account.name);
 
     if (account == NULL) {
         log_error("Unable to reconnect, account no longer exists: %s", saved_account.name);
@@ -434,6 +513,7 @@ _connection_handler(xmpp_conn_t * const conn,
     // login success
     if (status == XMPP_CONN_CONNECT) {
         log_debug("Connection handler: XMPP_CONN_CONNECT");
+        sendqueue_init(_send_queued, _release_queued);
 
         // logged in with account
         if (saved_account.name != NULL) {
@@ -453,9 +533,7 @@ _connection_handler(xmpp_conn_t * const conn,
             _connection_free_saved_details();
         }
 
-        Jid *my_jid = jid_create(jabber_get_fulljid());
-        jabber_conn.domain = strdup(my_jid->domainpart);
-        jid_destroy(my_jid);
+        jabber_conn.domain = strdup(jabber_get_jid()->domainpart);
 
         chat_sessions_init();
 
@@ -557,8 +635,10 @@ _xmpp_file_logger(void * const userdata, const xmpp_log_level_t level,
 {
     log_level_t prof_level = _get_log_level(level);
     log_msg(prof_level, area, msg);
-    if ((g_strcmp0(area, "xmpp") == 0) || (g_strcmp0(area, "conn")) == 0) {
-        handle_xmpp_stanza(msg);
+    _check_stream_features(msg);
+    _count_stream_bytes(msg);
+    if (xmltrace_active) {
+        xmltrace_capture(msg);
     }
 }
 
@@ -572,4 +652,67 @@ _xmpp_get_file_logger()
     file_log->userdata = &level;
 
     return file_log;
-}
\ No newline at end of file
+}
+
+static void
+_connection_flush(void)
+{
+    guint depth = sendqueue_depth();
+    if (depth > 1) {
+        log_debug("Sending %u queued stanzas", depth);
+    }
+    sendqueue_flush();
+}
+
+static void
+_send_queued(void *stanza)
+{
+    xmpp_send(jabber_conn.conn, stanza);
+}
+
+static void
+_release_queued(void *stanza)
+{
+    xmpp_stanza_release(stanza);
+}
+
+static void
+_send_csi(gboolean active)
+{
+    log_debug("Sending client state %s", active ? "active" : "inactive");
+    xmpp_stanza_t *csi = stanza_create_csi(jabber_conn.ctx, active);
+    connection_send_stanza(csi, SEND_PRIORITY_PRESENCE, STANZA_NS_CSI);
+    xmpp_stanza_release(csi);
+}
+
+/*
+ * libstrophe handles stream features itself, so look for the ones it does not
+ * know about in the received data it logs
+ */
+static void
+_check_stream_features(const char * const msg)
+{
+    if (!g_str_has_prefix(msg, "RECV: ") || csi_supported()) {
+        return;
+    }
+
+    if (csi_offered(msg + 6)) {
+        log_debug("Server supports client state indication");
+        csi_set_supported(TRUE);
+    }
+}
+
+// stream compression starts once the server confirms it, see XEP-0138
+static void
+_count_stream_bytes(const char * const msg)
+{
+    if (g_str_has_prefix(msg, "SENT: ")) {
+        compression_sent(msg + 6, strlen(msg + 6));
+    } else if (g_str_has_prefix(msg, "RECV: ")) {
+        compression_received(msg + 6, strlen(msg + 6));
+        if (!compression_active() && compression_confirmed(msg + 6)) {
+            log_info("Stream compression enabled");
+            compression_set_active(TRUE);
+        }
+    }
+}
@@ -37,7 +37,32 @@
 
 #include <strophe.h>
 
+#include "jid.h"
+#include "muc.h"
 #include "resource.h"
+#include "roster_list.h"
+#include "xmpp/sendqueue.h"
+#include "xmpp/xmpp.h"
+
+// everything one XMPP session owns, handed to the stanza handlers as userdata
+typedef struct jabber_conn_t {
+    xmpp_log_t *log;
+    xmpp_ctx_t *ctx;
+    xmpp_conn_t *conn;
+    jabber_conn_status_t conn_status;
+    char *presence_message;
+    int priority;
+    int tls_disabled;
+    char *domain;
+    GHashTable *available_resources;
+    // parsed jid of the connection, refreshed when the bound jid changes
+    Jid *my_jid;
+    RosterList *roster;
+    MucRooms *rooms;
+} JabberConn;
+
+JabberConn* connection_get(void);
+void connection_use(JabberConn *jc);
 
 xmpp_conn_t *connection_get_conn(void);
 xmpp_ctx_t *connection_get_ctx(void);
@@ -45,5 +70,6 @@ void connection_set_priority(int priority);
 void connection_set_presence_message(const char * const message);
 void connection_add_available_resource(Resource *resource);
 void connection_remove_available_resource(const char * const resource);
+void connection_send_stanza(xmpp_stanza_t *stanza, send_priority_t priority, const char * const key);
 
 #endif
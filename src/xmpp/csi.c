@@ -0,0 +1,147 @@
+/*
+ * csi.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "xmpp/csi.h"
+
+/*
+ * Client state indication (XEP-0352), the server is told when the user stops
+ * and starts paying attention so it can hold back non urgent traffic.
+ * Only changes are sent, and only to servers advertising the stream feature.
+ */
+static csi_send_func send_state = NULL;
+static gboolean supported = FALSE;
+static gboolean active = TRUE;
+
+static const char * _skip_stream_header(const char *data);
+
+// reset for a new stream, which starts out active
+void
+csi_init(csi_send_func send_func)
+{
+    send_state = send_func;
+    supported = FALSE;
+    active = TRUE;
+}
+
+void
+csi_set_supported(gboolean is_supported)
+{
+    supported = is_supported;
+}
+
+gboolean
+csi_supported(void)
+{
+    return supported;
+}
+
+void
+csi_set_active(gboolean is_active)
+{
+    if (!supported || active == is_active) {
+        return;
+    }
+
+    active = is_active;
+    if (send_state) {
+        send_state(active);
+    }
+}
+
+gboolean
+csi_active(void)
+{
+    return active;
+}
+
+/*
+ * Whether a chunk of received stream data is a <stream:features/> element
+ * offering CSI. Stanzas can carry the namespace in their text, so only a chunk
+ * that starts with the features element, or with the stream header sent just
+ * before it, is looked at.
+ */
+gboolean
+csi_offered(const char * const data)
+{
+    const char *features = _skip_stream_header(data);
+    if (!g_str_has_prefix(features, "<stream:features")) {
+        return FALSE;
+    }
+
+    const char *csi = strstr(features, "<csi xmlns='urn:xmpp:csi:0'");
+    if (csi == NULL) {
+        csi = strstr(features, "<csi xmlns=\"urn:xmpp:csi:0\"");
+    }
+    if (csi == NULL) {
+        return FALSE;
+    }
+
+    const char *end = strstr(features, "</stream:features>");
+    return end == NULL || csi < end;
+}
+
+// a server may send the header of a restarted stream in the same read as its features
+static const char *
+_skip_stream_header(const char *data)
+{
+    while (g_ascii_isspace(*data)) {
+        data++;
+    }
+    if (g_str_has_prefix(data, "<?xml")) {
+        const char *end = strstr(data, "?>");
+        if (end == NULL) {
+            return data;
+        }
+        data = end + 2;
+        while (g_ascii_isspace(*data)) {
+            data++;
+        }
+    }
+    if (g_str_has_prefix(data, "<stream:stream")) {
+        const char *end = strchr(data, '>');
+        if (end == NULL) {
+            return data;
+        }
+        data = end + 1;
+        while (g_ascii_isspace(*data)) {
+            data++;
+        }
+    }
+
+    return data;
+}
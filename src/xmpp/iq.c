@@ -50,9 +50,11 @@
 #include "config/preferences.h"
 #include "server_events.h"
 #include "xmpp/capabilities.h"
+#include "xmpp/capsqueue.h"
 #include "xmpp/connection.h"
 #include "xmpp/stanza.h"
 #include "xmpp/form.h"
+#include "xmpp/mam.h"
 #include "roster_list.h"
 #include "xmpp/xmpp.h"
 
@@ -100,6 +102,9 @@ static int _caps_response_handler_for_jid(xmpp_conn_t *const conn,
     xmpp_stanza_t * const stanza, void * const userdata);
 static int _caps_response_handler_legacy(xmpp_conn_t *const conn,
     xmpp_stanza_t * const stanza, void * const userdata);
+static void _caps_map_waiters(const char * const ver);
+static int _mam_fin_handler(xmpp_conn_t * const conn,
+    xmpp_stanza_t * const stanza, void * const userdata);
 
 void
 iq_add_handlers(void)
@@ -145,10 +150,9 @@ iq_set_autoping(const int seconds)
 void
 iq_room_list_request(gchar *conferencejid)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *iq = stanza_create_disco_items_iq(ctx, "confreq", conferencejid);
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -164,7 +168,7 @@ iq_disco_info_request(gchar *jid)
 
     free(id);
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -180,7 +184,7 @@ iq_room_info_request(gchar *room)
 
     free(id);
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -207,7 +211,7 @@ iq_send_caps_request_for_jid(const char * const to, const char * const id,
 
     xmpp_id_handler_add(conn, _caps_response_handler_for_jid, id, strdup(to));
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -232,9 +236,9 @@ iq_send_caps_request(const char * const to, const char * const id,
     xmpp_stanza_t *iq = stanza_create_disco_info_iq(ctx, id, to, node_str->str);
     g_string_free(node_str, TRUE);
 
-    xmpp_id_handler_add(conn, _caps_response_handler, id, NULL);
+    xmpp_id_handler_add(conn, _caps_response_handler, id, strdup(ver));
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -261,37 +265,34 @@ iq_send_caps_request_legacy(const char * const to, const char * const id,
     xmpp_id_handler_add(conn, _caps_response_handler_legacy, id, node_str->str);
     g_string_free(node_str, FALSE);
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
 void
 iq_disco_items_request(gchar *jid)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *iq = stanza_create_disco_items_iq(ctx, "discoitemsreq", jid);
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
 void
 iq_send_software_version(const char * const fulljid)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *iq = stanza_create_software_version_iq(ctx, fulljid);
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
 void
 iq_confirm_instant_room(const char * const room_jid)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *iq = stanza_create_instant_room_request_iq(ctx, room_jid);
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -305,7 +306,7 @@ iq_destroy_room(const char * const room_jid)
     char *id = xmpp_stanza_get_id(iq);
     xmpp_id_handler_add(conn, _destroy_room_result_handler, id, NULL);
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -319,7 +320,7 @@ iq_request_room_config_form(const char * const room_jid)
     char *id = xmpp_stanza_get_id(iq);
     xmpp_id_handler_add(conn, _room_config_handler, id, NULL);
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -333,17 +334,16 @@ iq_submit_room_config(const char * const room, DataForm *form)
     char *id = xmpp_stanza_get_id(iq);
     xmpp_id_handler_add(conn, _room_config_submit_handler, id, NULL);
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
 void
 iq_room_config_cancel(const char * const room_jid)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *iq = stanza_create_room_config_cancel_iq(ctx, room_jid);
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -357,7 +357,7 @@ iq_room_affiliation_list(const char * const room, char *affiliation)
     char *id = xmpp_stanza_get_id(iq);
     xmpp_id_handler_add(conn, _room_affiliation_list_result_handler, id, strdup(affiliation));
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -371,7 +371,7 @@ iq_room_kick_occupant(const char * const room, const char * const nick, const ch
     char *id = xmpp_stanza_get_id(iq);
     xmpp_id_handler_add(conn, _room_kick_result_handler, id, strdup(nick));
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -396,7 +396,7 @@ iq_room_affiliation_set(const char * const room, const char * const jid, char *a
 
     xmpp_id_handler_add(conn, _room_affiliation_set_result_handler, id, affiliation_set);
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -416,7 +416,7 @@ iq_room_role_set(const char * const room, const char * const nick, char *role,
 
     xmpp_id_handler_add(conn, _room_role_set_result_handler, id, role_set);
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -430,7 +430,7 @@ iq_room_role_list(const char * const room, char *role)
     char *id = xmpp_stanza_get_id(iq);
     xmpp_id_handler_add(conn, _room_role_list_result_handler, id, strdup(role));
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -445,7 +445,24 @@ iq_send_ping(const char * const target)
     GDateTime *now = g_date_time_new_now_local();
     xmpp_id_handler_add(conn, _manual_pong_handler, id, now);
 
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
+    xmpp_stanza_release(iq);
+}
+
+// archive is the room jid, or our own bare jid for the account's archive
+void
+iq_mam_query(const char * const archive, const char * const after, int max)
+{
+    xmpp_conn_t * const conn = connection_get_conn();
+    xmpp_ctx_t * const ctx = connection_get_ctx();
+    Jid *jidp = jabber_get_jid();
+    const char *to = g_strcmp0(archive, jidp->barejid) == 0 ? NULL : archive;
+    xmpp_stanza_t *iq = stanza_create_mam_iq(ctx, to, after, max);
+
+    char *id = xmpp_stanza_get_id(iq);
+    xmpp_id_handler_add(conn, _mam_fin_handler, id, strdup(archive));
+
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -512,6 +529,7 @@ static int
 _caps_response_handler(xmpp_conn_t *const conn, xmpp_stanza_t * const stanza,
     void * const userdata)
 {
+    char *expected_ver = (char *)userdata;
     const char *id = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_ID);
     xmpp_stanza_t *query = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_QUERY);
 
@@ -530,6 +548,8 @@ _caps_response_handler(xmpp_conn_t *const conn, xmpp_stanza_t * const stanza,
     const char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
     if (!from) {
         log_info("No from attribute");
+        capsqueue_failed(expected_ver, id, g_get_monotonic_time());
+        free(expected_ver);
         return 0;
     }
 
@@ -538,17 +558,23 @@ _caps_response_handler(xmpp_conn_t *const conn, xmpp_stanza_t * const stanza,
         char *error_message = stanza_get_error_message(stanza);
         log_warning("Error received for capabilities response from %s: ", from, error_message);
         free(error_message);
+        capsqueue_failed(expected_ver, id, g_get_monotonic_time());
+        free(expected_ver);
         return 0;
     }
 
     if (query == NULL) {
         log_warning("No query element found.");
+        capsqueue_failed(expected_ver, id, g_get_monotonic_time());
+        free(expected_ver);
         return 0;
     }
 
     char *node = xmpp_stanza_get_attribute(query, STANZA_ATTR_NODE);
     if (node == NULL) {
         log_warning("No node attribute found");
+        capsqueue_failed(expected_ver, id, g_get_monotonic_time());
+        free(expected_ver);
         return 0;
     }
 
@@ -561,6 +587,7 @@ _caps_response_handler(xmpp_conn_t *const conn, xmpp_stanza_t * const stanza,
         log_warning("Generated sha-1 does not match given:");
         log_warning("Generated : %s", generated_sha1);
         log_warning("Given     : %s", given_sha1);
+        capsqueue_failed(expected_ver, id, g_get_monotonic_time());
     } else {
         log_info("Valid SHA-1 hash found: %s", given_sha1);
 
@@ -574,10 +601,15 @@ _caps_response_handler(xmpp_conn_t *const conn, xmpp_stanza_t * const stanza,
         }
 
         caps_map_jid_to_ver(from, given_sha1);
+        _caps_map_waiters(given_sha1);
+        if (g_strcmp0(given_sha1, expected_ver) != 0) {
+            capsqueue_failed(expected_ver, id, g_get_monotonic_time());
+        }
     }
 
     g_free(generated_sha1);
     g_strfreev(split);
+    free(expected_ver);
 
     return 0;
 }
@@ -665,6 +697,7 @@ _caps_response_handler_legacy(xmpp_conn_t *const conn, xmpp_stanza_t * const sta
     const char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
     if (!from) {
         log_info("No from attribute");
+        capsqueue_failed(expected_node, id, g_get_monotonic_time());
         free(expected_node);
         return 0;
     }
@@ -674,12 +707,14 @@ _caps_response_handler_legacy(xmpp_conn_t *const conn, xmpp_stanza_t * const sta
         char *error_message = stanza_get_error_message(stanza);
         log_warning("Error received for capabilities response from %s: ", from, error_message);
         free(error_message);
+        capsqueue_failed(expected_node, id, g_get_monotonic_time());
         free(expected_node);
         return 0;
     }
 
     if (query == NULL) {
         log_warning("No query element found.");
+        capsqueue_failed(expected_node, id, g_get_monotonic_time());
         free(expected_node);
         return 0;
     }
@@ -687,6 +722,7 @@ _caps_response_handler_legacy(xmpp_conn_t *const conn, xmpp_stanza_t * const sta
     char *node = xmpp_stanza_get_attribute(query, STANZA_ATTR_NODE);
     if (node == NULL) {
         log_warning("No node attribute found");
+        capsqueue_failed(expected_node, id, g_get_monotonic_time());
         free(expected_node);
         return 0;
     }
@@ -704,16 +740,30 @@ _caps_response_handler_legacy(xmpp_conn_t *const conn, xmpp_stanza_t * const sta
         }
 
         caps_map_jid_to_ver(from, node);
+        _caps_map_waiters(node);
 
     // node match fail
     } else {
         log_info("Legacy Capabilities nodes do not match, expeceted %s, given %s.", expected_node, node);
+        capsqueue_failed(expected_node, id, g_get_monotonic_time());
     }
 
     free(expected_node);
     return 0;
 }
 
+static void
+_caps_map_waiters(const char * const ver)
+{
+    GSList *waiters = capsqueue_complete(ver, g_get_monotonic_time());
+    GSList *curr = waiters;
+    while (curr != NULL) {
+        caps_map_jid_to_ver(curr->data, ver);
+        curr = g_slist_next(curr);
+    }
+    g_slist_free_full(waiters, free);
+}
+
 static int
 _manual_pong_handler(xmpp_conn_t *const conn, xmpp_stanza_t * const stanza,
     void * const userdata)
@@ -757,7 +807,7 @@ _ping_timed_handler(xmpp_conn_t * const conn, void * const userdata)
         // add pong handler
         xmpp_id_handler_add(conn, _pong_handler, id, ctx);
 
-        xmpp_send(conn, iq);
+        connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
         xmpp_stanza_release(iq);
     }
 
@@ -852,7 +902,7 @@ _ping_get_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
         xmpp_stanza_set_attribute(pong, STANZA_ATTR_ID, id);
     }
 
-    xmpp_send(conn, pong);
+    connection_send_stanza(pong, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(pong);
 
     return 1;
@@ -912,7 +962,7 @@ _version_get_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
         xmpp_stanza_add_child(query, version);
         xmpp_stanza_add_child(response, query);
 
-        xmpp_send(conn, response);
+        connection_send_stanza(response, SEND_PRIORITY_IQ, NULL);
 
         g_string_free(version_str, TRUE);
         xmpp_stanza_release(name_txt);
@@ -950,7 +1000,7 @@ _disco_items_get_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
         xmpp_stanza_set_name(query, STANZA_NAME_QUERY);
         xmpp_stanza_set_ns(query, XMPP_NS_DISCO_ITEMS);
         xmpp_stanza_add_child(response, query);
-        xmpp_send(conn, response);
+        connection_send_stanza(response, SEND_PRIORITY_IQ, NULL);
 
         xmpp_stanza_release(response);
     }
@@ -988,7 +1038,7 @@ _disco_info_get_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
             xmpp_stanza_set_attribute(query, STANZA_ATTR_NODE, node_str);
         }
         xmpp_stanza_add_child(response, query);
-        xmpp_send(conn, response);
+        connection_send_stanza(response, SEND_PRIORITY_IQ, NULL);
 
         xmpp_stanza_release(query);
         xmpp_stanza_release(response);
@@ -1433,4 +1483,45 @@ _disco_items_result_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stan
     g_slist_free_full(items, (GDestroyNotify)_item_destroy);
 
     return 1;
-}
\ No newline at end of file
+}
+
+static int
+_mam_fin_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
+    void * const userdata)
+{
+    const char *type = xmpp_stanza_get_type(stanza);
+    char *archive = (char *)userdata;
+
+    if (g_strcmp0(type, STANZA_TYPE_ERROR) == 0) {
+        char *error_message = stanza_get_error_message(stanza);
+        log_info("Archive query for %s failed: %s", archive, error_message);
+        free(error_message);
+        mam_page_failed(archive);
+        free(archive);
+        return 0;
+    }
+
+    gboolean complete = TRUE;
+    char *last = NULL;
+    xmpp_stanza_t *fin = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_MAM);
+    if (fin) {
+        complete = g_strcmp0(xmpp_stanza_get_attribute(fin, STANZA_ATTR_COMPLETE), "true") == 0;
+        xmpp_stanza_t *set = xmpp_stanza_get_child_by_ns(fin, STANZA_NS_RSM);
+        if (set) {
+            xmpp_stanza_t *last_st = xmpp_stanza_get_child_by_name(set, STANZA_NAME_LAST);
+            if (last_st) {
+                last = xmpp_stanza_get_text(last_st);
+            }
+        }
+    }
+
+    log_debug("Archive page received for %s, complete: %s", archive, complete ? "true" : "false");
+    mam_page_complete(archive, last, complete);
+
+    if (last) {
+        xmpp_free(connection_get_ctx(), last);
+    }
+    free(archive);
+
+    return 0;
+}
@@ -0,0 +1,526 @@
+/*
+ * mam.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "common.h"
+#include "xmpp/mam.h"
+
+/*
+ * Message archive (XEP-0313) catch up. Each archive, the account's own or a
+ * room's, remembers the id of the last archived message we have, and on
+ * connect the archive is paged forward from there using result set
+ * management (XEP-0059). Each page is handed over as one batch, sorted by
+ * timestamp, so it can be shown and logged in one go.
+ * A catch up cut short by the page limit or a failed page leaves the archive
+ * truncated, live ids are then ignored so the next catch up resumes from the
+ * last page fetched rather than skipping the rest.
+ * Messages we already showed that the position could not move past, our own
+ * sent messages and live ones received while catching up or truncated, are
+ * remembered by id and left out when the catch up fetches them.
+ */
+typedef struct id_set_t {
+    GHashTable *ids;
+    GQueue *order;
+} IdSet;
+
+typedef struct archive_t {
+    char *last;
+    // archive ids of live messages shown while the position was held
+    IdSet *shown;
+    // message ids of messages we sent
+    IdSet *sent;
+    char *page_last;
+    gboolean truncated;
+    gboolean querying;
+    gboolean priming;
+    int pages;
+    int count;
+    GList *results;
+} Archive;
+
+static GHashTable *archives = NULL;
+static mam_query_func query = NULL;
+static mam_deliver_func deliver = NULL;
+static char *positions_file = NULL;
+static gboolean dirty = FALSE;
+
+static Archive* _get_archive(const char * const archive);
+static void _free_archive(Archive *archive);
+static void _free_message(ArchivedMessage *message);
+static void _clear_results(Archive *archive);
+static gint _cmp_timestamp(ArchivedMessage *a, ArchivedMessage *b);
+static IdSet* _id_set_new(void);
+static void _id_set_free(IdSet *set);
+static void _id_set_add(IdSet *set, const char * const id);
+static gboolean _id_set_contains(IdSet *set, const char * const id);
+static void _id_set_load(IdSet *set, GKeyFile *keyfile, const char * const group, const char * const key);
+static void _id_set_save(IdSet *set, GKeyFile *keyfile, const char * const group, const char * const key);
+
+void
+mam_init(mam_query_func query_func, mam_deliver_func deliver_func)
+{
+    mam_close();
+    query = query_func;
+    deliver = deliver_func;
+    archives = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_free_archive);
+}
+
+void
+mam_close(void)
+{
+    if (archives) {
+        mam_save();
+        g_hash_table_destroy(archives);
+        archives = NULL;
+    }
+    free(positions_file);
+    positions_file = NULL;
+    dirty = FALSE;
+}
+
+/*
+ * Replace the remembered positions with those in filename, which is also
+ * where mam_save writes to. Any catch up in progress is dropped.
+ */
+void
+mam_load(const char * const filename)
+{
+    if (archives) {
+        mam_save();
+        g_hash_table_remove_all(archives);
+    } else {
+        archives = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_free_archive);
+    }
+    free(positions_file);
+    positions_file = NULL;
+    dirty = FALSE;
+
+    if (filename == NULL) {
+        return;
+    }
+    positions_file = strdup(filename);
+
+    GKeyFile *keyfile = g_key_file_new();
+    if (!g_key_file_load_from_file(keyfile, filename, G_KEY_FILE_NONE, NULL)) {
+        g_key_file_free(keyfile);
+        return;
+    }
+
+    gsize num_archives = 0;
+    gchar **groups = g_key_file_get_groups(keyfile, &num_archives);
+    gsize i;
+    for (i = 0; i < num_archives; i++) {
+        gchar *last = g_key_file_get_string(keyfile, groups[i], "last", NULL);
+        if (last) {
+            Archive *archive = _get_archive(groups[i]);
+            archive->last = strdup(last);
+            archive->truncated = g_key_file_get_boolean(keyfile, groups[i], "truncated", NULL);
+            _id_set_load(archive->shown, keyfile, groups[i], "shown");
+            _id_set_load(archive->sent, keyfile, groups[i], "sent");
+            g_free(last);
+        }
+    }
+    g_strfreev(groups);
+    g_key_file_free(keyfile);
+}
+
+void
+mam_save(void)
+{
+    if (archives == NULL || positions_file == NULL || !dirty) {
+        return;
+    }
+
+    GKeyFile *keyfile = g_key_file_new();
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, archives);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        Archive *archive = value;
+        if (archive->last) {
+            g_key_file_set_string(keyfile, key, "last", archive->last);
+            if (archive->truncated) {
+                g_key_file_set_boolean(keyfile, key, "truncated", TRUE);
+            }
+            _id_set_save(archive->shown, keyfile, key, "shown");
+            _id_set_save(archive->sent, keyfile, key, "sent");
+        }
+    }
+
+    gsize length = 0;
+    gchar *data = g_key_file_to_data(keyfile, &length, NULL);
+    if (g_file_set_contents(positions_file, data, length, NULL)) {
+        g_chmod(positions_file, S_IRUSR | S_IWUSR);
+        dirty = FALSE;
+    }
+    g_free(data);
+    g_key_file_free(keyfile);
+}
+
+/*
+ * Start paging forward from the last message we have. An archive we have no
+ * position for only has its newest id fetched, older messages are left to
+ * the local logs.
+ */
+void
+mam_catch_up(const char * const archive)
+{
+    if (archives == NULL || query == NULL || archive == NULL) {
+        return;
+    }
+
+    Archive *curr = _get_archive(archive);
+    if (curr->querying) {
+        return;
+    }
+
+    curr->querying = TRUE;
+    curr->pages = 0;
+    curr->count = 0;
+    if (curr->last) {
+        curr->priming = FALSE;
+        query(archive, curr->last, MAM_PAGE_SIZE);
+    } else {
+        curr->priming = TRUE;
+        query(archive, NULL, 1);
+    }
+}
+
+gboolean
+mam_catching_up(const char * const archive)
+{
+    if (archives == NULL || archive == NULL) {
+        return FALSE;
+    }
+
+    Archive *curr = g_hash_table_lookup(archives, archive);
+    return curr && curr->querying;
+}
+
+const char *
+mam_last_id(const char * const archive)
+{
+    if (archives == NULL || archive == NULL) {
+        return NULL;
+    }
+
+    Archive *curr = g_hash_table_lookup(archives, archive);
+    return curr ? curr->last : NULL;
+}
+
+/*
+ * A live message carried its archive id, so there is no need to fetch it
+ * later. When the position cannot move the id is remembered instead.
+ */
+void
+mam_seen(const char * const archive, const char * const id)
+{
+    if (archives == NULL || archive == NULL || id == NULL) {
+        return;
+    }
+
+    Archive *curr = _get_archive(archive);
+    if (curr->querying || curr->truncated) {
+        _id_set_add(curr->shown, id);
+        dirty = TRUE;
+        return;
+    }
+
+    free(curr->last);
+    curr->last = strdup(id);
+    dirty = TRUE;
+}
+
+// we sent a message with this id, it is already in the window and the log
+void
+mam_sent(const char * const archive, const char * const message_id)
+{
+    if (archives == NULL || archive == NULL || message_id == NULL) {
+        return;
+    }
+
+    Archive *curr = _get_archive(archive);
+    _id_set_add(curr->sent, message_id);
+    dirty = TRUE;
+}
+
+void
+mam_result(const char * const archive, const char * const id, const char * const message_id,
+    const char * const from, const char * const body, GTimeVal *tv_stamp, gboolean outgoing)
+{
+    if (archives == NULL || archive == NULL || id == NULL || from == NULL || body == NULL) {
+        return;
+    }
+
+    Archive *curr = g_hash_table_lookup(archives, archive);
+    if (curr == NULL || !curr->querying || curr->count >= MAM_PAGE_SIZE) {
+        return;
+    }
+
+    free(curr->page_last);
+    curr->page_last = strdup(id);
+    curr->count++;
+
+    if (_id_set_contains(curr->shown, id) || _id_set_contains(curr->sent, message_id)) {
+        return;
+    }
+
+    ArchivedMessage *message = malloc(sizeof(ArchivedMessage));
+    message->id = strdup(id);
+    message->from = strdup(from);
+    message->body = strdup(body);
+    if (tv_stamp) {
+        message->timestamp = *tv_stamp;
+    } else {
+        g_get_current_time(&message->timestamp);
+    }
+    message->outgoing = outgoing;
+
+    curr->results = g_list_prepend(curr->results, message);
+}
+
+void
+mam_page_complete(const char * const archive, const char * const last, gboolean complete)
+{
+    if (archives == NULL || archive == NULL) {
+        return;
+    }
+
+    Archive *curr = g_hash_table_lookup(archives, archive);
+    if (curr == NULL || !curr->querying) {
+        return;
+    }
+
+    char *page_last = NULL;
+    if (last) {
+        page_last = strdup(last);
+    } else if (curr->page_last) {
+        page_last = strdup(curr->page_last);
+    }
+
+    if (!curr->priming && curr->results && deliver) {
+        curr->results = g_list_reverse(curr->results);
+        curr->results = g_list_sort(curr->results, (GCompareFunc)_cmp_timestamp);
+        deliver(archive, curr->results);
+    }
+    _clear_results(curr);
+
+    if (page_last) {
+        free(curr->last);
+        curr->last = page_last;
+        dirty = TRUE;
+    }
+
+    curr->pages++;
+    if (!complete && !curr->priming && page_last && curr->pages < MAM_MAX_PAGES) {
+        query(archive, curr->last, MAM_PAGE_SIZE);
+    } else {
+        // stopped at the page limit, the rest is left for the next catch up
+        gboolean truncated = !complete && !curr->priming && page_last != NULL;
+        if (curr->truncated != truncated) {
+            curr->truncated = truncated;
+            dirty = TRUE;
+        }
+        curr->querying = FALSE;
+        curr->priming = FALSE;
+    }
+}
+
+void
+mam_page_failed(const char * const archive)
+{
+    if (archives == NULL || archive == NULL) {
+        return;
+    }
+
+    Archive *curr = g_hash_table_lookup(archives, archive);
+    if (curr == NULL) {
+        return;
+    }
+
+    _clear_results(curr);
+    if (curr->querying && !curr->priming && curr->last && !curr->truncated) {
+        curr->truncated = TRUE;
+        dirty = TRUE;
+    }
+    curr->querying = FALSE;
+    curr->priming = FALSE;
+}
+
+static Archive*
+_get_archive(const char * const archive)
+{
+    Archive *curr = g_hash_table_lookup(archives, archive);
+    if (curr == NULL) {
+        curr = malloc(sizeof(Archive));
+        curr->last = NULL;
+        curr->shown = _id_set_new();
+        curr->sent = _id_set_new();
+        curr->page_last = NULL;
+        curr->truncated = FALSE;
+        curr->querying = FALSE;
+        curr->priming = FALSE;
+        curr->pages = 0;
+        curr->count = 0;
+        curr->results = NULL;
+        g_hash_table_insert(archives, strdup(archive), curr);
+    }
+
+    return curr;
+}
+
+static void
+_clear_results(Archive *archive)
+{
+    g_list_free_full(archive->results, (GDestroyNotify)_free_message);
+    archive->results = NULL;
+    archive->count = 0;
+    free(archive->page_last);
+    archive->page_last = NULL;
+}
+
+static void
+_free_archive(Archive *archive)
+{
+    if (archive) {
+        _clear_results(archive);
+        free(archive->last);
+        _id_set_free(archive->shown);
+        _id_set_free(archive->sent);
+        free(archive);
+    }
+}
+
+static void
+_free_message(ArchivedMessage *message)
+{
+    if (message) {
+        free(message->id);
+        free(message->from);
+        free(message->body);
+        free(message);
+    }
+}
+
+static gint
+_cmp_timestamp(ArchivedMessage *a, ArchivedMessage *b)
+{
+    if (a->timestamp.tv_sec != b->timestamp.tv_sec) {
+        return a->timestamp.tv_sec < b->timestamp.tv_sec ? -1 : 1;
+    }
+    if (a->timestamp.tv_usec != b->timestamp.tv_usec) {
+        return a->timestamp.tv_usec < b->timestamp.tv_usec ? -1 : 1;
+    }
+    return 0;
+}
+
+static IdSet*
+_id_set_new(void)
+{
+    IdSet *set = malloc(sizeof(IdSet));
+    set->ids = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    set->order = g_queue_new();
+
+    return set;
+}
+
+static void
+_id_set_free(IdSet *set)
+{
+    if (set) {
+        g_queue_free(set->order);
+        g_hash_table_destroy(set->ids);
+        free(set);
+    }
+}
+
+// the oldest ids make way once there are MAM_MAX_REMEMBERED
+static void
+_id_set_add(IdSet *set, const char * const id)
+{
+    if (g_hash_table_lookup_extended(set->ids, id, NULL, NULL)) {
+        return;
+    }
+
+    if (g_queue_get_length(set->order) >= MAM_MAX_REMEMBERED) {
+        char *oldest = g_queue_pop_head(set->order);
+        g_hash_table_remove(set->ids, oldest);
+    }
+
+    char *copy = strdup(id);
+    g_hash_table_insert(set->ids, copy, NULL);
+    g_queue_push_tail(set->order, copy);
+}
+
+static gboolean
+_id_set_contains(IdSet *set, const char * const id)
+{
+    return id && g_hash_table_lookup_extended(set->ids, id, NULL, NULL);
+}
+
+static void
+_id_set_load(IdSet *set, GKeyFile *keyfile, const char * const group, const char * const key)
+{
+    gsize num_ids = 0;
+    gchar **ids = g_key_file_get_string_list(keyfile, group, key, &num_ids, NULL);
+    gsize i;
+    for (i = 0; i < num_ids; i++) {
+        _id_set_add(set, ids[i]);
+    }
+    g_strfreev(ids);
+}
+
+static void
+_id_set_save(IdSet *set, GKeyFile *keyfile, const char * const group, const char * const key)
+{
+    gsize num_ids = g_queue_get_length(set->order);
+    if (num_ids == 0) {
+        return;
+    }
+
+    const gchar **ids = malloc(sizeof(gchar *) * num_ids);
+    gsize i = 0;
+    GList *curr = g_queue_peek_head_link(set->order);
+    while (curr != NULL) {
+        ids[i++] = curr->data;
+        curr = g_list_next(curr);
+    }
+    g_key_file_set_string_list(keyfile, group, key, ids, num_ids);
+    free(ids);
+}
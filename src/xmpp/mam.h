@@ -0,0 +1,76 @@
+/*
+ * mam.h
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef XMPP_MAM_H
+#define XMPP_MAM_H
+
+#include <glib.h>
+
+// results asked for in each archive query
+#define MAM_PAGE_SIZE 50
+
+// pages fetched per catch up, the rest follows on the next connect
+#define MAM_MAX_PAGES 20
+
+// shown and sent message ids kept per archive to leave out of a catch up
+#define MAM_MAX_REMEMBERED 500
+
+typedef struct archived_message_t {
+    char *id;
+    char *from;
+    char *body;
+    GTimeVal timestamp;
+    gboolean outgoing;
+} ArchivedMessage;
+
+typedef void (*mam_query_func)(const char * const archive, const char * const after, int max);
+typedef void (*mam_deliver_func)(const char * const archive, GList *messages);
+
+void mam_init(mam_query_func query_func, mam_deliver_func deliver_func);
+void mam_close(void);
+void mam_load(const char * const filename);
+void mam_save(void);
+
+void mam_catch_up(const char * const archive);
+gboolean mam_catching_up(const char * const archive);
+const char * mam_last_id(const char * const archive);
+void mam_seen(const char * const archive, const char * const id);
+void mam_sent(const char * const archive, const char * const message_id);
+
+void mam_result(const char * const archive, const char * const id, const char * const message_id,
+    const char * const from, const char * const body, GTimeVal *tv_stamp, gboolean outgoing);
+void mam_page_complete(const char * const archive, const char * const last, gboolean complete);
+void mam_page_failed(const char * const archive);
+
+#endif
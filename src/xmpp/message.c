@@ -37,6 +37,7 @@
 
 #include <strophe.h>
 
+#include "chat_message.h"
 #include "chat_session.h"
 #include "config/preferences.h"
 #include "log.h"
@@ -44,13 +45,14 @@
 #include "profanity.h"
 #include "server_events.h"
 #include "xmpp/connection.h"
+#include "xmpp/mam.h"
 #include "xmpp/message.h"
 #include "xmpp/roster.h"
 #include "roster_list.h"
 #include "xmpp/stanza.h"
 #include "xmpp/xmpp.h"
 
-#define HANDLE(ns, type, func) xmpp_handler_add(conn, func, ns, STANZA_NAME_MESSAGE, type, ctx)
+#define HANDLE(ns, type, func) xmpp_handler_add(conn, func, ns, STANZA_NAME_MESSAGE, type, jc)
 
 static int _groupchat_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata);
@@ -64,12 +66,16 @@ static int _captcha_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata);
 static int _message_error_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata);
+static int _mam_handler(xmpp_conn_t * const conn,
+    xmpp_stanza_t * const stanza, void * const userdata);
+static void _send_chat_state(const char * const jid, const char * const state);
+static gboolean _from_queried_archive(xmpp_stanza_t * const stanza);
 
 void
 message_add_handlers(void)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
-    xmpp_ctx_t * const ctx = connection_get_ctx();
+    JabberConn *jc = connection_get();
+    xmpp_conn_t * const conn = jc->conn;
 
     HANDLE(NULL,                 STANZA_TYPE_ERROR,      _message_error_handler);
     HANDLE(NULL,                 STANZA_TYPE_GROUPCHAT,  _groupchat_handler);
@@ -77,13 +83,13 @@ message_add_handlers(void)
     HANDLE(STANZA_NS_MUC_USER,   NULL,                   _muc_user_handler);
     HANDLE(STANZA_NS_CONFERENCE, NULL,                   _conference_handler);
     HANDLE(STANZA_NS_CAPTCHA,    NULL,                   _captcha_handler);
+    HANDLE(STANZA_NS_MAM,        NULL,                   _mam_handler);
 }
 
 void
 message_send_chat(const char * const barejid, const char * const msg)
 {
     xmpp_stanza_t *message;
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
 
     ChatSession *session = chat_session_get(barejid);
@@ -103,40 +109,44 @@ message_send_chat(const char * const barejid, const char * const msg)
         message = stanza_create_message(ctx, barejid, STANZA_TYPE_CHAT, msg, state);
     }
 
-    xmpp_send(conn, message);
+    // the message carries its own chat state, drop any still queued
+    connection_send_stanza(message, SEND_PRIORITY_MESSAGE, barejid);
+
+    // shown and logged already, leave it out when catching up from the archive
+    Jid *self = jabber_get_jid();
+    if (self) {
+        mam_sent(self->barejid, xmpp_stanza_get_id(message));
+    }
     xmpp_stanza_release(message);
 }
 
 void
 message_send_private(const char * const fulljid, const char * const msg)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *message = stanza_create_message(ctx, fulljid, STANZA_TYPE_CHAT, msg, NULL);
 
-    xmpp_send(conn, message);
+    connection_send_stanza(message, SEND_PRIORITY_MESSAGE, NULL);
     xmpp_stanza_release(message);
 }
 
 void
 message_send_groupchat(const char * const roomjid, const char * const msg)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *message = stanza_create_message(ctx, roomjid, STANZA_TYPE_GROUPCHAT, msg, NULL);
 
-    xmpp_send(conn, message);
+    connection_send_stanza(message, SEND_PRIORITY_MESSAGE, NULL);
     xmpp_stanza_release(message);
 }
 
 void
 message_send_groupchat_subject(const char * const roomjid, const char * const subject)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *message = stanza_create_room_subject_message(ctx, roomjid, subject);
 
-    xmpp_send(conn, message);
+    connection_send_stanza(message, SEND_PRIORITY_MESSAGE, NULL);
     xmpp_stanza_release(message);
 }
 
@@ -144,54 +154,54 @@ void
 message_send_invite(const char * const roomjid, const char * const contact,
     const char * const reason)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *stanza = stanza_create_invite(ctx, roomjid, contact, reason);
 
-    xmpp_send(conn, stanza);
+    connection_send_stanza(stanza, SEND_PRIORITY_MESSAGE, NULL);
     xmpp_stanza_release(stanza);
 }
 
 void
 message_send_composing(const char * const jid)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
-    xmpp_ctx_t * const ctx = connection_get_ctx();
-
-    xmpp_stanza_t *stanza = stanza_create_chat_state(ctx, jid, STANZA_NAME_COMPOSING);
-    xmpp_send(conn, stanza);
-    xmpp_stanza_release(stanza);
-
+    _send_chat_state(jid, STANZA_NAME_COMPOSING);
 }
 
 void
 message_send_paused(const char * const jid)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
-    xmpp_ctx_t * const ctx = connection_get_ctx();
-    xmpp_stanza_t *stanza = stanza_create_chat_state(ctx, jid, STANZA_NAME_PAUSED);
-    xmpp_send(conn, stanza);
-    xmpp_stanza_release(stanza);
+    _send_chat_state(jid, STANZA_NAME_PAUSED);
 }
 
 void
 message_send_inactive(const char * const jid)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
-    xmpp_ctx_t * const ctx = connection_get_ctx();
-    xmpp_stanza_t *stanza = stanza_create_chat_state(ctx, jid, STANZA_NAME_INACTIVE);
-
-    xmpp_send(conn, stanza);
-    xmpp_stanza_release(stanza);
+    _send_chat_state(jid, STANZA_NAME_INACTIVE);
 }
 
 void
 message_send_gone(const char * const jid)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
+    _send_chat_state(jid, STANZA_NAME_GONE);
+}
+
+/*
+ * Chat states are keyed on the bare jid, so a newer state or a message
+ * to the contact replaces one not yet sent
+ */
+static void
+_send_chat_state(const char * const jid, const char * const state)
+{
     xmpp_ctx_t * const ctx = connection_get_ctx();
-    xmpp_stanza_t *stanza = stanza_create_chat_state(ctx, jid, STANZA_NAME_GONE);
-    xmpp_send(conn, stanza);
+    xmpp_stanza_t *stanza = stanza_create_chat_state(ctx, jid, state);
+
+    Jid *jidp = jid_intern(jid);
+    if (jidp) {
+        connection_send_stanza(stanza, SEND_PRIORITY_CHAT_STATE, jidp->barejid);
+    } else {
+        connection_send_stanza(stanza, SEND_PRIORITY_CHAT_STATE, jid);
+    }
+    jid_release(jidp);
     xmpp_stanza_release(stanza);
 }
 
@@ -199,6 +209,8 @@ static int
 _message_error_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
     void * const userdata)
 {
+    connection_use(userdata);
+
     char *id = xmpp_stanza_get_id(stanza);
     char *jid = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
     xmpp_stanza_t *error_stanza = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_ERROR);
@@ -241,6 +253,8 @@ static int
 _muc_user_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
     void * const userdata)
 {
+    connection_use(userdata);
+
     xmpp_ctx_t *ctx = connection_get_ctx();
     xmpp_stanza_t *xns_muc_user = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_MUC_USER);
     char *room = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
@@ -259,7 +273,7 @@ _muc_user_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
             return 1;
         }
 
-        Jid *jidp = jid_create(invitor_jid);
+        Jid *jidp = jid_intern(invitor_jid);
         if (jidp == NULL) {
             return 1;
         }
@@ -272,7 +286,7 @@ _muc_user_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
         }
 
         handle_room_invite(INVITE_MEDIATED, invitor, room, reason);
-        jid_destroy(jidp);
+        jid_release(jidp);
         if (reason != NULL) {
             xmpp_free(ctx, reason);
         }
@@ -285,6 +299,8 @@ static int
 _conference_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
     void * const userdata)
 {
+    connection_use(userdata);
+
     xmpp_stanza_t *xns_conference = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_CONFERENCE);
     char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
     char *room = NULL;
@@ -321,6 +337,8 @@ static int
 _captcha_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
     void * const userdata)
 {
+    connection_use(userdata);
+
     xmpp_ctx_t *ctx = connection_get_ctx();
     char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
 
@@ -346,10 +364,12 @@ static int
 _groupchat_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata)
 {
+    connection_use(userdata);
+
     xmpp_ctx_t *ctx = connection_get_ctx();
     char *message = NULL;
     char *room_jid = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
-    Jid *jid = jid_create(room_jid);
+    Jid *jid = jid_intern(room_jid);
 
     // handle room subject
     xmpp_stanza_t *subject = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_SUBJECT);
@@ -358,7 +378,7 @@ _groupchat_handler(xmpp_conn_t * const conn,
         handle_room_subject(jid->barejid, jid->resourcepart, message);
         xmpp_free(ctx, message);
 
-        jid_destroy(jid);
+        jid_release(jid);
         return 1;
     }
 
@@ -373,20 +393,20 @@ _groupchat_handler(xmpp_conn_t * const conn,
             }
         }
 
-        jid_destroy(jid);
+        jid_release(jid);
         return 1;
     }
 
     if (!jid_is_valid_room_form(jid)) {
         log_error("Invalid room JID: %s", jid->str);
-        jid_destroy(jid);
+        jid_release(jid);
         return 1;
     }
 
     // room not active in profanity
     if (!muc_active(jid->barejid)) {
         log_error("Message received for inactive chat room: %s", jid->str);
-        jid_destroy(jid);
+        jid_release(jid);
         return 1;
     }
 
@@ -399,16 +419,18 @@ _groupchat_handler(xmpp_conn_t * const conn,
     if (body != NULL) {
         message = xmpp_stanza_get_text(body);
         if (message != NULL) {
+            char *stanza_id = stanza_get_stanza_id(stanza, jid->barejid);
             if (delayed) {
-                handle_room_history(jid->barejid, jid->resourcepart, tv_stamp, message);
+                handle_room_history(jid->barejid, stanza_id, jid->resourcepart, tv_stamp, message);
             } else {
-                handle_room_message(jid->barejid, jid->resourcepart, message);
+                handle_room_message(jid->barejid, stanza_id, jid->resourcepart, message);
+                mam_seen(jid->barejid, stanza_id);
             }
             xmpp_free(ctx, message);
         }
     }
 
-    jid_destroy(jid);
+    jid_release(jid);
 
     return 1;
 }
@@ -417,6 +439,8 @@ static int
 _chat_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
     void * const userdata)
 {
+    connection_use(userdata);
+
     // ignore if type not chat or absent
     char *type = xmpp_stanza_get_type(stanza);
     if (!(g_strcmp0(type, "chat") == 0 || type == NULL)) {
@@ -431,10 +455,16 @@ _chat_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
         return 1;
     }
 
+    // archive results are handled by _mam_handler, only when they come from an archive
+    xmpp_stanza_t *mam = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_MAM);
+    if (mam && _from_queried_archive(stanza)) {
+        return 1;
+    }
+
     xmpp_ctx_t *ctx = connection_get_ctx();
     gchar *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
 
-    Jid *jid = jid_create(from);
+    Jid *jid = jid_intern(from);
 
     // private message from chat room use full jid (room/nick)
     if (muc_active(jid->barejid)) {
@@ -456,7 +486,7 @@ _chat_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
             }
         }
 
-        jid_destroy(jid);
+        jid_release(jid);
         return 1;
 
     // standard chat message, use jid without resource
@@ -470,11 +500,18 @@ _chat_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
         if (body != NULL) {
             char *message = xmpp_stanza_get_text(body);
             if (message != NULL) {
+                ChatMessage *chat_message = NULL;
                 if (delayed) {
-                    handle_delayed_message(jid->barejid, message, tv_stamp);
+                    chat_message = chat_message_new(jid->barejid, NULL, message, &tv_stamp);
+                    handle_delayed_message(chat_message);
                 } else {
-                    handle_incoming_message(jid->barejid, jid->resourcepart, message);
+                    chat_message = chat_message_new(jid->barejid, jid->resourcepart, message, NULL);
+                    handle_incoming_message(chat_message);
+
+                    Jid *self = jabber_get_jid();
+                    mam_seen(self->barejid, stanza_get_stanza_id(stanza, self->barejid));
                 }
+                chat_message_unref(chat_message);
                 xmpp_free(ctx, message);
             }
         }
@@ -500,7 +537,83 @@ _chat_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
             }
         }
 
-        jid_destroy(jid);
+        jid_release(jid);
+        return 1;
+    }
+}
+
+// our own archive sends results without a from or from our bare jid, a room archive from the room
+static gboolean
+_from_queried_archive(xmpp_stanza_t * const stanza)
+{
+    char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
+    if (from == NULL) {
+        return TRUE;
+    }
+
+    Jid *self = jabber_get_jid();
+    return g_strcmp0(from, self->barejid) == 0 || mam_catching_up(from);
+}
+
+// a message forwarded from an archive we are paging through
+static int
+_mam_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
+    void * const userdata)
+{
+    connection_use(userdata);
+
+    xmpp_stanza_t *result = xmpp_stanza_get_child_by_ns(stanza, STANZA_NS_MAM);
+    if (result == NULL || g_strcmp0(xmpp_stanza_get_name(result), STANZA_NAME_RESULT) != 0) {
+        return 1;
+    }
+
+    xmpp_stanza_t *forwarded = xmpp_stanza_get_child_by_ns(result, STANZA_NS_FORWARD);
+    if (forwarded == NULL) {
+        return 1;
+    }
+    xmpp_stanza_t *archived = xmpp_stanza_get_child_by_name(forwarded, STANZA_NAME_MESSAGE);
+    if (archived == NULL) {
+        return 1;
+    }
+    xmpp_stanza_t *body = xmpp_stanza_get_child_by_name(archived, STANZA_NAME_BODY);
+    if (body == NULL) {
         return 1;
     }
-}
\ No newline at end of file
+
+    // results for our own archive come from our bare jid or without a from
+    Jid *self = jabber_get_jid();
+    char *archive = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
+    if (archive == NULL) {
+        archive = self->barejid;
+    }
+
+    xmpp_ctx_t *ctx = connection_get_ctx();
+    char *id = xmpp_stanza_get_attribute(result, STANZA_ATTR_ID);
+    char *message_id = xmpp_stanza_get_id(archived);
+    char *message = xmpp_stanza_get_text(body);
+    GTimeVal tv_stamp;
+    gboolean stamped = stanza_get_delay(forwarded, &tv_stamp);
+
+    Jid *from = jid_intern(xmpp_stanza_get_attribute(archived, STANZA_ATTR_FROM));
+    if (from && message) {
+        // room archives are keyed by nick
+        if (g_strcmp0(archive, self->barejid) != 0) {
+            mam_result(archive, id, message_id, from->resourcepart, message, stamped ? &tv_stamp : NULL, FALSE);
+        } else if (g_strcmp0(from->barejid, self->barejid) == 0) {
+            Jid *to = jid_intern(xmpp_stanza_get_attribute(archived, STANZA_ATTR_TO));
+            if (to) {
+                mam_result(archive, id, message_id, to->barejid, message, stamped ? &tv_stamp : NULL, TRUE);
+                jid_release(to);
+            }
+        } else {
+            mam_result(archive, id, message_id, from->barejid, message, stamped ? &tv_stamp : NULL, FALSE);
+        }
+    }
+
+    jid_release(from);
+    if (message) {
+        xmpp_free(ctx, message);
+    }
+
+    return 1;
+}
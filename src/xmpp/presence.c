@@ -43,9 +43,11 @@
 #include "config/preferences.h"
 #include "log.h"
 #include "muc.h"
+#include "muc_history.h"
 #include "profanity.h"
 #include "server_events.h"
 #include "xmpp/capabilities.h"
+#include "xmpp/capsqueue.h"
 #include "xmpp/connection.h"
 #include "xmpp/stanza.h"
 #include "xmpp/xmpp.h"
@@ -53,7 +55,7 @@
 static Autocomplete sub_requests_ac;
 
 #define HANDLE(ns, type, func) xmpp_handler_add(conn, func, ns, \
-                                                STANZA_NAME_PRESENCE, type, ctx)
+                                                STANZA_NAME_PRESENCE, type, jc)
 
 static int _unavailable_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata);
@@ -71,7 +73,9 @@ static int _presence_error_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata);
 
 void _send_caps_request(char *node, char *caps_key, char *id, char *from);
-static void _send_room_presence(xmpp_conn_t *conn, xmpp_stanza_t *presence);
+static void _send_room_presence(xmpp_stanza_t *presence);
+static char * _send_caps_query(const char * const jid, const char * const node,
+    const char * const ver, gboolean legacy);
 
 void
 presence_sub_requests_init(void)
@@ -82,8 +86,8 @@ presence_sub_requests_init(void)
 void
 presence_add_handlers(void)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
-    xmpp_ctx_t * const ctx = connection_get_ctx();
+    JabberConn *jc = connection_get();
+    xmpp_conn_t * const conn = jc->conn;
 
     HANDLE(NULL,               STANZA_TYPE_ERROR,        _presence_error_handler);
     HANDLE(STANZA_NS_MUC_USER, NULL,                     _muc_user_handler);
@@ -92,6 +96,8 @@ presence_add_handlers(void)
     HANDLE(NULL,               STANZA_TYPE_SUBSCRIBED,   _subscribed_handler);
     HANDLE(NULL,               STANZA_TYPE_UNSUBSCRIBED, _unsubscribed_handler);
     HANDLE(NULL,               NULL,                     _available_handler);
+
+    capsqueue_init(_send_caps_query);
 }
 
 void
@@ -100,7 +106,6 @@ presence_subscription(const char * const jid, const jabber_subscr_t action)
     assert(jid != NULL);
 
     xmpp_ctx_t * const ctx = connection_get_ctx();
-    xmpp_conn_t * const conn = connection_get_conn();
     const char *type = NULL;
 
     Jid *jidp = jid_create(jid);
@@ -132,7 +137,7 @@ presence_subscription(const char * const jid, const jabber_subscr_t action)
     xmpp_stanza_set_name(presence, STANZA_NAME_PRESENCE);
     xmpp_stanza_set_type(presence, type);
     xmpp_stanza_set_attribute(presence, STANZA_ATTR_TO, jidp->barejid);
-    xmpp_send(conn, presence);
+    connection_send_stanza(presence, SEND_PRIORITY_PRESENCE, NULL);
     xmpp_stanza_release(presence);
 
     jid_destroy(jidp);
@@ -209,7 +214,6 @@ presence_update(const resource_presence_t presence_type, const char * const msg,
     }
 
     xmpp_ctx_t * const ctx = connection_get_ctx();
-    xmpp_conn_t * const conn = connection_get_conn();
     const int pri =
         accounts_get_priority_for_presence_type(jabber_get_account_name(),
                                                 presence_type);
@@ -226,8 +230,9 @@ presence_update(const resource_presence_t presence_type, const char * const msg,
     stanza_attach_priority(ctx, presence, pri);
     stanza_attach_last_activity(ctx, presence, idle);
     stanza_attach_caps(ctx, presence);
-    xmpp_send(conn, presence);
-    _send_room_presence(conn, presence);
+    // keyed so a newer broadcast presence replaces one not yet sent
+    connection_send_stanza(presence, SEND_PRIORITY_PRESENCE, STANZA_NAME_PRESENCE);
+    _send_room_presence(presence);
     xmpp_stanza_release(presence);
 
     // set last presence for account
@@ -240,7 +245,7 @@ presence_update(const resource_presence_t presence_type, const char * const msg,
 }
 
 static void
-_send_room_presence(xmpp_conn_t *conn, xmpp_stanza_t *presence)
+_send_room_presence(xmpp_stanza_t *presence)
 {
     GList *rooms_p = muc_rooms();
     GList *rooms = rooms_p;
@@ -252,9 +257,12 @@ _send_room_presence(xmpp_conn_t *conn, xmpp_stanza_t *presence)
         if (nick != NULL) {
             char *full_room_jid = create_fulljid(room, nick);
 
-            xmpp_stanza_set_attribute(presence, STANZA_ATTR_TO, full_room_jid);
+            // copied, the broadcast presence may still be waiting in the send queue
+            xmpp_stanza_t *room_presence = xmpp_stanza_copy(presence);
+            xmpp_stanza_set_attribute(room_presence, STANZA_ATTR_TO, full_room_jid);
             log_debug("Sending presence to room: %s", full_room_jid);
-            xmpp_send(conn, presence);
+            connection_send_stanza(room_presence, SEND_PRIORITY_PRESENCE, full_room_jid);
+            xmpp_stanza_release(room_presence);
             free(full_room_jid);
         }
 
@@ -273,7 +281,6 @@ presence_join_room(char *room, char *nick, char * passwd)
 
     log_debug("Sending room join presence to: %s", jid->fulljid);
     xmpp_ctx_t *ctx = connection_get_ctx();
-    xmpp_conn_t *conn = connection_get_conn();
     resource_presence_t presence_type =
         accounts_get_last_presence(jabber_get_account_name());
     const char *show = stanza_get_presence_string_from_type(presence_type);
@@ -281,13 +288,17 @@ presence_join_room(char *room, char *nick, char * passwd)
     int pri = accounts_get_priority_for_presence_type(jabber_get_account_name(),
         presence_type);
 
-    xmpp_stanza_t *presence = stanza_create_room_join_presence(ctx, jid->fulljid, passwd);
+    // only ask for messages since the last one seen in the room
+    GTimeVal since;
+    gboolean seen = muc_history_since(room, &since);
+    xmpp_stanza_t *presence = stanza_create_room_join_presence(ctx, jid->fulljid, passwd,
+        seen ? &since : NULL);
     stanza_attach_show(ctx, presence, show);
     stanza_attach_status(ctx, presence, status);
     stanza_attach_priority(ctx, presence, pri);
     stanza_attach_caps(ctx, presence);
 
-    xmpp_send(conn, presence);
+    connection_send_stanza(presence, SEND_PRIORITY_PRESENCE, NULL);
     xmpp_stanza_release(presence);
 
     jid_destroy(jid);
@@ -301,7 +312,6 @@ presence_change_room_nick(const char * const room, const char * const nick)
 
     log_debug("Sending room nickname change to: %s, nick: %s", room, nick);
     xmpp_ctx_t *ctx = connection_get_ctx();
-    xmpp_conn_t *conn = connection_get_conn();
     resource_presence_t presence_type =
         accounts_get_last_presence(jabber_get_account_name());
     const char *show = stanza_get_presence_string_from_type(presence_type);
@@ -317,7 +327,7 @@ presence_change_room_nick(const char * const room, const char * const nick)
     stanza_attach_priority(ctx, presence, pri);
     stanza_attach_caps(ctx, presence);
 
-    xmpp_send(conn, presence);
+    connection_send_stanza(presence, SEND_PRIORITY_PRESENCE, NULL);
     xmpp_stanza_release(presence);
 
     free(full_room_jid);
@@ -330,13 +340,12 @@ presence_leave_chat_room(const char * const room_jid)
 
     log_debug("Sending room leave presence to: %s", room_jid);
     xmpp_ctx_t *ctx = connection_get_ctx();
-    xmpp_conn_t *conn = connection_get_conn();
     char *nick = muc_nick(room_jid);
 
     if (nick != NULL) {
         xmpp_stanza_t *presence = stanza_create_room_leave_presence(ctx, room_jid,
             nick);
-        xmpp_send(conn, presence);
+        connection_send_stanza(presence, SEND_PRIORITY_PRESENCE, NULL);
         xmpp_stanza_release(presence);
     }
 }
@@ -345,6 +354,8 @@ static int
 _presence_error_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
     void * const userdata)
 {
+    connection_use(userdata);
+
     char *id = xmpp_stanza_get_id(stanza);
     char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
     xmpp_stanza_t *error_stanza = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_ERROR);
@@ -412,6 +423,8 @@ static int
 _unsubscribed_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata)
 {
+    connection_use(userdata);
+
     char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
     Jid *from_jid = jid_create(from);
     log_debug("Unsubscribed presence handler fired for %s", from);
@@ -428,6 +441,8 @@ static int
 _subscribed_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata)
 {
+    connection_use(userdata);
+
     char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
     Jid *from_jid = jid_create(from);
     log_debug("Subscribed presence handler fired for %s", from);
@@ -444,6 +459,8 @@ static int
 _subscribe_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata)
 {
+    connection_use(userdata);
+
     char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
     log_debug("Subscribe presence handler fired for %s", from);
 
@@ -464,15 +481,15 @@ static int
 _unavailable_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata)
 {
-    const char *jid = xmpp_conn_get_jid(conn);
+    connection_use(userdata);
+
     char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
     log_debug("Unavailable presence handler fired for %s", from);
 
-    Jid *my_jid = jid_create(jid);
-    Jid *from_jid = jid_create(from);
+    Jid *my_jid = jabber_get_jid();
+    Jid *from_jid = jid_intern(from);
     if (my_jid == NULL || from_jid == NULL) {
-        jid_destroy(my_jid);
-        jid_destroy(from_jid);
+        jid_release(from_jid);
         return 1;
     }
 
@@ -493,12 +510,25 @@ _unavailable_handler(xmpp_conn_t * const conn,
     }
 
     free(status_str);
-    jid_destroy(my_jid);
-    jid_destroy(from_jid);
+    jid_release(from_jid);
 
     return 1;
 }
 
+static char *
+_send_caps_query(const char * const jid, const char * const node,
+    const char * const ver, gboolean legacy)
+{
+    char *id = create_unique_id("caps");
+    if (legacy) {
+        iq_send_caps_request_legacy(jid, id, node, ver);
+    } else {
+        iq_send_caps_request(jid, id, node, ver);
+    }
+
+    return id;
+}
+
 static void
 _handle_caps(char *jid, XMPPCaps *caps)
 {
@@ -509,11 +539,10 @@ _handle_caps(char *jid, XMPPCaps *caps)
             if (caps_contains(caps->ver)) {
                 log_info("Capabilities cache hit: %s, for %s.", caps->ver, jid);
                 caps_map_jid_to_ver(jid, caps->ver);
-            } else {
+            } else if (capsqueue_request(caps->ver, jid, caps->node, caps->ver, FALSE, g_get_monotonic_time())) {
                 log_info("Capabilities cache miss: %s, for %s, sending service discovery request", caps->ver, jid);
-                char *id = create_unique_id("caps");
-                iq_send_caps_request(jid, id, caps->node, caps->ver);
-                free(id);
+            } else {
+                log_info("Capabilities request pending: %s, for %s, waiting for response", caps->ver, jid);
             }
         }
 
@@ -526,10 +555,16 @@ _handle_caps(char *jid, XMPPCaps *caps)
 
    // no hash, legacy caps, cache against node#ver
    } else if (caps->node && caps->ver) {
-        log_info("No hash specified: %s, legacy request made for %s#%s", jid, caps->node, caps->ver);
-        char *id = create_unique_id("caps");
-        iq_send_caps_request_legacy(jid, id, caps->node, caps->ver);
-        free(id);
+        char *key = g_strdup_printf("%s#%s", caps->node, caps->ver);
+        if (caps_contains(key)) {
+            log_info("Capabilities cache hit: %s, for %s.", key, jid);
+            caps_map_jid_to_ver(jid, key);
+        } else if (capsqueue_request(key, jid, caps->node, caps->ver, TRUE, g_get_monotonic_time())) {
+            log_info("No hash specified: %s, legacy request made for %s", jid, key);
+        } else {
+            log_info("Legacy capabilities request pending: %s, for %s, waiting for response", key, jid);
+        }
+        g_free(key);
     } else {
         log_info("No hash specified: %s, could not create ver string, not sending service disovery request.", jid);
     }
@@ -539,6 +574,8 @@ static int
 _available_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata)
 {
+    connection_use(userdata);
+
     // handler still fires if error
     if (g_strcmp0(xmpp_stanza_get_type(stanza), STANZA_TYPE_ERROR) == 0) {
         return 1;
@@ -580,8 +617,7 @@ _available_handler(xmpp_conn_t * const conn,
         log_debug("Presence available handler fired for: %s", jid);
     }
 
-    const char *my_jid_str = xmpp_conn_get_jid(conn);
-    Jid *my_jid = jid_create(my_jid_str);
+    Jid *my_jid = jabber_get_jid();
 
     XMPPCaps *caps = stanza_parse_caps(stanza);
     if ((g_strcmp0(my_jid->fulljid, xmpp_presence->jid->fulljid) != 0) && caps) {
@@ -599,7 +635,6 @@ _available_handler(xmpp_conn_t * const conn,
         handle_contact_online(xmpp_presence->jid->barejid, resource, xmpp_presence->last_activity);
     }
 
-    jid_destroy(my_jid);
     stanza_free_presence(xmpp_presence);
 
     return 1;
@@ -609,14 +644,13 @@ void
 _send_caps_request(char *node, char *caps_key, char *id, char *from)
 {
     xmpp_ctx_t *ctx = connection_get_ctx();
-    xmpp_conn_t *conn = connection_get_conn();
 
     if (node != NULL) {
         log_debug("Node string: %s.", node);
         if (!caps_contains(caps_key)) {
             log_debug("Capabilities not cached for '%s', sending discovery IQ.", from);
             xmpp_stanza_t *iq = stanza_create_disco_info_iq(ctx, id, from, node);
-            xmpp_send(conn, iq);
+            connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
             xmpp_stanza_release(iq);
         } else {
             log_debug("Capabilities already cached, for %s", caps_key);
@@ -629,6 +663,8 @@ _send_caps_request(char *node, char *caps_key, char *id, char *from)
 static int
 _muc_user_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza, void * const userdata)
 {
+    connection_use(userdata);
+
     char *type = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_TYPE);
     char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
 
@@ -638,8 +674,9 @@ _muc_user_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza, void *
     }
 
     // invalid from attribute
-    Jid *from_jid = jid_create(from);
+    Jid *from_jid = jid_intern(from);
     if (from_jid == NULL || from_jid->resourcepart == NULL) {
+        jid_release(from_jid);
         return 1;
     }
 
@@ -771,7 +808,7 @@ _muc_user_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza, void *
 
     free(show_str);
     free(status_str);
-    jid_destroy(from_jid);
+    jid_release(from_jid);
 
     return 1;
 }
\ No newline at end of file
@@ -50,7 +50,7 @@
 #include "xmpp/xmpp.h"
 
 #define HANDLE(type, func) xmpp_handler_add(conn, func, XMPP_NS_ROSTER, \
-STANZA_NAME_IQ, type, ctx)
+STANZA_NAME_IQ, type, jc)
 
 // callback data for group commands
 typedef struct _group_data {
@@ -78,8 +78,8 @@ GSList * _get_groups_from_item(xmpp_stanza_t *item);
 void
 roster_add_handlers(void)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
-    xmpp_ctx_t * const ctx = connection_get_ctx();
+    JabberConn *jc = connection_get();
+    xmpp_conn_t * const conn = jc->conn;
 
     HANDLE(STANZA_TYPE_SET,    _roster_set_handler);
     HANDLE(STANZA_TYPE_RESULT, _roster_result_handler);
@@ -88,41 +88,37 @@ roster_add_handlers(void)
 void
 roster_request(void)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *iq = stanza_create_roster_iq(ctx);
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
 void
 roster_send_add_new(const char * const barejid, const char * const name)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *iq = stanza_create_roster_set(ctx, NULL, barejid, name, NULL);
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
 void
 roster_send_remove(const char * const barejid)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *iq = stanza_create_roster_remove_set(ctx, barejid);
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
 void
 roster_send_name_change(const char * const barejid, const char * const new_name, GSList *groups)
 {
-    xmpp_conn_t * const conn = connection_get_conn();
     xmpp_ctx_t * const ctx = connection_get_ctx();
     xmpp_stanza_t *iq = stanza_create_roster_set(ctx, NULL, barejid, new_name,
         groups);
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
 }
 
@@ -152,7 +148,7 @@ roster_send_add_to_group(const char * const group, PContact contact)
     xmpp_id_handler_add(conn, _group_add_handler, unique_id, data);
     xmpp_stanza_t *iq = stanza_create_roster_set(ctx, unique_id, p_contact_barejid(contact),
         p_contact_name(contact), new_groups);
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
     free(unique_id);
 }
@@ -199,7 +195,7 @@ roster_send_remove_from_group(const char * const group, PContact contact)
     xmpp_id_handler_add(conn, _group_remove_handler, unique_id, data);
     xmpp_stanza_t *iq = stanza_create_roster_set(ctx, unique_id, p_contact_barejid(contact),
         p_contact_name(contact), new_groups);
-    xmpp_send(conn, iq);
+    connection_send_stanza(iq, SEND_PRIORITY_IQ, NULL);
     xmpp_stanza_release(iq);
     free(unique_id);
 }
@@ -222,6 +218,9 @@ static int
 _roster_set_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
     void * const userdata)
 {
+    JabberConn *jc = userdata;
+    connection_use(jc);
+
     xmpp_stanza_t *query =
         xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_QUERY);
     xmpp_stanza_t *item =
@@ -232,7 +231,7 @@ _roster_set_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
     }
 
     // if from attribute exists and it is not current users barejid, ignore push
-    Jid *my_jid = jid_create(jabber_get_fulljid());
+    Jid *my_jid = jid_create(xmpp_conn_get_jid(jc->conn));
     const char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
     if ((from != NULL) && (strcmp(from, my_jid->barejid) != 0)) {
         jid_destroy(my_jid);
@@ -291,6 +290,9 @@ static int
 _roster_result_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
     void * const userdata)
 {
+    JabberConn *jc = userdata;
+    connection_use(jc);
+
     const char *id = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_ID);
 
     // handle initial roster response
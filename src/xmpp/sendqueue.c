@@ -0,0 +1,189 @@
+/*
+ * sendqueue.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "common.h"
+#include "xmpp/sendqueue.h"
+
+typedef struct queued_stanza_t {
+    char *key;
+    void *stanza;
+} QueuedStanza;
+
+static GQueue *queues[SEND_PRIORITY_COUNT];
+static sendqueue_send_func send_stanza;
+static sendqueue_free_func free_stanza;
+
+static QueuedStanza* _find(send_priority_t priority, const char * const key);
+static void _remove_key(send_priority_t priority, const char * const key);
+static void _free_queued(QueuedStanza *queued);
+
+void
+sendqueue_init(sendqueue_send_func send_func, sendqueue_free_func free_func)
+{
+    sendqueue_close();
+    send_stanza = send_func;
+    free_stanza = free_func;
+
+    int i;
+    for (i = 0; i < SEND_PRIORITY_COUNT; i++) {
+        queues[i] = g_queue_new();
+    }
+}
+
+/*
+ * Drop anything still queued, the stanzas are released without being sent
+ */
+void
+sendqueue_close(void)
+{
+    int i;
+    for (i = 0; i < SEND_PRIORITY_COUNT; i++) {
+        if (queues[i] != NULL) {
+            g_queue_free_full(queues[i], (GDestroyNotify)_free_queued);
+            queues[i] = NULL;
+        }
+    }
+}
+
+/*
+ * Queue a stanza, taking ownership of it.
+ * Presences and chat states with a key replace one already queued for the same key,
+ * a message drops any chat state still queued for its key.
+ */
+void
+sendqueue_add(send_priority_t priority, const char * const key, void *stanza)
+{
+    if (queues[priority] == NULL) {
+        free_stanza(stanza);
+        return;
+    }
+
+    if (key && (priority == SEND_PRIORITY_PRESENCE || priority == SEND_PRIORITY_CHAT_STATE)) {
+        QueuedStanza *queued = _find(priority, key);
+        if (queued) {
+            free_stanza(queued->stanza);
+            queued->stanza = stanza;
+            return;
+        }
+    }
+
+    if (key && priority == SEND_PRIORITY_MESSAGE) {
+        _remove_key(SEND_PRIORITY_CHAT_STATE, key);
+    }
+
+    QueuedStanza *queued = malloc(sizeof(QueuedStanza));
+    queued->key = key ? strdup(key) : NULL;
+    queued->stanza = stanza;
+    g_queue_push_tail(queues[priority], queued);
+}
+
+/*
+ * Send everything queued in priority order, returns the number of stanzas sent
+ */
+int
+sendqueue_flush(void)
+{
+    int sent = 0;
+    int i;
+    for (i = 0; i < SEND_PRIORITY_COUNT; i++) {
+        if (queues[i] == NULL) {
+            continue;
+        }
+
+        QueuedStanza *queued = g_queue_pop_head(queues[i]);
+        while (queued) {
+            send_stanza(queued->stanza);
+            _free_queued(queued);
+            sent++;
+            queued = g_queue_pop_head(queues[i]);
+        }
+    }
+
+    return sent;
+}
+
+guint
+sendqueue_depth(void)
+{
+    guint depth = 0;
+    int i;
+    for (i = 0; i < SEND_PRIORITY_COUNT; i++) {
+        if (queues[i] != NULL) {
+            depth += g_queue_get_length(queues[i]);
+        }
+    }
+
+    return depth;
+}
+
+static QueuedStanza*
+_find(send_priority_t priority, const char * const key)
+{
+    GList *curr = queues[priority]->head;
+    while (curr) {
+        QueuedStanza *queued = curr->data;
+        if (g_strcmp0(queued->key, key) == 0) {
+            return queued;
+        }
+        curr = g_list_next(curr);
+    }
+
+    return NULL;
+}
+
+static void
+_remove_key(send_priority_t priority, const char * const key)
+{
+    QueuedStanza *queued = _find(priority, key);
+    while (queued) {
+        g_queue_remove(queues[priority], queued);
+        _free_queued(queued);
+        queued = _find(priority, key);
+    }
+}
+
+static void
+_free_queued(QueuedStanza *queued)
+{
+    if (queued) {
+        free(queued->key);
+        free_stanza(queued->stanza);
+        free(queued);
+    }
+}
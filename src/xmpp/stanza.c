@@ -198,6 +198,16 @@ stanza_create_bookmarks_pubsub_add(xmpp_ctx_t *ctx, const char * const jid,
 }
 #endif
 
+xmpp_stanza_t *
+stanza_create_csi(xmpp_ctx_t *ctx, gboolean active)
+{
+    xmpp_stanza_t *csi = xmpp_stanza_new(ctx);
+    xmpp_stanza_set_name(csi, active ? STANZA_NAME_ACTIVE : STANZA_NAME_INACTIVE);
+    xmpp_stanza_set_ns(csi, STANZA_NS_CSI);
+
+    return csi;
+}
+
 xmpp_stanza_t *
 stanza_create_chat_state(xmpp_ctx_t *ctx, const char * const fulljid, const char * const state)
 {
@@ -379,7 +389,7 @@ stanza_create_invite(xmpp_ctx_t *ctx, const char * const room,
 
 xmpp_stanza_t *
 stanza_create_room_join_presence(xmpp_ctx_t * const ctx,
-    const char * const full_room_jid, const char * const passwd)
+    const char * const full_room_jid, const char * const passwd, GTimeVal *history_since)
 {
     xmpp_stanza_t *presence = xmpp_stanza_new(ctx);
     xmpp_stanza_set_name(presence, STANZA_NAME_PRESENCE);
@@ -404,6 +414,17 @@ stanza_create_room_join_presence(xmpp_ctx_t * const ctx,
         xmpp_stanza_release(pass);
     }
 
+    // limit the discussion history sent on join
+    if (history_since != NULL) {
+        xmpp_stanza_t *history = xmpp_stanza_new(ctx);
+        xmpp_stanza_set_name(history, STANZA_NAME_HISTORY);
+        gchar *since = g_time_val_to_iso8601(history_since);
+        xmpp_stanza_set_attribute(history, STANZA_ATTR_SINCE, since);
+        g_free(since);
+        xmpp_stanza_add_child(x, history);
+        xmpp_stanza_release(history);
+    }
+
     xmpp_stanza_add_child(presence, x);
     xmpp_stanza_release(x);
 
@@ -578,6 +599,65 @@ stanza_create_room_affiliation_list_iq(xmpp_ctx_t *ctx, const char * const room,
     return iq;
 }
 
+/*
+ * Query an archive for the page after the given id, or for the newest page
+ * when after is NULL. A NULL archive queries the account's own.
+ */
+xmpp_stanza_t *
+stanza_create_mam_iq(xmpp_ctx_t *ctx, const char * const archive,
+    const char * const after, int max)
+{
+    xmpp_stanza_t *iq = xmpp_stanza_new(ctx);
+    xmpp_stanza_set_name(iq, STANZA_NAME_IQ);
+    xmpp_stanza_set_type(iq, STANZA_TYPE_SET);
+    if (archive != NULL) {
+        xmpp_stanza_set_attribute(iq, STANZA_ATTR_TO, archive);
+    }
+    char *id = create_unique_id("mam");
+    xmpp_stanza_set_id(iq, id);
+
+    xmpp_stanza_t *query = xmpp_stanza_new(ctx);
+    xmpp_stanza_set_name(query, STANZA_NAME_QUERY);
+    xmpp_stanza_set_ns(query, STANZA_NS_MAM);
+    xmpp_stanza_set_attribute(query, STANZA_ATTR_QUERYID, id);
+    free(id);
+
+    xmpp_stanza_t *set = xmpp_stanza_new(ctx);
+    xmpp_stanza_set_name(set, STANZA_NAME_SET);
+    xmpp_stanza_set_ns(set, STANZA_NS_RSM);
+
+    xmpp_stanza_t *max_st = xmpp_stanza_new(ctx);
+    xmpp_stanza_set_name(max_st, STANZA_NAME_MAX);
+    xmpp_stanza_t *max_text = xmpp_stanza_new(ctx);
+    char *max_str = g_strdup_printf("%d", max);
+    xmpp_stanza_set_text(max_text, max_str);
+    g_free(max_str);
+    xmpp_stanza_add_child(max_st, max_text);
+    xmpp_stanza_release(max_text);
+    xmpp_stanza_add_child(set, max_st);
+    xmpp_stanza_release(max_st);
+
+    xmpp_stanza_t *position = xmpp_stanza_new(ctx);
+    if (after != NULL) {
+        xmpp_stanza_set_name(position, STANZA_NAME_AFTER);
+        xmpp_stanza_t *after_text = xmpp_stanza_new(ctx);
+        xmpp_stanza_set_text(after_text, after);
+        xmpp_stanza_add_child(position, after_text);
+        xmpp_stanza_release(after_text);
+    } else {
+        xmpp_stanza_set_name(position, STANZA_NAME_BEFORE);
+    }
+    xmpp_stanza_add_child(set, position);
+    xmpp_stanza_release(position);
+
+    xmpp_stanza_add_child(query, set);
+    xmpp_stanza_release(set);
+    xmpp_stanza_add_child(iq, query);
+    xmpp_stanza_release(query);
+
+    return iq;
+}
+
 xmpp_stanza_t *
 stanza_create_room_role_list_iq(xmpp_ctx_t *ctx, const char * const room, const char * const role)
 {
@@ -907,6 +987,26 @@ stanza_get_delay(xmpp_stanza_t * const stanza, GTimeVal *tv_stamp)
     return FALSE;
 }
 
+// the id an archive gave a message (XEP-0359), NULL when not stamped by that archive
+char *
+stanza_get_stanza_id(xmpp_stanza_t * const stanza, const char * const by)
+{
+    xmpp_stanza_t *child = xmpp_stanza_get_children(stanza);
+    while (child != NULL) {
+        char *name = xmpp_stanza_get_name(child);
+        char *xmlns = xmpp_stanza_get_ns(child);
+        if ((g_strcmp0(name, STANZA_NAME_STANZA_ID) == 0) && (g_strcmp0(xmlns, STANZA_NS_STANZA_ID) == 0)) {
+            char *child_by = xmpp_stanza_get_attribute(child, STANZA_ATTR_BY);
+            if (g_strcmp0(child_by, by) == 0) {
+                return xmpp_stanza_get_attribute(child, STANZA_ATTR_ID);
+            }
+        }
+        child = xmpp_stanza_get_next(child);
+    }
+
+    return NULL;
+}
+
 char *
 stanza_get_status(xmpp_stanza_t *stanza, char *def)
 {
@@ -1572,7 +1672,7 @@ stanza_free_presence(XMPPPresence *presence)
 {
     if (presence) {
         if (presence->jid) {
-            jid_destroy(presence->jid);
+            jid_release(presence->jid);
         }
         if (presence->last_activity) {
             g_date_time_unref(presence->last_activity);
@@ -1596,7 +1696,7 @@ stanza_parse_presence(xmpp_stanza_t *stanza, int *err)
         return NULL;
     }
 
-    Jid *from_jid = jid_create(from);
+    Jid *from_jid = jid_intern(from);
     if (!from_jid) {
         *err = STANZA_PARSE_ERROR_INVALID_FROM;
         return NULL;
@@ -58,6 +58,7 @@
 #define STANZA_NAME_PING "ping"
 #define STANZA_NAME_TEXT "text"
 #define STANZA_NAME_SUBJECT "subject"
+#define STANZA_NAME_HISTORY "history"
 #define STANZA_NAME_ITEM "item"
 #define STANZA_NAME_ITEMS "items"
 #define STANZA_NAME_C "c"
@@ -77,6 +78,15 @@
 #define STANZA_NAME_VALUE "value"
 #define STANZA_NAME_DESTROY "destroy"
 #define STANZA_NAME_ACTOR "actor"
+#define STANZA_NAME_RESULT "result"
+#define STANZA_NAME_FORWARDED "forwarded"
+#define STANZA_NAME_FIN "fin"
+#define STANZA_NAME_SET "set"
+#define STANZA_NAME_MAX "max"
+#define STANZA_NAME_AFTER "after"
+#define STANZA_NAME_BEFORE "before"
+#define STANZA_NAME_LAST "last"
+#define STANZA_NAME_STANZA_ID "stanza-id"
 
 // error conditions
 #define STANZA_NAME_BAD_REQUEST "bad-request"
@@ -114,6 +124,7 @@
 #define STANZA_TYPE_RESULT "result"
 
 #define STANZA_ATTR_TO "to"
+#define STANZA_ATTR_SINCE "since"
 #define STANZA_ATTR_FROM "from"
 #define STANZA_ATTR_STAMP "stamp"
 #define STANZA_ATTR_TYPE "type"
@@ -133,6 +144,9 @@
 #define STANZA_ATTR_CATEGORY "category"
 #define STANZA_ATTR_REASON "reason"
 #define STANZA_ATTR_AUTOJOIN "autojoin"
+#define STANZA_ATTR_QUERYID "queryid"
+#define STANZA_ATTR_COMPLETE "complete"
+#define STANZA_ATTR_BY "by"
 
 #define STANZA_TEXT_AWAY "away"
 #define STANZA_TEXT_DND "dnd"
@@ -154,6 +168,11 @@
 #define STANZA_NS_CONFERENCE "jabber:x:conference"
 #define STANZA_NS_CAPTCHA "urn:xmpp:captcha"
 #define STANZA_NS_PUBSUB "http://jabber.org/protocol/pubsub"
+#define STANZA_NS_CSI "urn:xmpp:csi:0"
+#define STANZA_NS_MAM "urn:xmpp:mam:2"
+#define STANZA_NS_RSM "http://jabber.org/protocol/rsm"
+#define STANZA_NS_FORWARD "urn:xmpp:forward:0"
+#define STANZA_NS_STANZA_ID "urn:xmpp:sid:0"
 
 #define STANZA_DATAFORM_SOFTWARE "urn:xmpp:dataforms:softwareinfo"
 
@@ -178,6 +197,7 @@ typedef enum {
 
 xmpp_stanza_t* stanza_create_bookmarks_storage_request(xmpp_ctx_t *ctx);
 
+xmpp_stanza_t* stanza_create_csi(xmpp_ctx_t *ctx, gboolean active);
 xmpp_stanza_t* stanza_create_chat_state(xmpp_ctx_t *ctx,
     const char * const fulljid, const char * const state);
 
@@ -186,7 +206,7 @@ xmpp_stanza_t* stanza_create_message(xmpp_ctx_t *ctx,
     const char * const message, const char * const state);
 
 xmpp_stanza_t* stanza_create_room_join_presence(xmpp_ctx_t * const ctx,
-    const char * const full_room_jid, const char * const passwd);
+    const char * const full_room_jid, const char * const passwd, GTimeVal *history_since);
 
 xmpp_stanza_t* stanza_create_room_newnick_presence(xmpp_ctx_t *ctx,
     const char * const full_room_jid);
@@ -207,6 +227,7 @@ xmpp_stanza_t* stanza_create_invite(xmpp_ctx_t *ctx, const char * const room,
 gboolean stanza_contains_chat_state(xmpp_stanza_t *stanza);
 
 gboolean stanza_get_delay(xmpp_stanza_t * const stanza, GTimeVal *tv_stamp);
+char * stanza_get_stanza_id(xmpp_stanza_t * const stanza, const char * const by);
 
 gboolean stanza_is_muc_presence(xmpp_stanza_t * const stanza);
 gboolean stanza_is_muc_self_presence(xmpp_stanza_t * const stanza,
@@ -233,6 +254,9 @@ xmpp_stanza_t* stanza_create_room_role_set_iq(xmpp_ctx_t * const ctx, const char
     const char * const role, const char * const reason);
 xmpp_stanza_t* stanza_create_room_role_list_iq(xmpp_ctx_t *ctx, const char * const room, const char * const role);
 
+xmpp_stanza_t* stanza_create_mam_iq(xmpp_ctx_t *ctx, const char * const archive,
+    const char * const after, int max);
+
 xmpp_stanza_t* stanza_create_room_subject_message(xmpp_ctx_t *ctx, const char * const room, const char * const subject);
 xmpp_stanza_t* stanza_create_room_kick_iq(xmpp_ctx_t * const ctx, const char * const room, const char * const nick,
     const char * const reason);
@@ -0,0 +1,353 @@
+/*
+ * xmltrace.c
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "common.h"
+#include "xmpp/xmltrace.h"
+
+#define XMLTRACE_SENT "SENT: "
+#define XMLTRACE_RECV "RECV: "
+#define XMLTRACE_PREFIX_LEN 6
+#define XMLTRACE_INDENT 2
+
+gboolean xmltrace_active = FALSE;
+
+static GQueue *pending;
+static gsize pending_bytes;
+static guint dropped;
+
+static xmltrace_dir_t dir_filter = XMLTRACE_DIR_ALL;
+static char *element_filter;
+static char *ns_filter;
+
+static void _clear_pending(void);
+static gboolean _element_matches(const char * const raw, const char * const element);
+static gboolean _ns_matches(const char * const raw, const char * const ns);
+static const char * _find_tag_end(const char * const tag);
+
+void
+xmltrace_start(void)
+{
+    if (pending == NULL) {
+        pending = g_queue_new();
+    }
+    pending_bytes = 0;
+    dropped = 0;
+    xmltrace_active = TRUE;
+}
+
+void
+xmltrace_stop(void)
+{
+    xmltrace_active = FALSE;
+    if (pending != NULL) {
+        _clear_pending();
+        g_queue_free(pending);
+        pending = NULL;
+    }
+}
+
+void
+xmltrace_capture(const char * const msg)
+{
+    if (!xmltrace_active || msg == NULL) {
+        return;
+    }
+
+    xmltrace_dir_t dir;
+    if (strncmp(msg, XMLTRACE_SENT, XMLTRACE_PREFIX_LEN) == 0) {
+        dir = XMLTRACE_DIR_SENT;
+    } else if (strncmp(msg, XMLTRACE_RECV, XMLTRACE_PREFIX_LEN) == 0) {
+        dir = XMLTRACE_DIR_RECV;
+    } else {
+        return;
+    }
+
+    const char *raw = &msg[XMLTRACE_PREFIX_LEN];
+    gsize len = strlen(raw);
+    if (len > XMLTRACE_MAX_BYTES) {
+        dropped++;
+        return;
+    }
+
+    XMLTraceEntry *entry = malloc(sizeof(XMLTraceEntry));
+    entry->dir = dir;
+    entry->raw = g_strndup(raw, len);
+    g_queue_push_tail(pending, entry);
+    pending_bytes += len;
+
+    // oldest stanzas make way when the console is not being looked at
+    while (pending_bytes > XMLTRACE_MAX_BYTES) {
+        XMLTraceEntry *oldest = g_queue_pop_head(pending);
+        pending_bytes -= strlen(oldest->raw);
+        xmltrace_entry_free(oldest);
+        dropped++;
+    }
+}
+
+GSList *
+xmltrace_take(void)
+{
+    if (pending == NULL) {
+        return NULL;
+    }
+
+    GSList *result = NULL;
+    XMLTraceEntry *entry = NULL;
+    while ((entry = g_queue_pop_tail(pending)) != NULL) {
+        if (xmltrace_matches(entry)) {
+            result = g_slist_prepend(result, entry);
+        } else {
+            xmltrace_entry_free(entry);
+        }
+    }
+    pending_bytes = 0;
+
+    return result;
+}
+
+guint
+xmltrace_take_dropped(void)
+{
+    guint result = dropped;
+    dropped = 0;
+
+    return result;
+}
+
+void
+xmltrace_entry_free(XMLTraceEntry *entry)
+{
+    if (entry != NULL) {
+        g_free(entry->raw);
+        free(entry);
+    }
+}
+
+void
+xmltrace_set_dir_filter(xmltrace_dir_t dir)
+{
+    dir_filter = dir;
+}
+
+xmltrace_dir_t
+xmltrace_get_dir_filter(void)
+{
+    return dir_filter;
+}
+
+void
+xmltrace_set_element_filter(const char * const element)
+{
+    GFREE_SET_NULL(element_filter);
+    if (element != NULL) {
+        element_filter = g_strdup(element);
+    }
+}
+
+const char *
+xmltrace_get_element_filter(void)
+{
+    return element_filter;
+}
+
+void
+xmltrace_set_ns_filter(const char * const ns)
+{
+    GFREE_SET_NULL(ns_filter);
+    if (ns != NULL) {
+        ns_filter = g_strdup(ns);
+    }
+}
+
+const char *
+xmltrace_get_ns_filter(void)
+{
+    return ns_filter;
+}
+
+void
+xmltrace_clear_filters(void)
+{
+    dir_filter = XMLTRACE_DIR_ALL;
+    xmltrace_set_element_filter(NULL);
+    xmltrace_set_ns_filter(NULL);
+}
+
+gboolean
+xmltrace_matches(const XMLTraceEntry * const entry)
+{
+    if (dir_filter != XMLTRACE_DIR_ALL && entry->dir != dir_filter) {
+        return FALSE;
+    }
+    if (element_filter != NULL && !_element_matches(entry->raw, element_filter)) {
+        return FALSE;
+    }
+    if (ns_filter != NULL && !_ns_matches(entry->raw, ns_filter)) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+GSList *
+xmltrace_pretty(const char * const raw)
+{
+    GSList *lines = NULL;
+    int depth = 0;
+    const char *curr = raw;
+
+    while (*curr != '\0') {
+        while (*curr == ' ' || *curr == '\n' || *curr == '\r' || *curr == '\t') {
+            curr++;
+        }
+        if (*curr == '\0') {
+            break;
+        }
+
+        GString *line = g_string_new(NULL);
+
+        // text content
+        if (*curr != '<') {
+            const char *next = strchr(curr, '<');
+            if (next == NULL) {
+                next = curr + strlen(curr);
+            }
+            g_string_append_printf(line, "%*s", depth * XMLTRACE_INDENT, "");
+            g_string_append_len(line, curr, next - curr);
+            lines = g_slist_prepend(lines, g_string_free(line, FALSE));
+            curr = next;
+            continue;
+        }
+
+        const char *end = _find_tag_end(curr);
+        gboolean closing = curr[1] == '/';
+        gboolean self_closing = (end > curr + 1 && end[-1] == '/') || curr[1] == '?' || curr[1] == '!';
+
+        if (closing && depth > 0) {
+            depth--;
+        }
+        g_string_append_printf(line, "%*s", depth * XMLTRACE_INDENT, "");
+        g_string_append_len(line, curr, end - curr + 1);
+        curr = end + 1;
+
+        // keep short text only elements on one line, e.g. <body>hi</body>
+        if (!closing && !self_closing && *curr != '<' && *curr != '\0') {
+            const char *text_end = strchr(curr, '<');
+            if (text_end != NULL && text_end[1] == '/') {
+                const char *close_end = _find_tag_end(text_end);
+                g_string_append_len(line, curr, close_end - curr + 1);
+                curr = close_end + 1;
+                self_closing = TRUE;
+            }
+        }
+
+        if (!closing && !self_closing) {
+            depth++;
+        }
+        lines = g_slist_prepend(lines, g_string_free(line, FALSE));
+    }
+
+    return g_slist_reverse(lines);
+}
+
+static void
+_clear_pending(void)
+{
+    XMLTraceEntry *entry = NULL;
+    while ((entry = g_queue_pop_head(pending)) != NULL) {
+        xmltrace_entry_free(entry);
+    }
+    pending_bytes = 0;
+}
+
+static const char *
+_find_tag_end(const char * const tag)
+{
+    const char *end = strchr(tag, '>');
+    if (end == NULL) {
+        end = tag + strlen(tag) - 1;
+    }
+
+    return end;
+}
+
+static gboolean
+_element_matches(const char * const raw, const char * const element)
+{
+    const char *name = raw;
+    while (*name == ' ' || *name == '\n') {
+        name++;
+    }
+    if (*name != '<') {
+        return FALSE;
+    }
+    name++;
+
+    size_t len = strlen(element);
+    if (strncmp(name, element, len) != 0) {
+        return FALSE;
+    }
+
+    char after = name[len];
+    return (after == ' ' || after == '>' || after == '/' || after == '\0');
+}
+
+static gboolean
+_ns_matches(const char * const raw, const char * const ns)
+{
+    const char *search = raw;
+    while ((search = strstr(search, "xmlns")) != NULL) {
+        const char *value = strchr(search, '=');
+        if (value == NULL) {
+            return FALSE;
+        }
+        value++;
+        if (*value == '"' || *value == '\'') {
+            char quote = *value;
+            value++;
+            size_t len = strlen(ns);
+            if (strncmp(value, ns, len) == 0 && value[len] == quote) {
+                return TRUE;
+            }
+        }
+        search = value;
+    }
+
+    return FALSE;
+}
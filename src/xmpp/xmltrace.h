@@ -0,0 +1,75 @@
+/*
+ * xmltrace.h
+ *
+ * Copyright (C) 2012 - 2015 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef XMPP_XMLTRACE_H
+#define XMPP_XMLTRACE_H
+
+#include <glib.h>
+
+// upper bound on raw stanza bytes held while waiting to be displayed
+#define XMLTRACE_MAX_BYTES 524288
+
+typedef enum {
+    XMLTRACE_DIR_ALL,
+    XMLTRACE_DIR_SENT,
+    XMLTRACE_DIR_RECV
+} xmltrace_dir_t;
+
+typedef struct xml_trace_entry_t {
+    xmltrace_dir_t dir;
+    char *raw;
+} XMLTraceEntry;
+
+// set while the XML console is open, checked before capturing anything
+extern gboolean xmltrace_active;
+
+void xmltrace_start(void);
+void xmltrace_stop(void);
+void xmltrace_capture(const char * const msg);
+GSList * xmltrace_take(void);
+guint xmltrace_take_dropped(void);
+void xmltrace_entry_free(XMLTraceEntry *entry);
+
+void xmltrace_set_dir_filter(xmltrace_dir_t dir);
+xmltrace_dir_t xmltrace_get_dir_filter(void);
+void xmltrace_set_element_filter(const char * const element);
+const char * xmltrace_get_element_filter(void);
+void xmltrace_set_ns_filter(const char * const ns);
+const char * xmltrace_get_ns_filter(void);
+void xmltrace_clear_filters(void);
+gboolean xmltrace_matches(const XMLTraceEntry * const entry);
+
+GSList * xmltrace_pretty(const char * const raw);
+
+#endif
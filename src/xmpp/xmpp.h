@@ -138,6 +138,7 @@ void jabber_disconnect(void);
 void jabber_shutdown(void);
 void jabber_process_events(void);
 const char * jabber_get_fulljid(void);
+Jid * jabber_get_jid(void);
 const char * jabber_get_domain(void);
 jabber_conn_status_t jabber_get_connection_status(void);
 char * jabber_get_presence_message(void);
@@ -197,6 +198,7 @@ void iq_room_kick_occupant(const char * const room, const char * const nick, con
 void iq_room_role_set(const char * const room, const char * const nick, char *role,
     const char * const reason);
 void iq_room_role_list(const char * const room, char *role);
+void iq_mam_query(const char * const archive, const char * const after, int max);
 
 // caps functions
 Capabilities* caps_lookup(const char * const jid);
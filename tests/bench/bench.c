@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <glib.h>
+
+#include "bench.h"
+
+#define BENCH_DEFAULT_MILLIS 1000
+#define BENCH_MAX_ITERATIONS 1000000000
+
+static const char *filter = NULL;
+static gint64 bench_time_ns;
+
+static gboolean timer_on;
+static gint64 timer_start;
+static gint64 elapsed_ns;
+static unsigned long allocs_start;
+static unsigned long elapsed_allocs;
+
+static volatile unsigned long allocs = 0;
+
+#ifdef __GLIBC__
+/*
+ * Count allocations by interposing the allocator, glib allocates with malloc
+ * so g_malloc, g_strdup etc. are counted as well as direct calls
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *
+malloc(size_t size)
+{
+    allocs++;
+    return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+    allocs++;
+    return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+    allocs++;
+    return __libc_realloc(ptr, size);
+}
+#define BENCH_COUNTS_ALLOCS 1
+#else
+#define BENCH_COUNTS_ALLOCS 0
+#endif
+
+static gint64 _now_ns(void);
+static void _run_once(bench_func func, int n);
+static int _next_iterations(int n);
+
+/*
+ * Usage: benchsuite [filter]
+ * Only benchmarks with filter in their name are run, PROF_BENCH_MILLIS sets
+ * how long each benchmark runs for, defaulting to one second
+ */
+void
+bench_init(int argc, char **argv)
+{
+    if (argc > 1) {
+        filter = argv[1];
+    }
+
+    gint64 millis = BENCH_DEFAULT_MILLIS;
+    const char *env_millis = getenv("PROF_BENCH_MILLIS");
+    if (env_millis) {
+        gint64 parsed = g_ascii_strtoll(env_millis, NULL, 10);
+        if (parsed > 0) {
+            millis = parsed;
+        }
+    }
+    bench_time_ns = millis * 1000000;
+}
+
+/*
+ * Run func with increasing iteration counts until it takes the benchmark time,
+ * then print one line per benchmark:
+ * Benchmark<name> <iterations> <ns> ns/op <allocs> allocs/op
+ */
+void
+bench_run(const char * const name, bench_func func)
+{
+    if (filter && strstr(name, filter) == NULL) {
+        return;
+    }
+
+    int n = 1;
+    _run_once(func, n);
+    while (elapsed_ns < bench_time_ns && n < BENCH_MAX_ITERATIONS) {
+        n = _next_iterations(n);
+        _run_once(func, n);
+    }
+
+    double ns_per_op = (double)elapsed_ns / n;
+    if (BENCH_COUNTS_ALLOCS) {
+        double allocs_per_op = (double)elapsed_allocs / n;
+        printf("Benchmark%-40s %10d %14.1f ns/op %12.2f allocs/op\n", name, n, ns_per_op, allocs_per_op);
+    } else {
+        printf("Benchmark%-40s %10d %14.1f ns/op\n", name, n, ns_per_op);
+    }
+    fflush(stdout);
+}
+
+void
+bench_start_timer(void)
+{
+    if (!timer_on) {
+        timer_start = _now_ns();
+        allocs_start = allocs;
+        timer_on = TRUE;
+    }
+}
+
+void
+bench_stop_timer(void)
+{
+    if (timer_on) {
+        elapsed_ns += _now_ns() - timer_start;
+        elapsed_allocs += allocs - allocs_start;
+        timer_on = FALSE;
+    }
+}
+
+// discard time and allocations so far, used after expensive setup
+void
+bench_reset_timer(void)
+{
+    if (timer_on) {
+        timer_start = _now_ns();
+        allocs_start = allocs;
+    }
+    elapsed_ns = 0;
+    elapsed_allocs = 0;
+}
+
+static void
+_run_once(bench_func func, int n)
+{
+    timer_on = FALSE;
+    bench_reset_timer();
+    bench_start_timer();
+    func(n);
+    bench_stop_timer();
+}
+
+// aim past the benchmark time based on the last run, growing at most 100 times
+static int
+_next_iterations(int n)
+{
+    gint64 per_op = elapsed_ns / n;
+    gint64 next = (per_op > 0) ? (bench_time_ns + bench_time_ns / 5) / per_op : (gint64)n * 100;
+    if (next > (gint64)n * 100) {
+        next = (gint64)n * 100;
+    }
+    if (next <= n) {
+        next = n + 1;
+    }
+    if (next > BENCH_MAX_ITERATIONS) {
+        next = BENCH_MAX_ITERATIONS;
+    }
+
+    return (int)next;
+}
+
+static gint64
+_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (gint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
@@ -0,0 +1,18 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// realistic sizes for a large roster, a busy room and a long session
+#define BENCH_CONTACTS 10000
+#define BENCH_OCCUPANTS 2000
+#define BENCH_LINES 100000
+
+typedef void (*bench_func)(int n);
+
+void bench_init(int argc, char **argv);
+void bench_run(const char * const name, bench_func func);
+
+void bench_start_timer(void);
+void bench_stop_timer(void);
+void bench_reset_timer(void);
+
+#endif
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "tools/autocomplete.h"
+
+#include "bench.h"
+#include "bench_autocomplete.h"
+
+static Autocomplete _contacts_ac(void);
+
+void
+bench_autocomplete_add(int n)
+{
+    char item[64];
+    Autocomplete ac = autocomplete_new();
+    int i;
+    for (i = 0; i < n; i++) {
+        snprintf(item, sizeof(item), "contact%d@server.org", i % BENCH_CONTACTS);
+        autocomplete_add(ac, item);
+    }
+    bench_stop_timer();
+    autocomplete_free(ac);
+}
+
+void
+bench_autocomplete_complete(int n)
+{
+    bench_stop_timer();
+    Autocomplete ac = _contacts_ac();
+    bench_start_timer();
+
+    int i;
+    for (i = 0; i < n; i++) {
+        autocomplete_reset(ac);
+        gchar *result = autocomplete_complete(ac, "contact9999", FALSE);
+        g_free(result);
+    }
+
+    bench_stop_timer();
+    autocomplete_free(ac);
+}
+
+void
+bench_autocomplete_cycle(int n)
+{
+    bench_stop_timer();
+    Autocomplete ac = _contacts_ac();
+    bench_start_timer();
+
+    int i;
+    for (i = 0; i < n; i++) {
+        gchar *result = autocomplete_complete(ac, "contact1", FALSE);
+        g_free(result);
+    }
+
+    bench_stop_timer();
+    autocomplete_free(ac);
+}
+
+static Autocomplete
+_contacts_ac(void)
+{
+    char item[64];
+    Autocomplete ac = autocomplete_new();
+    int i;
+    for (i = 0; i < BENCH_CONTACTS; i++) {
+        snprintf(item, sizeof(item), "contact%d@server.org", i);
+        autocomplete_add(ac, item);
+    }
+
+    return ac;
+}
@@ -0,0 +1,3 @@
+void bench_autocomplete_add(int n);
+void bench_autocomplete_complete(int n);
+void bench_autocomplete_cycle(int n);
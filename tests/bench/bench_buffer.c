@@ -0,0 +1,39 @@
+#include <glib.h>
+
+#include "ui/buffer.h"
+#include "chat_message.h"
+
+#include "bench.h"
+#include "bench_buffer.h"
+
+void
+bench_buffer_push(int n)
+{
+    ProfBuff buffer = buffer_create();
+    int i;
+    for (i = 0; i < n; i++) {
+        buffer_push(buffer, '-', g_date_time_new_now_local(), 0, THEME_TEXT, "contact@server.org",
+            "a line of chat that is around as long as a typical message");
+    }
+
+    bench_stop_timer();
+    buffer_free(buffer);
+}
+
+void
+bench_buffer_push_message(int n)
+{
+    GTimeVal tv;
+    g_get_current_time(&tv);
+    ProfBuff buffer = buffer_create();
+    int i;
+    for (i = 0; i < n; i++) {
+        ChatMessage *message = chat_message_new("contact@server.org", "laptop",
+            "a line of chat that is around as long as a typical message", &tv);
+        buffer_push_message(buffer, '-', g_date_time_new_now_local(), 0, THEME_TEXT, "contact", message);
+        chat_message_unref(message);
+    }
+
+    bench_stop_timer();
+    buffer_free(buffer);
+}
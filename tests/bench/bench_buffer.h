@@ -0,0 +1,2 @@
+void bench_buffer_push(int n);
+void bench_buffer_push_message(int n);
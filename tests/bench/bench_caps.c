@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <strophe.h>
+
+#include "xmpp/stanza.h"
+#include "xmpp/capabilities.h"
+
+#include "bench.h"
+#include "bench_caps.h"
+
+// about what a full featured desktop client advertises
+#define BENCH_FEATURES 40
+
+static xmpp_ctx_t *ctx = NULL;
+
+static xmpp_stanza_t * _disco_info(void);
+static xmpp_stanza_t * _child(xmpp_stanza_t *parent, const char * const name);
+static void _field(xmpp_stanza_t *form, const char * const var, const char * const value);
+
+// form.c allocates with the connection context, connection.c is not linked here
+xmpp_ctx_t *
+connection_get_ctx(void)
+{
+    return ctx;
+}
+
+// verification hash of one peer's disco#info reply
+void
+bench_caps_create_sha1_str(int n)
+{
+    bench_stop_timer();
+    ctx = xmpp_ctx_new(NULL, NULL);
+    xmpp_stanza_t *query = _disco_info();
+    bench_start_timer();
+
+    int i;
+    for (i = 0; i < n; i++) {
+        g_free(caps_create_sha1_str(query));
+    }
+
+    bench_stop_timer();
+    xmpp_stanza_release(query);
+    xmpp_ctx_free(ctx);
+    ctx = NULL;
+}
+
+static xmpp_stanza_t *
+_disco_info(void)
+{
+    xmpp_stanza_t *query = xmpp_stanza_new(ctx);
+    xmpp_stanza_set_name(query, STANZA_NAME_QUERY);
+    xmpp_stanza_set_ns(query, XMPP_NS_DISCO_INFO);
+
+    xmpp_stanza_t *identity = _child(query, STANZA_NAME_IDENTITY);
+    xmpp_stanza_set_attribute(identity, "category", "client");
+    xmpp_stanza_set_attribute(identity, "type", "pc");
+    xmpp_stanza_set_attribute(identity, "name", "Bench Client");
+
+    char var[64];
+    int i;
+    for (i = 0; i < BENCH_FEATURES; i++) {
+        xmpp_stanza_t *feature = _child(query, STANZA_NAME_FEATURE);
+        snprintf(var, sizeof(var), "urn:xmpp:bench:feature:%d", BENCH_FEATURES - i);
+        xmpp_stanza_set_attribute(feature, STANZA_ATTR_VAR, var);
+    }
+
+    xmpp_stanza_t *form = _child(query, STANZA_NAME_X);
+    xmpp_stanza_set_ns(form, STANZA_NS_DATA);
+    xmpp_stanza_set_attribute(form, STANZA_ATTR_TYPE, "result");
+    _field(form, "FORM_TYPE", "urn:xmpp:dataforms:softwareinfo");
+    _field(form, "software", "Bench Client");
+    _field(form, "software_version", "1.0");
+    _field(form, "os", "Linux");
+    _field(form, "os_version", "4.0");
+
+    return query;
+}
+
+static xmpp_stanza_t *
+_child(xmpp_stanza_t *parent, const char * const name)
+{
+    xmpp_stanza_t *child = xmpp_stanza_new(ctx);
+    xmpp_stanza_set_name(child, name);
+    xmpp_stanza_add_child(parent, child);
+    xmpp_stanza_release(child);
+
+    return child;
+}
+
+static void
+_field(xmpp_stanza_t *form, const char * const var, const char * const value)
+{
+    xmpp_stanza_t *field = _child(form, "field");
+    xmpp_stanza_set_attribute(field, STANZA_ATTR_VAR, var);
+    if (g_strcmp0(var, "FORM_TYPE") == 0) {
+        xmpp_stanza_set_attribute(field, STANZA_ATTR_TYPE, "hidden");
+    }
+
+    xmpp_stanza_t *value_stanza = _child(field, "value");
+    xmpp_stanza_t *text = xmpp_stanza_new(ctx);
+    xmpp_stanza_set_text(text, value);
+    xmpp_stanza_add_child(value_stanza, text);
+    xmpp_stanza_release(text);
+}
@@ -0,0 +1 @@
+void bench_caps_create_sha1_str(int n);
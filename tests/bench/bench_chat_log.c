@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "common.h"
+#include "log.h"
+
+#include "bench.h"
+#include "bench_chat_log.h"
+
+static void _remove_tree(const char * const path);
+
+// one incoming line appended to a contact's chat log, written under a temporary XDG_DATA_HOME
+void
+bench_chat_log_chat(int n)
+{
+    bench_stop_timer();
+    gchar *data_home = g_build_filename(g_get_tmp_dir(), "profanity-bench-XXXXXX", NULL);
+    if (mkdtemp(data_home) == NULL) {
+        perror("mkdtemp");
+        exit(1);
+    }
+    gchar *chatlogs = g_build_filename(data_home, "profanity", "chatlogs", NULL);
+    mkdir_recursive(chatlogs);
+    g_free(chatlogs);
+
+    gchar *old_data_home = g_strdup(getenv("XDG_DATA_HOME"));
+    setenv("XDG_DATA_HOME", data_home, 1);
+    chat_log_init();
+    groupchat_log_init();
+    bench_start_timer();
+
+    int i;
+    for (i = 0; i < n; i++) {
+        chat_log_chat("me@server.org", "contact@server.org",
+            "a line of chat that is around as long as a typical message", PROF_IN_LOG, NULL);
+    }
+
+    bench_stop_timer();
+    chat_log_close();
+    if (old_data_home) {
+        setenv("XDG_DATA_HOME", old_data_home, 1);
+    } else {
+        unsetenv("XDG_DATA_HOME");
+    }
+    g_free(old_data_home);
+    _remove_tree(data_home);
+    g_free(data_home);
+}
+
+static void
+_remove_tree(const char * const path)
+{
+    GDir *dir = g_dir_open(path, 0, NULL);
+    if (dir) {
+        const gchar *name = NULL;
+        while ((name = g_dir_read_name(dir)) != NULL) {
+            gchar *child = g_build_filename(path, name, NULL);
+            _remove_tree(child);
+            g_free(child);
+        }
+        g_dir_close(dir);
+        g_rmdir(path);
+    } else {
+        g_unlink(path);
+    }
+}
@@ -0,0 +1 @@
+void bench_chat_log_chat(int n);
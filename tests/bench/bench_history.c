@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "tools/history.h"
+
+#include "bench.h"
+#include "bench_history.h"
+
+static History _full_history(void);
+
+void
+bench_history_append(int n)
+{
+    char line[64];
+    History history = history_new(BENCH_LINES);
+    int i;
+    for (i = 0; i < n; i++) {
+        snprintf(line, sizeof(line), "/msg contact%d@server.org hello", i % BENCH_CONTACTS);
+        history_append(history, line);
+    }
+
+    bench_stop_timer();
+    history_free(history);
+}
+
+void
+bench_history_search(int n)
+{
+    bench_stop_timer();
+    History history = _full_history();
+    gint64 position = HISTORY_SEARCH_NEWEST;
+    free(history_search(history, "", &position));
+    bench_start_timer();
+
+    int i;
+    for (i = 0; i < n; i++) {
+        position = HISTORY_SEARCH_NEWEST;
+        char *found = history_search(history, "/msg contact42@", &position);
+        free(found);
+    }
+
+    bench_stop_timer();
+    history_free(history);
+}
+
+// BENCH_LINES lines of history, one distinct line per contact
+static History
+_full_history(void)
+{
+    char line[64];
+    History history = history_new(BENCH_LINES);
+    int i;
+    for (i = 0; i < BENCH_LINES; i++) {
+        snprintf(line, sizeof(line), "/msg contact%d@server.org hello", i % BENCH_CONTACTS);
+        history_append(history, line);
+    }
+
+    return history;
+}
@@ -0,0 +1,2 @@
+void bench_history_append(int n);
+void bench_history_search(int n);
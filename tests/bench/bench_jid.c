@@ -0,0 +1,33 @@
+#include <stdio.h>
+
+#include <glib.h>
+
+#include "jid.h"
+
+#include "bench.h"
+#include "bench_jid.h"
+
+void
+bench_jid_create(int n)
+{
+    int i;
+    for (i = 0; i < n; i++) {
+        Jid *jid = jid_create("someuser@server.org/laptop");
+        jid_destroy(jid);
+    }
+}
+
+void
+bench_jid_intern(int n)
+{
+    char fulljid[64];
+    int i;
+    for (i = 0; i < n; i++) {
+        snprintf(fulljid, sizeof(fulljid), "contact%d@server.org/laptop", i % 100);
+        Jid *jid = jid_intern(fulljid);
+        jid_release(jid);
+    }
+
+    bench_stop_timer();
+    jid_intern_clear();
+}
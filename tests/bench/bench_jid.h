@@ -0,0 +1,2 @@
+void bench_jid_create(int n);
+void bench_jid_intern(int n);
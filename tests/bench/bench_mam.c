@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "xmpp/mam.h"
+
+#include "bench.h"
+#include "bench_mam.h"
+
+#define BENCH_ARCHIVE "me@server.org"
+
+// the page most recently asked for, answered by _serve
+static int next_start = -1;
+static int next_max = 0;
+static int delivered = 0;
+
+static void _stub_query(const char * const archive, const char * const after, int max);
+static void _stub_deliver(const char * const archive, GList *messages);
+static void _serve(void);
+
+// one full catch up of MAM_MAX_PAGES pages from a local stand in archive
+void
+bench_mam_catch_up(int n)
+{
+    bench_stop_timer();
+    mam_init(_stub_query, _stub_deliver);
+
+    int i;
+    for (i = 0; i < n; i++) {
+        mam_seen(BENCH_ARCHIVE, "id0");
+        bench_start_timer();
+        mam_catch_up(BENCH_ARCHIVE);
+        _serve();
+        bench_stop_timer();
+    }
+
+    mam_close();
+}
+
+static void
+_stub_query(const char * const archive, const char * const after, int max)
+{
+    next_start = after ? atoi(after + 2) + 1 : 0;
+    next_max = max;
+}
+
+static void
+_stub_deliver(const char * const archive, GList *messages)
+{
+    delivered += g_list_length(messages);
+}
+
+static void
+_serve(void)
+{
+    char id[32];
+    char body[64];
+    while (next_start >= 0) {
+        int start = next_start;
+        int end = start + next_max;
+        next_start = -1;
+
+        int i;
+        for (i = start; i < end; i++) {
+            GTimeVal tv_stamp = { 1000000 + i, 0 };
+            snprintf(id, sizeof(id), "id%d", i);
+            snprintf(body, sizeof(body), "archived message number %d", i);
+            mam_result(BENCH_ARCHIVE, id, "friend@server.org", body, &tv_stamp, FALSE);
+        }
+        mam_page_complete(BENCH_ARCHIVE, id, FALSE);
+    }
+}
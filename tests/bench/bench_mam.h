@@ -0,0 +1 @@
+void bench_mam_catch_up(int n);
@@ -0,0 +1,60 @@
+#include <stdio.h>
+
+#include <glib.h>
+
+#include "muc.h"
+
+#include "bench.h"
+#include "bench_muc.h"
+
+#define BENCH_ROOM "room@conference.server.org"
+
+static void _join_room(void);
+
+void
+bench_muc_join_occupants(int n)
+{
+    bench_stop_timer();
+    muc_init();
+    int i;
+    for (i = 0; i < n; i++) {
+        bench_start_timer();
+        _join_room();
+        bench_stop_timer();
+        muc_leave(BENCH_ROOM);
+    }
+
+    muc_close();
+}
+
+void
+bench_muc_roster(int n)
+{
+    bench_stop_timer();
+    muc_init();
+    _join_room();
+    bench_start_timer();
+
+    int i;
+    for (i = 0; i < n; i++) {
+        GList *occupants = muc_roster(BENCH_ROOM);
+        g_list_free(occupants);
+    }
+
+    bench_stop_timer();
+    muc_close();
+}
+
+// join a room and receive presence for BENCH_OCCUPANTS occupants
+static void
+_join_room(void)
+{
+    char nick[32];
+    muc_join(BENCH_ROOM, "me", NULL, FALSE);
+    int i;
+    for (i = 0; i < BENCH_OCCUPANTS; i++) {
+        snprintf(nick, sizeof(nick), "occupant%d", i);
+        muc_roster_add(BENCH_ROOM, nick, NULL, "participant", "none", NULL, NULL);
+    }
+    muc_roster_set_complete(BENCH_ROOM);
+}
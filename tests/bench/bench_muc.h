@@ -0,0 +1,2 @@
+void bench_muc_join_occupants(int n);
+void bench_muc_roster(int n);
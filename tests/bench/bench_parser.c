@@ -0,0 +1,28 @@
+#include <glib.h>
+
+#include "tools/parser.h"
+
+#include "bench.h"
+#include "bench_parser.h"
+
+void
+bench_parse_args(int n)
+{
+    gboolean result;
+    int i;
+    for (i = 0; i < n; i++) {
+        gchar **args = parse_args("/join room@conference.server.org nick bob password \"a secret\"", 1, 5, &result);
+        g_strfreev(args);
+    }
+}
+
+void
+bench_parse_args_with_freetext(int n)
+{
+    gboolean result;
+    int i;
+    for (i = 0; i < n; i++) {
+        gchar **args = parse_args_with_freetext("/msg someone@server.org hello there, how are you doing today?", 1, 2, &result);
+        g_strfreev(args);
+    }
+}
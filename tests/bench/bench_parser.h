@@ -0,0 +1,2 @@
+void bench_parse_args(int n);
+void bench_parse_args_with_freetext(int n);
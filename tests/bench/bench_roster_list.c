@@ -0,0 +1,97 @@
+#include <stdio.h>
+
+#include <glib.h>
+
+#include "common.h"
+#include "resource.h"
+#include "roster_list.h"
+
+#include "bench.h"
+#include "bench_roster_list.h"
+
+static void _add_contacts(void);
+
+void
+bench_roster_add(int n)
+{
+    char barejid[64];
+    roster_init();
+    int i;
+    for (i = 0; i < n; i++) {
+        snprintf(barejid, sizeof(barejid), "contact%d@server.org", i);
+        roster_add(barejid, NULL, NULL, "both", FALSE);
+    }
+
+    bench_stop_timer();
+    roster_free();
+}
+
+void
+bench_roster_get_contacts_by_presence(int n)
+{
+    bench_stop_timer();
+    _add_contacts();
+    bench_start_timer();
+
+    int i;
+    for (i = 0; i < n; i++) {
+        GSList *contacts = roster_get_contacts_by_presence("online");
+        g_slist_free(contacts);
+    }
+
+    bench_stop_timer();
+    roster_free();
+}
+
+void
+bench_roster_get_contacts(int n)
+{
+    bench_stop_timer();
+    _add_contacts();
+    bench_start_timer();
+
+    int i;
+    for (i = 0; i < n; i++) {
+        GSList *contacts = roster_get_contacts();
+        g_slist_free(contacts);
+    }
+
+    bench_stop_timer();
+    roster_free();
+}
+
+void
+bench_roster_update_presence(int n)
+{
+    char barejid[64];
+    bench_stop_timer();
+    _add_contacts();
+    bench_start_timer();
+
+    int i;
+    for (i = 0; i < n; i++) {
+        snprintf(barejid, sizeof(barejid), "contact%d@server.org", i % BENCH_CONTACTS);
+        Resource *resource = resource_new("laptop", i % 2 ? RESOURCE_AWAY : RESOURCE_ONLINE, NULL, 0);
+        roster_update_presence(barejid, resource, NULL);
+    }
+
+    bench_stop_timer();
+    roster_free();
+}
+
+// a roster of BENCH_CONTACTS, a quarter of them online
+static void
+_add_contacts(void)
+{
+    char barejid[64];
+    roster_init();
+    int i;
+    for (i = 0; i < BENCH_CONTACTS; i++) {
+        snprintf(barejid, sizeof(barejid), "contact%d@server.org", i);
+        roster_add(barejid, NULL, NULL, "both", FALSE);
+        if (i % 4 == 0) {
+            Resource *resource = resource_new("laptop", RESOURCE_ONLINE, NULL, 0);
+            roster_update_presence(barejid, resource, NULL);
+        }
+    }
+}
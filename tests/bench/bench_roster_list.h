@@ -0,0 +1,4 @@
+void bench_roster_add(int n);
+void bench_roster_get_contacts_by_presence(int n);
+void bench_roster_get_contacts(int n);
+void bench_roster_update_presence(int n);
@@ -0,0 +1,49 @@
+#include <stdio.h>
+
+#include "config.h"
+
+#include "bench.h"
+#include "bench_autocomplete.h"
+#include "bench_buffer.h"
+#include "bench_caps.h"
+#include "bench_chat_log.h"
+#include "bench_history.h"
+#include "bench_jid.h"
+#include "bench_mam.h"
+#include "bench_muc.h"
+#include "bench_parser.h"
+#include "bench_roster_list.h"
+
+int main(int argc, char **argv) {
+    bench_init(argc, argv);
+
+    bench_run("AutocompleteAdd", bench_autocomplete_add);
+    bench_run("AutocompleteComplete", bench_autocomplete_complete);
+    bench_run("AutocompleteCycle", bench_autocomplete_cycle);
+
+    bench_run("ParseArgs", bench_parse_args);
+    bench_run("ParseArgsWithFreetext", bench_parse_args_with_freetext);
+
+    bench_run("JidCreate", bench_jid_create);
+    bench_run("JidIntern", bench_jid_intern);
+
+    bench_run("BufferPush", bench_buffer_push);
+    bench_run("BufferPushMessage", bench_buffer_push_message);
+
+    bench_run("RosterAdd", bench_roster_add);
+    bench_run("RosterGetContacts", bench_roster_get_contacts);
+    bench_run("RosterGetContactsByPresence", bench_roster_get_contacts_by_presence);
+    bench_run("RosterUpdatePresence", bench_roster_update_presence);
+
+    bench_run("MucJoinOccupants", bench_muc_join_occupants);
+    bench_run("MucRoster", bench_muc_roster);
+    bench_run("MamCatchUp", bench_mam_catch_up);
+
+    bench_run("HistoryAppend", bench_history_append);
+    bench_run("HistorySearch", bench_history_search);
+
+    bench_run("CapsCreateSha1Str", bench_caps_create_sha1_str);
+    bench_run("ChatLogChat", bench_chat_log_chat);
+
+    return 0;
+}
@@ -45,6 +45,13 @@ ProfAccount* accounts_get_account(const char * const name)
     return (ProfAccount*)mock();
 }
 
+const ProfAccount* accounts_get_account_ref(const char * const name)
+{
+    return NULL;
+}
+
+void accounts_add_listener(void (*func)(const char * const account_name)) {}
+
 gboolean accounts_enable(const char * const name)
 {
     check_expected(name);
@@ -39,6 +39,7 @@ void log_warning(const char * const msg, ...) {}
 void log_error(const char * const msg, ...) {}
 void log_msg(log_level_t level, const char * const area,
     const char * const msg) {}
+void log_timed_flush(void) {}
 char * get_log_file_location(void)
 {
     return mock_ptr_type(char *);
@@ -62,3 +63,11 @@ GSList * chat_log_get_previous(const gchar * const login,
 void groupchat_log_init(void) {}
 void groupchat_log_chat(const gchar * const login, const gchar * const room,
     const gchar * const nick, const gchar * const msg) {}
+char * groupchat_log_seen_filename(const gchar * const login)
+{
+    return NULL;
+}
+char * chat_log_archive_filename(const gchar * const login)
+{
+    return NULL;
+}
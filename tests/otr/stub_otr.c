@@ -87,10 +87,10 @@ char * otr_encrypt_message(const char * const to, const char * const message)
     return NULL;
 }
 
-char * otr_decrypt_message(const char * const from, const char * const message,
-    gboolean *was_decrypted)
+gboolean otr_decrypt_message(const char * const from, const char * const message,
+    char **decrypted)
 {
-    return NULL;
+    return FALSE;
 }
 
 void otr_free_message(char *message) {}
@@ -98,4 +98,6 @@ void otr_free_message(char *message) {}
 prof_otrpolicy_t otr_get_policy(const char * const recipient)
 {
     return PROF_OTRPOLICY_MANUAL;
-}
\ No newline at end of file
+}
+
+void otr_policy_changed(void) {}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <glib.h>
+
+#include "common.h"
+#include "xmpp/capsqueue.h"
+
+static GSList *sent;
+
+static char *
+_stub_query(const char * const jid, const char * const node,
+    const char * const ver, gboolean legacy)
+{
+    sent = g_slist_append(sent, strdup(jid));
+
+    char *id = malloc(16);
+    sprintf(id, "caps%d", g_slist_length(sent));
+    return id;
+}
+
+void capsqueue_before_test(void **state)
+{
+    sent = NULL;
+    capsqueue_init(_stub_query);
+}
+
+void capsqueue_after_test(void **state)
+{
+    capsqueue_close();
+    g_slist_free_full(sent, free);
+    sent = NULL;
+}
+
+void first_request_sent(void **state)
+{
+    gboolean res = capsqueue_request("ver1", "room@conf/bob", "http://client", "ver1", FALSE, 0);
+
+    assert_true(res);
+    assert_int_equal(1, g_slist_length(sent));
+    assert_string_equal("room@conf/bob", sent->data);
+    assert_int_equal(1, capsqueue_inflight());
+}
+
+void duplicate_ver_not_sent(void **state)
+{
+    capsqueue_request("ver1", "room@conf/bob", "http://client", "ver1", FALSE, 0);
+    gboolean res = capsqueue_request("ver1", "room@conf/mike", "http://client", "ver1", FALSE, 0);
+
+    assert_false(res);
+    assert_int_equal(1, g_slist_length(sent));
+    assert_int_equal(1, capsqueue_inflight());
+}
+
+void complete_returns_all_waiters(void **state)
+{
+    capsqueue_request("ver1", "room@conf/bob", "http://client", "ver1", FALSE, 0);
+    capsqueue_request("ver1", "room@conf/mike", "http://client", "ver1", FALSE, 0);
+    capsqueue_request("ver1", "room@conf/mike", "http://client", "ver1", FALSE, 0);
+
+    GSList *waiters = capsqueue_complete("ver1", 0);
+
+    assert_int_equal(2, g_slist_length(waiters));
+    assert_string_equal("room@conf/bob", waiters->data);
+    assert_string_equal("room@conf/mike", waiters->next->data);
+    assert_false(capsqueue_pending("ver1"));
+    assert_int_equal(0, capsqueue_inflight());
+    g_slist_free_full(waiters, free);
+}
+
+void requests_over_limit_wait(void **state)
+{
+    int i;
+    for (i = 0; i < CAPSQUEUE_MAX_INFLIGHT + 2; i++) {
+        char *ver = g_strdup_printf("ver%d", i);
+        capsqueue_request(ver, "room@conf/bob", "http://client", ver, FALSE, 0);
+        g_free(ver);
+    }
+
+    assert_int_equal(CAPSQUEUE_MAX_INFLIGHT, g_slist_length(sent));
+    assert_int_equal(CAPSQUEUE_MAX_INFLIGHT, capsqueue_inflight());
+    assert_true(capsqueue_pending("ver9"));
+}
+
+void complete_sends_waiting_request(void **state)
+{
+    int i;
+    for (i = 0; i < CAPSQUEUE_MAX_INFLIGHT; i++) {
+        char *ver = g_strdup_printf("ver%d", i);
+        capsqueue_request(ver, "room@conf/bob", "http://client", ver, FALSE, 0);
+        g_free(ver);
+    }
+    capsqueue_request("waiting", "room@conf/mike", "http://client", "waiting", FALSE, 0);
+
+    GSList *waiters = capsqueue_complete("ver0", 0);
+    g_slist_free_full(waiters, free);
+
+    assert_int_equal(CAPSQUEUE_MAX_INFLIGHT + 1, g_slist_length(sent));
+    assert_string_equal("room@conf/mike", g_slist_last(sent)->data);
+    assert_int_equal(CAPSQUEUE_MAX_INFLIGHT, capsqueue_inflight());
+}
+
+void failed_retries_next_waiter(void **state)
+{
+    capsqueue_request("ver1", "room@conf/bob", "http://client", "ver1", FALSE, 0);
+    capsqueue_request("ver1", "room@conf/mike", "http://client", "ver1", FALSE, 0);
+
+    capsqueue_failed("ver1", "caps1", 0);
+
+    assert_int_equal(2, g_slist_length(sent));
+    assert_string_equal("room@conf/mike", sent->next->data);
+    assert_true(capsqueue_pending("ver1"));
+    assert_int_equal(1, capsqueue_inflight());
+}
+
+void failed_without_waiters_drops(void **state)
+{
+    capsqueue_request("ver1", "room@conf/bob", "http://client", "ver1", FALSE, 0);
+
+    capsqueue_failed("ver1", "caps1", 0);
+
+    assert_int_equal(1, g_slist_length(sent));
+    assert_false(capsqueue_pending("ver1"));
+    assert_int_equal(0, capsqueue_inflight());
+}
+
+void expire_retries_timed_out_request(void **state)
+{
+    capsqueue_request("ver1", "room@conf/bob", "http://client", "ver1", FALSE, 0);
+    capsqueue_request("ver1", "room@conf/mike", "http://client", "ver1", FALSE, 0);
+
+    capsqueue_expire(CAPSQUEUE_TIMEOUT - 1, CAPSQUEUE_TIMEOUT);
+    assert_int_equal(1, g_slist_length(sent));
+
+    capsqueue_expire(CAPSQUEUE_TIMEOUT, CAPSQUEUE_TIMEOUT);
+    assert_int_equal(2, g_slist_length(sent));
+    assert_string_equal("room@conf/mike", sent->next->data);
+}
+
+void failed_reply_for_earlier_attempt_ignored(void **state)
+{
+    capsqueue_request("ver1", "room@conf/bob", "http://client", "ver1", FALSE, 0);
+    capsqueue_request("ver1", "room@conf/mike", "http://client", "ver1", FALSE, 0);
+    capsqueue_request("ver1", "room@conf/dave", "http://client", "ver1", FALSE, 0);
+    capsqueue_expire(CAPSQUEUE_TIMEOUT, CAPSQUEUE_TIMEOUT);
+
+    // bob's error arrives late, after mike was asked
+    capsqueue_failed("ver1", "caps1", CAPSQUEUE_TIMEOUT + 1);
+
+    assert_int_equal(2, g_slist_length(sent));
+    assert_true(capsqueue_pending("ver1"));
+    assert_int_equal(1, capsqueue_inflight());
+
+    capsqueue_failed("ver1", "caps2", CAPSQUEUE_TIMEOUT + 1);
+
+    assert_int_equal(3, g_slist_length(sent));
+    assert_string_equal("room@conf/dave", g_slist_last(sent)->data);
+}
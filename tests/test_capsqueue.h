@@ -0,0 +1,11 @@
+void capsqueue_before_test(void **state);
+void capsqueue_after_test(void **state);
+void first_request_sent(void **state);
+void duplicate_ver_not_sent(void **state);
+void complete_returns_all_waiters(void **state);
+void requests_over_limit_wait(void **state);
+void complete_sends_waiting_request(void **state);
+void failed_retries_next_waiter(void **state);
+void failed_without_waiters_drops(void **state);
+void expire_retries_timed_out_request(void **state);
+void failed_reply_for_earlier_attempt_ignored(void **state);
@@ -0,0 +1,86 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "chat_message.h"
+#include "ui/buffer.h"
+
+void new_message_copies_fields(void **state)
+{
+    char body[] = "hello";
+    ChatMessage *message = chat_message_new("bob@server.org", "laptop", body, NULL);
+    body[0] = 'j';
+
+    assert_string_equal("bob@server.org", message->barejid);
+    assert_string_equal("laptop", message->resource);
+    assert_string_equal("hello", message->body);
+    assert_false(message->delayed);
+    assert_false(message->encrypted);
+
+    chat_message_unref(message);
+}
+
+void new_message_without_resource(void **state)
+{
+    ChatMessage *message = chat_message_new("bob@server.org", NULL, "hello", NULL);
+
+    assert_null(message->resource);
+
+    chat_message_unref(message);
+}
+
+void new_message_with_timestamp_is_delayed(void **state)
+{
+    GTimeVal tv_stamp;
+    tv_stamp.tv_sec = 1000;
+    tv_stamp.tv_usec = 0;
+    ChatMessage *message = chat_message_new("bob@server.org", NULL, "hello", &tv_stamp);
+
+    assert_true(message->delayed);
+    assert_int_equal(1000, message->timestamp.tv_sec);
+
+    chat_message_unref(message);
+}
+
+void set_body_replaces_body(void **state)
+{
+    ChatMessage *message = chat_message_new("bob@server.org", NULL, "?OTR:AAMD", NULL);
+
+    chat_message_set_body(message, strdup("hello"));
+
+    assert_string_equal("hello", message->body);
+
+    chat_message_unref(message);
+}
+
+void buffer_entry_shares_message_body(void **state)
+{
+    ProfBuff buffer = buffer_create();
+    ChatMessage *message = chat_message_new("bob@server.org", NULL, "hello", NULL);
+
+    ProfBuffEntry *entry = buffer_push_message(buffer, '-', g_date_time_new_now_local(), 0, 0, "bob", message);
+
+    assert_ptr_equal(message->body, entry->message);
+    assert_int_equal(2, message->refs);
+
+    chat_message_unref(message);
+    assert_string_equal("hello", buffer_yield_entry(buffer, 0)->message);
+
+    buffer_free(buffer);
+}
+
+void buffer_entry_keeps_plain_message(void **state)
+{
+    ProfBuff buffer = buffer_create();
+
+    ProfBuffEntry *entry = buffer_push(buffer, '-', g_date_time_new_now_local(), 0, 0, "", "status");
+
+    assert_null(entry->chat_message);
+    assert_string_equal("status", entry->message);
+
+    buffer_free(buffer);
+}
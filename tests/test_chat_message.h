@@ -0,0 +1,6 @@
+void new_message_copies_fields(void **state);
+void new_message_without_resource(void **state);
+void new_message_with_timestamp_is_delayed(void **state);
+void set_body_replaces_body(void **state);
+void buffer_entry_shares_message_body(void **state);
+void buffer_entry_keeps_plain_message(void **state);
@@ -13,6 +13,7 @@
 
 #include "config/accounts.h"
 
+#include "command/command.h"
 #include "command/commands.h"
 
 void cmd_account_shows_usage_when_not_connected_and_no_args(void **state)
@@ -1015,3 +1016,31 @@ void cmd_account_clear_shows_message_when_invalid_property(void **state)
 
     free(help);
 }
+
+void cmd_history_not_saved_for_account_password(void **state)
+{
+    assert_false(cmd_history_savable("/account set a@b.com password secret"));
+    assert_false(cmd_history_savable("/account set a@b.com eval_password pass show"));
+    assert_true(cmd_history_savable("/account set a@b.com resource laptop"));
+}
+
+void cmd_history_not_saved_for_otr_secrets(void **state)
+{
+    assert_false(cmd_history_savable("/otr secret shared"));
+    assert_false(cmd_history_savable("/otr question \"pet?\" rex"));
+    assert_false(cmd_history_savable("/otr answer rex"));
+    assert_true(cmd_history_savable("/otr start"));
+}
+
+void cmd_history_not_saved_for_room_password(void **state)
+{
+    assert_false(cmd_history_savable("/join room@conf.org password secret"));
+    assert_true(cmd_history_savable("/join room@conf.org nick bob"));
+}
+
+void cmd_history_not_saved_for_messages(void **state)
+{
+    assert_false(cmd_history_savable("the password is in the usual place"));
+    assert_false(cmd_history_savable("/msg bob@server.org meet at noon"));
+    assert_true(cmd_history_savable("/msg bob@server.org"));
+}
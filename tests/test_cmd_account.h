@@ -53,3 +53,7 @@ void cmd_account_clear_shows_usage_when_no_args(void **state);
 void cmd_account_clear_shows_usage_when_one_arg(void **state);
 void cmd_account_clear_shows_message_when_account_doesnt_exist(void **state);
 void cmd_account_clear_shows_message_when_invalid_property(void **state);
+void cmd_history_not_saved_for_account_password(void **state);
+void cmd_history_not_saved_for_otr_secrets(void **state);
+void cmd_history_not_saved_for_room_password(void **state);
+void cmd_history_not_saved_for_messages(void **state);
@@ -0,0 +1,112 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <glib.h>
+
+#include "config.h"
+
+#include "xmpp/compression.h"
+
+#define PRESENCE "<presence from='contact%d@server.org/laptop' to='me@server.org/profanity'>" \
+    "<show>away</show><status>Away from keyboard</status>" \
+    "<c xmlns='http://jabber.org/protocol/caps' hash='sha-1' node='http://profanity.im' " \
+    "ver='rJDuB8Q3Lkw1MQjlTzHOyUR3yvs='/></presence>"
+
+// what a server would push for a large roster coming online
+static guint64
+_receive_presence_flood(int count)
+{
+    guint64 total = 0;
+    char stanza[512];
+    int i;
+    for (i = 0; i < count; i++) {
+        snprintf(stanza, sizeof(stanza), PRESENCE, i);
+        compression_received(stanza, strlen(stanza));
+        total += strlen(stanza);
+    }
+
+    return total;
+}
+
+void compression_not_counted_until_active(void **state)
+{
+    compression_init();
+
+    compression_sent("<presence/>", 11);
+    _receive_presence_flood(10);
+
+    CompressionStats stats;
+    compression_get_stats(&stats);
+    assert_false(stats.active);
+    assert_true(stats.sent == 0);
+    assert_true(stats.received == 0);
+    compression_close();
+}
+
+void compression_counts_plain_bytes(void **state)
+{
+    compression_init();
+    compression_set_active(TRUE);
+
+    compression_sent("<presence/>", 11);
+    guint64 received = _receive_presence_flood(10);
+
+    CompressionStats stats;
+    compression_get_stats(&stats);
+    assert_true(stats.active);
+    assert_true(stats.sent == 11);
+    assert_true(stats.received == received);
+    compression_close();
+}
+
+void compression_repetitive_stream_saves_bytes(void **state)
+{
+    compression_init();
+    compression_set_active(TRUE);
+
+    _receive_presence_flood(1000);
+
+    CompressionStats stats;
+    compression_get_stats(&stats);
+#ifdef HAVE_ZLIB
+    assert_true(stats.estimated);
+    assert_true(stats.received_compressed > 0);
+    assert_true(stats.received_compressed * 3 < stats.received);
+#else
+    assert_false(stats.estimated);
+    assert_true(stats.received_compressed == stats.received);
+#endif
+    compression_close();
+}
+
+void compression_reset_for_new_stream(void **state)
+{
+    compression_init();
+    compression_set_active(TRUE);
+    _receive_presence_flood(10);
+
+    compression_init();
+
+    CompressionStats stats;
+    compression_get_stats(&stats);
+    assert_false(stats.active);
+    assert_true(stats.received == 0);
+    assert_true(stats.received_compressed == 0);
+    compression_close();
+}
+
+void compression_confirmed_only_by_compressed_element(void **state)
+{
+    assert_true(compression_confirmed("<compressed xmlns='http://jabber.org/protocol/compress'/>"));
+    assert_true(compression_confirmed("<compressed xmlns=\"http://jabber.org/protocol/compress\"/>"));
+    assert_false(compression_confirmed("<failure xmlns='http://jabber.org/protocol/compress'>"
+        "<setup-failed/></failure>"));
+    assert_false(compression_confirmed("<message from='buddy@server.org/laptop' type='chat'>"
+        "<body>&lt;compressed xmlns='http://jabber.org/protocol/compress'/&gt;</body></message>"));
+    assert_false(compression_confirmed("<message from='buddy@server.org/laptop' type='chat'>"
+        "<body><compressed xmlns='http://jabber.org/protocol/compress'/></body></message>"));
+}
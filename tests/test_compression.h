@@ -0,0 +1,5 @@
+void compression_not_counted_until_active(void **state);
+void compression_counts_plain_bytes(void **state);
+void compression_repetitive_stream_saves_bytes(void **state);
+void compression_reset_for_new_stream(void **state);
+void compression_confirmed_only_by_compressed_element(void **state);
@@ -405,3 +405,29 @@ void contact_available_when_highest_priority_chat(void **state)
 
     p_contact_free(contact);
 }
+
+void contact_presence_updated_when_highest_resource_removed(void **state)
+{
+    PContact contact = p_contact_new("bob@server.com", "bob", NULL, "both",
+        "is offline", FALSE);
+
+    Resource *resource10 = resource_new("resource10", RESOURCE_XA, "gone", 10);
+    Resource *resource20 = resource_new("resource20", RESOURCE_CHAT, "here", 20);
+    p_contact_set_presence(contact, resource10);
+    p_contact_set_presence(contact, resource20);
+
+    assert_string_equal("chat", p_contact_presence(contact));
+    assert_string_equal("here", p_contact_status(contact));
+
+    p_contact_remove_resource(contact, "resource20");
+
+    assert_string_equal("xa", p_contact_presence(contact));
+    assert_string_equal("gone", p_contact_status(contact));
+
+    p_contact_remove_resource(contact, "resource10");
+
+    assert_string_equal("offline", p_contact_presence(contact));
+    assert_string_equal("is offline", p_contact_status(contact));
+
+    p_contact_free(contact);
+}
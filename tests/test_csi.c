@@ -0,0 +1,95 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <glib.h>
+
+#include "xmpp/csi.h"
+
+// states received by the server
+static GString *server;
+
+static void
+_stub_send(gboolean active)
+{
+    g_string_append(server, active ? "A" : "I");
+}
+
+void csi_before_test(void **state)
+{
+    server = g_string_new("");
+    csi_init(_stub_send);
+}
+
+void csi_after_test(void **state)
+{
+    g_string_free(server, TRUE);
+}
+
+void csi_not_sent_when_unsupported(void **state)
+{
+    csi_set_active(FALSE);
+    csi_set_active(TRUE);
+
+    assert_string_equal("", server->str);
+}
+
+void csi_sends_inactive_then_active(void **state)
+{
+    csi_set_supported(TRUE);
+
+    csi_set_active(FALSE);
+    assert_false(csi_active());
+    csi_set_active(TRUE);
+    assert_true(csi_active());
+
+    assert_string_equal("IA", server->str);
+}
+
+void csi_only_sends_changes(void **state)
+{
+    csi_set_supported(TRUE);
+
+    csi_set_active(TRUE);
+    csi_set_active(FALSE);
+    csi_set_active(FALSE);
+    csi_set_active(TRUE);
+    csi_set_active(TRUE);
+
+    assert_string_equal("IA", server->str);
+}
+
+void csi_reset_for_new_stream(void **state)
+{
+    csi_set_supported(TRUE);
+    csi_set_active(FALSE);
+
+    csi_init(_stub_send);
+
+    assert_false(csi_supported());
+    assert_true(csi_active());
+}
+
+void csi_offered_in_stream_features(void **state)
+{
+    assert_true(csi_offered("<stream:features><csi xmlns='urn:xmpp:csi:0'/>"
+        "<sm xmlns='urn:xmpp:sm:3'/></stream:features>"));
+}
+
+void csi_offered_after_stream_header(void **state)
+{
+    assert_true(csi_offered("<?xml version='1.0'?><stream:stream xmlns='jabber:client' "
+        "xmlns:stream='http://etherx.jabber.org/streams' version='1.0'>"
+        "<stream:features><csi xmlns=\"urn:xmpp:csi:0\"/></stream:features>"));
+}
+
+void csi_not_offered_by_message_text(void **state)
+{
+    assert_false(csi_offered("<message from='buddy@server.org/laptop' type='chat'>"
+        "<body>stream:features urn:xmpp:csi:0 &lt;csi xmlns='urn:xmpp:csi:0'/&gt;</body></message>"));
+    assert_false(csi_offered("<message from='buddy@server.org/laptop' type='chat'>"
+        "<body><stream:features><csi xmlns='urn:xmpp:csi:0'/></stream:features></body></message>"));
+    assert_false(csi_offered("<stream:features><starttls xmlns='urn:ietf:params:xml:ns:xmpp-tls'/>"
+        "</stream:features><message><body>&lt;csi xmlns='urn:xmpp:csi:0'/&gt;</body></message>"));
+}
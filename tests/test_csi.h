@@ -0,0 +1,9 @@
+void csi_before_test(void **state);
+void csi_after_test(void **state);
+void csi_not_sent_when_unsupported(void **state);
+void csi_sends_inactive_then_active(void **state);
+void csi_only_sends_changes(void **state);
+void csi_reset_for_new_stream(void **state);
+void csi_offered_in_stream_features(void **state);
+void csi_offered_after_stream_header(void **state);
+void csi_not_offered_by_message_text(void **state);
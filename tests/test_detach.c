@@ -0,0 +1,138 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <glib.h>
+
+#include "detach.h"
+
+void detach_not_detached_on_start(void **state)
+{
+    assert_false(detach_is_detached());
+}
+
+void detach_socket_path_is_per_user(void **state)
+{
+    gchar *runtime_dir = g_strdup(g_getenv("XDG_RUNTIME_DIR"));
+    g_unsetenv("XDG_RUNTIME_DIR");
+
+    char *path = detach_socket_path();
+    char *user_dir = g_strdup_printf("/profanity-%d/", (int)getuid());
+
+    assert_true(g_str_has_prefix(path, g_get_tmp_dir()));
+    assert_non_null(strstr(path, user_dir));
+
+    g_free(user_dir);
+    free(path);
+    if (runtime_dir) {
+        g_setenv("XDG_RUNTIME_DIR", runtime_dir, TRUE);
+    }
+    g_free(runtime_dir);
+}
+
+void detach_socket_path_prefers_runtime_dir(void **state)
+{
+    gchar *runtime_dir = g_strdup(g_getenv("XDG_RUNTIME_DIR"));
+    g_setenv("XDG_RUNTIME_DIR", "/run/user/1000", TRUE);
+
+    char *path = detach_socket_path();
+    assert_string_equal("/run/user/1000/profanity/session.sock", path);
+    free(path);
+
+    if (runtime_dir) {
+        g_setenv("XDG_RUNTIME_DIR", runtime_dir, TRUE);
+    } else {
+        g_unsetenv("XDG_RUNTIME_DIR");
+    }
+    g_free(runtime_dir);
+}
+
+void detach_dir_must_be_private(void **state)
+{
+    gchar *dir = g_build_filename(g_get_tmp_dir(), "prof_test_detach_XXXXXX", NULL);
+    assert_non_null(mkdtemp(dir));
+    gchar *link = g_strdup_printf("%s.link", dir);
+    assert_int_equal(0, symlink(dir, link));
+
+    assert_true(detach_dir_is_private(dir));
+    assert_false(detach_dir_is_private(link));
+
+    chmod(dir, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH);
+    assert_false(detach_dir_is_private(dir));
+
+    assert_false(detach_dir_is_private("/prof_test_detach_missing"));
+
+    unlink(link);
+    rmdir(dir);
+    g_free(link);
+    g_free(dir);
+}
+
+void detach_peer_is_same_user(void **state)
+{
+    int sockets[2];
+    assert_int_equal(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+    assert_true(detach_peer_is_user(sockets[0]));
+    assert_true(detach_peer_is_user(sockets[1]));
+
+    close(sockets[0]);
+    close(sockets[1]);
+}
+
+void detach_terminal_passed_over_socket(void **state)
+{
+    int sockets[2];
+    int input[2];
+    int output[2];
+    assert_int_equal(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+    assert_int_equal(0, pipe(input));
+    assert_int_equal(0, pipe(output));
+
+    assert_true(detach_send_terminal(sockets[0], input[0], output[1]));
+
+    int in_fd = -1;
+    int out_fd = -1;
+    assert_true(detach_receive_terminal(sockets[1], &in_fd, &out_fd));
+
+    char buf[4];
+    assert_int_equal(2, write(input[1], "in", 2));
+    assert_int_equal(2, read(in_fd, buf, 2));
+    assert_memory_equal("in", buf, 2);
+
+    assert_int_equal(3, write(out_fd, "out", 3));
+    assert_int_equal(3, read(output[0], buf, 3));
+    assert_memory_equal("out", buf, 3);
+
+    close(in_fd);
+    close(out_fd);
+    close(input[0]);
+    close(input[1]);
+    close(output[0]);
+    close(output[1]);
+    close(sockets[0]);
+    close(sockets[1]);
+}
+
+void detach_receive_needs_terminal(void **state)
+{
+    int sockets[2];
+    assert_int_equal(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+    assert_int_equal(1, send(sockets[0], "a", 1, 0));
+
+    int in_fd = -1;
+    int out_fd = -1;
+    assert_false(detach_receive_terminal(sockets[1], &in_fd, &out_fd));
+    assert_int_equal(-1, in_fd);
+    assert_int_equal(-1, out_fd);
+
+    close(sockets[0]);
+    close(sockets[1]);
+}
@@ -0,0 +1,7 @@
+void detach_not_detached_on_start(void **state);
+void detach_socket_path_is_per_user(void **state);
+void detach_socket_path_prefers_runtime_dir(void **state);
+void detach_dir_must_be_private(void **state);
+void detach_peer_is_same_user(void **state);
+void detach_terminal_passed_over_socket(void **state);
+void detach_receive_needs_terminal(void **state);
@@ -0,0 +1,153 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "tools/gapbuffer.h"
+
+void gapbuf_new_is_empty(void **state)
+{
+    GapBuffer buf = gapbuf_new();
+    char *contents = gapbuf_contents(buf);
+
+    assert_string_equal("", contents);
+    assert_int_equal(0, gapbuf_length(buf));
+    assert_int_equal(0, gapbuf_cursor(buf));
+    assert_int_equal(0, gapbuf_first_char(buf));
+
+    free(contents);
+    gapbuf_free(buf);
+}
+
+void gapbuf_insert_at_end(void **state)
+{
+    GapBuffer buf = gapbuf_new();
+    gapbuf_insert(buf, "Hello", -1);
+    gapbuf_insert(buf, " world", -1);
+    char *contents = gapbuf_contents(buf);
+
+    assert_string_equal("Hello world", contents);
+    assert_int_equal(11, gapbuf_cursor(buf));
+    assert_string_equal("", gapbuf_after_cursor(buf));
+
+    free(contents);
+    gapbuf_free(buf);
+}
+
+void gapbuf_insert_in_middle(void **state)
+{
+    GapBuffer buf = gapbuf_new();
+    gapbuf_set(buf, "Hello world");
+    gapbuf_set_cursor(buf, 5);
+    gapbuf_insert(buf, " there", -1);
+    char *contents = gapbuf_contents(buf);
+
+    assert_string_equal("Hello there world", contents);
+    assert_int_equal(11, gapbuf_cursor(buf));
+    assert_string_equal(" world", gapbuf_after_cursor(buf));
+    assert_int_equal('H', gapbuf_first_char(buf));
+
+    free(contents);
+    gapbuf_free(buf);
+}
+
+void gapbuf_delete_either_side_of_cursor(void **state)
+{
+    GapBuffer buf = gapbuf_new();
+    gapbuf_set(buf, "abcd");
+    gapbuf_set_cursor(buf, 2);
+
+    assert_true(gapbuf_delete_prev(buf));
+    assert_true(gapbuf_delete_next(buf));
+    char *contents = gapbuf_contents(buf);
+
+    assert_string_equal("ad", contents);
+    assert_int_equal(1, gapbuf_cursor(buf));
+    assert_int_equal(2, gapbuf_length(buf));
+
+    free(contents);
+    gapbuf_free(buf);
+}
+
+void gapbuf_delete_at_ends_does_nothing(void **state)
+{
+    GapBuffer buf = gapbuf_new();
+    gapbuf_set(buf, "ab");
+
+    assert_false(gapbuf_delete_next(buf));
+    gapbuf_set_cursor(buf, 0);
+    assert_int_equal('a', gapbuf_first_char(buf));
+    assert_false(gapbuf_delete_prev(buf));
+    assert_false(gapbuf_left(buf));
+    assert_int_equal(2, gapbuf_length(buf));
+
+    gapbuf_free(buf);
+}
+
+void gapbuf_counts_code_points_and_columns(void **state)
+{
+    GapBuffer buf = gapbuf_new();
+    gapbuf_set(buf, "a\xc3\xa9\xe4\xbd\xa0z");
+
+    assert_int_equal(4, gapbuf_length(buf));
+    assert_int_equal(5, gapbuf_width(buf));
+    assert_int_equal(7, gapbuf_bytes(buf));
+
+    gapbuf_left(buf);
+    assert_int_equal(3, gapbuf_cursor(buf));
+    assert_int_equal(4, gapbuf_cursor_col(buf));
+
+    gapbuf_left(buf);
+    assert_int_equal(2, gapbuf_cursor(buf));
+    assert_int_equal(2, gapbuf_cursor_col(buf));
+    assert_int_equal(0x4f60, gapbuf_char_after(buf));
+    assert_int_equal(0xe9, gapbuf_char_before(buf));
+
+    gapbuf_delete_prev(buf);
+    assert_int_equal(4, gapbuf_width(buf));
+    assert_string_equal("\xe4\xbd\xa0z", gapbuf_after_cursor(buf));
+
+    gapbuf_free(buf);
+}
+
+void gapbuf_grows_past_initial_size(void **state)
+{
+    GapBuffer buf = gapbuf_new();
+    GString *expected = g_string_new("");
+    int i;
+    for (i = 0; i < 5000; i++) {
+        gapbuf_insert(buf, "x", 1);
+        g_string_append_c(expected, 'x');
+    }
+    gapbuf_set_cursor(buf, 2500);
+    gapbuf_insert(buf, "\n", 1);
+    g_string_insert_c(expected, 2500, '\n');
+    char *contents = gapbuf_contents(buf);
+
+    assert_string_equal(expected->str, contents);
+    assert_int_equal(5001, gapbuf_length(buf));
+    assert_int_equal(2501, gapbuf_cursor(buf));
+
+    free(contents);
+    g_string_free(expected, TRUE);
+    gapbuf_free(buf);
+}
+
+void gapbuf_clear_empties_buffer(void **state)
+{
+    GapBuffer buf = gapbuf_new();
+    gapbuf_set(buf, "Hello");
+    gapbuf_set_cursor(buf, 2);
+    gapbuf_clear(buf);
+    char *contents = gapbuf_contents(buf);
+
+    assert_string_equal("", contents);
+    assert_int_equal(0, gapbuf_width(buf));
+    assert_int_equal(0, gapbuf_cursor_col(buf));
+
+    free(contents);
+    gapbuf_free(buf);
+}
@@ -0,0 +1,8 @@
+void gapbuf_new_is_empty(void **state);
+void gapbuf_insert_at_end(void **state);
+void gapbuf_insert_in_middle(void **state);
+void gapbuf_delete_either_side_of_cursor(void **state);
+void gapbuf_delete_at_ends_does_nothing(void **state);
+void gapbuf_counts_code_points_and_columns(void **state);
+void gapbuf_grows_past_initial_size(void **state);
+void gapbuf_clear_empties_buffer(void **state);
@@ -0,0 +1,118 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "tools/highlight.h"
+
+void no_patterns_matches_nothing(void **state)
+{
+    Highlighter highlighter = highlighter_new();
+
+    assert_false(highlighter_matches(highlighter, "hello there"));
+
+    highlighter_free(highlighter);
+}
+
+void matches_word_anywhere(void **state)
+{
+    Highlighter highlighter = highlighter_new();
+    highlighter_add_word(highlighter, "bob");
+
+    assert_true(highlighter_matches(highlighter, "hey bobby, how are you?"));
+
+    highlighter_free(highlighter);
+}
+
+void does_not_match_missing_word(void **state)
+{
+    Highlighter highlighter = highlighter_new();
+    highlighter_add_word(highlighter, "bob");
+    highlighter_add_word(highlighter, "profanity");
+
+    assert_false(highlighter_matches(highlighter, "hey bo, profane words"));
+
+    highlighter_free(highlighter);
+}
+
+void matches_ignoring_case(void **state)
+{
+    Highlighter highlighter = highlighter_new();
+    highlighter_add_word(highlighter, "Profanity");
+
+    assert_true(highlighter_matches(highlighter, "anyone using PROFANITY here?"));
+
+    highlighter_free(highlighter);
+}
+
+void matches_non_ascii_ignoring_case(void **state)
+{
+    Highlighter highlighter = highlighter_new();
+    highlighter_add_word(highlighter, "ärger");
+
+    assert_true(highlighter_matches(highlighter, "so viel ÄRGER heute"));
+
+    highlighter_free(highlighter);
+}
+
+void matches_overlapping_words(void **state)
+{
+    Highlighter highlighter = highlighter_new();
+    highlighter_add_word(highlighter, "he");
+    highlighter_add_word(highlighter, "she");
+    highlighter_add_word(highlighter, "hers");
+
+    assert_true(highlighter_matches(highlighter, "ushers"));
+
+    highlighter_free(highlighter);
+}
+
+void matches_word_that_is_suffix_of_prefix(void **state)
+{
+    Highlighter highlighter = highlighter_new();
+    highlighter_add_word(highlighter, "abcd");
+    highlighter_add_word(highlighter, "bc");
+
+    assert_true(highlighter_matches(highlighter, "xabcx"));
+
+    highlighter_free(highlighter);
+}
+
+void matches_word_added_after_match(void **state)
+{
+    Highlighter highlighter = highlighter_new();
+    highlighter_add_word(highlighter, "bob");
+    assert_false(highlighter_matches(highlighter, "hi mike"));
+
+    highlighter_add_word(highlighter, "mike");
+
+    assert_true(highlighter_matches(highlighter, "hi mike"));
+
+    highlighter_free(highlighter);
+}
+
+void matches_regex_entry(void **state)
+{
+    Highlighter highlighter = highlighter_new();
+    highlighter_add_entry(highlighter, "/deploy(ed|ing)/");
+
+    assert_true(highlighter_matches(highlighter, "Deployed to production"));
+    assert_false(highlighter_matches(highlighter, "deploy tomorrow"));
+
+    highlighter_free(highlighter);
+}
+
+void invalid_regex_not_added(void **state)
+{
+    Highlighter highlighter = highlighter_new();
+
+    gboolean result = highlighter_add_regex(highlighter, "deploy(");
+
+    assert_false(result);
+    assert_false(highlighter_matches(highlighter, "deploy("));
+
+    highlighter_free(highlighter);
+}
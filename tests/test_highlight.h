@@ -0,0 +1,10 @@
+void no_patterns_matches_nothing(void **state);
+void matches_word_anywhere(void **state);
+void does_not_match_missing_word(void **state);
+void matches_ignoring_case(void **state);
+void matches_non_ascii_ignoring_case(void **state);
+void matches_overlapping_words(void **state);
+void matches_word_that_is_suffix_of_prefix(void **state);
+void matches_word_added_after_match(void **state);
+void matches_regex_entry(void **state);
+void invalid_regex_not_added(void **state);
@@ -3,6 +3,9 @@
 #include <setjmp.h>
 #include <cmocka.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
 
 #include "tools/history.h"
 
@@ -217,3 +220,158 @@ void start_session_add_new_submit_previous(void **state)
 
     history_append(history, item3);
 }
+
+void search_returns_most_recent_with_prefix(void **state)
+{
+    History history = history_new(10);
+    history_append(history, "/msg bob hi");
+    history_append(history, "hello");
+    history_append(history, "/msg alice hi");
+
+    gint64 position = HISTORY_SEARCH_NEWEST;
+    char *item = history_search(history, "/msg", &position);
+    assert_string_equal("/msg alice hi", item);
+
+    free(item);
+    history_free(history);
+}
+
+void search_again_returns_older_match(void **state)
+{
+    History history = history_new(10);
+    history_append(history, "/msg bob hi");
+    history_append(history, "hello");
+    history_append(history, "/msg alice hi");
+
+    gint64 position = HISTORY_SEARCH_NEWEST;
+    char *item1 = history_search(history, "/msg", &position);
+    char *item2 = history_search(history, "/msg", &position);
+    char *item3 = history_search(history, "/msg", &position);
+    assert_string_equal("/msg alice hi", item1);
+    assert_string_equal("/msg bob hi", item2);
+    assert_null(item3);
+
+    free(item1);
+    free(item2);
+    history_free(history);
+}
+
+void search_skips_repeated_items(void **state)
+{
+    History history = history_new(10);
+    history_append(history, "/who");
+    history_append(history, "/wins");
+    history_append(history, "/who");
+
+    gint64 position = HISTORY_SEARCH_NEWEST;
+    char *item1 = history_search(history, "/w", &position);
+    char *item2 = history_search(history, "/w", &position);
+    char *item3 = history_search(history, "/w", &position);
+    assert_string_equal("/who", item1);
+    assert_string_equal("/wins", item2);
+    assert_null(item3);
+
+    free(item1);
+    free(item2);
+    history_free(history);
+}
+
+void search_does_not_find_removed_items(void **state)
+{
+    History history = history_new(2);
+    history_append(history, "first");
+    history_append(history, "second");
+    history_append(history, "third");
+
+    gint64 position = HISTORY_SEARCH_NEWEST;
+    char *item = history_search(history, "first", &position);
+    assert_null(item);
+
+    history_free(history);
+}
+
+void history_file_restores_items(void **state)
+{
+    gchar *filename = g_build_filename(g_get_tmp_dir(), "prof_test_inputhistory", NULL);
+    remove(filename);
+
+    History history1 = history_new(10);
+    history_set_file(history1, filename);
+    history_append(history1, "one");
+    history_append(history1, "two");
+    history_free(history1);
+
+    History history2 = history_new(10);
+    history_set_file(history2, filename);
+    char *item1 = history_previous(history2, NULL);
+    char *item2 = history_previous(history2, item1);
+    assert_string_equal("two", item1);
+    assert_string_equal("one", item2);
+
+    free(item1);
+    free(item2);
+    history_free(history2);
+    remove(filename);
+    g_free(filename);
+}
+
+static gboolean
+_save_unless_secret(const char * const item)
+{
+    return strncmp(item, "secret", 6) != 0;
+}
+
+void history_file_skips_filtered_items(void **state)
+{
+    gchar *filename = g_build_filename(g_get_tmp_dir(), "prof_test_inputhistory", NULL);
+    remove(filename);
+
+    History history1 = history_new(10);
+    history_set_file(history1, filename);
+    history_set_save_filter(history1, _save_unless_secret);
+    history_append(history1, "one");
+    history_append(history1, "secret stuff");
+    char *in_memory = history_previous(history1, NULL);
+    assert_string_equal("secret stuff", in_memory);
+    free(in_memory);
+    history_free(history1);
+
+    History history2 = history_new(10);
+    history_set_file(history2, filename);
+    char *item1 = history_previous(history2, NULL);
+    char *item2 = history_previous(history2, item1);
+    assert_string_equal("one", item1);
+    assert_string_equal("one", item2);
+
+    free(item1);
+    free(item2);
+    history_free(history2);
+    remove(filename);
+    g_free(filename);
+}
+
+void history_file_set_again_does_not_reload(void **state)
+{
+    gchar *filename = g_build_filename(g_get_tmp_dir(), "prof_test_inputhistory", NULL);
+    remove(filename);
+
+    History history1 = history_new(10);
+    history_set_file(history1, filename);
+    history_append(history1, "one");
+    history_free(history1);
+
+    History history2 = history_new(10);
+    history_set_file(history2, filename);
+    history_append(history2, "two");
+    history_set_file(history2, filename);
+    char *item1 = history_previous(history2, NULL);
+    char *item2 = history_previous(history2, item1);
+    assert_string_equal("two", item1);
+    assert_string_equal("one", item2);
+
+    free(item1);
+    free(item2);
+    history_free(history2);
+    remove(filename);
+    g_free(filename);
+}
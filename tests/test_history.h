@@ -11,3 +11,10 @@ void navigate_then_append_new(void **state);
 void edit_item_mid_history(void **state);
 void edit_previous_and_append(void **state);
 void start_session_add_new_submit_previous(void **state);
+void search_returns_most_recent_with_prefix(void **state);
+void search_again_returns_older_match(void **state);
+void search_skips_repeated_items(void **state);
+void search_does_not_find_removed_items(void **state);
+void history_file_restores_items(void **state);
+void history_file_skips_filtered_items(void **state);
+void history_file_set_again_does_not_reload(void **state);
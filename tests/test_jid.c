@@ -182,4 +182,37 @@ void returns_barejid_when_fulljid_not_exists(void **state)
     char *result = jid_fulljid_or_barejid(jid);
 
     assert_string_equal("localpart@domainpart", result);
-}
\ No newline at end of file
+}
+
+void intern_returns_same_jid_for_same_string(void **state)
+{
+    Jid *first = jid_intern("bob@server.org/laptop");
+    Jid *second = jid_intern("bob@server.org/laptop");
+
+    assert_ptr_equal(first, second);
+    assert_string_equal("bob@server.org", second->barejid);
+    assert_string_equal("laptop", second->resourcepart);
+
+    jid_release(first);
+    jid_release(second);
+    jid_intern_clear();
+}
+
+void intern_returns_null_for_invalid_jid(void **state)
+{
+    Jid *jid = jid_intern("/resource");
+
+    assert_null(jid);
+
+    jid_intern_clear();
+}
+
+void interned_jid_outlives_clear_while_referenced(void **state)
+{
+    Jid *jid = jid_intern("bob@server.org");
+
+    jid_intern_clear();
+
+    assert_string_equal("bob@server.org", jid->barejid);
+    jid_release(jid);
+}
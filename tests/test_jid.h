@@ -23,3 +23,6 @@ void create_with_at_and_slash_in_resource(void **state);
 void create_full_with_trailing_slash(void **state);
 void returns_fulljid_when_exists(void **state);
 void returns_barejid_when_fulljid_not_exists(void **state);
+void intern_returns_same_jid_for_same_string(void **state);
+void intern_returns_null_for_invalid_jid(void **state);
+void interned_jid_outlives_clear_while_referenced(void **state);
@@ -0,0 +1,340 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include "common.h"
+#include "xmpp/mam.h"
+
+#define ARCHIVE "me@server.org"
+#define STAND_IN_SIZE 2000
+
+typedef struct query_t {
+    char *archive;
+    char *after;
+    int max;
+} Query;
+
+// queries waiting for the stand in archive to answer them
+static GQueue *queries;
+
+// ids delivered, in delivery order, and the number of batches
+static GPtrArray *delivered;
+static int batches;
+
+static int archive_size;
+
+static void
+_stub_query(const char * const archive, const char * const after, int max)
+{
+    Query *query = malloc(sizeof(Query));
+    query->archive = strdup(archive);
+    query->after = after ? strdup(after) : NULL;
+    query->max = max;
+    g_queue_push_tail(queries, query);
+}
+
+static void
+_stub_deliver(const char * const archive, GList *messages)
+{
+    batches++;
+    GList *curr = messages;
+    while (curr != NULL) {
+        ArchivedMessage *message = curr->data;
+        g_ptr_array_add(delivered, strdup(message->id));
+        curr = g_list_next(curr);
+    }
+}
+
+static void
+_free_query(Query *query)
+{
+    free(query->archive);
+    free(query->after);
+    free(query);
+}
+
+// answer queries as a server holding archive_size messages id0, id1, ...
+static void
+_serve(void)
+{
+    Query *query = NULL;
+    while ((query = g_queue_pop_head(queries)) != NULL) {
+        int start;
+        if (query->after) {
+            start = atoi(query->after + 2) + 1;
+        } else {
+            start = archive_size - query->max;
+        }
+        if (start < 0) {
+            start = 0;
+        }
+
+        int end = start + query->max;
+        if (end > archive_size) {
+            end = archive_size;
+        }
+
+        char id[32];
+        char message_id[32];
+        char body[32];
+        int i;
+        for (i = start; i < end; i++) {
+            GTimeVal tv_stamp = { 1000000 + i, 0 };
+            snprintf(id, sizeof(id), "id%d", i);
+            snprintf(message_id, sizeof(message_id), "msg%d", i);
+            snprintf(body, sizeof(body), "message %d", i);
+            mam_result(query->archive, id, message_id, "friend@server.org", body, &tv_stamp, FALSE);
+        }
+
+        snprintf(id, sizeof(id), "id%d", end - 1);
+        mam_page_complete(query->archive, end > start ? id : NULL, end == archive_size);
+        _free_query(query);
+    }
+}
+
+void mam_before_test(void **state)
+{
+    queries = g_queue_new();
+    delivered = g_ptr_array_new_with_free_func(free);
+    batches = 0;
+    archive_size = STAND_IN_SIZE;
+    mam_init(_stub_query, _stub_deliver);
+}
+
+void mam_after_test(void **state)
+{
+    mam_close();
+    g_queue_free_full(queries, (GDestroyNotify)_free_query);
+    g_ptr_array_free(delivered, TRUE);
+}
+
+void mam_unknown_archive_only_fetches_newest_id(void **state)
+{
+    mam_catch_up(ARCHIVE);
+
+    Query *query = g_queue_peek_head(queries);
+    assert_null(query->after);
+    assert_int_equal(1, query->max);
+
+    _serve();
+
+    assert_int_equal(0, delivered->len);
+    assert_string_equal("id1999", mam_last_id(ARCHIVE));
+    assert_false(mam_catching_up(ARCHIVE));
+}
+
+void mam_pages_forward_from_last_id(void **state)
+{
+    archive_size = 500;
+    mam_seen(ARCHIVE, "id99");
+
+    mam_catch_up(ARCHIVE);
+    _serve();
+
+    assert_int_equal(400, delivered->len);
+    assert_int_equal(400 / MAM_PAGE_SIZE, batches);
+    int i;
+    for (i = 0; i < 400; i++) {
+        char id[32];
+        snprintf(id, sizeof(id), "id%d", i + 100);
+        assert_string_equal(id, g_ptr_array_index(delivered, i));
+    }
+    assert_string_equal("id499", mam_last_id(ARCHIVE));
+    assert_false(mam_catching_up(ARCHIVE));
+}
+
+void mam_stops_after_max_pages_and_resumes(void **state)
+{
+    mam_seen(ARCHIVE, "id0");
+
+    mam_catch_up(ARCHIVE);
+    _serve();
+
+    assert_int_equal(MAM_MAX_PAGES * MAM_PAGE_SIZE, delivered->len);
+    assert_false(mam_catching_up(ARCHIVE));
+
+    mam_catch_up(ARCHIVE);
+    _serve();
+
+    assert_int_equal(STAND_IN_SIZE - 1, delivered->len);
+    assert_string_equal("id1", g_ptr_array_index(delivered, 0));
+    assert_string_equal("id1999", g_ptr_array_index(delivered, STAND_IN_SIZE - 2));
+}
+
+void mam_page_delivered_in_timestamp_order(void **state)
+{
+    mam_seen(ARCHIVE, "start");
+    mam_catch_up(ARCHIVE);
+
+    GTimeVal late = { 3000, 0 };
+    GTimeVal early = { 1000, 0 };
+    GTimeVal middle = { 2000, 0 };
+    mam_result(ARCHIVE, "a", NULL, "friend@server.org", "late", &late, FALSE);
+    mam_result(ARCHIVE, "b", NULL, "friend@server.org", "early", &early, FALSE);
+    mam_result(ARCHIVE, "c", NULL, "friend@server.org", "middle", &middle, TRUE);
+    mam_page_complete(ARCHIVE, "c", TRUE);
+
+    assert_int_equal(1, batches);
+    assert_string_equal("b", g_ptr_array_index(delivered, 0));
+    assert_string_equal("c", g_ptr_array_index(delivered, 1));
+    assert_string_equal("a", g_ptr_array_index(delivered, 2));
+    assert_string_equal("c", mam_last_id(ARCHIVE));
+}
+
+void mam_failed_page_keeps_position(void **state)
+{
+    mam_seen(ARCHIVE, "id5");
+    mam_catch_up(ARCHIVE);
+
+    GTimeVal tv_stamp = { 1000, 0 };
+    mam_result(ARCHIVE, "id6", NULL, "friend@server.org", "hello", &tv_stamp, FALSE);
+    mam_page_failed(ARCHIVE);
+
+    assert_int_equal(0, delivered->len);
+    assert_string_equal("id5", mam_last_id(ARCHIVE));
+    assert_false(mam_catching_up(ARCHIVE));
+}
+
+void mam_results_ignored_when_not_catching_up(void **state)
+{
+    mam_seen(ARCHIVE, "id5");
+
+    GTimeVal tv_stamp = { 1000, 0 };
+    mam_result(ARCHIVE, "id6", NULL, "friend@server.org", "hello", &tv_stamp, FALSE);
+    mam_page_complete(ARCHIVE, "id6", TRUE);
+
+    assert_int_equal(0, delivered->len);
+    assert_string_equal("id5", mam_last_id(ARCHIVE));
+}
+
+void mam_live_id_ignored_while_catching_up(void **state)
+{
+    mam_seen(ARCHIVE, "id149");
+    mam_catch_up(ARCHIVE);
+
+    mam_seen(ARCHIVE, "live");
+    mam_page_failed(ARCHIVE);
+
+    assert_string_equal("id149", mam_last_id(ARCHIVE));
+}
+
+void mam_positions_restored_from_file(void **state)
+{
+    gchar *filename = g_build_filename(g_get_tmp_dir(), "prof_test_archive.positions", NULL);
+    remove(filename);
+
+    mam_load(filename);
+    mam_seen(ARCHIVE, "id42");
+    mam_seen("room@conference.server.org", "room-id");
+    mam_save();
+
+    mam_load(NULL);
+    assert_null(mam_last_id(ARCHIVE));
+
+    mam_load(filename);
+    assert_string_equal("id42", mam_last_id(ARCHIVE));
+    assert_string_equal("room-id", mam_last_id("room@conference.server.org"));
+
+    remove(filename);
+    g_free(filename);
+}
+
+void mam_live_id_ignored_after_max_pages(void **state)
+{
+    mam_seen(ARCHIVE, "id0");
+
+    mam_catch_up(ARCHIVE);
+    _serve();
+    assert_int_equal(MAM_MAX_PAGES * MAM_PAGE_SIZE, delivered->len);
+
+    mam_seen(ARCHIVE, "id1999");
+    assert_string_equal("id1000", mam_last_id(ARCHIVE));
+
+    mam_catch_up(ARCHIVE);
+    _serve();
+
+    // id1999 was shown live, it is not delivered again
+    assert_int_equal(STAND_IN_SIZE - 2, delivered->len);
+    assert_string_equal("id1998", g_ptr_array_index(delivered, STAND_IN_SIZE - 3));
+    assert_string_equal("id1001", g_ptr_array_index(delivered, MAM_MAX_PAGES * MAM_PAGE_SIZE));
+    assert_string_equal("id1999", mam_last_id(ARCHIVE));
+
+    mam_seen(ARCHIVE, "id2000");
+    assert_string_equal("id2000", mam_last_id(ARCHIVE));
+}
+
+void mam_truncated_archive_restored_from_file(void **state)
+{
+    gchar *filename = g_build_filename(g_get_tmp_dir(), "prof_test_archive.positions", NULL);
+    remove(filename);
+
+    mam_load(filename);
+    mam_seen(ARCHIVE, "id0");
+    mam_catch_up(ARCHIVE);
+    _serve();
+    mam_save();
+
+    mam_load(filename);
+    mam_seen(ARCHIVE, "id1999");
+    assert_string_equal("id1000", mam_last_id(ARCHIVE));
+
+    remove(filename);
+    g_free(filename);
+}
+
+static gboolean
+_delivered(const char * const id)
+{
+    guint i;
+    for (i = 0; i < delivered->len; i++) {
+        if (g_strcmp0(id, g_ptr_array_index(delivered, i)) == 0) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+void mam_live_and_sent_messages_not_delivered_again(void **state)
+{
+    archive_size = 500;
+    mam_seen(ARCHIVE, "id99");
+    mam_catch_up(ARCHIVE);
+
+    mam_seen(ARCHIVE, "id300");
+    mam_sent(ARCHIVE, "msg400");
+    _serve();
+
+    assert_int_equal(398, delivered->len);
+    assert_false(_delivered("id300"));
+    assert_false(_delivered("id400"));
+    assert_string_equal("id499", mam_last_id(ARCHIVE));
+}
+
+void mam_sent_messages_not_delivered_after_reconnect(void **state)
+{
+    gchar *filename = g_build_filename(g_get_tmp_dir(), "prof_test_archive.positions", NULL);
+    remove(filename);
+
+    archive_size = 200;
+    mam_load(filename);
+    mam_seen(ARCHIVE, "id99");
+    mam_sent(ARCHIVE, "msg150");
+    mam_save();
+
+    mam_load(filename);
+    mam_catch_up(ARCHIVE);
+    _serve();
+
+    assert_int_equal(99, delivered->len);
+    assert_false(_delivered("id150"));
+    assert_string_equal("id199", mam_last_id(ARCHIVE));
+
+    remove(filename);
+    g_free(filename);
+}
@@ -0,0 +1,14 @@
+void mam_before_test(void **state);
+void mam_after_test(void **state);
+void mam_unknown_archive_only_fetches_newest_id(void **state);
+void mam_pages_forward_from_last_id(void **state);
+void mam_stops_after_max_pages_and_resumes(void **state);
+void mam_page_delivered_in_timestamp_order(void **state);
+void mam_failed_page_keeps_position(void **state);
+void mam_results_ignored_when_not_catching_up(void **state);
+void mam_live_id_ignored_while_catching_up(void **state);
+void mam_positions_restored_from_file(void **state);
+void mam_live_id_ignored_after_max_pages(void **state);
+void mam_truncated_archive_restored_from_file(void **state);
+void mam_live_and_sent_messages_not_delivered_again(void **state);
+void mam_sent_messages_not_delivered_after_reconnect(void **state);
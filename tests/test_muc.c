@@ -76,3 +76,46 @@ void test_muc_active(void **state)
 
     assert_true(room_is_active);
 }
+
+void test_muc_roster_staged_until_join_complete(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    muc_roster_add(room, "alice", "alice@server.org/laptop", "participant", "member", "online", NULL);
+    muc_roster_add(room, "bob", NULL, "participant", "member", "online", NULL);
+
+    assert_null(muc_roster_item(room, "alice"));
+
+    muc_roster_set_complete(room);
+
+    assert_non_null(muc_roster_item(room, "alice"));
+    assert_non_null(muc_roster_item(room, "bob"));
+    assert_true(autocomplete_contains(muc_roster_ac(room), "alice"));
+    assert_true(autocomplete_contains(muc_roster_jid_ac(room), "alice@server.org"));
+}
+
+void test_muc_roster_remove_while_joining(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    muc_roster_add(room, "alice", NULL, "participant", "member", "online", NULL);
+    muc_roster_remove(room, "alice");
+    muc_roster_set_complete(room);
+
+    assert_null(muc_roster_item(room, "alice"));
+    assert_false(autocomplete_contains(muc_roster_ac(room), "alice"));
+}
+
+void test_muc_roster_later_presence_while_joining_wins(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    muc_roster_add(room, "alice", NULL, "participant", "member", "online", NULL);
+    muc_roster_add(room, "alice", NULL, "participant", "member", "away", "lunch");
+    muc_roster_set_complete(room);
+
+    Occupant *occupant = muc_roster_item(room, "alice");
+    assert_int_equal(RESOURCE_AWAY, occupant->presence);
+    assert_string_equal("lunch", occupant->status);
+    assert_int_equal(1, autocomplete_length(muc_roster_ac(room)));
+}
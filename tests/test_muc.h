@@ -7,3 +7,6 @@ void test_muc_invites_count_0(void **state);
 void test_muc_invites_count_5(void **state);
 void test_muc_room_is_not_active(void **state);
 void test_muc_active(void **state);
+void test_muc_roster_staged_until_join_complete(void **state);
+void test_muc_roster_remove_while_joining(void **state);
+void test_muc_roster_later_presence_while_joining_wins(void **state);
@@ -0,0 +1,107 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <glib.h>
+
+#include "muc_history.h"
+
+#define ROOM "room@conference.server.org"
+
+static GTimeVal
+_at(glong seconds)
+{
+    GTimeVal tv;
+    tv.tv_sec = seconds;
+    tv.tv_usec = 0;
+    return tv;
+}
+
+void muc_history_before_test(void **state)
+{
+    muc_history_init();
+}
+
+void muc_history_after_test(void **state)
+{
+    muc_history_close();
+}
+
+void no_since_for_unseen_room(void **state)
+{
+    GTimeVal since;
+    assert_false(muc_history_since(ROOM, &since));
+}
+
+void since_goes_back_from_latest_seen(void **state)
+{
+    GTimeVal first = _at(100000);
+    GTimeVal second = _at(100500);
+    muc_history_seen(ROOM, NULL, "bob", "hello", &second);
+    muc_history_seen(ROOM, NULL, "bob", "earlier", &first);
+
+    GTimeVal since;
+    assert_true(muc_history_since(ROOM, &since));
+    assert_int_equal(100500 - MUC_HISTORY_TOLERANCE, since.tv_sec);
+}
+
+void seen_line_is_duplicate_at_its_stamp(void **state)
+{
+    GTimeVal seen = _at(100000);
+    muc_history_seen(ROOM, NULL, "bob", "hello", &seen);
+
+    assert_true(muc_history_is_duplicate(ROOM, NULL, "bob", "hello", &seen));
+}
+
+void different_line_is_not_duplicate(void **state)
+{
+    GTimeVal seen = _at(100000);
+    muc_history_seen(ROOM, NULL, "bob", "hello", &seen);
+
+    assert_false(muc_history_is_duplicate(ROOM, NULL, "alice", "hello", &seen));
+    assert_false(muc_history_is_duplicate(ROOM, NULL, "bob", "goodbye", &seen));
+    assert_false(muc_history_is_duplicate("other@conference.server.org", NULL, "bob", "hello", &seen));
+}
+
+void repeated_short_line_is_not_duplicate(void **state)
+{
+    GTimeVal seen = _at(100000);
+    GTimeVal repeated = _at(100000 + 30);
+    muc_history_seen(ROOM, NULL, "bob", "ok", &seen);
+
+    assert_false(muc_history_is_duplicate(ROOM, NULL, "bob", "ok", &repeated));
+}
+
+void live_line_matched_by_stanza_id(void **state)
+{
+    GTimeVal replayed = _at(100000);
+    muc_history_seen(ROOM, "room-id-1", "bob", "ok", NULL);
+
+    assert_true(muc_history_is_duplicate(ROOM, "room-id-1", "bob", "ok", &replayed));
+    assert_false(muc_history_is_duplicate(ROOM, "room-id-2", "bob", "ok", &replayed));
+}
+
+void seen_lines_restored_from_file(void **state)
+{
+    gchar *filename = g_build_filename(g_get_tmp_dir(), "prof_test_history.seen", NULL);
+    remove(filename);
+
+    GTimeVal seen = _at(100000);
+    muc_history_load(filename);
+    muc_history_seen(ROOM, NULL, "bob", "hello", &seen);
+    muc_history_save();
+
+    muc_history_init();
+    assert_false(muc_history_is_duplicate(ROOM, NULL, "bob", "hello", &seen));
+
+    muc_history_load(filename);
+    GTimeVal since;
+    assert_true(muc_history_is_duplicate(ROOM, NULL, "bob", "hello", &seen));
+    assert_true(muc_history_since(ROOM, &since));
+    assert_int_equal(100000 - MUC_HISTORY_TOLERANCE, since.tv_sec);
+
+    remove(filename);
+    g_free(filename);
+}
@@ -0,0 +1,9 @@
+void muc_history_before_test(void **state);
+void muc_history_after_test(void **state);
+void no_since_for_unseen_room(void **state);
+void since_goes_back_from_latest_seen(void **state);
+void seen_line_is_duplicate_at_its_stamp(void **state);
+void different_line_is_not_duplicate(void **state);
+void repeated_short_line_is_not_duplicate(void **state);
+void live_line_matched_by_stanza_id(void **state);
+void seen_lines_restored_from_file(void **state);
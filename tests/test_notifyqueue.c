@@ -0,0 +1,135 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "common.h"
+#include "ui/notifyqueue.h"
+
+#define SECOND G_TIME_SPAN_SECOND
+
+static GSList *sent;
+
+static void
+_stub_send(const char * const message, int timeout, const char * const category)
+{
+    sent = g_slist_append(sent, strdup(message));
+}
+
+void notifyqueue_before_test(void **state)
+{
+    sent = NULL;
+    notifyqueue_init(_stub_send);
+}
+
+void notifyqueue_after_test(void **state)
+{
+    notifyqueue_close();
+    g_slist_free_full(sent, free);
+    sent = NULL;
+}
+
+void single_notification_sent_unchanged(void **state)
+{
+    notifyqueue_add(2, "from bob (win 2)", "bob (win 2)\nhello", 10000, "incoming message", SECOND);
+
+    int res = notifyqueue_dispatch(SECOND, 0, SECOND);
+
+    assert_int_equal(1, res);
+    assert_int_equal(1, g_slist_length(sent));
+    assert_string_equal("bob (win 2)\nhello", sent->data);
+    assert_int_equal(0, notifyqueue_pending());
+}
+
+void notification_held_until_coalesce_period(void **state)
+{
+    notifyqueue_add(2, "from bob (win 2)", "bob (win 2)", 10000, "incoming message", SECOND);
+
+    int res = notifyqueue_dispatch(2 * SECOND, 5 * SECOND, SECOND);
+    assert_int_equal(0, res);
+    assert_int_equal(1, notifyqueue_pending());
+
+    res = notifyqueue_dispatch(6 * SECOND, 5 * SECOND, SECOND);
+    assert_int_equal(1, res);
+    assert_int_equal(0, notifyqueue_pending());
+}
+
+void same_window_notifications_merged(void **state)
+{
+    notifyqueue_add(3, "in room (win 3)", "mike in room (win 3)", 10000, "incoming message", SECOND);
+    notifyqueue_add(3, "in room (win 3)", "anna in room (win 3)", 10000, "incoming message", 2 * SECOND);
+    notifyqueue_add(3, "in room (win 3)", "mike in room (win 3)", 10000, "incoming message", 3 * SECOND);
+
+    assert_int_equal(1, notifyqueue_pending());
+
+    notifyqueue_dispatch(10 * SECOND, 5 * SECOND, SECOND);
+
+    assert_int_equal(1, g_slist_length(sent));
+    assert_string_equal("3 new messages in room (win 3)", sent->data);
+}
+
+void different_windows_not_merged(void **state)
+{
+    notifyqueue_add(2, "from bob (win 2)", "bob (win 2)", 10000, "incoming message", SECOND);
+    notifyqueue_add(3, "from anna (win 3)", "anna (win 3)", 10000, "incoming message", SECOND);
+
+    assert_int_equal(2, notifyqueue_pending());
+}
+
+void no_win_notifications_not_merged(void **state)
+{
+    notifyqueue_add(NOTIFY_NO_WIN, NULL, "Subscription request: \nbob", 10000, "Incoming message", SECOND);
+    notifyqueue_add(NOTIFY_NO_WIN, NULL, "Subscription request: \nanna", 10000, "Incoming message", SECOND);
+
+    assert_int_equal(2, notifyqueue_pending());
+
+    notifyqueue_dispatch(SECOND, 5 * SECOND, 0);
+
+    assert_int_equal(2, g_slist_length(sent));
+    assert_string_equal("Subscription request: \nbob", sent->data);
+    assert_string_equal("Subscription request: \nanna", sent->next->data);
+}
+
+void dispatch_rate_limited(void **state)
+{
+    notifyqueue_add(2, "from bob (win 2)", "bob (win 2)", 10000, "incoming message", SECOND);
+    notifyqueue_add(3, "from anna (win 3)", "anna (win 3)", 10000, "incoming message", SECOND);
+
+    int res = notifyqueue_dispatch(SECOND, 0, SECOND);
+    assert_int_equal(1, res);
+    assert_int_equal(1, notifyqueue_pending());
+
+    res = notifyqueue_dispatch(SECOND + SECOND / 2, 0, SECOND);
+    assert_int_equal(0, res);
+
+    res = notifyqueue_dispatch(2 * SECOND, 0, SECOND);
+    assert_int_equal(1, res);
+    assert_int_equal(2, g_slist_length(sent));
+    assert_string_equal("anna (win 3)", sent->next->data);
+}
+
+void transient_notification_replaced_by_newer(void **state)
+{
+    notifyqueue_add_transient("bob", "bob: typing...", 10000, "Incoming message", SECOND);
+    notifyqueue_add_transient("bob", "bob: typing...", 10000, "Incoming message", 2 * SECOND);
+    notifyqueue_add_transient("anna", "anna: typing...", 10000, "Incoming message", 2 * SECOND);
+
+    assert_int_equal(2, notifyqueue_pending());
+}
+
+void transient_notification_dropped_when_out_of_date(void **state)
+{
+    notifyqueue_add(2, "from bob (win 2)", "bob (win 2)", 10000, "incoming message", SECOND);
+    notifyqueue_add_transient("anna", "anna: typing...", 10000, "Incoming message", SECOND);
+
+    notifyqueue_dispatch(SECOND, 0, 20 * SECOND);
+    assert_int_equal(1, notifyqueue_pending());
+
+    int res = notifyqueue_dispatch(12 * SECOND, 0, 20 * SECOND);
+    assert_int_equal(0, res);
+    assert_int_equal(0, notifyqueue_pending());
+    assert_int_equal(1, g_slist_length(sent));
+}
@@ -0,0 +1,10 @@
+void notifyqueue_before_test(void **state);
+void notifyqueue_after_test(void **state);
+void single_notification_sent_unchanged(void **state);
+void notification_held_until_coalesce_period(void **state);
+void same_window_notifications_merged(void **state);
+void different_windows_not_merged(void **state);
+void no_win_notifications_not_merged(void **state);
+void dispatch_rate_limited(void **state);
+void transient_notification_replaced_by_newer(void **state);
+void transient_notification_dropped_when_out_of_date(void **state);
@@ -31,3 +31,39 @@ void statuses_muc_defaults_to_all(void **state)
     assert_non_null(setting);
     assert_string_equal("all", setting);
 }
+
+void highlights_empty_by_default(void **state)
+{
+    GList *highlights = prefs_get_highlights();
+
+    assert_null(highlights);
+}
+
+void add_highlight_adds_once(void **state)
+{
+    gboolean first = prefs_add_highlight("profanity");
+    gboolean second = prefs_add_highlight("profanity");
+
+    GList *highlights = prefs_get_highlights();
+    assert_true(first);
+    assert_false(second);
+    assert_int_equal(1, g_list_length(highlights));
+    assert_string_equal("profanity", highlights->data);
+    prefs_free_highlights(highlights);
+}
+
+void remove_highlight_removes(void **state)
+{
+    prefs_add_highlight("profanity");
+    prefs_add_highlight("/deploy(ed)?/");
+
+    gboolean removed = prefs_remove_highlight("profanity");
+    gboolean missing = prefs_remove_highlight("profanity");
+
+    GList *highlights = prefs_get_highlights();
+    assert_true(removed);
+    assert_false(missing);
+    assert_int_equal(1, g_list_length(highlights));
+    assert_string_equal("/deploy(ed)?/", highlights->data);
+    prefs_free_highlights(highlights);
+}
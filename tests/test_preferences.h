@@ -1,3 +1,6 @@
 void statuses_console_defaults_to_all(void **state);
 void statuses_chat_defaults_to_all(void **state);
 void statuses_muc_defaults_to_all(void **state);
+void highlights_empty_by_default(void **state);
+void add_highlight_adds_once(void **state);
+void remove_highlight_removes(void **state);
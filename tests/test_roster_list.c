@@ -6,7 +6,9 @@
 #include <cmocka.h>
 #include <stdlib.h>
 
+#include "common.h"
 #include "contact.h"
+#include "resource.h"
 #include "roster_list.h"
 
 void empty_list_when_none_added(void **state)
@@ -269,3 +271,82 @@ void find_twice_returns_first_when_two_match_and_reset(void **state)
     free(result2);
     roster_free();
 }
+
+void contacts_by_presence_offline_when_added(void **state)
+{
+    roster_init();
+    roster_add("James", NULL, NULL, NULL, FALSE);
+    roster_add("Bob", NULL, NULL, NULL, FALSE);
+
+    GSList *offline = roster_get_contacts_by_presence("offline");
+    GSList *online = roster_get_contacts_by_presence("online");
+    assert_int_equal(2, g_slist_length(offline));
+    assert_string_equal("Bob", p_contact_barejid(offline->data));
+    assert_null(online);
+
+    g_slist_free(offline);
+    roster_free();
+}
+
+void contacts_by_presence_follows_presence_changes(void **state)
+{
+    roster_init();
+    roster_add("James", NULL, NULL, NULL, FALSE);
+    roster_add("Bob", NULL, NULL, NULL, FALSE);
+    roster_update_presence("James", resource_new("laptop", RESOURCE_ONLINE, NULL, 10), NULL);
+    roster_update_presence("James", resource_new("phone", RESOURCE_AWAY, NULL, 5), NULL);
+
+    GSList *online = roster_get_contacts_by_presence("online");
+    GSList *away = roster_get_contacts_by_presence("away");
+    assert_int_equal(1, g_slist_length(online));
+    assert_string_equal("James", p_contact_barejid(online->data));
+    assert_null(away);
+    g_slist_free(online);
+
+    roster_contact_offline("James", "laptop", NULL);
+
+    online = roster_get_contacts_by_presence("online");
+    away = roster_get_contacts_by_presence("away");
+    GSList *offline = roster_get_contacts_by_presence("offline");
+    assert_null(online);
+    assert_int_equal(1, g_slist_length(away));
+    assert_int_equal(1, g_slist_length(offline));
+    assert_string_equal("Bob", p_contact_barejid(offline->data));
+
+    g_slist_free(away);
+    g_slist_free(offline);
+    roster_free();
+}
+
+void contacts_by_presence_excludes_removed(void **state)
+{
+    roster_init();
+    roster_add("James", NULL, NULL, NULL, FALSE);
+    roster_update_presence("James", resource_new("laptop", RESOURCE_DND, NULL, 10), NULL);
+
+    roster_remove("James", "James");
+
+    GSList *dnd = roster_get_contacts_by_presence("dnd");
+    assert_null(dnd);
+    roster_free();
+}
+
+void roster_lists_keep_contacts_apart(void **state)
+{
+    RosterList *work = roster_list_new();
+    RosterList *home = roster_list_new();
+
+    roster_list_use(work);
+    roster_add("James", NULL, NULL, NULL, FALSE);
+    roster_list_use(home);
+    roster_add("Bob", NULL, NULL, NULL, FALSE);
+
+    assert_null(roster_get_contact("James"));
+    assert_non_null(roster_get_contact("Bob"));
+    roster_list_use(work);
+    assert_non_null(roster_get_contact("James"));
+    assert_null(roster_get_contact("Bob"));
+
+    roster_list_free(home);
+    roster_list_free(work);
+}
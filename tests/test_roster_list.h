@@ -16,3 +16,7 @@ void find_on_empty_returns_null(void **state);
 void find_twice_returns_second_when_two_match(void **state);
 void find_five_times_finds_fifth(void **state);
 void find_twice_returns_first_when_two_match_and_reset(void **state);
+void contacts_by_presence_offline_when_added(void **state);
+void contacts_by_presence_follows_presence_changes(void **state);
+void contacts_by_presence_excludes_removed(void **state);
+void roster_lists_keep_contacts_apart(void **state);
@@ -0,0 +1,110 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "xmpp/sendqueue.h"
+
+static GString *sent;
+static int released;
+
+static void
+_stub_send(void *stanza)
+{
+    g_string_append(sent, stanza);
+}
+
+static void
+_stub_free(void *stanza)
+{
+    free(stanza);
+    released++;
+}
+
+void sendqueue_before_test(void **state)
+{
+    sent = g_string_new("");
+    released = 0;
+    sendqueue_init(_stub_send, _stub_free);
+}
+
+void sendqueue_after_test(void **state)
+{
+    sendqueue_close();
+    g_string_free(sent, TRUE);
+}
+
+void flush_sends_in_priority_order(void **state)
+{
+    sendqueue_add(SEND_PRIORITY_CHAT_STATE, "bob@server.org", strdup("c"));
+    sendqueue_add(SEND_PRIORITY_PRESENCE, NULL, strdup("p"));
+    sendqueue_add(SEND_PRIORITY_IQ, NULL, strdup("i"));
+    sendqueue_add(SEND_PRIORITY_MESSAGE, NULL, strdup("m"));
+
+    int count = sendqueue_flush();
+
+    assert_int_equal(4, count);
+    assert_string_equal("mipc", sent->str);
+    assert_int_equal(0, sendqueue_depth());
+}
+
+void flush_keeps_order_within_priority(void **state)
+{
+    sendqueue_add(SEND_PRIORITY_IQ, NULL, strdup("1"));
+    sendqueue_add(SEND_PRIORITY_IQ, NULL, strdup("2"));
+    sendqueue_add(SEND_PRIORITY_IQ, NULL, strdup("3"));
+
+    sendqueue_flush();
+
+    assert_string_equal("123", sent->str);
+}
+
+void newer_presence_replaces_queued(void **state)
+{
+    sendqueue_add(SEND_PRIORITY_PRESENCE, "room@conf.org/me", strdup("a"));
+    sendqueue_add(SEND_PRIORITY_PRESENCE, NULL, strdup("j"));
+    sendqueue_add(SEND_PRIORITY_PRESENCE, "room@conf.org/me", strdup("b"));
+
+    assert_int_equal(2, sendqueue_depth());
+    assert_int_equal(1, released);
+
+    sendqueue_flush();
+
+    assert_string_equal("bj", sent->str);
+}
+
+void chat_state_replaces_queued_for_same_key(void **state)
+{
+    sendqueue_add(SEND_PRIORITY_CHAT_STATE, "bob@server.org", strdup("c"));
+    sendqueue_add(SEND_PRIORITY_CHAT_STATE, "alice@server.org", strdup("a"));
+    sendqueue_add(SEND_PRIORITY_CHAT_STATE, "bob@server.org", strdup("p"));
+
+    sendqueue_flush();
+
+    assert_string_equal("pa", sent->str);
+}
+
+void message_drops_queued_chat_state(void **state)
+{
+    sendqueue_add(SEND_PRIORITY_CHAT_STATE, "bob@server.org", strdup("c"));
+    sendqueue_add(SEND_PRIORITY_CHAT_STATE, "alice@server.org", strdup("a"));
+    sendqueue_add(SEND_PRIORITY_MESSAGE, "bob@server.org", strdup("m"));
+
+    sendqueue_flush();
+
+    assert_string_equal("ma", sent->str);
+}
+
+void close_releases_unsent(void **state)
+{
+    sendqueue_add(SEND_PRIORITY_MESSAGE, NULL, strdup("m"));
+    sendqueue_add(SEND_PRIORITY_IQ, NULL, strdup("i"));
+
+    sendqueue_close();
+
+    assert_int_equal(2, released);
+    assert_string_equal("", sent->str);
+}
@@ -0,0 +1,8 @@
+void sendqueue_before_test(void **state);
+void sendqueue_after_test(void **state);
+void flush_sends_in_priority_order(void **state);
+void flush_keeps_order_within_priority(void **state);
+void newer_presence_replaces_queued(void **state);
+void chat_state_replaces_queued_for_same_key(void **state);
+void message_drops_queued_chat_state(void **state);
+void close_releases_unsent(void **state);
@@ -0,0 +1,128 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "tools/timerwheel.h"
+
+static GString *fired = NULL;
+static TimerWheel rescheduling_wheel = NULL;
+static gint64 rescheduling_now = 0;
+
+static void
+_record(void *data)
+{
+    g_string_append(fired, data);
+}
+
+static void
+_reschedule(void *data)
+{
+    g_string_append(fired, data);
+    timer_wheel_add(rescheduling_wheel, rescheduling_now, 1000, _record, "again");
+}
+
+void timerwheel_before_test(void **state)
+{
+    fired = g_string_new("");
+}
+
+void timerwheel_after_test(void **state)
+{
+    g_string_free(fired, TRUE);
+    fired = NULL;
+}
+
+void timer_fires_when_due(void **state)
+{
+    TimerWheel wheel = timer_wheel_new(0);
+    timer_wheel_add(wheel, 0, 1000, _record, "a");
+
+    timer_wheel_advance(wheel, 900);
+    assert_string_equal("", fired->str);
+
+    timer_wheel_advance(wheel, 1000);
+    assert_string_equal("a", fired->str);
+    assert_int_equal(0, timer_wheel_pending(wheel));
+
+    timer_wheel_free(wheel);
+}
+
+void cancelled_timer_does_not_fire(void **state)
+{
+    TimerWheel wheel = timer_wheel_new(0);
+    WheelTimer *timer = timer_wheel_add(wheel, 0, 1000, _record, "a");
+    timer_wheel_add(wheel, 0, 2000, _record, "b");
+
+    timer_wheel_cancel(wheel, timer);
+    timer_wheel_advance(wheel, 5000);
+
+    assert_string_equal("b", fired->str);
+
+    timer_wheel_free(wheel);
+}
+
+void timers_fire_in_deadline_order(void **state)
+{
+    TimerWheel wheel = timer_wheel_new(0);
+    timer_wheel_add(wheel, 0, 10 * 60 * 1000, _record, "c");
+    timer_wheel_add(wheel, 0, 100, _record, "a");
+    timer_wheel_add(wheel, 0, 30 * 1000, _record, "b");
+
+    timer_wheel_advance(wheel, 60 * 60 * 1000);
+
+    assert_string_equal("abc", fired->str);
+
+    timer_wheel_free(wheel);
+}
+
+void long_timer_fires_on_time(void **state)
+{
+    TimerWheel wheel = timer_wheel_new(123456);
+    timer_wheel_add(wheel, 123456, 7 * 60 * 1000, _record, "a");
+
+    timer_wheel_advance(wheel, 123456 + 7 * 60 * 1000 - 200);
+    assert_string_equal("", fired->str);
+
+    timer_wheel_advance(wheel, 123456 + 7 * 60 * 1000 + 100);
+    assert_string_equal("a", fired->str);
+
+    timer_wheel_free(wheel);
+}
+
+void timer_added_when_firing_fires_later(void **state)
+{
+    TimerWheel wheel = timer_wheel_new(0);
+    rescheduling_wheel = wheel;
+    timer_wheel_add(wheel, 0, 1000, _reschedule, "a");
+
+    rescheduling_now = 1500;
+    timer_wheel_advance(wheel, 1500);
+    assert_string_equal("a", fired->str);
+    assert_int_equal(1, timer_wheel_pending(wheel));
+
+    timer_wheel_advance(wheel, 2400);
+    assert_string_equal("a", fired->str);
+
+    timer_wheel_advance(wheel, 2500);
+    assert_string_equal("aagain", fired->str);
+
+    timer_wheel_free(wheel);
+}
+
+void timer_added_to_idle_wheel_counts_from_now(void **state)
+{
+    TimerWheel wheel = timer_wheel_new(0);
+    timer_wheel_add(wheel, 60 * 1000, 1000, _record, "a");
+
+    timer_wheel_advance(wheel, 60 * 1000 + 900);
+    assert_string_equal("", fired->str);
+
+    timer_wheel_advance(wheel, 60 * 1000 + 1000);
+    assert_string_equal("a", fired->str);
+
+    timer_wheel_free(wheel);
+}
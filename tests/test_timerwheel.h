@@ -0,0 +1,8 @@
+void timerwheel_before_test(void **state);
+void timerwheel_after_test(void **state);
+void timer_fires_when_due(void **state);
+void cancelled_timer_does_not_fire(void **state);
+void timers_fire_in_deadline_order(void **state);
+void long_timer_fires_on_time(void **state);
+void timer_added_when_firing_fires_later(void **state);
+void timer_added_to_idle_wheel_counts_from_now(void **state);
@@ -0,0 +1,160 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "common.h"
+#include "xmpp/xmltrace.h"
+
+void capture_ignored_when_not_started(void **state)
+{
+    xmltrace_capture("SENT: <presence/>");
+
+    GSList *entries = xmltrace_take();
+
+    assert_null(entries);
+}
+
+void capture_keeps_sent_and_recv(void **state)
+{
+    xmltrace_start();
+    xmltrace_capture("SENT: <presence/>");
+    xmltrace_capture("RECV: <message/>");
+
+    GSList *entries = xmltrace_take();
+
+    assert_int_equal(2, g_slist_length(entries));
+    XMLTraceEntry *first = entries->data;
+    XMLTraceEntry *second = entries->next->data;
+    assert_int_equal(XMLTRACE_DIR_SENT, first->dir);
+    assert_string_equal("<presence/>", first->raw);
+    assert_int_equal(XMLTRACE_DIR_RECV, second->dir);
+    assert_string_equal("<message/>", second->raw);
+
+    g_slist_free_full(entries, (GDestroyNotify)xmltrace_entry_free);
+    xmltrace_stop();
+}
+
+void capture_ignores_other_lines(void **state)
+{
+    xmltrace_start();
+    xmltrace_capture("Connecting via altdomain.");
+
+    GSList *entries = xmltrace_take();
+
+    assert_null(entries);
+    xmltrace_stop();
+}
+
+void capture_drops_oldest_over_limit(void **state)
+{
+    xmltrace_start();
+    char *big = malloc(XMLTRACE_MAX_BYTES / 2 + 7);
+    memcpy(big, "RECV: ", 6);
+    memset(big + 6, 'x', XMLTRACE_MAX_BYTES / 2);
+    big[XMLTRACE_MAX_BYTES / 2 + 6] = '\0';
+
+    xmltrace_capture(big);
+    xmltrace_capture(big);
+    xmltrace_capture(big);
+    free(big);
+
+    GSList *entries = xmltrace_take();
+
+    assert_int_equal(2, g_slist_length(entries));
+    assert_int_equal(1, xmltrace_take_dropped());
+    assert_int_equal(0, xmltrace_take_dropped());
+
+    g_slist_free_full(entries, (GDestroyNotify)xmltrace_entry_free);
+    xmltrace_stop();
+}
+
+void take_filters_by_dir(void **state)
+{
+    xmltrace_start();
+    xmltrace_set_dir_filter(XMLTRACE_DIR_RECV);
+    xmltrace_capture("SENT: <presence/>");
+    xmltrace_capture("RECV: <message/>");
+
+    GSList *entries = xmltrace_take();
+
+    assert_int_equal(1, g_slist_length(entries));
+    XMLTraceEntry *entry = entries->data;
+    assert_string_equal("<message/>", entry->raw);
+
+    g_slist_free_full(entries, (GDestroyNotify)xmltrace_entry_free);
+    xmltrace_clear_filters();
+    xmltrace_stop();
+}
+
+void take_filters_by_element(void **state)
+{
+    xmltrace_start();
+    xmltrace_set_element_filter("presence");
+    xmltrace_capture("RECV: <presence from='a@b'/>");
+    xmltrace_capture("RECV: <presenceother/>");
+    xmltrace_capture("RECV: <message><presence/></message>");
+
+    GSList *entries = xmltrace_take();
+
+    assert_int_equal(1, g_slist_length(entries));
+    XMLTraceEntry *entry = entries->data;
+    assert_string_equal("<presence from='a@b'/>", entry->raw);
+
+    g_slist_free_full(entries, (GDestroyNotify)xmltrace_entry_free);
+    xmltrace_clear_filters();
+    xmltrace_stop();
+}
+
+void take_filters_by_ns(void **state)
+{
+    xmltrace_start();
+    xmltrace_set_ns_filter("urn:xmpp:ping");
+    xmltrace_capture("RECV: <iq type=\"get\"><ping xmlns=\"urn:xmpp:ping\"/></iq>");
+    xmltrace_capture("RECV: <iq type=\"get\"><ping xmlns=\"urn:xmpp:ping2\"/></iq>");
+
+    GSList *entries = xmltrace_take();
+
+    assert_int_equal(1, g_slist_length(entries));
+
+    g_slist_free_full(entries, (GDestroyNotify)xmltrace_entry_free);
+    xmltrace_clear_filters();
+    xmltrace_stop();
+}
+
+void pretty_indents_children(void **state)
+{
+    GSList *lines = xmltrace_pretty("<iq type=\"result\"><query><item jid=\"a@b\"/></query></iq>");
+
+    assert_int_equal(5, g_slist_length(lines));
+    assert_string_equal("<iq type=\"result\">", g_slist_nth_data(lines, 0));
+    assert_string_equal("  <query>", g_slist_nth_data(lines, 1));
+    assert_string_equal("    <item jid=\"a@b\"/>", g_slist_nth_data(lines, 2));
+    assert_string_equal("  </query>", g_slist_nth_data(lines, 3));
+    assert_string_equal("</iq>", g_slist_nth_data(lines, 4));
+
+    g_slist_free_full(lines, g_free);
+}
+
+void pretty_keeps_text_inline(void **state)
+{
+    GSList *lines = xmltrace_pretty("<message><body>hello there</body></message>");
+
+    assert_int_equal(3, g_slist_length(lines));
+    assert_string_equal("  <body>hello there</body>", g_slist_nth_data(lines, 1));
+
+    g_slist_free_full(lines, g_free);
+}
+
+void pretty_handles_lone_open_bracket(void **state)
+{
+    GSList *lines = xmltrace_pretty("<");
+
+    assert_int_equal(1, g_slist_length(lines));
+    assert_string_equal("<", g_slist_nth_data(lines, 0));
+
+    g_slist_free_full(lines, g_free);
+}
@@ -0,0 +1,10 @@
+void capture_ignored_when_not_started(void **state);
+void capture_keeps_sent_and_recv(void **state);
+void capture_ignores_other_lines(void **state);
+void capture_drops_oldest_over_limit(void **state);
+void take_filters_by_dir(void **state);
+void take_filters_by_element(void **state);
+void take_filters_by_ns(void **state);
+void pretty_indents_children(void **state);
+void pretty_keeps_text_inline(void **state);
+void pretty_handles_lone_open_bracket(void **state);
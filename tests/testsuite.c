@@ -22,6 +22,8 @@
 #include "test_cmd_statuses.h"
 #include "test_cmd_otr.h"
 #include "test_history.h"
+#include "test_gapbuffer.h"
+#include "test_timerwheel.h"
 #include "test_jid.h"
 #include "test_parser.h"
 #include "test_roster_list.h"
@@ -31,10 +33,21 @@
 #include "test_cmd_bookmark.h"
 #include "test_cmd_join.h"
 #include "test_muc.h"
+#include "test_muc_history.h"
 #include "test_cmd_roster.h"
 #include "test_cmd_win.h"
 #include "test_cmd_disconnect.h"
 #include "test_form.h"
+#include "test_xmltrace.h"
+#include "test_notifyqueue.h"
+#include "test_capsqueue.h"
+#include "test_sendqueue.h"
+#include "test_csi.h"
+#include "test_mam.h"
+#include "test_compression.h"
+#include "test_detach.h"
+#include "test_highlight.h"
+#include "test_chat_message.h"
 
 int main(int argc, char* argv[]) {
     const UnitTest all_tests[] = {
@@ -107,6 +120,15 @@ int main(int argc, char* argv[]) {
         unit_test(add_two_same_adds_one),
         unit_test(add_two_same_updates),
 
+        unit_test(gapbuf_new_is_empty),
+        unit_test(gapbuf_insert_at_end),
+        unit_test(gapbuf_insert_in_middle),
+        unit_test(gapbuf_delete_either_side_of_cursor),
+        unit_test(gapbuf_delete_at_ends_does_nothing),
+        unit_test(gapbuf_counts_code_points_and_columns),
+        unit_test(gapbuf_grows_past_initial_size),
+        unit_test(gapbuf_clear_empties_buffer),
+
         unit_test(previous_on_empty_returns_null),
         unit_test(next_on_empty_returns_null),
         unit_test(previous_once_returns_last),
@@ -120,6 +142,31 @@ int main(int argc, char* argv[]) {
         unit_test(edit_item_mid_history),
         unit_test(edit_previous_and_append),
         unit_test(start_session_add_new_submit_previous),
+        unit_test(search_returns_most_recent_with_prefix),
+        unit_test(search_again_returns_older_match),
+        unit_test(search_skips_repeated_items),
+        unit_test(search_does_not_find_removed_items),
+        unit_test(history_file_restores_items),
+        unit_test(history_file_skips_filtered_items),
+
+        unit_test_setup_teardown(timer_fires_when_due,
+            timerwheel_before_test,
+            timerwheel_after_test),
+        unit_test_setup_teardown(cancelled_timer_does_not_fire,
+            timerwheel_before_test,
+            timerwheel_after_test),
+        unit_test_setup_teardown(timers_fire_in_deadline_order,
+            timerwheel_before_test,
+            timerwheel_after_test),
+        unit_test_setup_teardown(long_timer_fires_on_time,
+            timerwheel_before_test,
+            timerwheel_after_test),
+        unit_test_setup_teardown(timer_added_when_firing_fires_later,
+            timerwheel_before_test,
+            timerwheel_after_test),
+        unit_test_setup_teardown(timer_added_to_idle_wheel_counts_from_now,
+            timerwheel_before_test,
+            timerwheel_after_test),
 
         unit_test(create_jid_from_null_returns_null),
         unit_test(create_jid_from_empty_string_returns_null),
@@ -146,6 +193,9 @@ int main(int argc, char* argv[]) {
         unit_test(create_full_with_trailing_slash),
         unit_test(returns_fulljid_when_exists),
         unit_test(returns_barejid_when_fulljid_not_exists),
+        unit_test(intern_returns_same_jid_for_same_string),
+        unit_test(intern_returns_null_for_invalid_jid),
+        unit_test(interned_jid_outlives_clear_while_referenced),
 
         unit_test(parse_null_returns_null),
         unit_test(parse_empty_returns_null),
@@ -216,6 +266,10 @@ int main(int argc, char* argv[]) {
         unit_test(find_twice_returns_second_when_two_match),
         unit_test(find_five_times_finds_fifth),
         unit_test(find_twice_returns_first_when_two_match_and_reset),
+        unit_test(contacts_by_presence_offline_when_added),
+        unit_test(contacts_by_presence_follows_presence_changes),
+        unit_test(contacts_by_presence_excludes_removed),
+        unit_test(roster_lists_keep_contacts_apart),
 
         unit_test_setup_teardown(returns_false_when_chat_session_does_not_exist,
             init_chat_sessions,
@@ -368,6 +422,10 @@ int main(int argc, char* argv[]) {
         unit_test(cmd_account_clear_shows_usage_when_one_arg),
         unit_test(cmd_account_clear_shows_message_when_account_doesnt_exist),
         unit_test(cmd_account_clear_shows_message_when_invalid_property),
+        unit_test(cmd_history_not_saved_for_account_password),
+        unit_test(cmd_history_not_saved_for_otr_secrets),
+        unit_test(cmd_history_not_saved_for_room_password),
+        unit_test(cmd_history_not_saved_for_messages),
 
         unit_test(cmd_sub_shows_message_when_not_connected),
         unit_test(cmd_sub_shows_usage_when_no_arg),
@@ -396,6 +454,7 @@ int main(int argc, char* argv[]) {
         unit_test(contact_not_available_when_highest_priority_dnd),
         unit_test(contact_available_when_highest_priority_online),
         unit_test(contact_available_when_highest_priority_chat),
+        unit_test(contact_presence_updated_when_highest_resource_removed),
 
         unit_test(cmd_statuses_shows_usage_when_bad_subcmd),
         unit_test(cmd_statuses_shows_usage_when_bad_console_setting),
@@ -438,6 +497,15 @@ int main(int argc, char* argv[]) {
         unit_test_setup_teardown(statuses_muc_defaults_to_all,
             load_preferences,
             close_preferences),
+        unit_test_setup_teardown(highlights_empty_by_default,
+            load_preferences,
+            close_preferences),
+        unit_test_setup_teardown(add_highlight_adds_once,
+            load_preferences,
+            close_preferences),
+        unit_test_setup_teardown(remove_highlight_removes,
+            load_preferences,
+            close_preferences),
 
         unit_test_setup_teardown(console_doesnt_show_online_presence_when_set_none,
             load_preferences,
@@ -496,6 +564,17 @@ int main(int argc, char* argv[]) {
         unit_test_setup_teardown(test_muc_invites_count_5, muc_before_test, muc_after_test),
         unit_test_setup_teardown(test_muc_room_is_not_active, muc_before_test, muc_after_test),
         unit_test_setup_teardown(test_muc_active, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_roster_staged_until_join_complete, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_roster_remove_while_joining, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_roster_later_presence_while_joining_wins, muc_before_test, muc_after_test),
+
+        unit_test_setup_teardown(no_since_for_unseen_room, muc_history_before_test, muc_history_after_test),
+        unit_test_setup_teardown(since_goes_back_from_latest_seen, muc_history_before_test, muc_history_after_test),
+        unit_test_setup_teardown(seen_line_is_duplicate_at_its_stamp, muc_history_before_test, muc_history_after_test),
+        unit_test_setup_teardown(different_line_is_not_duplicate, muc_history_before_test, muc_history_after_test),
+        unit_test_setup_teardown(repeated_short_line_is_not_duplicate, muc_history_before_test, muc_history_after_test),
+        unit_test_setup_teardown(live_line_matched_by_stanza_id, muc_history_before_test, muc_history_after_test),
+        unit_test_setup_teardown(seen_lines_restored_from_file, muc_history_before_test, muc_history_after_test),
 
         unit_test(cmd_bookmark_shows_message_when_disconnected),
         unit_test(cmd_bookmark_shows_message_when_disconnecting),
@@ -626,6 +705,96 @@ int main(int argc, char* argv[]) {
         unit_test(remove_text_multi_value_removes_when_many),
 
         unit_test(clears_chat_sessions),
+
+        unit_test(capture_ignored_when_not_started),
+        unit_test(capture_keeps_sent_and_recv),
+        unit_test(capture_ignores_other_lines),
+        unit_test(capture_drops_oldest_over_limit),
+        unit_test(take_filters_by_dir),
+        unit_test(take_filters_by_element),
+        unit_test(take_filters_by_ns),
+        unit_test(pretty_indents_children),
+        unit_test(pretty_keeps_text_inline),
+        unit_test(pretty_handles_lone_open_bracket),
+
+        unit_test_setup_teardown(single_notification_sent_unchanged, notifyqueue_before_test, notifyqueue_after_test),
+        unit_test_setup_teardown(notification_held_until_coalesce_period, notifyqueue_before_test, notifyqueue_after_test),
+        unit_test_setup_teardown(same_window_notifications_merged, notifyqueue_before_test, notifyqueue_after_test),
+        unit_test_setup_teardown(different_windows_not_merged, notifyqueue_before_test, notifyqueue_after_test),
+        unit_test_setup_teardown(no_win_notifications_not_merged, notifyqueue_before_test, notifyqueue_after_test),
+        unit_test_setup_teardown(dispatch_rate_limited, notifyqueue_before_test, notifyqueue_after_test),
+        unit_test_setup_teardown(transient_notification_replaced_by_newer, notifyqueue_before_test, notifyqueue_after_test),
+        unit_test_setup_teardown(transient_notification_dropped_when_out_of_date, notifyqueue_before_test, notifyqueue_after_test),
+
+        unit_test_setup_teardown(first_request_sent, capsqueue_before_test, capsqueue_after_test),
+        unit_test_setup_teardown(duplicate_ver_not_sent, capsqueue_before_test, capsqueue_after_test),
+        unit_test_setup_teardown(complete_returns_all_waiters, capsqueue_before_test, capsqueue_after_test),
+        unit_test_setup_teardown(requests_over_limit_wait, capsqueue_before_test, capsqueue_after_test),
+        unit_test_setup_teardown(complete_sends_waiting_request, capsqueue_before_test, capsqueue_after_test),
+        unit_test_setup_teardown(failed_retries_next_waiter, capsqueue_before_test, capsqueue_after_test),
+        unit_test_setup_teardown(failed_without_waiters_drops, capsqueue_before_test, capsqueue_after_test),
+        unit_test_setup_teardown(expire_retries_timed_out_request, capsqueue_before_test, capsqueue_after_test),
+        unit_test_setup_teardown(failed_reply_for_earlier_attempt_ignored, capsqueue_before_test, capsqueue_after_test),
+
+        unit_test_setup_teardown(flush_sends_in_priority_order, sendqueue_before_test, sendqueue_after_test),
+        unit_test_setup_teardown(flush_keeps_order_within_priority, sendqueue_before_test, sendqueue_after_test),
+        unit_test_setup_teardown(newer_presence_replaces_queued, sendqueue_before_test, sendqueue_after_test),
+        unit_test_setup_teardown(chat_state_replaces_queued_for_same_key, sendqueue_before_test, sendqueue_after_test),
+        unit_test_setup_teardown(message_drops_queued_chat_state, sendqueue_before_test, sendqueue_after_test),
+        unit_test_setup_teardown(close_releases_unsent, sendqueue_before_test, sendqueue_after_test),
+
+        unit_test_setup_teardown(csi_not_sent_when_unsupported, csi_before_test, csi_after_test),
+        unit_test_setup_teardown(csi_sends_inactive_then_active, csi_before_test, csi_after_test),
+        unit_test_setup_teardown(csi_only_sends_changes, csi_before_test, csi_after_test),
+        unit_test_setup_teardown(csi_reset_for_new_stream, csi_before_test, csi_after_test),
+        unit_test(csi_offered_in_stream_features),
+        unit_test(csi_offered_after_stream_header),
+        unit_test(csi_not_offered_by_message_text),
+
+        unit_test_setup_teardown(mam_unknown_archive_only_fetches_newest_id, mam_before_test, mam_after_test),
+        unit_test_setup_teardown(mam_pages_forward_from_last_id, mam_before_test, mam_after_test),
+        unit_test_setup_teardown(mam_stops_after_max_pages_and_resumes, mam_before_test, mam_after_test),
+        unit_test_setup_teardown(mam_page_delivered_in_timestamp_order, mam_before_test, mam_after_test),
+        unit_test_setup_teardown(mam_failed_page_keeps_position, mam_before_test, mam_after_test),
+        unit_test_setup_teardown(mam_results_ignored_when_not_catching_up, mam_before_test, mam_after_test),
+        unit_test_setup_teardown(mam_live_id_ignored_while_catching_up, mam_before_test, mam_after_test),
+        unit_test_setup_teardown(mam_positions_restored_from_file, mam_before_test, mam_after_test),
+        unit_test_setup_teardown(mam_live_id_ignored_after_max_pages, mam_before_test, mam_after_test),
+        unit_test_setup_teardown(mam_truncated_archive_restored_from_file, mam_before_test, mam_after_test),
+        unit_test_setup_teardown(mam_live_and_sent_messages_not_delivered_again, mam_before_test, mam_after_test),
+        unit_test_setup_teardown(mam_sent_messages_not_delivered_after_reconnect, mam_before_test, mam_after_test),
+
+        unit_test(compression_not_counted_until_active),
+        unit_test(compression_counts_plain_bytes),
+        unit_test(compression_repetitive_stream_saves_bytes),
+        unit_test(compression_reset_for_new_stream),
+        unit_test(compression_confirmed_only_by_compressed_element),
+
+        unit_test(detach_not_detached_on_start),
+        unit_test(detach_socket_path_is_per_user),
+        unit_test(detach_socket_path_prefers_runtime_dir),
+        unit_test(detach_dir_must_be_private),
+        unit_test(detach_peer_is_same_user),
+        unit_test(detach_terminal_passed_over_socket),
+        unit_test(detach_receive_needs_terminal),
+
+        unit_test(no_patterns_matches_nothing),
+        unit_test(matches_word_anywhere),
+        unit_test(does_not_match_missing_word),
+        unit_test(matches_ignoring_case),
+        unit_test(matches_non_ascii_ignoring_case),
+        unit_test(matches_overlapping_words),
+        unit_test(matches_word_that_is_suffix_of_prefix),
+        unit_test(matches_word_added_after_match),
+        unit_test(matches_regex_entry),
+        unit_test(invalid_regex_not_added),
+
+        unit_test(new_message_copies_fields),
+        unit_test(new_message_without_resource),
+        unit_test(new_message_with_timestamp_is_delayed),
+        unit_test(set_body_replaces_body),
+        unit_test(buffer_entry_shares_message_body),
+        unit_test(buffer_entry_keeps_plain_message),
     };
 
     return run_tests(all_tests);
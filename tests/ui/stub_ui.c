@@ -57,6 +57,8 @@ void ui_init(void) {}
 void ui_load_colours(void) {}
 void ui_update(void) {}
 void ui_close(void) {}
+void ui_suspend(void) {}
+void ui_resume(void) {}
 void ui_redraw(void) {}
 void ui_resize(void) {}
 GSList* ui_get_chat_recipients(void)
@@ -97,6 +99,11 @@ unsigned long ui_get_idle_time(void)
     return 0;
 }
 
+unsigned long ui_get_input_idle_time(void)
+{
+    return 0;
+}
+
 void ui_reset_idle_time(void) {}
 void ui_new_chat_win(const char * const barejid) {}
 void ui_new_private_win(const char * const fulljid) {}
@@ -183,12 +190,12 @@ char * ui_ask_password(void)
     return mock_ptr_type(char *);
 }
 
-void ui_handle_stanza(const char * const msg) {}
 
 // ui events
 void ui_contact_typing(const char * const barejid, const char * const resource) {}
-void ui_incoming_msg(const char * const from, const char * const resource, const char * const message, GTimeVal *tv_stamp) {}
+void ui_incoming_msg(ChatMessage *message) {}
 void ui_incoming_private_msg(const char * const fulljid, const char * const message, GTimeVal *tv_stamp) {}
+void ui_archived_messages(GList *messages) {}
 
 void ui_disconnected(void) {}
 void ui_recipient_gone(const char * const barejid, const char * const resource) {}
@@ -329,6 +336,7 @@ char * ui_readline(void)
 }
 
 void ui_inp_history_append(char *inp) {}
+void ui_inp_history_set_size(int size) {}
 
 void ui_input_clear(void) {}
 void ui_input_nonblocking(gboolean reset) {}
@@ -343,6 +351,15 @@ gboolean ui_xmlconsole_exists(void)
 
 void ui_open_xmlconsole_win(void) {}
 
+void ui_create_highlights_win(void) {}
+gboolean ui_highlights_exists(void)
+{
+    return FALSE;
+}
+
+void ui_open_highlights_win(void) {}
+void ui_highlights_changed(void) {}
+
 gboolean ui_win_has_unsaved_form(int num)
 {
     return FALSE;
@@ -408,6 +425,8 @@ void cons_show_aliases(GList *aliases)
     check_expected(aliases);
 }
 
+void cons_show_highlights(GList *highlights) {}
+
 void cons_show_login_success(ProfAccount *account) {}
 void cons_show_software_version(const char * const jid,
     const char * const presence, const char * const name,
@@ -463,9 +482,13 @@ void cons_grlog_setting(void) {}
 void cons_autoaway_setting(void) {}
 void cons_reconnect_setting(void) {}
 void cons_autoping_setting(void) {}
+void cons_csi_setting(void) {}
+void cons_compression_setting(void) {}
 void cons_priority_setting(void) {}
 void cons_autoconnect_setting(void) {}
 void cons_inpblock_setting(void) {}
+void cons_multiline_setting(void) {}
+void cons_inputhistory_setting(void) {}
 
 void cons_show_contact_online(PContact contact, Resource *resource, GDateTime *last_activity)
 {
@@ -485,6 +508,7 @@ void occupantswin_occupants(const char * const room) {}
 
 // desktop notifier actions
 void notifier_uninit(void) {}
+void notifier_forked(void) {}
 
 void notify_typing(const char * const handle) {}
 void notify_message(const char * const handle, int win, const char * const text) {}
@@ -32,6 +32,11 @@ const char * jabber_get_fulljid(void)
     return (char *)mock();
 }
 
+Jid * jabber_get_jid(void)
+{
+    return NULL;
+}
+
 const char * jabber_get_domain(void)
 {
     return NULL;
@@ -149,15 +154,7 @@ void iq_room_kick_occupant(const char * const room, const char * const nick, con
 void iq_room_role_set(const char * const room, const char * const nick, char *role,
     const char * const reason) {}
 void iq_room_role_list(const char * const room, char *role) {}
-
-// caps functions
-Capabilities* caps_lookup(const char * const jid)
-{
-    return NULL;
-}
-
-void caps_close(void) {}
-void caps_destroy(Capabilities *caps) {}
+void iq_mam_query(const char * const archive, const char * const after, int max) {}
 
 gboolean bookmark_add(const char *jid, const char *nick, const char *password, const char *autojoin_str)
 {